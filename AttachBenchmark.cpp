@@ -0,0 +1,126 @@
+#include "AttachBenchmark.hpp"
+#include "Logger.hpp"
+#include "WinMMExports.hpp"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+// loads of each path, the first one included
+#define BENCHMARK_LOADS 200
+
+static const char* const exportNames[] = {
+#define EXPORT_NAME(name, ordinal) #name,
+    WINMM_EXPORTS(EXPORT_NAME, EXPORT_NAME)
+#undef EXPORT_NAME
+};
+
+// what WinMM::load looks up for the MCI wrappers, and the timer a game
+// polls, a typical first use of the proxy
+static const char* const firstUseNames[] = {"mciSendCommandA",
+    "mciSendCommandW", "mciSendStringA", "mciSendStringW", "timeGetTime",
+    "timeBeginPeriod", "timeEndPeriod"};
+
+static double getSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+AttachBenchmark::AttachBenchmark(
+    const std::string& libraryPath, const std::string& proxyPath)
+    : m_libraryPath(libraryPath)
+    , m_proxyPath(proxyPath)
+{
+}
+
+bool AttachBenchmark::run(const std::string& reportPath)
+{
+    LOG_INFO("Benchmarking process attach with %s", m_libraryPath.c_str());
+
+    // a library the process already has is only looked up, not mapped
+    if (GetModuleHandle(m_libraryPath.c_str())) {
+        LOG_INFO("%s is loaded already, only the lookups are timed",
+            m_libraryPath.c_str());
+    }
+
+    if (!measure("eager attach", m_libraryPath, exportNames,
+            sizeof(exportNames) / sizeof(exportNames[0])) ||
+        !measure("lazy first use", m_libraryPath, firstUseNames,
+            sizeof(firstUseNames) / sizeof(firstUseNames[0]))) {
+        return false;
+    }
+
+    if (!m_proxyPath.empty() &&
+        !measure("proxy load", m_proxyPath, nullptr, 0)) {
+        return false;
+    }
+
+    return writeReport(reportPath);
+}
+
+bool AttachBenchmark::measure(const std::string& path,
+    const std::string& libraryPath, const char* const* names, uint32_t count)
+{
+    std::vector<double> times;
+    uint32_t missing = 0;
+
+    for (int32_t i = 0; i < BENCHMARK_LOADS; i++) {
+        double start = getSeconds();
+
+        HMODULE module = LoadLibrary(libraryPath.c_str());
+        if (!module) {
+            LOG_INFO("Can't load %s", libraryPath.c_str());
+            return false;
+        }
+
+        for (uint32_t j = 0; j < count; j++) {
+            missing += !GetProcAddress(module, names[j]);
+        }
+
+        times.push_back(getSeconds() - start);
+
+        // unloading happened at process exit, it isn't part of the attach
+        FreeLibrary(module);
+    }
+
+    if (missing) {
+        LOG_INFO("%s: %u exports are missing from %s", path.c_str(),
+            missing / BENCHMARK_LOADS, libraryPath.c_str());
+    }
+
+    Run run = {};
+    run.path = path;
+    run.lookups = count;
+    run.first = times[0];
+
+    std::sort(times.begin() + 1, times.end());
+    run.median = times[times.size() / 2];
+
+    m_runs.push_back(run);
+    return true;
+}
+
+bool AttachBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return false;
+    }
+
+    fprintf(file, "path\tlookups\tloads\tfirst us\tmedian us\n");
+
+    for (const Run& run : m_runs) {
+        fprintf(file, "%s\t%u\t%d\t%.1f\t%.1f\n", run.path.c_str(),
+            run.lookups, BENCHMARK_LOADS, run.first * 1e6, run.median * 1e6);
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked process attach, see %s", reportPath.c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Times the work DllMain did at process attach before the exports were
+// resolved on first call, loading the system winmm.dll and looking up all of
+// its exports, against what is left of it for the first call: loading the
+// library and looking up the few exports a game uses. Optionally times the
+// load of a built proxy DLL as a whole, to compare two builds. Each load is
+// undone before the next, the first one maps the file and is written apart
+// from the median of the rest. Writes the microseconds per load.
+class AttachBenchmark
+{
+public:
+    // The library should be the system winmm.dll, the proxy may be empty.
+    AttachBenchmark(
+        const std::string& libraryPath, const std::string& proxyPath);
+
+    // false if a library can't be loaded or the report can't be written
+    bool run(const std::string& reportPath);
+
+private:
+    struct Run
+    {
+        std::string path;
+        uint32_t lookups;
+        double first;
+        double median;
+    };
+
+    std::string m_libraryPath;
+    std::string m_proxyPath;
+    std::vector<Run> m_runs;
+
+    // loads and looks up the names, false if the library can't be loaded
+    bool measure(const std::string& path, const std::string& libraryPath,
+        const char* const* names, uint32_t count);
+
+    bool writeReport(const std::string& reportPath);
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "AudioClock.hpp"
+#include "AudioSource.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+AudioClock::AudioClock(TimeSource timeSource)
+    : m_timeSource(timeSource ? timeSource : &getSystemTime)
+    , m_sequence(0)
+    , m_timestamp(0)
+    , m_played(0)
+    , m_rendered(0)
+    , m_lastPlayed(0.0)
+{
+}
+
+void AudioClock::reset()
+{
+    update(0, 0);
+    m_lastPlayed = 0.0;
+}
+
+void AudioClock::update(uint64_t rendered, uint32_t pending)
+{
+    int64_t now = m_timeSource();
+
+    // odd sequence numbers mark a snapshot that is being written
+    m_sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_timestamp.store(now, std::memory_order_relaxed);
+    m_played.store(rendered - (std::min)(rendered, static_cast<uint64_t>(pending)),
+        std::memory_order_relaxed);
+    m_rendered.store(rendered, std::memory_order_relaxed);
+
+    m_sequence.fetch_add(1, std::memory_order_release);
+}
+
+double AudioClock::getPlayedFrames()
+{
+    int64_t timestamp;
+    uint64_t played;
+    uint64_t rendered;
+    uint32_t sequence;
+
+    do {
+        sequence = m_sequence.load(std::memory_order_acquire);
+        timestamp = m_timestamp.load(std::memory_order_relaxed);
+        played = m_played.load(std::memory_order_relaxed);
+        rendered = m_rendered.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) ||
+             sequence != m_sequence.load(std::memory_order_relaxed));
+
+    // the device has been playing since the snapshot, but it can't be
+    // ahead of what has been rendered
+    int64_t elapsed = (std::max)(m_timeSource() - timestamp, int64_t(0));
+    double position = played + elapsed * (AUDIO_SAMPLE_RATE / 1e9);
+    position = (std::min)(position, static_cast<double>(rendered));
+
+    // callbacks jitter, so an update may land behind an earlier
+    // interpolated value
+    double last = m_lastPlayed.load();
+    while (position > last &&
+           !m_lastPlayed.compare_exchange_weak(last, position)) {
+    }
+
+    return (std::max)(position, last);
+}
+
+int64_t AudioClock::getSystemTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
\ No newline at end of file
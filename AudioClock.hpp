@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Tracks how many mixed frames have been played by the output device.
+// Between device callbacks, the position is interpolated from a high
+// resolution clock.
+class AudioClock
+{
+public:
+    // returns the current time in nanoseconds
+    typedef int64_t (*TimeSource)();
+
+    AudioClock(TimeSource timeSource = nullptr);
+
+    void reset();
+
+    // Called on the audio thread after a block was handed to the device.
+    // rendered is the total number of frames rendered so far, pending the
+    // number of those that aren't audible yet.
+    void update(uint64_t rendered, uint32_t pending);
+
+    // interpolated number of frames played, never decreases until reset
+    double getPlayedFrames();
+
+    static int64_t getSystemTime();
+
+private:
+    TimeSource m_timeSource;
+
+    // snapshot of the last update, guarded by the sequence counter
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<int64_t> m_timestamp;
+    std::atomic<uint64_t> m_played;
+    std::atomic<uint64_t> m_rendered;
+
+    std::atomic<double> m_lastPlayed;
+};
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "AudioMixer.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#ifndef NO_LIBZPLAY
+#include "ZPlayOutput.hpp"
+#endif
+
+#include <algorithm>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) ||            \
+    defined(__SSE2__)
+#define MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+// number of frames mixed in one pass
+#define MIX_BLOCK 512
+
+// Adds a source block to the mix buffer. The gain of each channel starts at
+// gain[] and changes by step[] per frame.
+static void mixAdd(float* mix, const int16_t* source, size_t frames,
+    const float gain[2], const float step[2])
+{
+    size_t i = 0;
+
+#ifdef MIXER_SSE2
+    // four samples hold two frames, so the gain advances by two steps
+    __m128 g = _mm_setr_ps(
+        gain[0], gain[1], gain[0] + step[0], gain[1] + step[1]);
+    __m128 gs = _mm_setr_ps(
+        step[0] * 2, step[1] * 2, step[0] * 2, step[1] * 2);
+
+    for (; i + 4 <= frames; i += 4) {
+        __m128i s = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(source + i * AUDIO_CHANNELS));
+
+        // sign extend int16 to int32 by shifting the duplicated halves back
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+
+        float* m = mix + i * AUDIO_CHANNELS;
+        _mm_storeu_ps(m, _mm_add_ps(_mm_loadu_ps(m), _mm_mul_ps(lo, g)));
+        g = _mm_add_ps(g, gs);
+        _mm_storeu_ps(m + 4, _mm_add_ps(_mm_loadu_ps(m + 4), _mm_mul_ps(hi, g)));
+        g = _mm_add_ps(g, gs);
+    }
+#endif
+
+    for (; i < frames; i++) {
+        for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+            float g = gain[c] + step[c] * i;
+            mix[i * AUDIO_CHANNELS + c] += source[i * AUDIO_CHANNELS + c] * g;
+        }
+    }
+}
+
+AudioMixer::AudioMixer(Config& config)
+    : m_config(config)
+    , m_output(nullptr)
+    , m_rendered(0)
+    , m_mix(MIX_BLOCK * AUDIO_CHANNELS)
+    , m_read(MIX_BLOCK * AUDIO_CHANNELS)
+    , m_kernels(SampleKernels::get(SampleKernels::getBest()))
+    , m_format(SampleInt16)
+{
+    SampleKernels::seedDither(m_dither);
+}
+
+void AudioMixer::addSource(AudioSource* source)
+{
+    if (!m_output) {
+        openOutput();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sources.push_back(source);
+}
+
+void AudioMixer::removeSource(AudioSource* source)
+{
+    bool empty;
+
+    {
+        // the audio thread holds the lock while mixing, so the source is no
+        // longer in use once we got it
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sources.erase(std::remove(m_sources.begin(), m_sources.end(), source),
+            m_sources.end());
+        empty = m_sources.empty();
+    }
+
+    // close outside of the lock, stopping waits for the audio thread
+    if (empty) {
+        closeOutput();
+    }
+}
+
+void AudioMixer::render(void* buffer, size_t frames, uint32_t pending)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint8_t* output = static_cast<uint8_t*>(buffer);
+    size_t frameSize = SampleKernels::getSampleSize(m_format) * AUDIO_CHANNELS;
+
+    uint64_t mixerFrame = m_rendered;
+    size_t remaining = frames;
+
+    while (remaining) {
+        size_t count = (std::min)(remaining, static_cast<size_t>(MIX_BLOCK));
+        std::fill(m_mix.begin(), m_mix.begin() + count * AUDIO_CHANNELS, 0.0f);
+
+        int32_t active = 0;
+        bool unity = true;
+
+        for (AudioSource* source : m_sources) {
+            if (source->isPaused()) {
+                continue;
+            }
+
+            size_t read = source->pull(&m_read[0], count, mixerFrame);
+
+            float gain[2];
+            float step[2];
+            source->nextGain(count, gain, step);
+
+            if (!read) {
+                continue;
+            }
+
+            mixAdd(&m_mix[0], &m_read[0], read, gain, step);
+
+            active++;
+            unity = unity && gain[0] == 1.0f && gain[1] == 1.0f &&
+                    step[0] == 0.0f && step[1] == 0.0f;
+        }
+
+        // a single source at unity gain is passed through bit-exact
+        bool dither = active > 1 || !unity;
+        m_kernels.fromFloat[m_format](
+            output, &m_mix[0], count * AUDIO_CHANNELS, m_dither, dither);
+
+        output += count * frameSize;
+        remaining -= count;
+        mixerFrame += count;
+    }
+
+    m_rendered = mixerFrame;
+    m_clock.update(m_rendered, static_cast<uint32_t>(pending + frames));
+}
+
+uint32_t AudioMixer::getLatency()
+{
+    return m_output ? m_output->getLatency() : 0;
+}
+
+double AudioMixer::getPosition(AudioSource* source)
+{
+    return source->getPosition(m_clock.getPlayedFrames());
+}
+
+void AudioMixer::openOutput()
+{
+    LOG_TRACE("Opening output");
+
+    // the new device starts at frame 0
+    m_rendered = 0;
+    m_clock.reset();
+
+    m_output = AudioOutput::create(m_config);
+    m_format = m_output->getFormat();
+
+    try {
+        m_output->start(*this);
+#ifdef NO_LIBZPLAY
+    } catch (const WinMMError&) {
+        // there is no libzplay output to fall back to
+        delete m_output;
+        m_output = nullptr;
+        throw;
+    }
+#else
+    } catch (const WinMMError& ex) {
+        bool fallback = dynamic_cast<ZPlayOutput*>(m_output) == nullptr;
+
+        delete m_output;
+        m_output = nullptr;
+
+        if (!fallback) {
+            throw;
+        }
+
+        // fall back to libzplay's wave-out, which works everywhere
+        LOG_INFO("%s, falling back to libzplay output", ex.what());
+
+        m_output = new ZPlayOutput(m_config.getInt("output", "period", 10));
+        m_format = m_output->getFormat();
+
+        try {
+            m_output->start(*this);
+        } catch (...) {
+            delete m_output;
+            m_output = nullptr;
+            throw;
+        }
+    }
+#endif
+}
+
+void AudioMixer::closeOutput()
+{
+    if (!m_output) {
+        return;
+    }
+
+    LOG_TRACE("Closing output");
+
+    m_output->stop();
+    delete m_output;
+    m_output = nullptr;
+}
\ No newline at end of file
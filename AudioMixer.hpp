@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AudioClock.hpp"
+#include "AudioOutput.hpp"
+#include "AudioSource.hpp"
+#include "Config.hpp"
+#include "SampleFormat.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Owns the output device and sums all active sources into it, so every
+// player shares a single output stream and audio thread.
+class AudioMixer
+{
+public:
+    AudioMixer(Config& config);
+
+    // the output device is opened with the first source and closed with the
+    // last one
+    void addSource(AudioSource* source);
+    void removeSource(AudioSource* source);
+
+    // Called on the audio thread. Mixes all sources into the buffer of
+    // interleaved stereo frames in the sample format of the output. pending
+    // is the number of frames queued in the device ahead of this buffer.
+    void render(void* buffer, size_t frames, uint32_t pending);
+
+    // number of mixed frames that haven't reached the speakers yet
+    uint32_t getLatency();
+
+    // number of frames of the source that have been played
+    double getPosition(AudioSource* source);
+
+private:
+    Config& m_config;
+    AudioOutput* m_output;
+    AudioClock m_clock;
+    uint64_t m_rendered;
+    std::mutex m_mutex;
+    std::vector<AudioSource*> m_sources;
+    std::vector<float> m_mix;
+    std::vector<int16_t> m_read;
+    const SampleKernels& m_kernels;
+    SampleFormat m_format;
+    uint32_t m_dither[4];
+
+    void openOutput();
+    void closeOutput();
+};
\ No newline at end of file
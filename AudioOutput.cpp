@@ -0,0 +1,198 @@
+#include "AudioOutput.hpp"
+#include "AudioMixer.hpp"
+#include "Logger.hpp"
+#include "WasapiOutput.hpp"
+#include "WinMMError.hpp"
+
+#ifndef NO_LIBZPLAY
+#include "ZPlayOutput.hpp"
+#endif
+
+#include <chrono>
+
+AudioOutput::AudioOutput(SampleFormat format)
+    : m_format(format)
+{
+}
+
+AudioOutput::~AudioOutput()
+{
+}
+
+SampleFormat AudioOutput::getFormat()
+{
+    return m_format;
+}
+
+AudioOutput* AudioOutput::create(Config& config)
+{
+    // [output]
+    // backend = wasapi | zplay | null | file, zplay only in 32-bit builds
+    // period = buffer period in milliseconds
+    // exclusive = 1 to open the WASAPI device in exclusive mode
+    // file = WAV file written by the file backend
+    // realtime = 0 to render the null and file backends as fast as possible
+    // format = int16 | int24 | int32 | float32, libzplay plays int16 only
+    std::string backend = config.getString("output", "backend", "wasapi");
+    uint32_t period = config.getInt("output", "period", 10);
+    uint32_t periodFrames = period * AUDIO_SAMPLE_RATE / 1000;
+    bool realtime = config.getBool("output", "realtime", true);
+
+    std::string formatName = config.getString("output", "format", "int16");
+    SampleFormat format = SampleInt16;
+    if (!SampleKernels::parseFormat(formatName, format)) {
+        LOG_INFO("Unknown output format %s, using int16", formatName.c_str());
+    }
+
+    LOG_TRACE("Output backend %s, period %d ms, format %s", backend.c_str(),
+        period, SampleKernels::getFormatName(format));
+
+#ifndef NO_LIBZPLAY
+    if (backend == "zplay") {
+        return new ZPlayOutput(period);
+    }
+#endif
+
+    if (backend == "null") {
+        return new NullOutput(periodFrames, realtime, format);
+    } else if (backend == "file") {
+        std::string path = config.getString("output", "file", "zplaymm.wav");
+        return new FileOutput(path, periodFrames, realtime, format);
+    } else {
+        bool exclusive = config.getBool("output", "exclusive", false);
+        return new WasapiOutput(period, exclusive, format);
+    }
+}
+
+NullOutput::NullOutput(
+    uint32_t periodFrames, bool realtime, SampleFormat format)
+    : AudioOutput(format)
+    , m_periodFrames(periodFrames ? periodFrames : 1)
+    , m_realtime(realtime)
+    , m_buffer(m_periodFrames * AUDIO_CHANNELS *
+               SampleKernels::getSampleSize(format))
+    , m_running(false)
+{
+}
+
+NullOutput::~NullOutput()
+{
+    stop();
+}
+
+void NullOutput::start(AudioMixer& mixer)
+{
+    m_running = true;
+    m_thread = std::thread(&NullOutput::run, this, &mixer);
+}
+
+void NullOutput::stop()
+{
+    m_running = false;
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+uint32_t NullOutput::getLatency()
+{
+    return m_periodFrames;
+}
+
+void NullOutput::write(const uint8_t* buffer, size_t frames)
+{
+}
+
+void NullOutput::run(AudioMixer* mixer)
+{
+    auto period = std::chrono::microseconds(
+        static_cast<int64_t>(m_periodFrames) * 1000000 / AUDIO_SAMPLE_RATE);
+    auto next = std::chrono::steady_clock::now();
+
+    while (m_running) {
+        mixer->render(&m_buffer[0], m_periodFrames, 0);
+        write(&m_buffer[0], m_periodFrames);
+
+        if (m_realtime) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+FileOutput::FileOutput(const std::string& path, uint32_t periodFrames,
+    bool realtime, SampleFormat format)
+    : NullOutput(periodFrames, realtime, format)
+    , m_path(path)
+    , m_file(nullptr)
+    , m_dataSize(0)
+{
+}
+
+void FileOutput::start(AudioMixer& mixer)
+{
+    m_file = fopen(m_path.c_str(), "wb");
+    if (!m_file) {
+        throw WinMMError("Can't open output file: " + m_path, MCIERR_HARDWARE);
+    }
+
+    // sizes are filled in when the output is stopped
+    m_dataSize = 0;
+    writeHeader();
+
+    NullOutput::start(mixer);
+}
+
+void FileOutput::stop()
+{
+    NullOutput::stop();
+
+    if (m_file) {
+        fseek(m_file, 0, SEEK_SET);
+        writeHeader();
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void FileOutput::write(const uint8_t* buffer, size_t frames)
+{
+    size_t size =
+        frames * AUDIO_CHANNELS * SampleKernels::getSampleSize(m_format);
+    fwrite(buffer, 1, size, m_file);
+    m_dataSize += static_cast<uint32_t>(size);
+}
+
+void FileOutput::writeHeader()
+{
+    // the 3 for float is WAVE_FORMAT_IEEE_FLOAT
+    const uint16_t formatTag = m_format == SampleFloat32 ? 3 : 1;
+    const uint16_t bitsPerSample =
+        static_cast<uint16_t>(SampleKernels::getSampleSize(m_format) * 8);
+    const uint16_t blockAlign = AUDIO_CHANNELS * bitsPerSample / 8;
+    const uint32_t byteRate = AUDIO_SAMPLE_RATE * blockAlign;
+
+    struct
+    {
+        char riff[4];
+        uint32_t riffSize;
+        char wave[4];
+        char fmt[4];
+        uint32_t fmtSize;
+        uint16_t formatTag;
+        uint16_t channels;
+        uint32_t sampleRate;
+        uint32_t byteRate;
+        uint16_t blockAlign;
+        uint16_t bitsPerSample;
+        char data[4];
+        uint32_t dataSize;
+    } header = {{'R', 'I', 'F', 'F'}, 36 + m_dataSize, {'W', 'A', 'V', 'E'},
+        {'f', 'm', 't', ' '}, 16, formatTag, AUDIO_CHANNELS, AUDIO_SAMPLE_RATE,
+        byteRate, blockAlign, bitsPerSample, {'d', 'a', 't', 'a'}, m_dataSize};
+
+    static_assert(sizeof(header) == 44, "WAV header must not be padded");
+
+    fwrite(&header, sizeof(header), 1, m_file);
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Config.hpp"
+#include "SampleFormat.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AudioMixer;
+
+// Output device backend. Each backend runs its own audio thread that pulls
+// interleaved stereo frames in its sample format from the mixer.
+class AudioOutput
+{
+public:
+    explicit AudioOutput(SampleFormat format = SampleInt16);
+    virtual ~AudioOutput();
+
+    // starts the audio thread, throws WinMMError if the device can't be opened
+    virtual void start(AudioMixer& mixer) = 0;
+    virtual void stop() = 0;
+
+    // number of frames rendered by the mixer that haven't been played yet
+    virtual uint32_t getLatency() = 0;
+
+    SampleFormat getFormat();
+
+    // creates the backend selected by the [output] config section
+    static AudioOutput* create(Config& config);
+
+protected:
+    SampleFormat m_format;
+};
+
+// Discards all audio, paced by the system clock unless realtime is disabled.
+// Doesn't depend on any audio API.
+class NullOutput : public AudioOutput
+{
+public:
+    NullOutput(uint32_t periodFrames, bool realtime, SampleFormat format);
+    ~NullOutput();
+
+    void start(AudioMixer& mixer) override;
+    void stop() override;
+    uint32_t getLatency() override;
+
+protected:
+    virtual void write(const uint8_t* buffer, size_t frames);
+
+private:
+    uint32_t m_periodFrames;
+    bool m_realtime;
+    std::vector<uint8_t> m_buffer;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    void run(AudioMixer* mixer);
+};
+
+// Writes all audio to a WAV file.
+class FileOutput : public NullOutput
+{
+public:
+    FileOutput(const std::string& path, uint32_t periodFrames, bool realtime,
+        SampleFormat format);
+
+    void start(AudioMixer& mixer) override;
+    void stop() override;
+
+protected:
+    void write(const uint8_t* buffer, size_t frames) override;
+
+private:
+    std::string m_path;
+    FILE* m_file;
+    uint32_t m_dataSize;
+
+    void writeHeader();
+};
\ No newline at end of file
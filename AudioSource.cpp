@@ -0,0 +1,313 @@
+#include "AudioSource.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+AudioSource::AudioSource()
+    : m_rampFrames(0)
+    , m_gainSerial(0)
+    , m_paused(false)
+    , m_rampLeft(0)
+    , m_appliedSerial(0)
+    , m_consumed(0)
+    , m_consumedEnd(0)
+    , m_position(0.0)
+{
+    for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+        m_targetGain[c] = 1.0f;
+        m_gain[c] = 1.0f;
+        m_rampTarget[c] = 1.0f;
+    }
+}
+
+AudioSource::~AudioSource()
+{
+}
+
+void AudioSource::setGain(float left, float right, uint32_t rampFrames)
+{
+    m_targetGain[0] = left;
+    m_targetGain[1] = right;
+    m_rampFrames = rampFrames;
+    m_gainSerial.fetch_add(1, std::memory_order_release);
+}
+
+void AudioSource::getGain(float& left, float& right)
+{
+    left = m_targetGain[0];
+    right = m_targetGain[1];
+}
+
+void AudioSource::setPaused(bool paused)
+{
+    m_paused = paused;
+}
+
+bool AudioSource::isPaused()
+{
+    return m_paused;
+}
+
+void AudioSource::nextGain(size_t frames, float gain[2], float step[2])
+{
+    // pick up a new gain set by the control thread
+    uint32_t serial = m_gainSerial.load(std::memory_order_acquire);
+    if (serial != m_appliedSerial) {
+        m_appliedSerial = serial;
+        m_rampLeft = m_rampFrames;
+
+        for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+            m_rampTarget[c] = m_targetGain[c];
+            if (!m_rampLeft) {
+                m_gain[c] = m_rampTarget[c];
+            }
+        }
+    }
+
+    if (!m_rampLeft || !frames) {
+        for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+            gain[c] = m_gain[c];
+            step[c] = 0.0f;
+        }
+        return;
+    }
+
+    // if the block is longer than the rest of the ramp, stretch the ramp to
+    // the end of the block so the kernel doesn't need to clamp
+    size_t length = (std::max)(static_cast<size_t>(m_rampLeft), frames);
+
+    for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+        gain[c] = m_gain[c];
+        step[c] = (m_rampTarget[c] - m_gain[c]) / length;
+        m_gain[c] += step[c] * frames;
+    }
+
+    if (m_rampLeft > frames) {
+        m_rampLeft -= static_cast<uint32_t>(frames);
+    } else {
+        m_rampLeft = 0;
+        for (int32_t c = 0; c < AUDIO_CHANNELS; c++) {
+            m_gain[c] = m_rampTarget[c];
+        }
+    }
+}
+
+size_t AudioSource::pull(int16_t* buffer, size_t frames, uint64_t mixerFrame)
+{
+    std::lock_guard<std::mutex> lock(m_positionMutex);
+
+    frames = read(buffer, frames);
+
+    if (frames) {
+        m_consumed += frames;
+        m_consumedEnd = mixerFrame + frames;
+    }
+
+    return frames;
+}
+
+double AudioSource::getPosition(double playedFrames)
+{
+    std::lock_guard<std::mutex> lock(m_positionMutex);
+
+    // consumed frames that are still on their way to the speakers
+    double pending = (std::max)(m_consumedEnd - playedFrames, 0.0);
+    double position = (std::max)(m_consumed - pending, 0.0);
+
+    // don't let clock jitter move the position backwards
+    m_position = (std::max)(m_position, position);
+
+    return m_position;
+}
+
+void AudioSource::resetPosition()
+{
+    std::lock_guard<std::mutex> lock(m_positionMutex);
+
+    m_consumed = 0;
+    m_consumedEnd = 0;
+    m_position = 0.0;
+}
+
+StreamSource::StreamSource(size_t capacity)
+    : m_buffer(capacity * AUDIO_CHANNELS)
+    , m_capacity(capacity)
+    , m_readPos(0)
+    , m_queued(0)
+    , m_length(STREAM_UNLIMITED)
+    , m_written(0)
+    , m_read(0)
+    , m_open(false)
+    , m_ended(false)
+    , m_underruns(0)
+{
+}
+
+size_t StreamSource::read(int16_t* buffer, size_t frames)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // the mixer fills the rest with silence
+    if (frames > m_queued && m_open && !m_ended &&
+        m_read + m_queued < m_length) {
+        m_underruns++;
+    }
+
+    frames = (std::min)(frames, m_queued);
+
+    // copy in up to two parts if the data wraps around the ring end
+    size_t first = (std::min)(frames, m_capacity - m_readPos);
+    memcpy(buffer, &m_buffer[m_readPos * AUDIO_CHANNELS],
+        first * AUDIO_CHANNELS * sizeof(int16_t));
+    memcpy(buffer + first * AUDIO_CHANNELS, &m_buffer[0],
+        (frames - first) * AUDIO_CHANNELS * sizeof(int16_t));
+
+    m_readPos = (m_readPos + frames) % m_capacity;
+    m_queued -= frames;
+    m_read += frames;
+
+    // signal each end once, as soon as its last frame is out
+    bool ended = m_open && !m_ends.empty() && m_read >= m_ends.front();
+    if (ended) {
+        m_ends.pop_front();
+    }
+
+    lock.unlock();
+
+    if (frames) {
+        m_space.notify_one();
+    }
+
+    if (ended && m_endHandler) {
+        m_endHandler();
+    }
+
+    return frames;
+}
+
+StreamSource::WriteResult StreamSource::write(
+    const int16_t* buffer, size_t frames)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_open) {
+        return WriteClosed;
+    }
+
+    // cut the data at the end of the stream
+    WriteResult result = WriteQueued;
+    if (frames >= m_length - m_written) {
+        frames = static_cast<size_t>(m_length - m_written);
+        result = WriteEnded;
+    }
+
+    while (frames) {
+        // wait until there's some space or the stream gets closed
+        m_space.wait(lock, [this] { return !m_open || m_queued < m_capacity; });
+
+        if (!m_open) {
+            return WriteClosed;
+        }
+
+        size_t writePos = (m_readPos + m_queued) % m_capacity;
+        size_t count = (std::min)(frames, m_capacity - m_queued);
+        count = (std::min)(count, m_capacity - writePos);
+
+        memcpy(&m_buffer[writePos * AUDIO_CHANNELS], buffer,
+            count * AUDIO_CHANNELS * sizeof(int16_t));
+
+        m_queued += count;
+        m_written += count;
+        buffer += count * AUDIO_CHANNELS;
+        frames -= count;
+    }
+
+    if (result == WriteEnded) {
+        addEnd(m_length);
+    }
+
+    return result;
+}
+
+void StreamSource::end()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // a closed stream has no end to report, a stream that reached its
+    // length reported it already
+    if (m_open && m_written < m_length) {
+        addEnd(m_written);
+    }
+
+    m_ended = true;
+}
+
+void StreamSource::setEndHandler(std::function<void()> handler)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_endHandler = handler;
+}
+
+void StreamSource::open(uint64_t length)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_ended = false;
+        m_length = length;
+        m_written = 0;
+        m_read = 0;
+        m_ends.clear();
+    }
+
+    // positions are counted from the first frame written after opening
+    resetPosition();
+}
+
+void StreamSource::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+        m_ends.clear();
+        m_readPos = 0;
+        m_queued = 0;
+    }
+
+    m_space.notify_all();
+}
+
+void StreamSource::extend(uint64_t frames)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_open) {
+        addEnd(m_written);
+        m_length = m_written + frames;
+    }
+}
+
+void StreamSource::addEnd(uint64_t frame)
+{
+    // the same end may be reported by the producer and the decoder
+    if (m_ends.empty() || m_ends.back() < frame) {
+        m_ends.push_back(frame);
+    }
+}
+
+bool StreamSource::isOpen()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+size_t StreamSource::queued()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queued;
+}
+
+uint32_t StreamSource::getUnderruns()
+{
+    return m_underruns;
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// number of interleaved channels in all mixer buffers
+#define AUDIO_CHANNELS 2
+
+// sample rate of the mixer and the output device
+#define AUDIO_SAMPLE_RATE 44100
+
+class AudioSource
+{
+public:
+    AudioSource();
+    virtual ~AudioSource();
+
+    // Called on the audio thread. Fills the buffer with up to the given
+    // number of interleaved 16 bit stereo frames and returns the number of
+    // frames written.
+    virtual size_t read(int16_t* buffer, size_t frames) = 0;
+
+    // gain, ramped linearly over the given number of frames
+    void setGain(float left, float right, uint32_t rampFrames = 0);
+    void getGain(float& left, float& right);
+
+    // paused sources are skipped by the mixer
+    void setPaused(bool paused);
+    bool isPaused();
+
+    // Called on the audio thread. Returns the gain at the start of the next
+    // block and the per-frame gain step for both channels.
+    void nextGain(size_t frames, float gain[2], float step[2]);
+
+    // Called on the audio thread. Reads like read() and remembers the mixer
+    // frame the data will end at, so the audible position can be derived
+    // from the output clock.
+    size_t pull(int16_t* buffer, size_t frames, uint64_t mixerFrame);
+
+    // number of frames that reached the speakers since the last position
+    // reset, given the number of mixer frames that have been played
+    double getPosition(double playedFrames);
+    void resetPosition();
+
+private:
+    // written by the control thread
+    std::atomic<float> m_targetGain[AUDIO_CHANNELS];
+    std::atomic<uint32_t> m_rampFrames;
+    std::atomic<uint32_t> m_gainSerial;
+    std::atomic<bool> m_paused;
+
+    // owned by the audio thread
+    float m_gain[AUDIO_CHANNELS];
+    float m_rampTarget[AUDIO_CHANNELS];
+    uint32_t m_rampLeft;
+    uint32_t m_appliedSerial;
+
+    // position bookkeeping
+    std::mutex m_positionMutex;
+    uint64_t m_consumed;
+    uint64_t m_consumedEnd;
+    double m_position;
+};
+
+// length of a stream that ends with its producer only
+#define STREAM_UNLIMITED UINT64_MAX
+
+// Source fed by a producer thread through a ring buffer. The producer blocks
+// while the ring is full, so the audio thread paces the decoder.
+class StreamSource : public AudioSource
+{
+public:
+    enum WriteResult
+    {
+        // all data was queued
+        WriteQueued,
+        // the stream reached its length, data past it was dropped
+        WriteEnded,
+        // the stream has been closed, the data was dropped
+        WriteClosed
+    };
+
+    explicit StreamSource(size_t capacity);
+
+    size_t read(int16_t* buffer, size_t frames) override;
+
+    // producer side
+    WriteResult write(const int16_t* buffer, size_t frames);
+
+    // Marks the end of the data. The handler runs on the audio thread once
+    // the last frame has been mixed.
+    void end();
+    void setEndHandler(std::function<void()> handler);
+
+    // Closed streams discard queued data and drop all writes, which also
+    // releases a blocked producer. An opened stream ends by itself after
+    // the given number of frames.
+    void open(uint64_t length = STREAM_UNLIMITED);
+    void close();
+
+    // Continues the open stream with the given number of frames after the
+    // data written so far. The end handler still runs once the reader gets
+    // to the end of that data.
+    void extend(uint64_t frames);
+    bool isOpen();
+
+    size_t queued();
+
+    // reads that came up short while the producer was still going
+    uint32_t getUnderruns();
+
+private:
+    std::vector<int16_t> m_buffer;
+    size_t m_capacity;
+    size_t m_readPos;
+    size_t m_queued;
+    uint64_t m_length;
+    uint64_t m_written;
+    uint64_t m_read;
+    std::deque<uint64_t> m_ends;
+    bool m_open;
+    bool m_ended;
+    std::atomic<uint32_t> m_underruns;
+    std::function<void()> m_endHandler;
+    std::mutex m_mutex;
+    std::condition_variable m_space;
+
+    void addEnd(uint64_t frame);
+};
\ No newline at end of file
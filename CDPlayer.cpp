@@ -1,6 +1,9 @@
 #include "CDPlayer.hpp"
 #include "Logger.hpp"
 #include "WinMMError.hpp"
+
+#include <algorithm>
+#include <sstream>
 #include <thread>
 
 void CDPlayer::loadVolume()
@@ -9,7 +12,7 @@ void CDPlayer::loadVolume()
         // Open a file in read mode
         fptr = fopen("volumeBGM.txt", "r");
         if (fptr == NULL) {
-            m_player->SetPlayerVolume(100, 100);
+            setGain(100, 100);
         } else {
             // Store the content of the file
             char strVol[4];
@@ -23,10 +26,10 @@ void CDPlayer::loadVolume()
 
             if (*endptr != '\0' || endptr == strVol) {
                 // Invalid number, set to default
-                m_player->SetPlayerVolume(100, 100);
+                setGain(100, 100);
             } else {
                 // Set Volume to the number in the file
-                m_player->SetPlayerVolume(newVol, newVol);
+                setGain(newVol, newVol);
             }
         }
 }
@@ -122,13 +125,150 @@ void CDPlayer::MonitorDirectory(wchar_t* directoryPath, wchar_t* targetFileName)
         thr.detach();
 }
 
-CDPlayer::CDPlayer()
-    : m_player(CreateZPlay())
-    , m_tracks("music", "Track", m_player)
-    , m_currentTrack(1)
-    , m_notifyMessage(0)
+// number of decoded frames buffered between the decoder and the mixer
+#define STREAM_BUFFER_FRAMES 8192
+
+// number of frames the feeder decodes at once
+#define FEED_BLOCK_FRAMES 2048
+
+// Scans the directories of all soundtrack sets. Sets that can't be scanned
+// are left out, unless none is left.
+static std::vector<std::unique_ptr<CDTrackList>> scanTrackSets(
+    Config& config)
+{
+    std::istringstream names(config.getString("soundtrack", "sets", "music"));
+    std::vector<std::unique_ptr<CDTrackList>> sets;
+    std::string name;
+    std::string error;
+
+    while (std::getline(names, name, ',')) {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+
+        if (name.empty()) {
+            continue;
+        }
+
+        try {
+            sets.push_back(
+                std::make_unique<CDTrackList>(name, "Track", config));
+        } catch (const WinMMError& ex) {
+            LOG_INFO("Soundtrack set %s: %s", name.c_str(), ex.what());
+
+            if (error.empty()) {
+                error = ex.what();
+            }
+        }
+    }
+
+    if (sets.empty()) {
+        throw WinMMError(
+            error.empty() ? "No soundtrack sets" : error, MCIERR_HARDWARE);
+    }
+
+    return sets;
+}
+
+CDPlayer::CDPlayer(
+    AudioMixer& mixer, Config& config, Diagnostics& diagnostics)
+    : m_mixer(mixer)
+    , m_config(config)
+    , m_diagnostics(diagnostics)
+    , m_stream(STREAM_BUFFER_FRAMES)
+    , m_trackSets(scanTrackSets(config))
+    , m_selectedTracks(m_trackSets[0].get())
+    , m_tracks(m_trackSets[0].get())
+    , m_playFrom({1, 0})
+    , m_playEnd({1, 0})
+    , m_playTo(1)
+    , m_timeFormat(CDTimeFormat::get(MCI_FORMAT_MSF))
+    , m_notifier(getDeviceID())
+    , m_playToken(0)
+    , m_decoder(nullptr)
+    , m_decoderTrack(0)
+    , m_decoderGain(1.0f)
+    , m_underruns(0)
+    , m_feeding(false)
+    , m_feedBusy(false)
+    , m_feedExit(false)
+    , m_feedBuffer(FEED_BLOCK_FRAMES * AUDIO_CHANNELS)
+    , m_feedFloat(FEED_BLOCK_FRAMES * AUDIO_CHANNELS)
+    , m_sampleKernels(SampleKernels::get(SampleKernels::getBest()))
+    , m_loopMode(LoopOff)
+    , m_loopNotify(false)
+    , m_looping(false)
+    , m_loopStart(0)
+    , m_loopEnd(0)
+    , m_wrapFrames(0)
+    , m_sequence(m_trackSets[0]->getDirectory() + "\\zplaymm.seq")
+    , m_sequenceTrack(0)
+    , m_predicted(0)
 {
-    m_player->SetCallbackFunc(&callback, MsgStop, this);
+    SampleKernels::seedDither(m_feedDither);
+
+    // the set that plays first, the first one scanned by default
+    std::string trackSet = m_config.getString(
+        "soundtrack", "set", m_trackSets[0]->getName().c_str());
+    if (CDTrackList* tracks = findTrackSet(trackSet)) {
+        m_selectedTracks = tracks;
+        m_tracks = tracks;
+    } else {
+        LOG_INFO("No soundtrack set %s", trackSet.c_str());
+    }
+
+    m_stream.setEndHandler([this] { playEnded(); });
+
+    // "all" loops every track, "tagged" the ones with loop points
+    std::string loopMode = m_config.getString("loop", "mode", "off");
+    if (loopMode == "all") {
+        m_loopMode = LoopAll;
+    } else if (loopMode == "tagged") {
+        m_loopMode = LoopTagged;
+    }
+
+    // "synthesize" notifies at every wrap, otherwise the play notification
+    // stays pending while looping
+    m_loopNotify =
+        m_config.getString("loop", "notify", "suppress") == "synthesize";
+
+    // per track settings override the mode, read once for the tracks of all
+    // sets as the file is read on every call
+    for (auto& tracks : m_trackSets) {
+        for (auto& track : tracks->map()) {
+            char key[16];
+            sprintf_s(key, sizeof(key), "track%02d", track.first);
+
+            int32_t looped = m_config.getInt("loop", key, -1);
+            if (looped >= 0) {
+                m_loopTracks[track.first] = looped != 0;
+            }
+        }
+    }
+
+    // the feeder waits for these, so they run at its priority
+    int32_t decodeThreads = m_config.getInt("decoder", "threads", 1);
+    if (decodeThreads > 1) {
+        m_decodePool = std::make_unique<WorkerPool>(
+            decodeThreads, THREAD_PRIORITY_ABOVE_NORMAL);
+    }
+
+    // level the tracks of all sets to a common loudness, found in the
+    // background
+    if (m_config.getBool("loudness", "normalize", false)) {
+        for (auto& tracks : m_trackSets) {
+            m_loudness.push_back(std::make_unique<LoudnessScanner>(
+                *tracks, getPool(),
+                tracks->getDirectory() + "\\loudness.txt",
+                m_config.getInt("loudness", "target", -18),
+                m_config.getBool("loudness", "tags", true)));
+        }
+    }
+
+    // decode all tracks in the background and report broken files
+    if (m_config.getBool("verify", "enabled", false)) {
+        m_verifier = std::make_unique<TrackVerifier>(
+            *m_tracks, getPool(), m_tracks->getDirectory() + "\\verify.txt");
+    }
 
     // Gets the current working directory, and creates a path containing it and the volumeBGM.txt file that we want to monitor for changes
     wchar_t directoryPath[1024];
@@ -138,49 +278,104 @@ CDPlayer::CDPlayer()
 
     // Load the volume
     loadVolume();
+
+    // Nothing may throw once the feeder runs, a joinable thread can't be
+    // destroyed. The members own everything else if the output fails.
+    m_mixer.addSource(&m_stream);
+
+    try {
+        m_feedThread = std::thread(&CDPlayer::feedThread, this);
+    } catch (...) {
+        m_mixer.removeSource(&m_stream);
+        throw;
+    }
+
+    m_diagnostics.set(DiagState, StateStopped);
 }
 
 CDPlayer::~CDPlayer()
 {
-    m_player->Release();
-    m_player = nullptr;
+    // the background jobs go first, they use the tracks and the pool
+    m_loudness.clear();
+    m_verifier.reset();
+    m_pool.reset();
+
+    m_looping = false;
+    stopFeeding();
+
+    {
+        std::lock_guard<std::mutex> lock(m_feedMutex);
+        m_feedExit = true;
+    }
+
+    m_feedWake.notify_one();
+    m_feedThread.join();
+    closeDecoder();
+    m_decodePool.reset();
+
+    // totals of all opens so far
+    const char* names[] = {"restarted", "seeked"};
+    const DiagnosticsItem counts[] = {DiagRestarts, DiagSeeks};
+    for (int32_t i = 0; i < 2; i++) {
+        uint64_t count = m_diagnostics.get(counts[i]);
+        uint64_t totalUs =
+            m_diagnostics.get(static_cast<DiagnosticsItem>(counts[i] + 1));
+        uint64_t maxUs =
+            m_diagnostics.get(static_cast<DiagnosticsItem>(counts[i] + 2));
+        if (count) {
+            LOG_INFO("%llu plays %s, %.3f ms average, %.3f ms max", count,
+                names[i], totalUs / 1e3 / count, maxUs / 1e3);
+        }
+    }
+
+    if (m_diagnostics.get(DiagPredictions)) {
+        LOG_INFO("%llu of %llu predictions hit, %llu of them prefetched",
+            m_diagnostics.get(DiagPredictionHits),
+            m_diagnostics.get(DiagPredictions),
+            m_diagnostics.get(DiagPrefetchHits));
+    }
+
+    m_diagnostics.set(DiagState, StateClosed);
+
+    m_mixer.removeSource(&m_stream);
 }
 
 bool CDPlayer::isOpen()
 {
-    return m_player != nullptr;
+    return m_feedThread.joinable();
 }
 
 bool CDPlayer::isPlaying()
 {
-    if (!m_player) {
+    if (m_stream.isPaused()) {
         return false;
     }
 
-    TStreamStatus streamStatus;
-    m_player->GetStatus(&streamStatus);
-    return streamStatus.fPlay != 0;
+    bool feeding;
+    {
+        std::lock_guard<std::mutex> lock(m_feedMutex);
+        feeding = m_feeding;
+    }
+
+    // the feeder may already be done while the mixer drains the stream
+    return feeding || m_stream.queued() > 0;
 }
 
 bool CDPlayer::isPaused()
 {
-    if (!m_player) {
-        return false;
-    }
-
-    TStreamStatus streamStatus;
-    m_player->GetStatus(&streamStatus);
-    return streamStatus.fPause != 0;
+    return m_stream.isPaused();
 }
 
 int32_t CDPlayer::getNumTracks()
 {
-    return m_tracks.map().size();
+    return m_tracks->map().size();
 }
 
 int32_t CDPlayer::getCurrentTrack()
 {
-    return m_currentTrack;
+    CDTime position = {};
+    getCurrentPosition(position);
+    return position.track;
 }
 
 int32_t CDPlayer::getLength(int32_t index)
@@ -189,25 +384,18 @@ int32_t CDPlayer::getLength(int32_t index)
 
     if (!index) {
         // return length of whole disc: position of last track plus its length
-        const CDTrack& track = m_tracks.last();
-        length.seconds = track.position.seconds + track.length.seconds;
-    } else if (m_tracks.isValid(index)) {
+        const CDTrack& track = m_tracks->last();
+        length.samples = track.position.samples + track.length.samples;
+    } else if (m_tracks->isValid(index)) {
         // return length of the selected track
-        const CDTrack& track = m_tracks.get(index);
-        length.seconds = track.length.seconds;
+        const CDTrack& track = m_tracks->get(index);
+        length.samples = track.length.samples;
     } else {
         // invalid track
     }
 
-    // The MSDN documentation doesn't mention it anywhere, but when
-    // the current time format is set to TMSF, the length is actually
-    // returned as MSF.
-    int32_t timeFormat = m_timeFormat;
-    if (timeFormat == MCI_FORMAT_TMSF) {
-        timeFormat = MCI_FORMAT_MSF;
-    }
-
-    return length.toMciTime(timeFormat);
+    // TMSF lengths are returned as MSF
+    return m_timeFormat->length->encode(length);
 }
 
 int32_t CDPlayer::getPosition(int32_t index)
@@ -217,50 +405,71 @@ int32_t CDPlayer::getPosition(int32_t index)
     if (!index) {
         // position of the current track plus player position
         getCurrentPosition(position);
-    } else if (m_tracks.isValid(index)) {
-        if (m_timeFormat == MCI_FORMAT_TMSF) {
+    } else if (m_tracks->isValid(index)) {
+        if (m_timeFormat->relative) {
             // simply return the track index at second 0
             position.track = index;
-            position.seconds = 0;
+            position.samples = 0;
         } else {
             // position to the beginning of the selected track
-            const CDTrack& track = m_tracks.get(index);
+            const CDTrack& track = m_tracks->get(index);
             position = track.position;
         }
     } else {
         // invalid track
     }
 
-    return position.toMciTime(m_timeFormat);
+    return m_timeFormat->encode(position);
 }
 
 void CDPlayer::getCurrentPosition(CDTime& position)
 {
-    // get current track index
-    TStreamStatus streamStatus;
-    m_player->GetStatus(&streamStatus);
-    int32_t index = m_currentTrack + streamStatus.nSongIndex;
+    // start of the played range plus the samples that reached the speakers
+    int32_t index = m_playFrom.track;
+    int64_t samples = m_playFrom.samples +
+                      static_cast<int64_t>(m_mixer.getPosition(&m_stream));
+
+    // everything after the loop end is another pass through the loop
+    if (m_looping && samples >= m_loopEnd) {
+        samples = m_loopStart +
+                  (samples - m_loopEnd) % (m_loopEnd - m_loopStart);
+    }
 
-    if (m_timeFormat == MCI_FORMAT_TMSF) {
-        // start at second 0
-        position.track = index;
-        position.seconds = 0;
-    } else {
-        // start at the absolute track position
-        const CDTrack& track = m_tracks.get(index);
-        position.track = index;
-        position.seconds = track.position.seconds;
+    // follow the queue into the next tracks
+    while (index < m_playTo &&
+           samples >= m_tracks->get(index).length.samples) {
+        samples -= m_tracks->get(index).length.samples;
+        index++;
     }
 
-    // add current stream time
-    TStreamTime streamTime;
-    m_player->GetPosition(&streamTime);
-    position.seconds += streamTime.sec;
+    position.track = index;
+    position.samples = static_cast<int32_t>(samples);
+
+    if (!m_timeFormat->relative) {
+        // make the position absolute
+        position.samples += m_tracks->get(index).position.samples;
+    }
+}
+
+uint64_t CDPlayer::getRangeLength()
+{
+    // the queued tracks from the start position on
+    int64_t length = -m_playFrom.samples;
+    for (int32_t i = m_playFrom.track; i <= m_playTo; i++) {
+        length += m_tracks->get(i).length.samples;
+    }
+
+    // minus the part of the last track after the end position
+    if (m_playEnd.track == m_playTo && m_playEnd.samples > 0) {
+        length -= m_tracks->get(m_playTo).length.samples - m_playEnd.samples;
+    }
+
+    return static_cast<uint64_t>((std::max)(length, static_cast<int64_t>(0)));
 }
 
 int32_t CDPlayer::getType(int32_t index)
 {
-    if (m_tracks.isAudio(index)) {
+    if (m_tracks->isAudio(index)) {
         return MCI_CDA_TRACK_AUDIO;
     } else {
         // threat data and missing tracks as "other"
@@ -273,14 +482,20 @@ int32_t CDPlayer::getDeviceID()
     return 0xCDFACADE;
 }
 
-void CDPlayer::setTimeFormat(int32_t timeFormat)
+MCIERROR CDPlayer::setTimeFormat(int32_t timeFormat)
 {
-    m_timeFormat = timeFormat;
+    const CDTimeFormat* format = CDTimeFormat::get(timeFormat);
+    if (!format) {
+        return MCIERR_BAD_TIME_FORMAT;
+    }
+
+    m_timeFormat = format;
+    return MMSYSERR_NOERROR;
 }
 
 int32_t CDPlayer::getTimeFormat()
 {
-    return m_timeFormat;
+    return m_timeFormat->format;
 }
 
 void CDPlayer::setVolume(int32_t volume)
@@ -288,60 +503,281 @@ void CDPlayer::setVolume(int32_t volume)
     uint32_t left = (LOWORD(volume) * 100) / 0xffff;
     uint32_t right = (HIWORD(volume) * 100) / 0xffff;
 
-    m_player->SetPlayerVolume(left, right);
+    setGain(left, right);
 }
 
 int32_t CDPlayer::getVolume()
 {
-    uint32_t left;
-    uint32_t right;
+    float left;
+    float right;
+
+    m_stream.getGain(left, right);
 
-    m_player->GetPlayerVolume(&left, &right);
+    return MAKELONG(static_cast<uint32_t>(left * 0xffff),
+        static_cast<uint32_t>(right * 0xffff));
+}
 
-    return MAKELONG(left * 0xffff / 100, right * 0xffff / 100);
+void CDPlayer::setGain(uint32_t left, uint32_t right)
+{
+    // volume is applied by the mixer, ramp it over 10 ms to avoid clicks
+    m_stream.setGain(left / 100.0f, right / 100.0f, AUDIO_SAMPLE_RATE / 100);
+}
+
+void CDPlayer::notify(HWND hwnd)
+{
+    m_notifier.notify(hwnd);
 }
 
-void CDPlayer::setNotify(bool notify)
+void CDPlayer::playEnded()
 {
-    m_notifyMessage = notify ? MCI_NOTIFY_SUCCESSFUL : 0;
+    // Called on the audio thread once the last frame of the range is mixed,
+    // which is the loop end while looping. A loop only notifies if the game
+    // expects to restart the track itself.
+    if (m_looping && !m_loopNotify) {
+        return;
+    }
+
+    m_diagnostics.set(DiagState, StateStopped);
+
+    uint32_t token = m_playToken.exchange(0);
+    if (token) {
+        m_notifier.finish(token, MCI_NOTIFY_SUCCESSFUL);
+    }
+}
+
+bool CDPlayer::isLooped(int32_t index)
+{
+    auto looped = m_loopTracks.find(index);
+    if (looped != m_loopTracks.end()) {
+        return looped->second;
+    }
+
+    switch (m_loopMode) {
+        case LoopAll:
+            return true;
+        case LoopTagged:
+            return m_tracks->get(index).loopLength > 0;
+        default:
+            return false;
+    }
+}
+
+void CDPlayer::playFailed()
+{
+    m_diagnostics.set(DiagState, StateStopped);
+
+    uint32_t token = m_playToken.exchange(0);
+    if (token) {
+        m_notifier.finish(token, MCI_NOTIFY_FAILURE);
+    }
 }
 
-void CDPlayer::setNotifyCallback(HWND hwnd)
+void CDPlayer::feedThread()
 {
-    m_notifyHwnd = hwnd;
+    // the stream only holds a few hundred milliseconds, so the feeder must
+    // not get starved by the game
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    std::unique_lock<std::mutex> lock(m_feedMutex);
+
+    while (true) {
+        m_feedWake.wait(lock, [this] { return m_feeding || m_feedExit; });
+
+        if (m_feedExit) {
+            return;
+        }
+
+        // commands wait for the block to finish before they touch the
+        // decoder
+        m_feedBusy = true;
+        lock.unlock();
+
+        bool more;
+        try {
+            more = feed();
+        } catch (const WinMMError& ex) {
+            LOG_INFO("Decoding failed: %s", ex.what());
+            m_looping = false;
+            playFailed();
+            m_stream.end();
+            more = false;
+        }
+
+        lock.lock();
+        m_feedBusy = false;
+
+        if (!more) {
+            m_feeding = false;
+        }
+
+        m_feedIdle.notify_all();
+    }
 }
 
-void CDPlayer::notify()
+bool CDPlayer::feed()
 {
-    if (m_notifyMessage && m_notifyHwnd) {
-        LOG_TRACE("Posting MM_MCINOTIFY message %d to HWND %p", m_notifyMessage,
-            m_notifyHwnd);
-        PostMessage(m_notifyHwnd, MM_MCINOTIFY, m_notifyMessage, getDeviceID());
+    double decoding = m_decoder->getStats().seconds;
+    size_t frames = m_decoder->read(&m_feedBuffer[0], FEED_BLOCK_FRAMES);
+
+    // counters for the stats queries, the stream counts its underruns from
+    // zero for every player
+    decoding = m_decoder->getStats().seconds - decoding;
+    m_diagnostics.add(DiagDecoded, frames);
+    m_diagnostics.add(DiagDecodeUs, static_cast<uint64_t>(decoding * 1e6));
+    m_diagnostics.set(DiagBuffered, m_stream.queued());
+
+    uint32_t underruns = m_stream.getUnderruns();
+    m_diagnostics.add(DiagUnderruns, underruns - m_underruns);
+    m_underruns = underruns;
+
+    if (!frames) {
+        // the track is over before the stream length, the range goes on with
+        // the next track or the loop, if this pass decoded anything at all
+        if (m_looping && m_decoder->getStats().frames > m_wrapFrames) {
+            wrapLoop();
+            return true;
+        }
 
-        // make sure the notification is send once only
-        m_notifyMessage = 0;
-        m_notifyHwnd = 0;
+        if (m_decoderTrack < m_playTo) {
+            openDecoder(m_decoderTrack + 1);
+            return true;
+        }
+
+        m_stream.end();
+        return false;
+    }
+
+    if (m_decoderGain != 1.0f) {
+        applyGain(frames);
+    }
+
+    switch (m_stream.write(&m_feedBuffer[0], frames)) {
+        case StreamSource::WriteQueued:
+            return true;
+
+        case StreamSource::WriteEnded:
+            if (m_looping) {
+                wrapLoop();
+                return true;
+            }
+
+            // the range is complete
+            return false;
+
+        default:
+            // a command closed the stream
+            return false;
     }
 }
 
-int32_t WINAPI CDPlayer::callback(void* instance, void* user_data,
-    TCallbackMessage message, uint32_t param1, uint32_t param2)
+void CDPlayer::applyGain(size_t frames)
 {
-    LOG_TRACE("%d, %d, %d", message, param1, param2);
+    size_t samples = frames * AUDIO_CHANNELS;
 
-    CDPlayer* instancePlayer = static_cast<CDPlayer*>(user_data);
-    instancePlayer->notify();
+    // rounded back to 16 bit with dither like any other reduction
+    m_sampleKernels.toFloat[SampleInt16](
+        &m_feedFloat[0], &m_feedBuffer[0], samples);
 
-    return 0;
+    for (size_t i = 0; i < samples; i++) {
+        m_feedFloat[i] *= m_decoderGain;
+    }
+
+    m_sampleKernels.fromFloat[SampleInt16](
+        &m_feedBuffer[0], &m_feedFloat[0], samples, m_feedDither, true);
 }
 
-void CDPlayer::play(int32_t from, int32_t to)
+void CDPlayer::wrapLoop()
 {
+    LOG_TRACE("Looping back to %d", m_loopStart);
+
+    // the mixer plays the buffered audio while the decoder is rewound, so
+    // there is no gap
+    m_decoder->seek(m_loopStart);
+    m_wrapFrames = m_decoder->getStats().frames;
+    m_stream.extend(m_loopEnd - m_loopStart);
+}
+
+void CDPlayer::startFeeding()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_feedMutex);
+        m_feeding = true;
+    }
+
+    m_feedWake.notify_one();
+}
+
+void CDPlayer::stopFeeding()
+{
+    std::unique_lock<std::mutex> lock(m_feedMutex);
+    m_feeding = false;
+
+    // drop buffered audio, this also releases a feeder waiting for room
+    m_stream.close();
+
+    m_feedIdle.wait(lock, [this] { return !m_feedBusy; });
+}
+
+void CDPlayer::openDecoder(int32_t track)
+{
+    closeDecoder();
+
+    const CDTrack& info = m_tracks->get(track);
+    Decoder* decoder = Decoder::create(info.codec);
+
+    if (!decoder) {
+        throw WinMMError("No decoder for " + info.path, MCIERR_HARDWARE);
+    }
+
+    try {
+        decoder->open(info.path);
+    } catch (...) {
+        delete decoder;
+        throw;
+    }
+
+    decoder->setPool(m_decodePool.get());
+    m_decoder = decoder;
+    m_decoderTrack = track;
+    m_diagnostics.set(DiagTrack, track);
+    m_decoderGain = m_tracks->getGain(track);
+}
+
+void CDPlayer::closeDecoder()
+{
+    if (!m_decoder) {
+        return;
+    }
+
+    const DecoderStats& stats = m_decoder->getStats();
+    if (stats.frames) {
+        LOG_TRACE("Track %d: %.1f s of %s decoded in %.3f s, %llu bytes read",
+            m_decoderTrack, static_cast<double>(stats.frames) / CD_SAMPLE_RATE,
+            m_decoder->getName(), stats.seconds,
+            static_cast<unsigned long long>(stats.bytesRead));
+    }
+
+    delete m_decoder;
+    m_decoder = nullptr;
+    m_decoderTrack = 0;
+}
+
+MCIERROR CDPlayer::play(int32_t from, int32_t to, HWND notify)
+{
+    // a set selected while the previous range played takes over first, so
+    // that the range is resolved and checked against its tracks
+    if (m_selectedTracks != m_tracks) {
+        m_playToken = 0;
+        m_looping = false;
+        stopFeeding();
+        adoptTrackSet();
+    }
+
     CDTime fromTime = {};
     if (from) {
-        fromTime.fromMciTime(from, m_timeFormat);
-        if (m_timeFormat != MCI_FORMAT_TMSF) {
-            m_tracks.toTrackTime(fromTime);
+        fromTime = m_timeFormat->decode(from);
+        if (!m_timeFormat->relative) {
+            m_tracks->toTrackTime(fromTime);
         }
     } else {
         // "If MCI_FROM is not specified, the starting location defaults to the
@@ -351,129 +787,336 @@ void CDPlayer::play(int32_t from, int32_t to)
 
     CDTime toTime = {};
     if (to) {
-        toTime.fromMciTime(to, m_timeFormat);
-        if (m_timeFormat != MCI_FORMAT_TMSF) {
-            m_tracks.toTrackTime(toTime);
+        toTime = m_timeFormat->decode(to);
+        if (!m_timeFormat->relative) {
+            m_tracks->toTrackTime(toTime);
         }
     } else {
         // "If MCI_TO is not specified, the ending location defaults to the end
         // of the media."
-        const CDTrack& track = m_tracks.last();
+        const CDTrack& track = m_tracks->last();
         toTime.track = track.position.track;
-        toTime.seconds = track.length.seconds;
+        toTime.samples = track.length.samples;
     }
 
-    if (!m_player->Close()) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    // replaying the range that loops right now just takes the new
+    // notification, the loop goes on without a restart
+    bool sameStart = !from || (fromTime.track == m_playFrom.track &&
+                                  fromTime.samples == m_playFrom.samples);
+    bool sameEnd = toTime.track == m_playEnd.track &&
+                   toTime.samples == m_playEnd.samples;
+
+    if (m_looping && m_loopNotify && sameStart && sameEnd) {
+        if (notify) {
+            m_playToken = m_notifier.begin(notify);
+        } else {
+            m_notifier.abort();
+        }
+        return MMSYSERR_NOERROR;
     }
 
     LOG_TRACE("Playing from %d:%d to %d:%d", fromTime.track,
-        fromTime.seconds, toTime.track, toTime.seconds);
+        fromTime.samples, toTime.track, toTime.samples);
 
     // cancel if the track selection is invalid
-    int32_t numTracks = m_tracks.map().size();
+    int32_t numTracks = m_tracks->map().size();
     if (fromTime.track > numTracks || fromTime.track < 1) {
-        throw WinMMError(MCIERR_OUTOFRANGE);
+        return MCIERR_OUTOFRANGE;
     }
 
     if (toTime.track > numTracks || toTime.track < 1) {
-        throw WinMMError(MCIERR_OUTOFRANGE);
+        return MCIERR_OUTOFRANGE;
     }
 
     if (toTime.track == fromTime.track &&
-        toTime.seconds - fromTime.seconds < 1) {
-        throw WinMMError(MCIERR_OUTOFRANGE);
+        toTime.samples - fromTime.samples < CD_SAMPLES_PER_FRAME) {
+        return MCIERR_OUTOFRANGE;
     }
 
     if (toTime.track - fromTime.track < 0) {
-        throw WinMMError(MCIERR_OUTOFRANGE);
+        return MCIERR_OUTOFRANGE;
     }
 
+    // the tracks to queue, without the end track if the range ends at its
+    // beginning
+    int32_t lastTrack = fromTime.track;
+    bool playable = true;
+
     for (int32_t i = fromTime.track; i <= toTime.track; i++) {
-        // cancel if the playlist contains an unplayable track
-        if (!m_tracks.isAudio(i)) {
-            return;
+        if (i == toTime.track && toTime.samples == 0) {
+            break;
         }
 
-        // if the end position is the beginning of the next track, don't add it
-        if (i == toTime.track && toTime.seconds == 0) {
+        // cancel if the playlist contains an unplayable track
+        if (!m_tracks->isAudio(i)) {
+            playable = false;
             break;
         }
 
-        const CDTrack& track = m_tracks.get(i);
-		
-        // add file to queue
-        if (!m_player->AddFile(track.path.c_str(), track.format)) {
-            throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+        lastTrack = i;
+    }
+
+    int64_t started = AudioClock::getSystemTime();
+
+    // the previous range is interrupted, not finished
+    m_playToken = 0;
+    m_looping = false;
+    stopFeeding();
+
+    if (!playable) {
+        closeDecoder();
+        return MMSYSERR_NOERROR;
+    }
+
+    // The decoder is kept if the range starts in the track it's on. Seeking
+    // is much cheaper than reopening.
+    bool reuse = m_decoder && m_decoderTrack == fromTime.track;
+
+    if (!reuse) {
+        openDecoder(fromTime.track);
+    }
+
+    // the gain may have been measured since the decoder was opened
+    m_decoderGain = m_tracks->getGain(fromTime.track);
+
+    m_playFrom = fromTime;
+    m_playEnd = toTime;
+    m_playTo = lastTrack;
+
+    // seek to start position, a reused decoder may be anywhere in the track
+    if (reuse || fromTime.samples > 0) {
+        m_decoder->seek(fromTime.samples);
+    }
+
+    // a single looped track played to its end loops between the loop points,
+    // or over the whole track if it has none
+    const CDTrack& track = m_tracks->get(fromTime.track);
+    uint64_t length = getRangeLength();
+
+    if (fromTime.track == m_playTo && isLooped(fromTime.track) &&
+        length == track.length.samples - fromTime.samples) {
+        m_loopStart = track.loopLength > 0 ? track.loopStart : 0;
+        m_loopEnd = track.loopLength > 0
+                        ? (std::min)(track.loopStart + track.loopLength,
+                              track.length.samples)
+                        : track.length.samples;
+
+        if (m_loopStart < m_loopEnd && fromTime.samples < m_loopEnd) {
+            LOG_TRACE("Looping %d to %d", m_loopStart, m_loopEnd);
+            m_looping = true;
+            m_wrapFrames = m_decoder->getStats().frames;
+            length = m_loopEnd - fromTime.samples;
+        }
+    }
+
+    // the stream ends at the exact end sample even within a track
+    m_stream.open(length);
+    m_stream.setPaused(false);
+
+    // a play with notification supersedes the pending one, a play without
+    // aborts it
+    if (notify) {
+        m_playToken = m_notifier.begin(notify);
+    } else {
+        m_notifier.abort();
+    }
+
+    startFeeding();
+
+    m_diagnostics.set(DiagState, StatePlaying);
+    recordPlay(reuse, started);
+    predictNext(fromTime.track);
+
+    return MMSYSERR_NOERROR;
+}
+
+void CDPlayer::recordPlay(bool reused, int64_t started)
+{
+    int64_t elapsed = AudioClock::getSystemTime() - started;
+    m_diagnostics.addLatency(reused ? DiagSeeks : DiagRestarts, elapsed);
+
+    double ms = elapsed / 1e6;
+    LOG_TRACE("%s in %.3f ms", reused ? "Seeked" : "Restarted", ms);
+}
+
+void CDPlayer::predictNext(int32_t track)
+{
+    // replaying the same track is neither a hit nor a miss
+    if (track == m_sequenceTrack) {
+        return;
+    }
+
+    m_sequenceTrack = track;
+
+    if (m_predicted) {
+        m_diagnostics.add(DiagPredictions, 1);
+
+        if (track == m_predicted) {
+            m_diagnostics.add(DiagPredictionHits, 1);
+
+            if (m_prefetcher.isWarm(m_tracks->get(track).path)) {
+                m_diagnostics.add(DiagPrefetchHits, 1);
+            }
         }
     }
 
-    m_currentTrack = fromTime.track;
+    // track changes are rare, so the table is saved right away
+    m_sequence.record(track);
+    m_sequence.save();
 
-    // seek to start position
-    if (fromTime.seconds > 0) {
-        TStreamTime offset;
-        offset.sec = fromTime.seconds;
-        m_player->Seek(tfSecond, &offset, smFromBeginning);
+    // warm up the likely next track while this one plays
+    m_predicted = m_sequence.predict(track);
+    if (m_tracks->isAudio(m_predicted)) {
+        LOG_TRACE("Track %d likely follows %d", m_predicted, track);
+        m_prefetcher.prefetch(m_tracks->get(m_predicted).path);
     }
+}
 
-    if (!m_player->Play()) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+WorkerPool& CDPlayer::getPool()
+{
+    if (!m_pool) {
+        m_pool = std::make_unique<WorkerPool>();
     }
+
+    return *m_pool;
 }
 
 void CDPlayer::pause()
 {
-    if (!m_player->Pause()) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    // the feeder stalls by itself once the stream is full
+    m_stream.setPaused(true);
+
+    if (m_diagnostics.get(DiagState) == StatePlaying) {
+        m_diagnostics.set(DiagState, StatePaused);
     }
 }
 
 void CDPlayer::resume()
 {
-    if (!m_player->Resume()) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    m_stream.setPaused(false);
+
+    if (m_diagnostics.get(DiagState) == StatePaused) {
+        m_diagnostics.set(DiagState, StatePlaying);
     }
 }
 
 void CDPlayer::stop()
 {
-    if (isPlaying()) {
-        // set "aborted" notification if enabled
-        if (m_notifyMessage) {
-            m_notifyMessage = MCI_NOTIFY_ABORTED;
+    m_looping = false;
+
+    // the pending notification gets "aborted"
+    m_playToken = 0;
+    m_notifier.abort();
+
+    // the decoder stays open for a replay of the track
+    stopFeeding();
+    adoptTrackSet();
+
+    m_diagnostics.set(DiagState, StateStopped);
+}
+
+MCIERROR CDPlayer::selectTrackSet(const std::string& name)
+{
+    CDTrackList* tracks = findTrackSet(name);
+    if (!tracks) {
+        LOG_TRACE("No soundtrack set %s", name.c_str());
+        return MCIERR_OUTOFRANGE;
+    }
+
+    m_selectedTracks = tracks;
+
+    // a range that is playing finishes in the set it started in
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(m_feedMutex);
+        idle = !m_feeding && !m_feedBusy;
+    }
+
+    if (idle) {
+        adoptTrackSet();
+    }
+
+    return MMSYSERR_NOERROR;
+}
+
+const std::string& CDPlayer::getTrackSet()
+{
+    return m_selectedTracks.load()->getName();
+}
+
+CDTrackList* CDPlayer::findTrackSet(const std::string& name)
+{
+    for (auto& tracks : m_trackSets) {
+        if (!_stricmp(tracks->getName().c_str(), name.c_str())) {
+            return tracks.get();
         }
     }
 
-    if (!m_player->Stop()) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    return nullptr;
+}
+
+void CDPlayer::adoptTrackSet()
+{
+    CDTrackList* tracks = m_selectedTracks;
+    if (tracks == m_tracks) {
+        return;
     }
+
+    // the decoder is on a file of the other set
+    closeDecoder();
+    m_tracks = tracks;
+
+    if (!m_tracks->isValid(m_playFrom.track)) {
+        m_playFrom = {1, 0};
+        m_playEnd = {1, 0};
+        m_playTo = 1;
+    }
+
+    LOG_INFO("Playing soundtrack set %s", m_tracks->getName().c_str());
 }
 
 void CDPlayer::seekBegin()
 {
-    TStreamTime offset = {};
-    if (!m_player->Seek(tfSecond, &offset, smFromBeginning)) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
-    }
+    seek(0);
 }
 
 void CDPlayer::seekEnd()
 {
-    TStreamTime offset = {};
-    if (!m_player->Seek(tfSecond, &offset, smFromEnd)) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
-    }
+    seek(m_tracks->get(m_playFrom.track).length.samples);
 }
 
 void CDPlayer::seekTo(int32_t to)
 {
-    CDTime time;
-    time.fromMciTime(to, m_timeFormat);
+    CDTime time = m_timeFormat->decode(to);
+
+    seek(time.samples);
+}
+
+void CDPlayer::seek(int32_t samples)
+{
+    // seeking leaves the loop, the range plays to its end from here on
+    m_looping = false;
+
+    // discard audio decoded before the seek
+    bool open = m_stream.isOpen();
+    stopFeeding();
 
-    TStreamTime offset = {};
-    offset.sec = time.seconds;
-    if (!m_player->Seek(tfSecond, &offset, smFromBeginning)) {
-        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    m_playFrom.samples = samples;
+
+    if (!open) {
+        // the next play starts here
+        m_stream.resetPosition();
+        return;
     }
+
+    // the feeder may have moved on to one of the next tracks
+    if (m_decoderTrack != m_playFrom.track) {
+        openDecoder(m_playFrom.track);
+    }
+
+    m_decoder->seek(samples);
+
+    // the range end stays where it was
+    m_stream.open(getRangeLength());
+    startFeeding();
 }
\ No newline at end of file
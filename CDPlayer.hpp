@@ -1,20 +1,36 @@
 #pragma once
 
+#include "AudioMixer.hpp"
+#include "AudioSource.hpp"
 #include "CDTime.hpp"
 #include "CDTrackList.hpp"
-#include "libzplay.h"
+#include "Config.hpp"
+#include "Decoder.hpp"
+#include "Diagnostics.hpp"
+#include "LoudnessScanner.hpp"
+#include "Notifier.hpp"
+#include "PlaySequence.hpp"
+#include "Prefetcher.hpp"
+#include "SampleFormat.hpp"
+#include "TrackVerifier.hpp"
+#include "WorkerPool.hpp"
 
 #include <Windows.h>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
-
-using namespace libZPlay;
+#include <thread>
+#include <vector>
 
 class CDPlayer
 {
 public:
     // initialization
-    CDPlayer();
+    CDPlayer(AudioMixer& mixer, Config& config, Diagnostics& diagnostics);
     ~CDPlayer();
 
     // player status
@@ -31,15 +47,19 @@ public:
 
     // properties
     int32_t getDeviceID();
-    void setTimeFormat(int32_t timeFormat);
+    // MCIERR_BAD_TIME_FORMAT for formats without a codec
+    MCIERROR setTimeFormat(int32_t timeFormat);
     int32_t getTimeFormat();
     void setVolume(int32_t volume);
     int32_t getVolume();
-    void setNotify(bool notify);
-    void setNotifyCallback(HWND hwnd);
 
-    // playback
-    void play(int32_t from, int32_t to);
+    // notifies a command that completed immediately
+    void notify(HWND hwnd);
+
+    // Playback, notifies the window once the range has been played if
+    // given. Ranges games probe for are refused with MCIERR_OUTOFRANGE
+    // instead of an exception, only failures to decode still throw.
+    MCIERROR play(int32_t from, int32_t to, HWND notify = nullptr);
     void pause();
     void resume();
     void stop();
@@ -47,22 +67,109 @@ public:
     void seekEnd();
     void seekTo(int32_t to);
 
+    // Soundtrack sets are named after their directory. A range that is
+    // playing finishes in its set, the next play uses the selected one.
+    // MCIERR_OUTOFRANGE for an unknown set.
+    MCIERROR selectTrackSet(const std::string& name);
+    const std::string& getTrackSet();
+
     // worms 2 plus extension
     void loadVolume();
     void MonitorDirectoryThread(struct ThreadData* data);
     void MonitorDirectory(wchar_t* directoryPath, wchar_t* targetFileName);
 
 private:
-    ZPlay* m_player;
-    CDTrackList m_tracks;
-    int32_t m_currentTrack;
-    int32_t m_timeFormat;
-    int32_t m_notifyMessage;
-    HWND m_notifyHwnd;
+    enum LoopMode
+    {
+        LoopOff,
+        LoopAll,
+        LoopTagged
+    };
+
+    AudioMixer& m_mixer;
+    Config& m_config;
+    Diagnostics& m_diagnostics;
+    StreamSource m_stream;
+
+    // all soundtrack sets, scanned at open. Commands and the feeder use
+    // m_tracks, which follows the selected set whenever the feeder is idle.
+    std::vector<std::unique_ptr<CDTrackList>> m_trackSets;
+    std::atomic<CDTrackList*> m_selectedTracks;
+    CDTrackList* m_tracks;
+
+    CDTime m_playFrom;
+    CDTime m_playEnd;
+    int32_t m_playTo;
+    const CDTimeFormat* m_timeFormat;
+    Notifier m_notifier;
+    std::atomic<uint32_t> m_playToken;
+
+    // decoder of the track the feeder is on, only touched by commands while
+    // the feeder is stopped
+    Decoder* m_decoder;
+    int32_t m_decoderTrack;
+
+    // loudness gain of the decoder's track, applied by the feeder
+    float m_decoderGain;
+
+    // stream underruns the feeder has passed on to the diagnostics
+    uint32_t m_underruns;
+
+    // the feeder thread decodes the range into the stream
+    std::mutex m_feedMutex;
+    std::condition_variable m_feedWake;
+    std::condition_variable m_feedIdle;
+    bool m_feeding;
+    bool m_feedBusy;
+    bool m_feedExit;
+    std::vector<int16_t> m_feedBuffer;
+    std::vector<float> m_feedFloat;
+    const SampleKernels& m_sampleKernels;
+    uint32_t m_feedDither[4];
+    std::thread m_feedThread;
+
+    // seamless looping, the feeder rewinds the decoder whenever it reaches
+    // the loop end
+    LoopMode m_loopMode;
+    std::map<int32_t, bool> m_loopTracks;
+    bool m_loopNotify;
+    std::atomic<bool> m_looping;
+    int32_t m_loopStart;
+    int32_t m_loopEnd;
+    uint64_t m_wrapFrames;
+
+    // prefetch of the track the game most likely plays next
+    PlaySequence m_sequence;
+    Prefetcher m_prefetcher;
+    int32_t m_sequenceTrack;
+    int32_t m_predicted;
+
+    // background decode jobs, the pool is created on first use
+    std::unique_ptr<WorkerPool> m_pool;
+    std::unique_ptr<TrackVerifier> m_verifier;
+    std::vector<std::unique_ptr<LoudnessScanner>> m_loudness;
 
-    static int32_t WINAPI callback(void* instance, void* user_data,
-        TCallbackMessage message, unsigned int param1, unsigned int param2);
+    // threads the decoder may decode ahead with, none unless configured
+    std::unique_ptr<WorkerPool> m_decodePool;
 
-    void notify();
+    CDTrackList* findTrackSet(const std::string& name);
+    void adoptTrackSet();
+    void playEnded();
+    void playFailed();
+    bool isLooped(int32_t index);
+    void recordPlay(bool reused, int64_t started);
+    void predictNext(int32_t track);
+    WorkerPool& getPool();
+    void feedThread();
+    bool feed();
+    void applyGain(size_t frames);
+    void wrapLoop();
+    void startFeeding();
+    void stopFeeding();
+    void openDecoder(int32_t track);
+    void closeDecoder();
+    void setGain(uint32_t left, uint32_t right);
     void getCurrentPosition(CDTime& position);
+    uint64_t getRangeLength();
+    void seek(int32_t samples);
 };
\ No newline at end of file
@@ -1,45 +1,76 @@
 #include "CDTime.hpp"
 
-#include <Windows.h>
+#define TIME_FORMAT(format, length)                                            \
+    {                                                                          \
+        format, CDTimeCodec<format>::relative, CDTimeCodec<format>::encode,    \
+            CDTimeCodec<format>::decode, &TIME_FORMATS[length]                 \
+    }
 
-void CDTime::fromMciTime(int32_t mciTime, int32_t format)
-{
-    switch (format) {
-        case MCI_FORMAT_MILLISECONDS:
-            track = 0;
-            seconds = mciTime / 1000;
-            break;
-
-        case MCI_FORMAT_MSF: {
-            int32_t minute = MCI_MSF_MINUTE(mciTime);
-            int32_t second = MCI_MSF_SECOND(mciTime);
-            track = 0;
-            seconds = second + minute * 60;
-            break;
-        }
+// MCI_FORMAT_HMS isn't supported by cdaudio devices
+static const CDTimeFormat TIME_FORMATS[] = {
+    TIME_FORMAT(MCI_FORMAT_MILLISECONDS, 0),
+    TIME_FORMAT(MCI_FORMAT_MSF, 1),
+    // The MSDN documentation doesn't mention it anywhere, but when the
+    // current time format is set to TMSF, the length is actually returned
+    // as MSF.
+    TIME_FORMAT(MCI_FORMAT_TMSF, 1),
+    TIME_FORMAT(MCI_FORMAT_FRAMES, 3),
+    TIME_FORMAT(MCI_FORMAT_SAMPLES, 4),
+};
 
-        case MCI_FORMAT_TMSF: {
-            int32_t minute = MCI_TMSF_MINUTE(mciTime);
-            int32_t second = MCI_TMSF_SECOND(mciTime);
-            track = MCI_TMSF_TRACK(mciTime);
-            seconds = second + minute * 60;
-            break;
+const CDTimeFormat* CDTimeFormat::get(int32_t format)
+{
+    for (const CDTimeFormat& timeFormat : TIME_FORMATS) {
+        if (timeFormat.format == format) {
+            return &timeFormat;
         }
     }
+
+    return nullptr;
 }
 
-int32_t CDTime::toMciTime(int32_t format)
-{
-    switch (format) {
-        case MCI_FORMAT_MILLISECONDS:
-            return seconds * 1000;
+// one minute, two seconds and three frames into track 4
+#define TEST_SAMPLES (62 * CD_SAMPLE_RATE + 3 * CD_SAMPLES_PER_FRAME)
 
-        case MCI_FORMAT_MSF:
-            return MCI_MAKE_MSF(seconds / 60, seconds % 60, 0);
+template <int32_t Format>
+static constexpr bool roundTrips(int32_t mciTime)
+{
+    return CDTimeCodec<Format>::encode(CDTimeCodec<Format>::decode(mciTime)) ==
+           mciTime;
+}
 
-        case MCI_FORMAT_TMSF:
-            return MCI_MAKE_TMSF(track, seconds / 60, seconds % 60, 0);
-    }
+static_assert(CDTimeCodec<MCI_FORMAT_MILLISECONDS>::encode(
+                  {4, TEST_SAMPLES}) == 62040,
+    "Milliseconds encode wrong!");
+static_assert(CDTimeCodec<MCI_FORMAT_MILLISECONDS>::decode(62040).samples ==
+                  TEST_SAMPLES,
+    "Milliseconds decode wrong!");
+static_assert(CDTimeCodec<MCI_FORMAT_MSF>::encode({4, TEST_SAMPLES}) ==
+                  MCI_MAKE_MSF(1, 2, 3),
+    "MSF encode wrong!");
+static_assert(
+    CDTimeCodec<MCI_FORMAT_MSF>::decode(MCI_MAKE_MSF(1, 2, 3)).samples ==
+        TEST_SAMPLES,
+    "MSF decode wrong!");
+static_assert(CDTimeCodec<MCI_FORMAT_TMSF>::encode({4, TEST_SAMPLES}) ==
+                  MCI_MAKE_TMSF(4, 1, 2, 3),
+    "TMSF encode wrong!");
+static_assert(
+    CDTimeCodec<MCI_FORMAT_TMSF>::decode(MCI_MAKE_TMSF(4, 1, 2, 3)).track ==
+            4 &&
+        CDTimeCodec<MCI_FORMAT_TMSF>::decode(MCI_MAKE_TMSF(4, 1, 2, 3))
+                .samples == TEST_SAMPLES,
+    "TMSF decode wrong!");
+static_assert(CDTimeCodec<MCI_FORMAT_FRAMES>::encode({4, TEST_SAMPLES}) ==
+                  62 * CD_FRAMES_PER_SECOND + 3,
+    "Frames encode wrong!");
+static_assert(CDTimeCodec<MCI_FORMAT_SAMPLES>::encode({4, TEST_SAMPLES}) ==
+                  TEST_SAMPLES,
+    "Samples encode wrong!");
 
-    return 0;
-}
\ No newline at end of file
+// frames are the resolution of all formats but milliseconds
+static_assert(roundTrips<MCI_FORMAT_MSF>(MCI_MAKE_MSF(74, 59, 74)) &&
+                  roundTrips<MCI_FORMAT_TMSF>(MCI_MAKE_TMSF(99, 74, 59, 74)) &&
+                  roundTrips<MCI_FORMAT_FRAMES>(74 * 60 * 75) &&
+                  roundTrips<MCI_FORMAT_SAMPLES>(74 * 60 * CD_SAMPLE_RATE),
+    "MCI time formats don't round trip!");
\ No newline at end of file
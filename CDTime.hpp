@@ -1,14 +1,132 @@
 #pragma once
 
+#include <Windows.h>
+
 #include <cstdint>
 #include <map>
 
+// Red Book audio timing
+#define CD_SAMPLE_RATE 44100
+#define CD_FRAMES_PER_SECOND 75
+#define CD_SAMPLES_PER_FRAME (CD_SAMPLE_RATE / CD_FRAMES_PER_SECOND)
+
 class CDTime
 {
 public:
     int32_t track;
-    int32_t seconds;
+    int32_t samples;
+};
+
+// Conversions between CDTime and one MCI time format. TMSF times are
+// relative to their track, all other formats count from the start of the
+// disc and leave the track at 0.
+template <int32_t Format>
+struct CDTimeCodec;
+
+template <>
+struct CDTimeCodec<MCI_FORMAT_MILLISECONDS>
+{
+    static constexpr bool relative = false;
+
+    static constexpr int32_t encode(CDTime time)
+    {
+        return static_cast<int32_t>(
+            static_cast<int64_t>(time.samples) * 1000 / CD_SAMPLE_RATE);
+    }
+
+    static constexpr CDTime decode(int32_t mciTime)
+    {
+        return {0, static_cast<int32_t>(
+                       static_cast<int64_t>(mciTime) * CD_SAMPLE_RATE / 1000)};
+    }
+};
+
+template <>
+struct CDTimeCodec<MCI_FORMAT_MSF>
+{
+    static constexpr bool relative = false;
+
+    static constexpr int32_t encode(CDTime time)
+    {
+        int32_t frames = time.samples / CD_SAMPLES_PER_FRAME;
+        int32_t seconds = frames / CD_FRAMES_PER_SECOND;
+        return static_cast<int32_t>(MCI_MAKE_MSF(
+            seconds / 60, seconds % 60, frames % CD_FRAMES_PER_SECOND));
+    }
+
+    static constexpr CDTime decode(int32_t mciTime)
+    {
+        return {0, (MCI_MSF_SECOND(mciTime) + MCI_MSF_MINUTE(mciTime) * 60) *
+                           CD_SAMPLE_RATE +
+                       MCI_MSF_FRAME(mciTime) * CD_SAMPLES_PER_FRAME};
+    }
+};
+
+template <>
+struct CDTimeCodec<MCI_FORMAT_TMSF>
+{
+    static constexpr bool relative = true;
+
+    static constexpr int32_t encode(CDTime time)
+    {
+        int32_t frames = time.samples / CD_SAMPLES_PER_FRAME;
+        int32_t seconds = frames / CD_FRAMES_PER_SECOND;
+        return static_cast<int32_t>(MCI_MAKE_TMSF(time.track, seconds / 60,
+            seconds % 60, frames % CD_FRAMES_PER_SECOND));
+    }
+
+    static constexpr CDTime decode(int32_t mciTime)
+    {
+        return {MCI_TMSF_TRACK(mciTime),
+            (MCI_TMSF_SECOND(mciTime) + MCI_TMSF_MINUTE(mciTime) * 60) *
+                    CD_SAMPLE_RATE +
+                MCI_TMSF_FRAME(mciTime) * CD_SAMPLES_PER_FRAME};
+    }
+};
+
+template <>
+struct CDTimeCodec<MCI_FORMAT_FRAMES>
+{
+    static constexpr bool relative = false;
+
+    static constexpr int32_t encode(CDTime time)
+    {
+        return time.samples / CD_SAMPLES_PER_FRAME;
+    }
+
+    static constexpr CDTime decode(int32_t mciTime)
+    {
+        return {0, mciTime * CD_SAMPLES_PER_FRAME};
+    }
+};
+
+template <>
+struct CDTimeCodec<MCI_FORMAT_SAMPLES>
+{
+    static constexpr bool relative = false;
+
+    static constexpr int32_t encode(CDTime time)
+    {
+        return time.samples;
+    }
+
+    static constexpr CDTime decode(int32_t mciTime)
+    {
+        return {0, mciTime};
+    }
+};
+
+// An MCI time format as picked at MCI_SET_TIME_FORMAT, so that conversions
+// don't have to look at the format again.
+struct CDTimeFormat
+{
+    int32_t format;
+    bool relative;
+    int32_t (*encode)(CDTime time);
+    CDTime (*decode)(int32_t mciTime);
+    // the format lengths are reported in
+    const CDTimeFormat* length;
 
-    void fromMciTime(int32_t mciTime, int32_t format);
-    int32_t toMciTime(int32_t format);
+    // nullptr if the format isn't supported
+    static const CDTimeFormat* get(int32_t format);
 };
\ No newline at end of file
@@ -1,112 +1,156 @@
 #include "CDTrackList.hpp"
+#include "Decoder.hpp"
+#include "FileSystem.hpp"
+#include "FlacMetadata.hpp"
 #include "Logger.hpp"
+#include "TrackPattern.hpp"
 #include "WinMMError.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+static std::string toLower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return value;
+}
+
+// case insensitive comparison of a file extension with a codec name
+static bool isExtension(const char* extension, const std::string& codec)
+{
+    size_t i = 0;
+    for (; extension[i] && i < codec.size(); i++) {
+        if (tolower(static_cast<unsigned char>(extension[i])) != codec[i]) {
+            return false;
+        }
+    }
+
+    return !extension[i] && i == codec.size();
+}
 
 CDTrackList::CDTrackList(
-    const std::string& path, const std::string& prefix, ZPlay* player)
-    : m_invalidTrack({})
+    const std::string& path, const std::string& prefix, Config& config)
+    : m_name(path)
+    , m_directory(Config::getGameDirectory() + PATH_SEPARATOR + path)
+    , m_disc(0)
+    , m_invalidTrack({})
 {
     LOG_TRACE("Finding tracks");
 
-    // get module path
-    std::string modulePath;
-    modulePath.resize(MAX_PATH);
-    DWORD size = GetModuleFileName(
-        GetModuleHandle(NULL), &modulePath[0], modulePath.capacity());
-    modulePath.resize(size);
-
-    // remove module file from path
-    modulePath = modulePath.substr(0, modulePath.find_last_of('\\'));
+    readOrder(path, config);
 
-    // find files in music directory
-    std::string basePath = std::string(modulePath) + '\\' + path + '\\';
-    std::string findPath = basePath + "*.flac";
+    // the prefix alone gives the original "Track01.ogg" naming
+    std::string pattern = config.getString(
+        path.c_str(), "pattern", (prefix + "{track}*").c_str());
+    TrackPattern trackPattern(pattern);
 
-    WIN32_FIND_DATA fdata;
-    HANDLE hFind = FindFirstFile(findPath.c_str(), &fdata);
+    if (!trackPattern.isValid()) {
+        throw WinMMError(
+            "No {track} in the file name pattern: " + pattern, MCIERR_HARDWARE);
+    }
 
-    if (hFind == INVALID_HANDLE_VALUE) {
+    if (!FileSystem::exists(m_directory)) {
         throw WinMMError(
-            "Music directory not found: " + basePath, MCIERR_HARDWARE);
+            "Music directory not found: " + m_directory + PATH_SEPARATOR,
+            MCIERR_HARDWARE);
     }
 
-    int32_t numTracks = 0;
-    std::map<int32_t, CDTrack> tracks;
+    // the best file of each track on each disc
+    std::map<int32_t, std::map<int32_t, TrackFile>> discs;
+    scan(trackPattern, 0, m_directory, 1, discs);
 
-    do {
-        // skip directories
-        if (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-            continue;
-        }
+    for (auto& discPair : discs) {
+        m_discs.push_back(discPair.first);
+    }
 
-        std::string fileName = std::string(fdata.cFileName);
+    // disc 0 picks the first one there is
+    m_disc = config.getInt(path.c_str(), "disc", 0);
+    if (!m_disc && !discs.empty()) {
+        m_disc = discs.begin()->first;
+    }
 
-        // skip files with wrong prefix
-        if (fileName.substr(0, prefix.length()) != prefix) {
-            continue;
-        }
+    auto disc = discs.find(m_disc);
+    if (disc == discs.end()) {
+        throw WinMMError("No tracks matching " + pattern + " on disc " +
+                             std::to_string(m_disc) + " in " + m_directory,
+            MCIERR_HARDWARE);
+    }
 
-        std::string trackNumberStr = fileName.substr(5, 2);
-        int32_t trackNumber;
+    LOG_TRACE("Found %zu discs, playing disc %d", m_discs.size(), m_disc);
 
-        try {
-            trackNumber = std::stoi(trackNumberStr);
-        } catch (const std::exception&) {
-            // not a valid track number
-            continue;
-        }
+    int32_t numTracks = 0;
+    std::map<int32_t, CDTrack> tracks;
 
-        // skip track numbers that are out of range
-        if (trackNumber <= 0) {
-            continue;
-        }
+    // only the files that get played are opened
+    for (auto& filePair : disc->second) {
+        int32_t trackNumber = filePair.first;
+        const TrackFile& file = filePair.second;
 
         CDTrack track = {};
-        track.path = basePath + fileName;
-        track.format = player->GetFileFormat(track.path.c_str());
+        track.path = file.path;
+        track.codec = m_order[file.rank];
+        const std::string& codec = track.codec;
 
-        // skip files with unknown formats
-        if (track.format == sfUnknown) {
-            continue;
-        }
+        // open file to get the track length
+        Decoder* decoder = Decoder::create(codec);
 
-        // open file
-        if (!player->OpenFile(track.path.c_str(), track.format)) {
-            throw WinMMError(player->GetError(), MCIERR_HARDWARE);
-            continue;
+        try {
+            decoder->open(track.path);
+        } catch (...) {
+            delete decoder;
+            throw;
         }
 
-        // get track length
-        TStreamInfo info;
-        player->GetStreamInfo(&info);
+        uint32_t sampleRate = decoder->getSampleRate();
+        uint64_t length = decoder->getLength();
+        delete decoder;
 
-        track.length.seconds = info.Length.sec;
+        // lengths are kept in CD samples regardless of the file's rate
+        if (sampleRate > 0) {
+            track.length.samples =
+                static_cast<int32_t>(length * CD_SAMPLE_RATE / sampleRate);
+        }
 
-        // close file
-        if (!player->Close()) {
-            throw WinMMError(player->GetError(), MCIERR_HARDWARE);
-            continue;
+        // loop points are given in samples of the file
+        if (codec == "flac" && sampleRate > 0) {
+            FlacMetadata metadata(track.path);
+            int64_t loopStart = metadata.getInt("LOOPSTART", -1);
+            int64_t loopLength = metadata.getInt("LOOPLENGTH", -1);
+
+            if (loopStart >= 0 && loopLength > 0) {
+                track.loopStart = static_cast<int32_t>(
+                    loopStart * CD_SAMPLE_RATE / sampleRate);
+                track.loopLength = static_cast<int32_t>(
+                    loopLength * CD_SAMPLE_RATE / sampleRate);
+
+                LOG_TRACE("%s: loop %d+%d",
+                    track.path.c_str() + m_directory.size() + 1,
+                    track.loopStart, track.loopLength);
+            }
         }
 
-        TStreamHMSTime& time = info.Length.hms;
-        LOG_TRACE("%s: %02d:%02d:%02d.%03d", fileName.c_str(),
-            time.hour, time.minute, time.second, time.millisecond);
+#ifdef LOG_TRACE_ENABLED
+        // the file name below the music directory and its length
+        int32_t ms = static_cast<int32_t>(
+            static_cast<int64_t>(track.length.samples) * 1000 / CD_SAMPLE_RATE);
+        LOG_TRACE("%s: %02d:%02d:%02d.%03d",
+            track.path.c_str() + m_directory.size() + 1, ms / 3600000,
+            ms / 60000 % 60, ms / 1000 % 60, ms % 1000);
+#endif
 
         // put track into map
         tracks[trackNumber] = track;
 
         // update number of tracks
         numTracks = (std::max)(numTracks, trackNumber);
-    } while (FindNextFile(hFind, &fdata) != 0);
-
-    FindClose(hFind);
-    hFind = INVALID_HANDLE_VALUE;
+    }
 
     // data tracks are 2 seconds of silence
     CDTrack dataTrack = {};
-    dataTrack.length.seconds = 2;
+    dataTrack.length.samples = 2 * CD_SAMPLE_RATE;
 
     CDTime position = {};
 
@@ -120,22 +164,142 @@ CDTrackList::CDTrackList(
 
         position.track = i;
         track.position = position;
-        position.seconds += track.length.seconds;
+        position.samples += track.length.samples;
     }
 
     // copy temporary map to member map (CDTrack to const CDTrack)
     for (auto trackPair : tracks) {
         m_tracks.insert(trackPair);
+        m_gains[trackPair.first] = 1.0f;
     }
 
     LOG_TRACE("Found %d tracks", numTracks);
 }
 
+void CDTrackList::scan(const TrackPattern& pattern, size_t level,
+    const std::string& directory, int32_t disc,
+    std::map<int32_t, std::map<int32_t, TrackFile>>& discs)
+{
+    bool last = level + 1 == pattern.getDepth();
+
+    // only names starting with the literal text of the level, matched in
+    // place, only the best file of a track gets a path
+    FileSystem::list(directory, pattern.getPrefix(level),
+        [&](const char* name, bool isDirectory) {
+            // files on the last level, directories above it
+            if (isDirectory == last) {
+                return;
+            }
+
+            // the pattern doesn't cover the extension
+            const char* dot = last ? strrchr(name, '.') : nullptr;
+            size_t length = dot ? dot - name : strlen(name);
+
+            int32_t fileDisc = disc;
+            int32_t trackNumber = 0;
+            if (!pattern.match(level, name, length, fileDisc, trackNumber)) {
+                return;
+            }
+
+            if (!last) {
+                scan(pattern, level + 1, directory + PATH_SEPARATOR + name,
+                    fileDisc, discs);
+                return;
+            }
+
+            // skip track numbers that are out of range
+            if (trackNumber <= 0 || !dot) {
+                return;
+            }
+
+            // skip formats that aren't in the order, and files of a format
+            // that comes after one we already have
+            size_t rank = 0;
+            while (rank < m_order.size() &&
+                   !isExtension(dot + 1, m_order[rank])) {
+                rank++;
+            }
+
+            if (rank == m_order.size()) {
+                return;
+            }
+
+            std::map<int32_t, TrackFile>& files = discs[fileDisc];
+            auto file = files.find(trackNumber);
+            if (file != files.end() && file->second.rank <= rank) {
+                return;
+            }
+
+            TrackFile& best = files[trackNumber];
+            best.path = directory + PATH_SEPARATOR + name;
+            best.rank = rank;
+        });
+}
+
 const std::map<int32_t, const CDTrack>& CDTrackList::map()
 {
     return m_tracks;
 }
 
+int32_t CDTrackList::getDisc()
+{
+    return m_disc;
+}
+
+const std::vector<int32_t>& CDTrackList::getDiscs()
+{
+    return m_discs;
+}
+
+const std::string& CDTrackList::getName()
+{
+    return m_name;
+}
+
+const std::string& CDTrackList::getDirectory()
+{
+    return m_directory;
+}
+
+const std::vector<std::string>& CDTrackList::getOrder()
+{
+    return m_order;
+}
+
+void CDTrackList::readOrder(const std::string& section, Config& config)
+{
+    std::string defaultOrder;
+    for (const std::string& extension : Decoder::getExtensions()) {
+        defaultOrder += (defaultOrder.empty() ? "" : ",") + extension;
+    }
+
+    std::istringstream order(toLower(
+        config.getString(section.c_str(), "order", defaultOrder.c_str())));
+    std::string codec;
+
+    while (std::getline(order, codec, ',')) {
+        codec.erase(0, codec.find_first_not_of(" \t"));
+        codec.erase(codec.find_last_not_of(" \t") + 1);
+
+        if (codec.empty()) {
+            continue;
+        }
+
+        // a codec without decoder can't be played, drop it
+        Decoder* decoder = Decoder::create(codec);
+        if (!decoder) {
+            LOG_INFO("No decoder for %s files", codec.c_str());
+            continue;
+        }
+
+        delete decoder;
+        m_order.push_back(codec);
+    }
+
+    LOG_TRACE("Decoder order for %s: %s", section.c_str(),
+        order.str().c_str());
+}
+
 const CDTrack& CDTrackList::get(int32_t index)
 {
     if (isValid(index)) {
@@ -146,6 +310,21 @@ const CDTrack& CDTrackList::get(int32_t index)
     }
 }
 
+float CDTrackList::getGain(int32_t index)
+{
+    auto gain = m_gains.find(index);
+    return gain != m_gains.end() ? gain->second.load() : 1.0f;
+}
+
+void CDTrackList::setGain(int32_t index, float gain)
+{
+    // the map itself never changes after construction
+    auto entry = m_gains.find(index);
+    if (entry != m_gains.end()) {
+        entry->second = gain;
+    }
+}
+
 const CDTrack& CDTrackList::last()
 {
     return m_tracks.rbegin()->second;
@@ -163,17 +342,24 @@ bool CDTrackList::isAudio(int32_t index)
 
 void CDTrackList::toTrackTime(CDTime& time)
 {
-    for (auto trackPair : m_tracks) {
-        const CDTrack& track = trackPair.second;
-        if (track.position.seconds >= time.seconds) {
-            time.track = trackPair.first;
-            time.seconds = track.position.seconds - time.seconds;
-            return;
+    // find the last track that starts at or before the absolute time
+    for (auto trackPair = m_tracks.rbegin(); trackPair != m_tracks.rend();
+         ++trackPair) {
+        const CDTrack& track = trackPair->second;
+        if (track.position.samples <= time.samples) {
+            time.track = trackPair->first;
+            time.samples -= track.position.samples;
+
+            if (time.samples <= track.length.samples) {
+                return;
+            }
+
+            break;
         }
     }
 
     // offset is out of range, set length to last track length
     auto trackPair = m_tracks.rbegin();
     time.track = trackPair->first;
-    time.seconds = trackPair->second.length.seconds;
+    time.samples = trackPair->second.length.samples;
 }
\ No newline at end of file
@@ -1,35 +1,83 @@
 #pragma once
 
 #include "CDTime.hpp"
-#include "libzplay.h"
+#include "Config.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <map>
-
-using namespace libZPlay;
+#include <vector>
 
 struct CDTrack
 {
     std::string path;
-    TStreamFormat format;
+
+    // lower case file extension, selects the decoder
+    std::string codec;
     CDTime length;
     CDTime position;
+
+    // loop points in CD samples from the file's tags, no length means the
+    // track has none
+    int32_t loopStart;
+    int32_t loopLength;
 };
 
+class TrackPattern;
+
+// Tracks are files named after the prefix and the track number, or after the
+// TrackPattern in the "pattern" key of the section named after the directory.
+// Patterns with a disc number find several discs, the "disc" key picks the
+// one that plays, the first by default. If a track comes in several formats,
+// the first one in the directory's decoder order is used, which is read from
+// the "order" key.
 class CDTrackList
 {
 public:
     CDTrackList(
-        const std::string& path, const std::string& prefix, ZPlay* player);
+        const std::string& path, const std::string& prefix, Config& config);
     const std::map<int32_t, const CDTrack>& map();
+    const std::string& getName();
+    const std::string& getDirectory();
+    int32_t getDisc();
+
+    // all discs with tracks, in ascending order
+    const std::vector<int32_t>& getDiscs();
+    const std::vector<std::string>& getOrder();
     const CDTrack& get(int32_t index);
     const CDTrack& last();
     bool isValid(int32_t index);
     bool isAudio(int32_t index);
     void toTrackTime(CDTime& time);
 
+    // linear gain that levels the track's loudness, 1 until it is known
+    float getGain(int32_t index);
+    void setGain(int32_t index, float gain);
+
 private:
+    // a file found for a track, rank is its position in the decoder order
+    struct TrackFile
+    {
+        std::string path;
+        size_t rank;
+    };
+
+    std::string m_name;
+    std::string m_directory;
+    int32_t m_disc;
+    std::vector<int32_t> m_discs;
+    std::vector<std::string> m_order;
     std::map<int32_t, const CDTrack> m_tracks;
     CDTrack m_invalidTrack;
+
+    // set by the loudness scan while tracks play
+    std::map<int32_t, std::atomic<float>> m_gains;
+
+    void readOrder(const std::string& section, Config& config);
+
+    // finds the files matching the pattern from the given level down
+    void scan(const TrackPattern& pattern, size_t level,
+        const std::string& directory, int32_t disc,
+        std::map<int32_t, std::map<int32_t, TrackFile>>& discs);
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Config.hpp"
+#include "FileSystem.hpp"
+
+#include <Windows.h>
+
+#include <cstdlib>
+
+#define CONFIG_FILE "zplaymm.ini"
+
+static std::string gameDirectory;
+
+Config::Config()
+    : m_path(getGameDirectory() + PATH_SEPARATOR + CONFIG_FILE)
+{
+}
+
+std::string Config::getString(
+    const char* section, const char* key, const char* defaultValue)
+{
+    const std::string* override = findOverride(section, key);
+    if (override) {
+        return *override;
+    }
+
+    std::string value;
+    value.resize(MAX_PATH);
+    DWORD size = GetPrivateProfileStringA(section, key, defaultValue,
+        &value[0], static_cast<DWORD>(value.capacity()), m_path.c_str());
+    value.resize(size);
+    return value;
+}
+
+int32_t Config::getInt(
+    const char* section, const char* key, int32_t defaultValue)
+{
+    const std::string* override = findOverride(section, key);
+    if (override) {
+        return atoi(override->c_str());
+    }
+
+    return static_cast<int32_t>(
+        GetPrivateProfileIntA(section, key, defaultValue, m_path.c_str()));
+}
+
+bool Config::getBool(const char* section, const char* key, bool defaultValue)
+{
+    return getInt(section, key, defaultValue ? 1 : 0) != 0;
+}
+
+void Config::set(
+    const char* section, const char* key, const std::string& value)
+{
+    m_overrides[std::string(section) + '.' + key] = value;
+}
+
+const std::string* Config::findOverride(const char* section, const char* key)
+{
+    if (m_overrides.empty()) {
+        return nullptr;
+    }
+
+    auto it = m_overrides.find(std::string(section) + '.' + key);
+    return it != m_overrides.end() ? &it->second : nullptr;
+}
+
+std::string Config::getGameDirectory()
+{
+    if (!gameDirectory.empty()) {
+        return gameDirectory;
+    }
+
+    return FileSystem::getModuleDirectory();
+}
+
+void Config::setGameDirectory(const std::string& directory)
+{
+    gameDirectory = directory;
+}
\ No newline at end of file
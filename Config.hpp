@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Settings read from zplaymm.ini in the game directory. Missing files or
+// keys fall back to the given defaults.
+class Config
+{
+public:
+    Config();
+    std::string getString(
+        const char* section, const char* key, const char* defaultValue);
+    int32_t getInt(const char* section, const char* key, int32_t defaultValue);
+    bool getBool(const char* section, const char* key, bool defaultValue);
+
+    // takes precedence over the file, for tools that need a fixed setup
+    void set(const char* section, const char* key, const std::string& value);
+
+    // The directory of the executable unless set. Configs created
+    // afterwards read the file in the new directory.
+    static std::string getGameDirectory();
+    static void setGameDirectory(const std::string& directory);
+
+private:
+    std::string m_path;
+    std::map<std::string, std::string> m_overrides;
+
+    const std::string* findOverride(const char* section, const char* key);
+};
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "CoreBenchmark.hpp"
+#include "FileSystem.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#ifdef _WIN32
+#include "WinMM.hpp"
+#endif
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+// minimum time spent on each run
+#define BENCHMARK_SECONDS 0.5
+
+// length of each synthetic track
+#define TRACK_SECONDS 1
+
+// disc times mapped per batch
+#define TIME_BATCH 1024
+
+static double getSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static void writeLE(FILE* file, uint32_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        fputc((value >> (i * 8)) & 0xFF, file);
+    }
+}
+
+// a second of CD audio silence
+static bool writeWav(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t dataSize = TRACK_SECONDS * CD_SAMPLE_RATE * 4;
+
+    fwrite("RIFF", 1, 4, file);
+    writeLE(file, 36 + dataSize, 4);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeLE(file, 16, 4);
+    writeLE(file, 1, 2);
+    writeLE(file, 2, 2);
+    writeLE(file, CD_SAMPLE_RATE, 4);
+    writeLE(file, CD_SAMPLE_RATE * 4, 4);
+    writeLE(file, 4, 2);
+    writeLE(file, 16, 2);
+    fwrite("data", 1, 4, file);
+    writeLE(file, dataSize, 4);
+
+    std::vector<uint8_t> silence(dataSize);
+    bool written = fwrite(silence.data(), 1, dataSize, file) == dataSize;
+    return fclose(file) == 0 && written;
+}
+
+// disc positions spread over the whole soundtrack, reproducibly
+static std::vector<int32_t> getRandomSamples(int32_t length)
+{
+    std::vector<int32_t> samples(TIME_BATCH);
+    uint32_t random = 0x12345678;
+    for (int32_t& sample : samples) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        sample = static_cast<int32_t>(random % static_cast<uint32_t>(length));
+    }
+    return samples;
+}
+
+CoreBenchmark::CoreBenchmark(Config& config, const std::string& directory,
+    int32_t tracks, WinMM* winmm)
+    : m_config(config)
+    , m_winmm(winmm)
+    , m_directory(directory)
+    , m_tracks(tracks)
+    , m_sink(0)
+{
+}
+
+bool CoreBenchmark::run(const std::string& reportPath)
+{
+    if (!writeTracks(m_directory, m_tracks)) {
+        LOG_INFO("Can't write the benchmark tracks to %s",
+            m_directory.c_str());
+        return false;
+    }
+
+    LOG_INFO("Benchmarking the playback core with %d tracks", m_tracks);
+
+    try {
+        benchmarkTrackList();
+        benchmarkTimeFormats();
+
+#ifdef _WIN32
+        if (m_winmm) {
+            benchmarkOpen();
+
+            MCIDEVICEID deviceID = open();
+            benchmarkStatus(deviceID, 1);
+            benchmarkStatus(deviceID, 4);
+            benchmarkCycles(deviceID);
+            close(deviceID);
+        }
+#endif
+    } catch (const WinMMError& ex) {
+        LOG_INFO("Benchmark failed: %s (%s)", ex.what(), ex.getErrorName());
+        return false;
+    }
+
+    writeReport(reportPath);
+    return true;
+}
+
+template <typename Function>
+void CoreBenchmark::measure(
+    const std::string& name, int32_t batch, Function function)
+{
+    Run run = {};
+    run.name = name;
+
+    double start = getSeconds();
+    double now = start;
+    do {
+        double before = now;
+        function();
+        now = getSeconds();
+
+        run.calls += batch;
+        run.maxSeconds = (std::max)(run.maxSeconds, (now - before) / batch);
+    } while (now - start < BENCHMARK_SECONDS);
+
+    run.seconds = now - start;
+    m_runs.push_back(run);
+}
+
+bool CoreBenchmark::writeTracks(const std::string& directory, int32_t tracks)
+{
+    std::string music = directory + PATH_SEPARATOR + "music";
+    if (!FileSystem::createDirectory(music)) {
+        return false;
+    }
+
+    for (int32_t i = 2; i <= tracks; i++) {
+        char name[32];
+        sprintf_s(name, sizeof(name), "Track%02d.wav", i);
+        if (!writeWav(music + PATH_SEPARATOR + name)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CoreBenchmark::benchmarkTrackList()
+{
+    measure("track list", 1,
+        [this] { CDTrackList("music", "Track", m_config); });
+
+    CDTrackList tracks("music", "Track", m_config);
+    const CDTrack& last = tracks.last();
+    std::vector<int32_t> samples =
+        getRandomSamples(last.position.samples + last.length.samples);
+
+    measure("toTrackTime", TIME_BATCH, [this, &tracks, &samples] {
+        for (int32_t sample : samples) {
+            CDTime time = {0, sample};
+            tracks.toTrackTime(time);
+            m_sink = m_sink + time.track;
+        }
+    });
+}
+
+void CoreBenchmark::benchmarkTimeFormats()
+{
+    static const struct
+    {
+        int32_t format;
+        const char* name;
+    } formats[] = {
+        {MCI_FORMAT_MILLISECONDS, "ms"},
+        {MCI_FORMAT_MSF, "msf"},
+        {MCI_FORMAT_TMSF, "tmsf"},
+        {MCI_FORMAT_FRAMES, "frames"},
+        {MCI_FORMAT_SAMPLES, "samples"},
+    };
+
+    std::vector<int32_t> samples = getRandomSamples(74 * 60 * CD_SAMPLE_RATE);
+
+    for (const auto& format : formats) {
+        const CDTimeFormat* timeFormat = CDTimeFormat::get(format.format);
+
+        // a round trip per call
+        measure(std::string("time format ") + format.name, TIME_BATCH,
+            [this, timeFormat, &samples] {
+                for (int32_t sample : samples) {
+                    CDTime time = {1, sample};
+                    time = timeFormat->decode(timeFormat->encode(time));
+                    m_sink = m_sink + time.samples;
+                }
+            });
+    }
+}
+
+void CoreBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return;
+    }
+
+    fprintf(file, "benchmark\tcalls\tns/call\tmax ns\n");
+
+    for (const Run& run : m_runs) {
+        double ns = run.calls > 0 ? run.seconds * 1e9 / run.calls : 0.0;
+        fprintf(file, "%s\t%.0f\t%.1f\t%.1f\n", run.name.c_str(), run.calls,
+            ns, run.maxSeconds * 1e9);
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked the playback core, see %s", reportPath.c_str());
+}
+
+#ifdef _WIN32
+
+MCIDEVICEID CoreBenchmark::open()
+{
+    MCI_OPEN_PARMSA parms = {};
+    parms.lpstrDeviceType = "cdaudio";
+
+    MCIERROR result = m_winmm->mciSendCommandA(0, MCI_OPEN, MCI_OPEN_TYPE,
+        reinterpret_cast<DWORD_PTR>(&parms));
+    if (result) {
+        throw WinMMError("Can't open the benchmark device", result);
+    }
+
+    return parms.wDeviceID;
+}
+
+void CoreBenchmark::close(MCIDEVICEID deviceID)
+{
+    m_winmm->mciSendCommandA(deviceID, MCI_CLOSE, 0, 0);
+}
+
+void CoreBenchmark::benchmarkOpen()
+{
+    // scans the soundtrack and starts the player threads
+    measure("open/close", 1, [this] { close(open()); });
+}
+
+void CoreBenchmark::benchmarkStatus(MCIDEVICEID deviceID, int32_t threads)
+{
+    // the exports serialize the player's commands behind one lock
+    std::mutex mutex;
+
+    auto poll = [this, deviceID, &mutex] {
+        MCI_STATUS_PARMS parms = {};
+        parms.dwItem = MCI_STATUS_POSITION;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        m_winmm->mciSendCommandA(deviceID, MCI_STATUS, MCI_STATUS_ITEM,
+            reinterpret_cast<DWORD_PTR>(&parms));
+    };
+
+    // games poll while the music plays
+    MCI_PLAY_PARMS play = {};
+    m_winmm->mciSendCommandA(
+        deviceID, MCI_PLAY, 0, reinterpret_cast<DWORD_PTR>(&play));
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> pollers;
+    for (int32_t i = 1; i < threads; i++) {
+        pollers.emplace_back([&done, &poll] {
+            while (!done) {
+                poll();
+            }
+        });
+    }
+
+    measure("status poll, " + std::to_string(threads) + " threads", 1, poll);
+
+    done = true;
+    for (std::thread& poller : pollers) {
+        poller.join();
+    }
+
+    m_winmm->mciSendCommandA(deviceID, MCI_STOP, 0, 0);
+}
+
+void CoreBenchmark::benchmarkCycles(MCIDEVICEID deviceID)
+{
+    MCI_SET_PARMS set = {};
+    set.dwTimeFormat = MCI_FORMAT_TMSF;
+    m_winmm->mciSendCommandA(deviceID, MCI_SET, MCI_SET_TIME_FORMAT,
+        reinterpret_cast<DWORD_PTR>(&set));
+
+    // through all audio tracks, to the middle of the next one and back
+    int32_t track = 2;
+    measure("play/seek/stop", 1, [this, deviceID, &track] {
+        int32_t next = track < m_tracks ? track + 1 : 2;
+
+        MCI_PLAY_PARMS play = {};
+        play.dwFrom = MCI_MAKE_TMSF(track, 0, 0, 0);
+        m_winmm->mciSendCommandA(deviceID, MCI_PLAY, MCI_FROM,
+            reinterpret_cast<DWORD_PTR>(&play));
+
+        MCI_SEEK_PARMS seek = {};
+        seek.dwTo = MCI_MAKE_TMSF(next, 0, 0, CD_FRAMES_PER_SECOND / 2);
+        m_winmm->mciSendCommandA(deviceID, MCI_SEEK, MCI_TO,
+            reinterpret_cast<DWORD_PTR>(&seek));
+
+        m_winmm->mciSendCommandA(deviceID, MCI_STOP, 0, 0);
+        track = next;
+    });
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CDTrackList.hpp"
+#include "Config.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WinMM;
+
+// Times the playback core on a soundtrack of synthetic tracks: opening the
+// device, building the track list, mapping disc times to track times, the
+// time format codecs, status polls with and without other threads polling,
+// and play/seek/stop cycles. Writes the calls, nanoseconds per call and the
+// slowest call of each run as a TSV file.
+class CoreBenchmark
+{
+public:
+    // The directory should be the game directory, the tracks are written to
+    // the music directory in it. The MCI runs need a WinMM set up for the
+    // null output, without one only the track list and the time formats
+    // are timed.
+    CoreBenchmark(Config& config, const std::string& directory,
+        int32_t tracks, WinMM* winmm = nullptr);
+
+    // false if the tracks can't be written or the device fails
+    bool run(const std::string& reportPath);
+
+    // Writes tracks 2 to the last one as a second of silence each to the
+    // music directory in the directory, track 1 becomes a data track.
+    static bool writeTracks(const std::string& directory, int32_t tracks);
+
+private:
+    struct Run
+    {
+        std::string name;
+        double calls;
+        double seconds;
+        double maxSeconds;
+    };
+
+    Config& m_config;
+    WinMM* m_winmm;
+    std::string m_directory;
+    int32_t m_tracks;
+    std::vector<Run> m_runs;
+    volatile int32_t m_sink;
+
+    // runs the function until the time is up, it makes batch calls each time
+    template <typename Function>
+    void measure(const std::string& name, int32_t batch, Function function);
+
+    void benchmarkTrackList();
+    void benchmarkTimeFormats();
+    void writeReport(const std::string& reportPath);
+
+#ifdef _WIN32
+    MCIDEVICEID open();
+    void close(MCIDEVICEID deviceID);
+    void benchmarkOpen();
+    void benchmarkStatus(MCIDEVICEID deviceID, int32_t threads);
+    void benchmarkCycles(MCIDEVICEID deviceID);
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Decoder.hpp"
+#include "FlacDecoder.hpp"
+#include "Logger.hpp"
+#include "VorbisDecoder.hpp"
+#include "WavDecoder.hpp"
+
+#ifndef NO_LIBZPLAY
+#include "ZPlayDecoder.hpp"
+#endif
+
+Decoder::Decoder()
+    : m_sampleRate(0)
+    , m_channels(0)
+    , m_length(0)
+    , m_stats({})
+{
+}
+
+Decoder::~Decoder()
+{
+}
+
+uint32_t Decoder::getSampleRate()
+{
+    return m_sampleRate;
+}
+
+uint32_t Decoder::getChannels()
+{
+    return m_channels;
+}
+
+uint64_t Decoder::getLength()
+{
+    return m_length;
+}
+
+void Decoder::setPool(WorkerPool*)
+{
+}
+
+const DecoderStats& Decoder::getStats()
+{
+    return m_stats;
+}
+
+Decoder* Decoder::create(const std::string& extension)
+{
+    if (extension == "wav") {
+        return new WavDecoder();
+    }
+
+    if (extension == "flac") {
+        return new FlacDecoder();
+    }
+
+    // native in every build, so x64 plays the same ogg files as x86
+    if (extension == "ogg") {
+        return new VorbisDecoder();
+    }
+
+#ifndef NO_LIBZPLAY
+    if (extension == "mp3") {
+        return new ZPlayDecoder(sfMp3, "mp3");
+    }
+#endif
+
+    // Opus is left out on purpose. It needs SILK, CELT and their hybrid
+    // mode, several times the code of the Vorbis decoder, and libopus can't
+    // be linked into both DLLs. The games shipped Vorbis, so opus tracks are
+    // reported by the track list and the decoder benchmark, not played.
+    return nullptr;
+}
+
+const std::vector<std::string>& Decoder::getExtensions()
+{
+    // also the default decoder order
+#ifndef NO_LIBZPLAY
+    static const std::vector<std::string> extensions = {
+        "flac", "ogg", "mp3", "wav"};
+#else
+    // there is no 64-bit libzplay to decode mp3
+    static const std::vector<std::string> extensions = {
+        "flac", "ogg", "wav"};
+#endif
+    return extensions;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+// what decoding a file has cost so far
+struct DecoderStats
+{
+    // decoded frames
+    uint64_t frames;
+
+    // bytes read from the file
+    uint64_t bytesRead;
+
+    // time spent decoding, including the reads
+    double seconds;
+};
+
+// Decodes an audio file to interleaved 16 bit stereo, pulled by the caller.
+// open() throws WinMMError if the file can't be decoded.
+class Decoder
+{
+public:
+    Decoder();
+    virtual ~Decoder();
+
+    virtual void open(const std::string& path) = 0;
+
+    // Decodes up to the given number of frames, returns the number of frames
+    // decoded or 0 at the end of the file.
+    virtual size_t read(int16_t* buffer, size_t frames) = 0;
+
+    // moves to the given frame, the next read starts there
+    virtual void seek(uint64_t frame) = 0;
+
+    // short codec name as used in the decoder order
+    virtual const char* getName() = 0;
+
+    // threads the decoder may use to decode ahead, ignored by default
+    virtual void setPool(WorkerPool* pool);
+
+    uint32_t getSampleRate();
+    uint32_t getChannels();
+    uint64_t getLength();
+    const DecoderStats& getStats();
+
+    // Creates the decoder for the file extension, nullptr if there is none.
+    // Pass the lower case extension without dot.
+    static Decoder* create(const std::string& extension);
+    static const std::vector<std::string>& getExtensions();
+
+protected:
+    uint32_t m_sampleRate;
+    uint32_t m_channels;
+    uint64_t m_length;
+    DecoderStats m_stats;
+};
\ No newline at end of file
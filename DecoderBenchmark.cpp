@@ -0,0 +1,113 @@
+#include "DecoderBenchmark.hpp"
+#include "Decoder.hpp"
+#include "FileSystem.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <stdio.h>
+
+// number of frames decoded at once
+#define BENCHMARK_BLOCK_FRAMES 4096
+
+// the formats tracks may come in, those this build has no decoder for are
+// counted as failed
+static const char* const CODECS[] = {"flac", "ogg", "opus", "mp3", "wav"};
+
+DecoderBenchmark::DecoderBenchmark(CDTrackList& tracks)
+{
+    // every encoding of the audio tracks next to the one that gets played
+    for (auto& trackPair : tracks.map()) {
+        const std::string& path = trackPair.second.path;
+        if (path.empty()) {
+            continue;
+        }
+
+        std::string stem = path.substr(0, path.rfind('.') + 1);
+
+        for (const char* codec : CODECS) {
+            File file = {stem + codec, codec};
+            if (FileSystem::exists(file.path)) {
+                m_files.push_back(file);
+            }
+        }
+    }
+}
+
+bool DecoderBenchmark::run(const std::string& reportPath)
+{
+    LOG_INFO("Benchmarking %zu files", m_files.size());
+
+    for (const File& file : m_files) {
+        measure(file);
+    }
+
+    return writeReport(reportPath);
+}
+
+void DecoderBenchmark::measure(const File& file)
+{
+    Totals& totals = m_totals[file.codec];
+    totals.files++;
+
+    Decoder* decoder = Decoder::create(file.codec);
+    if (!decoder) {
+        LOG_INFO("No decoder for %s", file.path.c_str());
+        totals.failed++;
+        return;
+    }
+
+    try {
+        decoder->open(file.path);
+
+        std::vector<int16_t> buffer(BENCHMARK_BLOCK_FRAMES * 2);
+        while (decoder->read(&buffer[0], BENCHMARK_BLOCK_FRAMES)) {
+        }
+
+        const DecoderStats& stats = decoder->getStats();
+        if (decoder->getSampleRate()) {
+            totals.audio +=
+                static_cast<double>(stats.frames) / decoder->getSampleRate();
+        }
+
+        totals.seconds += stats.seconds;
+        totals.bytesRead += stats.bytesRead;
+    } catch (const WinMMError& ex) {
+        LOG_INFO("%s: %s", file.path.c_str(), ex.what());
+        totals.failed++;
+    }
+
+    delete decoder;
+}
+
+bool DecoderBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return false;
+    }
+
+    fprintf(file, "codec\tfiles\tfailed\taudio\tdecode/min\tread/min\tspeed\n");
+
+    for (auto& totalsPair : m_totals) {
+        const Totals& totals = totalsPair.second;
+        double minutes = totals.audio / 60;
+
+        if (minutes <= 0) {
+            fprintf(file, "%s\t%u\t%u\t-\t-\t-\t-\n", totalsPair.first.c_str(),
+                totals.files, totals.failed);
+            continue;
+        }
+
+        fprintf(file, "%s\t%u\t%u\t%.1f min\t%.3f s\t%.2f MB\t%.1fx\n",
+            totalsPair.first.c_str(), totals.files, totals.failed, minutes,
+            totals.seconds / minutes, totals.bytesRead / minutes / 1e6,
+            totals.seconds > 0 ? totals.audio / totals.seconds : 0.0);
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked %zu codecs, see %s", m_totals.size(),
+        reportPath.c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CDTrackList.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Decodes each track once in every format it's available in and writes the
+// decode time and the bytes read per minute of audio for each codec. Runs
+// one file at a time, so the codecs don't compete for the disk. Files in a
+// format without decoder, like opus, are listed as failed.
+class DecoderBenchmark
+{
+public:
+    explicit DecoderBenchmark(CDTrackList& tracks);
+
+    // false if the report can't be written
+    bool run(const std::string& reportPath);
+
+private:
+    struct File
+    {
+        std::string path;
+        std::string codec;
+    };
+
+    struct Totals
+    {
+        uint32_t files;
+        uint32_t failed;
+        double audio;
+        double seconds;
+        uint64_t bytesRead;
+    };
+
+    std::vector<File> m_files;
+    std::map<std::string, Totals> m_totals;
+
+    void measure(const File& file);
+    bool writeReport(const std::string& reportPath);
+};
\ No newline at end of file
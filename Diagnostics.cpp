@@ -0,0 +1,223 @@
+#include "Diagnostics.hpp"
+#include "Logger.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+static const char* const ITEM_NAMES[] = {"state", "track", "buffered",
+    "decoded", "decode-us", "underruns", "opens", "open-us", "open-max-us",
+    "restarts", "restart-us", "restart-max-us", "seeks", "seek-us",
+    "seek-max-us", "predictions", "prediction-hits", "prefetch-hits"};
+
+static const char* const STATE_NAMES[] = {
+    "closed", "stopped", "playing", "paused"};
+
+static_assert(sizeof(ITEM_NAMES) / sizeof(ITEM_NAMES[0]) == DiagCount,
+    "Diagnostics item names don't match the items!");
+
+// a snapshot is well below this
+#define PIPE_BUFFER_SIZE 1024
+
+Diagnostics::Diagnostics()
+{
+    for (std::atomic<uint64_t>& item : m_items) {
+        item = 0;
+    }
+}
+
+void Diagnostics::set(DiagnosticsItem item, uint64_t value)
+{
+    m_items[item] = value;
+}
+
+void Diagnostics::add(DiagnosticsItem item, uint64_t value)
+{
+    m_items[item] += value;
+}
+
+uint64_t Diagnostics::get(DiagnosticsItem item)
+{
+    return m_items[item];
+}
+
+void Diagnostics::addLatency(DiagnosticsItem count, int64_t nanoseconds)
+{
+    uint64_t us = static_cast<uint64_t>(nanoseconds > 0 ? nanoseconds : 0) /
+                  1000;
+
+    m_items[count]++;
+    m_items[count + 1] += us;
+
+    // only the thread that raises the maximum writes it
+    std::atomic<uint64_t>& max = m_items[count + 2];
+    uint64_t previous = max;
+    while (us > previous && !max.compare_exchange_weak(previous, us)) {
+    }
+}
+
+bool Diagnostics::findItem(const char* name, DiagnosticsItem& item)
+{
+    for (int32_t i = 0; i < DiagCount; i++) {
+        if (!_stricmp(name, ITEM_NAMES[i])) {
+            item = static_cast<DiagnosticsItem>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Diagnostics::format(char* buffer, size_t size)
+{
+    size_t length = 0;
+
+    for (int32_t i = 0; i < DiagCount; i++) {
+        char value[32];
+        format(static_cast<DiagnosticsItem>(i), value, sizeof(value));
+
+        int written = _snprintf_s(buffer + length, size - length, _TRUNCATE,
+            "%s%s=%s", i ? " " : "", ITEM_NAMES[i], value);
+        if (written < 0) {
+            buffer[0] = '\0';
+            return false;
+        }
+        length += written;
+    }
+
+    return true;
+}
+
+bool Diagnostics::format(DiagnosticsItem item, char* buffer, size_t size)
+{
+    uint64_t value = m_items[item];
+
+    if (item == DiagState && value <= StatePaused) {
+        return _snprintf_s(
+                   buffer, size, _TRUNCATE, "%s", STATE_NAMES[value]) >= 0;
+    }
+
+    return _snprintf_s(buffer, size, _TRUNCATE, "%llu",
+               static_cast<unsigned long long>(value)) >= 0;
+}
+
+DiagnosticsPipe::DiagnosticsPipe()
+    : m_diagnostics(nullptr)
+    , m_stop(nullptr)
+{
+}
+
+DiagnosticsPipe::~DiagnosticsPipe()
+{
+    stop();
+}
+
+void DiagnosticsPipe::start(Diagnostics& diagnostics, Config& config)
+{
+    // [diagnostics]
+    // pipe = 1 to serve the counters to other processes
+    if (m_thread.joinable() || !config.getBool("diagnostics", "pipe", false)) {
+        return;
+    }
+
+    m_stop = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!m_stop) {
+        LOG_INFO("Can't create the diagnostics stop event");
+        return;
+    }
+
+    m_diagnostics = &diagnostics;
+    m_name = "\\\\.\\pipe\\zplaymm-" + std::to_string(GetCurrentProcessId());
+    m_thread = std::thread(&DiagnosticsPipe::run, this);
+
+    LOG_INFO("Serving diagnostics on %s", m_name.c_str());
+}
+
+void DiagnosticsPipe::stop()
+{
+    // at process exit the system has ended the thread already, so the join
+    // returns right away
+    if (m_thread.joinable()) {
+        SetEvent(m_stop);
+        m_thread.join();
+    }
+
+    if (m_stop) {
+        CloseHandle(m_stop);
+        m_stop = nullptr;
+    }
+}
+
+void DiagnosticsPipe::run()
+{
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!overlapped.hEvent) {
+        LOG_INFO("Can't create the diagnostics pipe event");
+        return;
+    }
+
+    while (WaitForSingleObject(m_stop, 0) == WAIT_TIMEOUT) {
+        HANDLE pipe = CreateNamedPipe(m_name.c_str(),
+            PIPE_ACCESS_OUTBOUND | FILE_FLAG_OVERLAPPED,
+            PIPE_TYPE_BYTE | PIPE_WAIT, 1, PIPE_BUFFER_SIZE, 0, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            LOG_INFO("Can't create %s", m_name.c_str());
+            break;
+        }
+
+        serve(pipe, overlapped);
+
+        // Closing instead of disconnecting leaves the snapshot readable, so
+        // nothing waits for a client that doesn't read it.
+        CloseHandle(pipe);
+    }
+
+    CloseHandle(overlapped.hEvent);
+}
+
+void DiagnosticsPipe::serve(HANDLE pipe, OVERLAPPED& overlapped)
+{
+    // a client that connected before the wait is fine as well
+    ResetEvent(overlapped.hEvent);
+    if (!ConnectNamedPipe(pipe, &overlapped)) {
+        DWORD error = GetLastError();
+        if (error == ERROR_IO_PENDING) {
+            if (!complete(pipe, overlapped)) {
+                return;
+            }
+        } else if (error != ERROR_PIPE_CONNECTED) {
+            return;
+        }
+    }
+
+    char snapshot[PIPE_BUFFER_SIZE];
+    m_diagnostics->format(snapshot, sizeof(snapshot) - 1);
+    strcat_s(snapshot, sizeof(snapshot), "\n");
+
+    // the snapshot fits into the pipe's buffer, so the write normally
+    // completes without the client reading
+    ResetEvent(overlapped.hEvent);
+    if (!WriteFile(pipe, snapshot, static_cast<DWORD>(strlen(snapshot)),
+            nullptr, &overlapped) &&
+        GetLastError() == ERROR_IO_PENDING) {
+        complete(pipe, overlapped);
+    }
+}
+
+bool DiagnosticsPipe::complete(HANDLE pipe, OVERLAPPED& overlapped)
+{
+    HANDLE events[] = {m_stop, overlapped.hEvent};
+    DWORD transferred;
+
+    if (WaitForMultipleObjects(2, events, FALSE, INFINITE) !=
+        WAIT_OBJECT_0 + 1) {
+        // stopped, the operation must be over before the pipe is closed
+        CancelIo(pipe);
+        GetOverlappedResult(pipe, &overlapped, &transferred, TRUE);
+        return false;
+    }
+
+    return GetOverlappedResult(pipe, &overlapped, &transferred, FALSE) != 0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <Windows.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Vendor MCI_STATUS items, MCI_STATUS_ZPLAYMM + a DiagnosticsItem returns
+// that counter in dwReturn.
+#define MCI_STATUS_ZPLAYMM 0x5A500000
+
+enum DiagnosticsItem
+{
+    // a DiagnosticsState
+    DiagState,
+    // track the feeder decodes and frames queued for the mixer
+    DiagTrack,
+    DiagBuffered,
+    // decoded frames and the microseconds spent decoding them
+    DiagDecoded,
+    DiagDecodeUs,
+    // mixer reads the feeder didn't keep up with
+    DiagUnderruns,
+    // each latency is a count, the total and the maximum in microseconds
+    DiagOpens,
+    DiagOpenUs,
+    DiagOpenMaxUs,
+    DiagRestarts,
+    DiagRestartUs,
+    DiagRestartMaxUs,
+    DiagSeeks,
+    DiagSeekUs,
+    DiagSeekMaxUs,
+    // predictions of the next track, how many hit and were prefetched
+    DiagPredictions,
+    DiagPredictionHits,
+    DiagPrefetchHits,
+    DiagCount
+};
+
+enum DiagnosticsState
+{
+    StateClosed,
+    StateStopped,
+    StatePlaying,
+    StatePaused
+};
+
+// Counters of the player for the stats queries. They are atomic, so the
+// queries read them without the lock the commands hold. WinMM owns them,
+// so that they outlive the players, the counts add up over all opens.
+class Diagnostics
+{
+public:
+    Diagnostics();
+
+    void set(DiagnosticsItem item, uint64_t value);
+    void add(DiagnosticsItem item, uint64_t value);
+    uint64_t get(DiagnosticsItem item);
+
+    // counts a latency for one of DiagOpens, DiagRestarts or DiagSeeks
+    void addLatency(DiagnosticsItem count, int64_t nanoseconds);
+
+    // false if the name isn't an item
+    static bool findItem(const char* name, DiagnosticsItem& item);
+
+    // "name=value" pairs of all items separated by spaces, false if they
+    // don't fit
+    bool format(char* buffer, size_t size);
+    // the value of one item, the state by name
+    bool format(DiagnosticsItem item, char* buffer, size_t size);
+
+private:
+    std::atomic<uint64_t> m_items[DiagCount];
+};
+
+// Serves the formatted counters on \\.\pipe\zplaymm-<process ID>, one
+// snapshot per connection, if [diagnostics] pipe is set. Clients are waited
+// for with overlapped I/O, so that the thread can be stopped.
+class DiagnosticsPipe
+{
+public:
+    DiagnosticsPipe();
+
+    // stops the thread, the counters must still be there
+    ~DiagnosticsPipe();
+
+    void start(Diagnostics& diagnostics, Config& config);
+    void stop();
+
+private:
+    Diagnostics* m_diagnostics;
+    std::string m_name;
+    HANDLE m_stop;
+    std::thread m_thread;
+
+    void run();
+    void serve(HANDLE pipe, OVERLAPPED& overlapped);
+
+    // waits for the pending operation, false if it failed or the pipe was
+    // stopped, which cancels it
+    bool complete(HANDLE pipe, OVERLAPPED& overlapped);
+};
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "ErrorBenchmark.hpp"
+#include "CoreBenchmark.hpp"
+#include "Logger.hpp"
+#include "WinMM.hpp"
+#include "WinMMError.hpp"
+
+#include <Windows.h>
+
+#include <chrono>
+#include <stdio.h>
+
+// minimum time spent on each path
+#define BENCHMARK_SECONDS 0.5
+
+// calls between two looks at the clock
+#define BENCHMARK_BATCH 1000
+
+// tracks of the soundtrack the device plays from
+#define BENCHMARK_TRACKS 10
+
+static double getSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// the track count a game probes against, volatile so the checks stay
+static volatile int32_t numTracks = 0;
+
+static __declspec(noinline) void playThrowing(int32_t track)
+{
+    if (track > numTracks) {
+        throw WinMMError(MCIERR_OUTOFRANGE);
+    }
+}
+
+static __declspec(noinline) MCIERROR playReturning(int32_t track)
+{
+    if (track > numTracks) {
+        return MCIERR_OUTOFRANGE;
+    }
+    return MMSYSERR_NOERROR;
+}
+
+// the handler the wrappers use, without the logging
+static MCIERROR handleException()
+{
+    try {
+        throw;
+    } catch (const WinMMError& ex) {
+        return ex.getErrorCode();
+    }
+}
+
+static MCIERROR sendThrowing(int32_t track)
+{
+    try {
+        playThrowing(track);
+        return MMSYSERR_NOERROR;
+    } catch (...) {
+        return handleException();
+    }
+}
+
+static MCIERROR sendReturning(int32_t track)
+{
+    try {
+        return playReturning(track);
+    } catch (...) {
+        return handleException();
+    }
+}
+
+ErrorBenchmark::ErrorBenchmark(WinMM& winmm, const std::string& directory)
+    : m_winmm(winmm)
+    , m_directory(directory)
+{
+}
+
+bool ErrorBenchmark::run(const std::string& reportPath)
+{
+    if (!CoreBenchmark::writeTracks(m_directory, BENCHMARK_TRACKS)) {
+        LOG_INFO("Can't write the benchmark tracks to %s",
+            m_directory.c_str());
+        return false;
+    }
+
+    LOG_INFO("Benchmarking MCI error paths");
+
+    try {
+        benchmarkPlay();
+    } catch (const WinMMError& ex) {
+        LOG_INFO("Benchmark failed: %s (%s)", ex.what(), ex.getErrorName());
+        return false;
+    }
+
+    measure("thrown", sendThrowing);
+    measure("returned", sendReturning);
+
+    return writeReport(reportPath);
+}
+
+template <typename Send>
+void ErrorBenchmark::measure(const std::string& path, Send send)
+{
+    Run run = {};
+    run.path = path;
+
+    uint32_t refused = 0;
+    double start = getSeconds();
+    do {
+        for (int32_t i = 0; i < BENCHMARK_BATCH; i++) {
+            refused += send(i + 1) == MCIERR_OUTOFRANGE;
+        }
+        run.calls += BENCHMARK_BATCH;
+        run.seconds = getSeconds() - start;
+    } while (run.seconds < BENCHMARK_SECONDS);
+
+    if (refused != run.calls) {
+        LOG_INFO("The %s path accepted a probe", run.path.c_str());
+    }
+
+    m_runs.push_back(run);
+}
+
+void ErrorBenchmark::benchmarkPlay()
+{
+    MCI_OPEN_PARMSA open = {};
+    open.lpstrDeviceType = "cdaudio";
+
+    MCIERROR result = m_winmm.mciSendCommandA(0, MCI_OPEN, MCI_OPEN_TYPE,
+        reinterpret_cast<DWORD_PTR>(&open));
+    if (result) {
+        throw WinMMError("Can't open the benchmark device", result);
+    }
+
+    MCIDEVICEID deviceID = open.wDeviceID;
+
+    MCI_SET_PARMS set = {};
+    set.dwTimeFormat = MCI_FORMAT_TMSF;
+    m_winmm.mciSendCommandA(deviceID, MCI_SET, MCI_SET_TIME_FORMAT,
+        reinterpret_cast<DWORD_PTR>(&set));
+
+    // the tracks past the last one up to the highest a TMSF time holds
+    measure("mci play", [this, deviceID](int32_t probe) {
+        MCI_PLAY_PARMS play = {};
+        play.dwFrom = MCI_MAKE_TMSF(
+            BENCHMARK_TRACKS + 1 + probe % (99 - BENCHMARK_TRACKS), 0, 0, 0);
+        return m_winmm.mciSendCommandA(deviceID, MCI_PLAY, MCI_FROM,
+            reinterpret_cast<DWORD_PTR>(&play));
+    });
+
+    m_winmm.mciSendCommandA(deviceID, MCI_CLOSE, 0, 0);
+}
+
+bool ErrorBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return false;
+    }
+
+    fprintf(file, "path\tcalls\tns/call\n");
+
+    for (const Run& run : m_runs) {
+        double ns = run.calls > 0 ? run.seconds * 1e9 / run.calls : 0.0;
+        fprintf(file, "%s\t%.0f\t%.1f\n", run.path.c_str(), run.calls, ns);
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked the MCI error paths, see %s", reportPath.c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WinMM;
+
+// Times a refused MCI command: the out-of-range MCI_PLAY of a game probing
+// the track count, sent through the exports to a device on the null output,
+// and next to it the two error channels alone, a thrown WinMMError caught
+// by a rethrowing handler the commands used to go through and the returned
+// error code they use now. Writes the nanoseconds per refused command.
+class ErrorBenchmark
+{
+public:
+    // The directory should be the game directory, a few synthetic tracks are
+    // written to the music directory in it. The WinMM has to be set up for
+    // the null output.
+    ErrorBenchmark(WinMM& winmm, const std::string& directory);
+
+    // false if the tracks can't be written or the device fails
+    bool run(const std::string& reportPath);
+
+private:
+    struct Run
+    {
+        std::string path;
+        double calls;
+        double seconds;
+    };
+
+    WinMM& m_winmm;
+    std::string m_directory;
+    std::vector<Run> m_runs;
+
+    // sends batches of probes of rising track numbers until the time is up
+    template <typename Send>
+    void measure(const std::string& path, Send send);
+
+    void benchmarkPlay();
+    bool writeReport(const std::string& reportPath);
+};
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "FileSystem.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+
+void FileSystem::list(const std::string& directory,
+    const std::string& prefix, const Visitor& visit)
+{
+    // the file system filters by the prefix
+    WIN32_FIND_DATA fdata;
+    HANDLE hFind = FindFirstFile(
+        (directory + PATH_SEPARATOR + prefix + '*').c_str(), &fdata);
+
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    do {
+        if (strcmp(fdata.cFileName, ".") && strcmp(fdata.cFileName, "..")) {
+            visit(fdata.cFileName,
+                (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+        }
+    } while (FindNextFile(hFind, &fdata) != 0);
+
+    FindClose(hFind);
+}
+
+bool FileSystem::exists(const std::string& path)
+{
+    return GetFileAttributes(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+bool FileSystem::createDirectory(const std::string& path)
+{
+    return CreateDirectory(path.c_str(), nullptr) ||
+           GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+std::string FileSystem::getModuleDirectory()
+{
+    std::string modulePath;
+    modulePath.resize(MAX_PATH);
+    DWORD size = GetModuleFileName(GetModuleHandle(NULL), &modulePath[0],
+        static_cast<DWORD>(modulePath.capacity()));
+    modulePath.resize(size);
+
+    // remove module file from path
+    return modulePath.substr(0, modulePath.find_last_of(PATH_SEPARATOR));
+}
+
+std::string FileSystem::getTempDirectory()
+{
+    char tempPath[MAX_PATH];
+    DWORD size = GetTempPath(sizeof(tempPath), tempPath);
+    return std::string(tempPath, size < sizeof(tempPath) ? size : 0);
+}
+
+#else
+
+void FileSystem::list(const std::string& directory,
+    const std::string& prefix, const Visitor& visit)
+{
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (!strcmp(name, ".") || !strcmp(name, "..") ||
+            strncasecmp(name, prefix.c_str(), prefix.size())) {
+            continue;
+        }
+
+        // links and file systems without types in their entries need a
+        // stat, relative to the directory so no path is put together
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat info;
+            if (fstatat(dirfd(dir), name, &info, 0)) {
+                continue;
+            }
+            isDirectory = S_ISDIR(info.st_mode);
+        }
+
+        visit(name, isDirectory);
+    }
+
+    closedir(dir);
+}
+
+bool FileSystem::exists(const std::string& path)
+{
+    struct stat info;
+    return !stat(path.c_str(), &info);
+}
+
+bool FileSystem::createDirectory(const std::string& path)
+{
+    struct stat info;
+    return !mkdir(path.c_str(), 0777) ||
+           (!stat(path.c_str(), &info) && S_ISDIR(info.st_mode));
+}
+
+std::string FileSystem::getModuleDirectory()
+{
+    std::string modulePath(4096, '\0');
+    ssize_t size =
+        readlink("/proc/self/exe", &modulePath[0], modulePath.size());
+    modulePath.resize(size > 0 ? size : 0);
+
+    // remove module file from path
+    return modulePath.substr(0, modulePath.find_last_of(PATH_SEPARATOR));
+}
+
+std::string FileSystem::getTempDirectory()
+{
+    const char* tempPath = getenv("TMPDIR");
+    std::string directory = tempPath && *tempPath ? tempPath : "/tmp";
+    if (directory.back() != PATH_SEPARATOR) {
+        directory += PATH_SEPARATOR;
+    }
+    return directory;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#ifdef _WIN32
+#define PATH_SEPARATOR '\\'
+#else
+#define PATH_SEPARATOR '/'
+#endif
+
+// The file system calls of the portable core, on Win32 and on POSIX
+// systems. Paths are narrow strings in the system code page.
+class FileSystem
+{
+public:
+    // gets the name as the system returned it, valid during the call only
+    typedef std::function<void(const char* name, bool isDirectory)> Visitor;
+
+    // Visits the entries of the directory whose names start with the prefix
+    // in any case, without "." and "..". Nothing is visited if the
+    // directory can't be read.
+    static void list(const std::string& directory, const std::string& prefix,
+        const Visitor& visit);
+
+    static bool exists(const std::string& path);
+
+    // true if the directory is there afterwards
+    static bool createDirectory(const std::string& path);
+
+    // directory of the running executable
+    static std::string getModuleDirectory();
+
+    // ends with a separator, empty if there is none
+    static std::string getTempDirectory();
+};
\ No newline at end of file
@@ -0,0 +1,598 @@
+#include "FlacBenchmark.hpp"
+#include "FileSystem.hpp"
+#include "FlacDecoder.hpp"
+#include "Logger.hpp"
+#include "Md5.hpp"
+#include "WinMMError.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdio.h>
+
+// length of each corpus stream
+#define CORPUS_SECONDS 60
+
+#define CORPUS_SAMPLE_RATE 44100
+#define CORPUS_PI 3.14159265358979323846
+#define CORPUS_BLOCK_SIZE 4096
+
+// number of frames decoded at once
+#define BENCHMARK_BLOCK_FRAMES 4096
+
+// channel assignments of a FLAC frame header
+#define FLAC_INDEPENDENT 1
+#define FLAC_LEFT_SIDE 8
+#define FLAC_RIGHT_SIDE 9
+#define FLAC_MID_SIDE 10
+
+// one stream of the corpus, order 0 means the second order fixed predictor
+// and precision 0 the highest one the 32 bit kernels take
+struct CorpusStream
+{
+    const char* name;
+    uint32_t bitsPerSample;
+    uint32_t order;
+    uint32_t precision;
+    uint32_t assignment;
+};
+
+static const CorpusStream corpus[] = {
+    {"lpc8-ms", 16, 8, 0, FLAC_MID_SIDE},
+    {"lpc12-ls", 16, 12, 0, FLAC_LEFT_SIDE},
+    {"lpc32-rs", 16, 32, 0, FLAC_RIGHT_SIDE},
+    {"lpc12-wide", 16, 12, 15, FLAC_INDEPENDENT},
+    {"fixed2-ms", 16, 0, 0, FLAC_MID_SIDE},
+    {"lpc12-24bit", 24, 12, 14, FLAC_MID_SIDE},
+};
+
+// MSB first bit writer for the encoder
+class BitWriter
+{
+public:
+    BitWriter(std::vector<uint8_t>& out)
+        : m_out(out)
+        , m_bits(0)
+        , m_count(0)
+    {
+    }
+
+    void write(uint32_t bits, uint32_t value)
+    {
+        for (uint32_t i = bits; i > 0; i--) {
+            m_bits = (m_bits << 1) | ((value >> (i - 1)) & 1);
+            if (++m_count == 8) {
+                flush();
+            }
+        }
+    }
+
+    void writeUnary(uint32_t zeros)
+    {
+        for (; zeros >= 32; zeros -= 32) {
+            write(32, 0);
+        }
+        write(zeros + 1, 1);
+    }
+
+    void alignToByte()
+    {
+        if (m_count) {
+            write(8 - m_count, 0);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint32_t m_bits;
+    uint32_t m_count;
+
+    void flush()
+    {
+        m_out.push_back(static_cast<uint8_t>(m_bits));
+        m_bits = 0;
+        m_count = 0;
+    }
+};
+
+static uint8_t crc8(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int32_t bit = 0; bit < 8; bit++) {
+            crc = ((crc << 1) ^ (crc & 0x80 ? 0x07 : 0)) & 0xff;
+        }
+    }
+    return static_cast<uint8_t>(crc);
+}
+
+static uint16_t crc16(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i] << 8;
+        for (int32_t bit = 0; bit < 8; bit++) {
+            crc = ((crc << 1) ^ (crc & 0x8000 ? 0x8005 : 0)) & 0xffff;
+        }
+    }
+    return static_cast<uint16_t>(crc);
+}
+
+static uint32_t getLog2(uint32_t value)
+{
+    uint32_t bits = 0;
+    while (value >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// music-like test signal, a few partials with a slow tremolo and some noise
+// that the right channel partly shares with the left
+static void generate(std::vector<int32_t> channels[2], uint32_t frames,
+    uint32_t bitsPerSample)
+{
+    double scale = static_cast<double>(1 << (bitsPerSample - 1)) * 0.3;
+    uint32_t random = 0x9E3779B9;
+
+    for (int32_t c = 0; c < 2; c++) {
+        channels[c].resize(frames);
+    }
+
+    for (uint32_t i = 0; i < frames; i++) {
+        double t = static_cast<double>(i) / CORPUS_SAMPLE_RATE;
+        double tremolo = 0.75 + 0.25 * sin(2 * CORPUS_PI * 0.5 * t);
+        double tone = sin(2 * CORPUS_PI * 220 * t) +
+                      0.5 * sin(2 * CORPUS_PI * 331 * t) +
+                      0.25 * sin(2 * CORPUS_PI * 1375 * t);
+
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        double noise = (static_cast<int32_t>(random) / 2147483648.0) * 0.02;
+
+        double left = tone * tremolo + noise;
+        double right =
+            0.7 * left + 0.3 * sin(2 * CORPUS_PI * 440 * t) - noise;
+
+        channels[0][i] = static_cast<int32_t>(lrint(left * scale));
+        channels[1][i] = static_cast<int32_t>(lrint(right * scale));
+    }
+}
+
+// LPC coefficients from the windowed autocorrelation by Levinson-Durbin
+static void computeLpc(const int32_t* x, uint32_t count, uint32_t order,
+    double coefs[FLAC_MAX_LPC_ORDER])
+{
+    std::vector<double> windowed(count);
+    for (uint32_t i = 0; i < count; i++) {
+        double window = 0.5 - 0.5 * cos(2 * CORPUS_PI * i / (count - 1));
+        windowed[i] = x[i] * window;
+    }
+
+    double r[FLAC_MAX_LPC_ORDER + 1];
+    for (uint32_t lag = 0; lag <= order; lag++) {
+        r[lag] = 0;
+        for (uint32_t i = lag; i < count; i++) {
+            r[lag] += windowed[i] * windowed[i - lag];
+        }
+    }
+
+    double a[FLAC_MAX_LPC_ORDER + 1] = {};
+    double error = r[0] * (1 + 1e-9) + 1e-9;
+
+    for (uint32_t m = 1; m <= order; m++) {
+        double k = r[m];
+        for (uint32_t j = 1; j < m; j++) {
+            k -= a[j] * r[m - j];
+        }
+        k /= error;
+
+        double previous[FLAC_MAX_LPC_ORDER + 1];
+        std::copy(a, a + m, previous);
+
+        a[m] = k;
+        for (uint32_t j = 1; j < m; j++) {
+            a[j] = previous[j] - k * previous[m - j];
+        }
+        error *= 1 - k * k;
+    }
+
+    for (uint32_t j = 0; j < order; j++) {
+        coefs[j] = a[j + 1];
+    }
+}
+
+// Rice codes the residual with the partition order that gives the fewest
+// bits. The parameters are estimated from the mean of each partition.
+static void writeResidual(BitWriter& writer,
+    const std::vector<int32_t>& residual, uint32_t blockSize, uint32_t order)
+{
+    std::vector<uint32_t> folded(residual.size());
+    for (size_t i = 0; i < residual.size(); i++) {
+        int32_t r = residual[i];
+        folded[i] = r >= 0 ? static_cast<uint32_t>(r) << 1
+                           : (static_cast<uint32_t>(-(r + 1)) << 1) | 1;
+    }
+
+    uint32_t bestOrder = 0;
+    uint64_t bestBits = UINT64_MAX;
+    std::vector<uint32_t> bestParams;
+
+    for (uint32_t partitionOrder = 0; partitionOrder <= 8; partitionOrder++) {
+        uint32_t partitionSize = blockSize >> partitionOrder;
+        if (partitionSize << partitionOrder != blockSize ||
+            partitionSize < order || !partitionSize) {
+            break;
+        }
+
+        std::vector<uint32_t> params;
+        uint64_t bits = 0;
+        size_t pos = 0;
+
+        for (uint32_t p = 0; p < (1u << partitionOrder); p++) {
+            uint32_t count = partitionSize - (p ? 0 : order);
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                sum += folded[pos + i];
+            }
+
+            uint32_t param = 0;
+            uint64_t mean = sum / (count ? count : 1);
+            while (param < 30 && (1ull << param) < mean) {
+                param++;
+            }
+
+            params.push_back(param);
+            bits += 5 + count * (param + 1) + (sum >> param);
+            pos += count;
+        }
+
+        if (bits < bestBits) {
+            bestBits = bits;
+            bestOrder = partitionOrder;
+            bestParams = params;
+        }
+    }
+
+    // the escape code 15 of the 4 bit parameters can't be used
+    uint32_t method =
+        *std::max_element(bestParams.begin(), bestParams.end()) >= 15 ? 1 : 0;
+
+    writer.write(2, method);
+    writer.write(4, bestOrder);
+
+    size_t pos = 0;
+    uint32_t partitionSize = blockSize >> bestOrder;
+
+    for (uint32_t p = 0; p < bestParams.size(); p++) {
+        uint32_t param = bestParams[p];
+        uint32_t count = partitionSize - (p ? 0 : order);
+
+        writer.write(method ? 5 : 4, param);
+        for (uint32_t i = 0; i < count; i++, pos++) {
+            writer.writeUnary(folded[pos] >> param);
+            writer.write(param, folded[pos]);
+        }
+    }
+}
+
+static void writeSubframe(BitWriter& writer, const CorpusStream& stream,
+    const int32_t* x, uint32_t blockSize, uint32_t bitsPerSample)
+{
+    uint32_t order = stream.order ? stream.order : 2;
+    std::vector<int32_t> residual;
+
+    // type, fixed predictors are 8 + order, LPC 31 + order
+    writer.write(1, 0);
+    writer.write(6, stream.order ? 31 + order : 8 + order);
+    writer.write(1, 0);
+
+    for (uint32_t i = 0; i < order; i++) {
+        writer.write(bitsPerSample, static_cast<uint32_t>(x[i]));
+    }
+
+    if (!stream.order) {
+        for (uint32_t i = order; i < blockSize; i++) {
+            residual.push_back(x[i] - (2 * x[i - 1] - x[i - 2]));
+        }
+
+        writeResidual(writer, residual, blockSize, order);
+        return;
+    }
+
+    uint32_t precision = stream.precision;
+    if (!precision) {
+        precision = (std::min)(32 - bitsPerSample - getLog2(order), 15u);
+    }
+
+    double lpc[FLAC_MAX_LPC_ORDER];
+    computeLpc(x, blockSize, order, lpc);
+
+    // scale the largest coefficient to the top of the precision
+    double largest = 0;
+    for (uint32_t i = 0; i < order; i++) {
+        largest = (std::max)(largest, fabs(lpc[i]));
+    }
+
+    int32_t exponent = 0;
+    frexp(largest, &exponent);
+    int32_t shift = (std::max)(
+        (std::min)(static_cast<int32_t>(precision) - 1 - exponent, 15), 0);
+
+    int32_t limit = 1 << (precision - 1);
+    int32_t coefs[FLAC_MAX_LPC_ORDER];
+    double error = 0;
+
+    for (uint32_t i = 0; i < order; i++) {
+        error += lpc[i] * (1 << shift);
+        coefs[i] = (std::max)(
+            (std::min)(static_cast<int32_t>(lrint(error)), limit - 1), -limit);
+        error -= coefs[i];
+    }
+
+    writer.write(4, precision - 1);
+    writer.write(5, shift);
+    for (uint32_t i = 0; i < order; i++) {
+        writer.write(precision, static_cast<uint32_t>(coefs[i]));
+    }
+
+    for (uint32_t i = order; i < blockSize; i++) {
+        int64_t sum = 0;
+        for (uint32_t j = 0; j < order; j++) {
+            sum += static_cast<int64_t>(coefs[j]) * x[i - 1 - j];
+        }
+        residual.push_back(x[i] - static_cast<int32_t>(sum >> shift));
+    }
+
+    writeResidual(writer, residual, blockSize, order);
+}
+
+// Writes a stereo stream with a STREAMINFO carrying the MD5 signature.
+// Every frame uses the predictor and channel assignment of the stream.
+static bool writeStream(const std::string& path, const CorpusStream& stream)
+{
+    uint32_t frames = CORPUS_SECONDS * CORPUS_SAMPLE_RATE;
+    uint32_t bps = stream.bitsPerSample;
+
+    std::vector<int32_t> channels[2];
+    generate(channels, frames, bps);
+
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> samples;
+    uint32_t bytes = bps / 8;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        for (int32_t c = 0; c < 2; c++) {
+            for (uint32_t b = 0; b < bytes; b++) {
+                samples.push_back(
+                    static_cast<uint8_t>(channels[c][i] >> (b * 8)));
+            }
+        }
+    }
+
+    Md5 md5;
+    md5.update(samples.data(), samples.size());
+    uint8_t digest[16];
+    md5.finish(digest);
+
+    const uint8_t magic[] = {'f', 'L', 'a', 'C', 0x80, 0, 0, 34};
+    out.insert(out.end(), magic, magic + sizeof(magic));
+
+    BitWriter info(out);
+    info.write(16, CORPUS_BLOCK_SIZE);
+    info.write(16, CORPUS_BLOCK_SIZE);
+    info.write(24, 0);
+    info.write(24, 0);
+    info.write(20, CORPUS_SAMPLE_RATE);
+    info.write(3, 1);
+    info.write(5, bps - 1);
+    info.write(4, 0);
+    info.write(32, frames);
+    out.insert(out.end(), digest, digest + sizeof(digest));
+
+    std::vector<int32_t> subframes[2];
+
+    for (uint32_t start = 0, number = 0; start < frames;
+         start += CORPUS_BLOCK_SIZE, number++) {
+        uint32_t blockSize = (std::min)(
+            frames - start, static_cast<uint32_t>(CORPUS_BLOCK_SIZE));
+        size_t frameStart = out.size();
+
+        // block size 4096 or 16 bits after the number, 44.1 kHz
+        BitWriter writer(out);
+        writer.write(16, 0xfff8);
+        writer.write(4, blockSize == CORPUS_BLOCK_SIZE ? 12 : 7);
+        writer.write(4, 9);
+        writer.write(4, stream.assignment);
+        writer.write(3, bps == 24 ? 6 : 4);
+        writer.write(1, 0);
+
+        // frame number, coded like UTF-8
+        if (number < 0x80) {
+            writer.write(8, number);
+        } else if (number < 0x800) {
+            writer.write(8, 0xc0 | (number >> 6));
+            writer.write(8, 0x80 | (number & 0x3f));
+        } else {
+            writer.write(8, 0xe0 | (number >> 12));
+            writer.write(8, 0x80 | ((number >> 6) & 0x3f));
+            writer.write(8, 0x80 | (number & 0x3f));
+        }
+
+        if (blockSize != CORPUS_BLOCK_SIZE) {
+            writer.write(16, blockSize - 1);
+        }
+
+        out.push_back(crc8(&out[frameStart], out.size() - frameStart));
+
+        const int32_t* left = &channels[0][start];
+        const int32_t* right = &channels[1][start];
+
+        for (int32_t c = 0; c < 2; c++) {
+            subframes[c].resize(blockSize);
+        }
+
+        for (uint32_t i = 0; i < blockSize; i++) {
+            int32_t side = left[i] - right[i];
+
+            switch (stream.assignment) {
+                case FLAC_LEFT_SIDE:
+                    subframes[0][i] = left[i];
+                    subframes[1][i] = side;
+                    break;
+                case FLAC_RIGHT_SIDE:
+                    subframes[0][i] = side;
+                    subframes[1][i] = right[i];
+                    break;
+                case FLAC_MID_SIDE:
+                    subframes[0][i] = (left[i] + right[i]) >> 1;
+                    subframes[1][i] = side;
+                    break;
+                default:
+                    subframes[0][i] = left[i];
+                    subframes[1][i] = right[i];
+                    break;
+            }
+        }
+
+        for (int32_t c = 0; c < 2; c++) {
+            // the side channel has one more bit
+            bool side = (stream.assignment == FLAC_RIGHT_SIDE && c == 0) ||
+                        (stream.assignment != FLAC_RIGHT_SIDE &&
+                            stream.assignment != FLAC_INDEPENDENT && c == 1);
+
+            writeSubframe(writer, stream, &subframes[c][0], blockSize,
+                bps + (side ? 1 : 0));
+        }
+
+        writer.alignToByte();
+
+        uint16_t crc = crc16(&out[frameStart], out.size() - frameStart);
+        out.push_back(static_cast<uint8_t>(crc >> 8));
+        out.push_back(static_cast<uint8_t>(crc));
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), out.size());
+    return file.good();
+}
+
+bool FlacBenchmark::run(const std::string& reportPath)
+{
+    std::string tempPath = FileSystem::getTempDirectory();
+    if (tempPath.empty()) {
+        LOG_INFO("No temporary directory for the FLAC corpus");
+        return false;
+    }
+
+    std::vector<std::string> paths;
+
+    for (const CorpusStream& stream : corpus) {
+        std::string path = tempPath + "zplaymm-" + stream.name + ".flac";
+
+        if (!writeStream(path, stream)) {
+            LOG_INFO("Can't write %s", path.c_str());
+            break;
+        }
+
+        paths.push_back(path);
+    }
+
+    WorkerPool pool;
+    LOG_INFO("Benchmarking FLAC decoding of %zu streams on up to %u threads",
+        paths.size(), pool.getThreadCount() + 1);
+
+    for (int32_t set = FlacKernelsScalar; set <= FlacKernelsAvx2; set++) {
+        FlacKernelSet kernels = static_cast<FlacKernelSet>(set);
+        if (!FlacKernels::isSupported(kernels)) {
+            continue;
+        }
+
+        for (int32_t pooled = 0; pooled < 2; pooled++) {
+            for (size_t i = 0; i < paths.size(); i++) {
+                Run run = {};
+                run.stream = corpus[i].name;
+                run.kernels = kernels;
+                run.threads = pooled ? pool.getThreadCount() : 1;
+
+                measure(run, paths[i], pooled ? &pool : nullptr);
+                m_runs.push_back(run);
+            }
+        }
+    }
+
+    for (const std::string& path : paths) {
+        remove(path.c_str());
+    }
+
+    return paths.size() == sizeof(corpus) / sizeof(corpus[0]) &&
+           writeReport(reportPath);
+}
+
+void FlacBenchmark::measure(Run& run, const std::string& path, WorkerPool* pool)
+{
+    FlacDecoder decoder;
+
+    try {
+        decoder.open(path);
+        decoder.setKernels(run.kernels);
+        decoder.setPool(pool);
+        decoder.setHashing(true);
+
+        std::vector<int16_t> buffer(BENCHMARK_BLOCK_FRAMES * 2);
+        while (decoder.read(&buffer[0], BENCHMARK_BLOCK_FRAMES)) {
+        }
+
+        const DecoderStats& stats = decoder.getStats();
+        run.audio = static_cast<double>(stats.frames) / decoder.getSampleRate();
+        run.seconds = stats.seconds;
+
+        // the output has to match the encoder's input bit for bit
+        uint8_t digest[16];
+        if (!decoder.getDigest(digest)) {
+            run.result = "incomplete";
+        } else if (memcmp(digest, decoder.getSignature(), sizeof(digest))) {
+            run.result = "mismatch";
+        } else {
+            run.result = "match";
+        }
+    } catch (const WinMMError& ex) {
+        LOG_INFO("%s: %s", path.c_str(), ex.what());
+        run.result = "failed";
+    }
+}
+
+bool FlacBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return false;
+    }
+
+    fprintf(file, "stream\tkernels\tthreads\taudio\tdecode\tspeed\tmd5\n");
+
+    int32_t mismatches = 0;
+
+    for (const Run& run : m_runs) {
+        fprintf(file, "%s\t%s\t%u\t%.1f s\t%.3f s\t%.1fx\t%s\n",
+            run.stream.c_str(), FlacKernels::getName(run.kernels), run.threads,
+            run.audio, run.seconds,
+            run.seconds > 0 ? run.audio / run.seconds : 0.0,
+            run.result.c_str());
+
+        if (run.result != "match") {
+            mismatches++;
+        }
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked %zu FLAC decodes, %d not bit-exact, see %s",
+        m_runs.size(), mismatches, reportPath.c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "FlacKernels.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+// Encodes a synthetic FLAC corpus covering the LPC orders, stereo modes and
+// sample sizes the kernels handle differently, then decodes it with every
+// kernel set the CPU supports, with and without a decode pool. Writes the
+// speed in multiples of realtime and whether the output matched the MD5
+// signature bit for bit.
+class FlacBenchmark
+{
+public:
+    // false if the corpus or the report can't be written
+    bool run(const std::string& reportPath);
+
+private:
+    struct Run
+    {
+        std::string stream;
+        FlacKernelSet kernels;
+        uint32_t threads;
+        double audio;
+        double seconds;
+        std::string result;
+    };
+
+    std::vector<Run> m_runs;
+
+    void measure(Run& run, const std::string& path, WorkerPool* pool);
+    bool writeReport(const std::string& reportPath);
+};
\ No newline at end of file
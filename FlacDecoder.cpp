@@ -0,0 +1,1092 @@
+#include "FlacDecoder.hpp"
+#include "AudioClock.hpp"
+#include "WinMMError.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <stdlib.h>
+#endif
+
+#define FLAC_BLOCK_STREAMINFO 0
+#define FLAC_BLOCK_SEEKTABLE 3
+#define FLAC_STREAMINFO_SIZE 34
+#define FLAC_SEEKPOINT_SIZE 18
+#define FLAC_PLACEHOLDER_POINT UINT64_MAX
+
+// longest possible frame header
+#define FLAC_HEADER_MAX 16
+
+// bytes read from the file at once
+#define FLAC_READ_SIZE (256 * 1024)
+
+// the bit reader loads 8 bytes at any position up to a bit past the frame
+#define FLAC_INPUT_PADDING 32
+
+// frames decoded per batch for each thread of the pool
+#define FLAC_FRAMES_PER_THREAD 2
+
+// a seek bisects the file until the range is this small, then decodes on
+#define FLAC_SEEK_SPAN (64 * 1024)
+
+// findFrame() accepts any frame that decodes
+#define FLAC_ANY_SAMPLE UINT64_MAX
+
+static const uint8_t* getCrc8Table()
+{
+    static uint8_t table[256];
+    static bool ready = false;
+
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int32_t bit = 0; bit < 8; bit++) {
+                crc = (crc << 1) ^ (crc & 0x80 ? 0x07 : 0);
+            }
+            table[i] = static_cast<uint8_t>(crc);
+        }
+        ready = true;
+    }
+
+    return table;
+}
+
+static const uint16_t* getCrc16Table()
+{
+    static uint16_t table[256];
+    static bool ready = false;
+
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i << 8;
+            for (int32_t bit = 0; bit < 8; bit++) {
+                crc = (crc << 1) ^ (crc & 0x8000 ? 0x8005 : 0);
+            }
+            table[i] = static_cast<uint16_t>(crc);
+        }
+        ready = true;
+    }
+
+    return table;
+}
+
+static uint8_t crc8(const uint8_t* data, size_t size)
+{
+    const uint8_t* table = getCrc8Table();
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+static uint16_t crc16(const uint8_t* data, size_t size)
+{
+    const uint16_t* table = getCrc16Table();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+static inline uint64_t loadBE64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#ifdef _MSC_VER
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+static inline uint32_t countLeadingZeros(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<uint32_t>(value >> 32))) {
+        return 31 - index;
+    }
+    _BitScanReverse(&index, static_cast<uint32_t>(value));
+    return 63 - index;
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+// log2 rounded down, how many bits an LPC sum adds to the products
+static uint32_t getLog2(uint32_t value)
+{
+    uint32_t bits = 0;
+    while (value >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// MSB first reader over a frame in memory. Each read loads the 8 bytes at
+// the current position, so reads up to 32 bits never need a refill. Reads
+// past the end land in the input padding and are caught by overrun().
+class BitReader
+{
+public:
+    BitReader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_pos(0)
+        , m_end(size * 8)
+    {
+    }
+
+    uint32_t read(uint32_t bits)
+    {
+        if (!bits) {
+            return 0;
+        }
+        uint32_t value = static_cast<uint32_t>(peek() >> (64 - bits));
+        m_pos += bits;
+        return value;
+    }
+
+    int32_t readSigned(uint32_t bits)
+    {
+        if (!bits) {
+            return 0;
+        }
+        int32_t value =
+            static_cast<int32_t>(static_cast<int64_t>(peek()) >> (64 - bits));
+        m_pos += bits;
+        return value;
+    }
+
+    // number of zero bits up to the next one bit, which is skipped too
+    uint32_t readUnary()
+    {
+        uint32_t count = 0;
+        uint64_t word;
+
+        // the bits shifted in at the bottom are zero, so a one bit found is
+        // always a real one
+        while (!(word = peek())) {
+            uint32_t valid = 64 - (m_pos & 7);
+            count += valid;
+            m_pos += valid;
+
+            if (overrun()) {
+                return count;
+            }
+        }
+
+        uint32_t zeros = countLeadingZeros(word);
+        m_pos += zeros + 1;
+        return count + zeros;
+    }
+
+    bool readRice(int32_t* out, size_t count, uint32_t param)
+    {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t value = (readUnary() << param) | read(param);
+
+            // zigzag, even values are positive
+            out[i] = static_cast<int32_t>(value >> 1) ^
+                     -static_cast<int32_t>(value & 1);
+
+            if (overrun()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool has(uint64_t bits)
+    {
+        return m_pos + bits <= m_end;
+    }
+
+    bool overrun()
+    {
+        return m_pos > m_end;
+    }
+
+    void alignToByte()
+    {
+        m_pos = (m_pos + 7) & ~static_cast<size_t>(7);
+    }
+
+    size_t getBytePosition()
+    {
+        return m_pos / 8;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_pos;
+    size_t m_end;
+
+    uint64_t peek()
+    {
+        return loadBE64(m_data + (m_pos >> 3)) << (m_pos & 7);
+    }
+};
+
+static bool decodeResidual(
+    BitReader& reader, int32_t* out, uint32_t blockSize, uint32_t order)
+{
+    if (!reader.has(6)) {
+        return false;
+    }
+
+    // rice parameters have 4 bits, or 5 for the second method
+    uint32_t method = reader.read(2);
+    if (method > 1) {
+        return false;
+    }
+
+    uint32_t paramBits = method ? 5 : 4;
+    uint32_t escape = (1u << paramBits) - 1;
+    uint32_t partitionOrder = reader.read(4);
+    uint32_t partitionSize = blockSize >> partitionOrder;
+
+    if (partitionSize << partitionOrder != blockSize ||
+        partitionSize < order) {
+        return false;
+    }
+
+    for (uint32_t p = 0; p < (1u << partitionOrder); p++) {
+        // the warm-up samples have no residual
+        uint32_t count = partitionSize - (p ? 0 : order);
+
+        if (!reader.has(paramBits)) {
+            return false;
+        }
+
+        uint32_t param = reader.read(paramBits);
+
+        if (param == escape) {
+            // unencoded partition of fixed size samples
+            uint32_t bits = reader.read(5);
+            if (!reader.has(static_cast<uint64_t>(count) * bits)) {
+                return false;
+            }
+
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = reader.readSigned(bits);
+            }
+        } else if (!reader.readRice(out, count, param)) {
+            return false;
+        }
+
+        out += count;
+    }
+
+    return true;
+}
+
+static void restoreFixed(int32_t* data, size_t samples, uint32_t order)
+{
+    // at most 25 bits with the side channel, so 4th order sums fit 32 bits
+    switch (order) {
+        case 1:
+            for (size_t i = 1; i < samples; i++) {
+                data[i] += data[i - 1];
+            }
+            break;
+
+        case 2:
+            for (size_t i = 2; i < samples; i++) {
+                data[i] += 2 * data[i - 1] - data[i - 2];
+            }
+            break;
+
+        case 3:
+            for (size_t i = 3; i < samples; i++) {
+                data[i] += 3 * (data[i - 1] - data[i - 2]) + data[i - 3];
+            }
+            break;
+
+        case 4:
+            for (size_t i = 4; i < samples; i++) {
+                data[i] += 4 * (data[i - 1] + data[i - 3]) -
+                           6 * data[i - 2] - data[i - 4];
+            }
+            break;
+    }
+}
+
+static bool decodeSubframe(BitReader& reader, const FlacKernels& kernels,
+    int32_t* out, uint32_t blockSize, uint32_t bitsPerSample)
+{
+    if (!reader.has(8) || reader.read(1)) {
+        return false;
+    }
+
+    uint32_t type = reader.read(6);
+
+    // samples may have zero bits at the bottom that aren't coded
+    uint32_t wasted = 0;
+    if (reader.read(1)) {
+        wasted = reader.readUnary() + 1;
+        if (wasted >= bitsPerSample) {
+            return false;
+        }
+        bitsPerSample -= wasted;
+    }
+
+    if (type == 0) {
+        // constant
+        int32_t value = reader.readSigned(bitsPerSample);
+        std::fill(out, out + blockSize, value);
+    } else if (type == 1) {
+        // verbatim
+        if (!reader.has(static_cast<uint64_t>(blockSize) * bitsPerSample)) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < blockSize; i++) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+    } else if (type >= 8 && type <= 12) {
+        // fixed polynomial predictor
+        uint32_t order = type - 8;
+        if (order > blockSize || !reader.has(order * bitsPerSample)) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < order; i++) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+
+        if (!decodeResidual(reader, out + order, blockSize, order)) {
+            return false;
+        }
+
+        restoreFixed(out, blockSize, order);
+    } else if (type >= 32) {
+        // linear predictor with quantized coefficients
+        uint32_t order = type - 31;
+        if (order > blockSize ||
+            !reader.has(order * bitsPerSample + 9 + order * 15)) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < order; i++) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+
+        uint32_t precision = reader.read(4) + 1;
+        int32_t shift = reader.readSigned(5);
+        if (precision == 16 || shift < 0) {
+            return false;
+        }
+
+        int32_t coefs[FLAC_MAX_LPC_ORDER];
+        for (uint32_t i = 0; i < order; i++) {
+            coefs[i] = reader.readSigned(precision);
+        }
+
+        if (!decodeResidual(reader, out + order, blockSize, order)) {
+            return false;
+        }
+
+        if (bitsPerSample + precision + getLog2(order) <= 32) {
+            kernels.restoreLpc(out, blockSize, coefs, order, shift);
+        } else {
+            kernels.restoreLpcWide(out, blockSize, coefs, order, shift);
+        }
+    } else {
+        return false;
+    }
+
+    if (wasted) {
+        for (uint32_t i = 0; i < blockSize; i++) {
+            out[i] =
+                static_cast<int32_t>(static_cast<uint32_t>(out[i]) << wasted);
+        }
+    }
+
+    return !reader.overrun();
+}
+
+FlacDecoder::FlacDecoder()
+    : m_fileSize(0)
+    , m_audioOffset(0)
+    , m_kernels(&FlacKernels::get(FlacKernels::getBest()))
+    , m_pool(nullptr)
+    , m_maxBlockSize(0)
+    , m_bitsPerSample(0)
+    , m_signature()
+    , m_inputOffset(0)
+    , m_inputPos(0)
+    , m_inputSize(0)
+    , m_inputEnded(false)
+    , m_frameBound(0)
+    , m_pcmPos(0)
+    , m_pcmFrames(0)
+    , m_nextSample(0)
+    , m_skip(0)
+    , m_sampleKernels(SampleKernels::get(SampleKernels::getBest()))
+    , m_hashing(false)
+    , m_hashValid(false)
+    , m_hashEnded(false)
+    , m_hashFinished(false)
+    , m_digest()
+{
+    SampleKernels::seedDither(m_dither);
+}
+
+void FlacDecoder::open(const std::string& path)
+{
+    m_path = path;
+    m_file.open(path, std::ios::binary);
+    if (!m_file) {
+        throw WinMMError("Can't open " + path, MCIERR_HARDWARE);
+    }
+
+    m_file.seekg(0, std::ios::end);
+    m_fileSize = static_cast<uint64_t>(m_file.tellg());
+    m_file.seekg(0, std::ios::beg);
+
+    readMetadata();
+
+    if (m_channels < 1 || m_channels > 8 || m_bitsPerSample < 4 ||
+        m_bitsPerSample > 24 || m_maxBlockSize < 16 || !m_sampleRate) {
+        throw WinMMError("Unsupported FLAC stream in " + path, MCIERR_HARDWARE);
+    }
+
+    // a verbatim frame is the largest an encoder writes, even with the
+    // extra bit of a side channel
+    m_frameBound = FLAC_HEADER_MAX + 2 +
+                   m_channels * (2 + m_maxBlockSize * sizeof(int32_t));
+
+    if (m_bitsPerSample > 16) {
+        m_float.resize(m_maxBlockSize * 2);
+    }
+
+    resizeBatch(1);
+    moveTo(m_audioOffset);
+}
+
+void FlacDecoder::readMetadata()
+{
+    unsigned char magic[10];
+    if (!m_file.read(reinterpret_cast<char*>(magic), 4)) {
+        throw WinMMError("Not a FLAC file: " + m_path, MCIERR_HARDWARE);
+    }
+
+    // skip an ID3v2 tag, its size is stored in 7 bit bytes
+    if (!memcmp(magic, "ID3", 3) &&
+        m_file.read(reinterpret_cast<char*>(magic + 4), 6)) {
+        uint32_t size = (magic[6] << 21) | (magic[7] << 14) |
+                        (magic[8] << 7) | magic[9];
+        m_file.seekg(10 + size, std::ios::beg);
+        m_file.read(reinterpret_cast<char*>(magic), 4);
+    }
+
+    if (!m_file || memcmp(magic, "fLaC", 4) != 0) {
+        throw WinMMError("Not a FLAC file: " + m_path, MCIERR_HARDWARE);
+    }
+
+    bool streamInfo = false;
+    bool last = false;
+
+    while (!last) {
+        unsigned char header[4];
+        if (!m_file.read(reinterpret_cast<char*>(header), 4)) {
+            throw WinMMError("Broken FLAC metadata in " + m_path,
+                MCIERR_HARDWARE);
+        }
+
+        last = (header[0] & 0x80) != 0;
+        int32_t type = header[0] & 0x7f;
+        uint32_t size = (header[1] << 16) | (header[2] << 8) | header[3];
+
+        if (type == FLAC_BLOCK_STREAMINFO && size >= FLAC_STREAMINFO_SIZE) {
+            unsigned char p[FLAC_STREAMINFO_SIZE];
+            m_file.read(reinterpret_cast<char*>(p), sizeof(p));
+            m_file.seekg(size - sizeof(p), std::ios::cur);
+
+            // block sizes, frame sizes, 20 bits sample rate, 3 bits channels
+            // minus one, 5 bits sample size minus one, 36 bits sample count
+            // and the MD5 signature
+            m_maxBlockSize = (p[2] << 8) | p[3];
+            m_sampleRate = (p[10] << 12) | (p[11] << 4) | (p[12] >> 4);
+            m_channels = ((p[12] >> 1) & 7) + 1;
+            m_bitsPerSample = (((p[12] & 1) << 4) | (p[13] >> 4)) + 1;
+            m_length = (static_cast<uint64_t>(p[13] & 15) << 32) |
+                       (static_cast<uint32_t>(p[14]) << 24) | (p[15] << 16) |
+                       (p[16] << 8) | p[17];
+            memcpy(m_signature, p + 18, sizeof(m_signature));
+            streamInfo = true;
+        } else if (type == FLAC_BLOCK_SEEKTABLE) {
+            std::vector<unsigned char> block(size);
+            m_file.read(reinterpret_cast<char*>(block.data()), size);
+
+            for (size_t i = 0; i + FLAC_SEEKPOINT_SIZE <= size;
+                 i += FLAC_SEEKPOINT_SIZE) {
+                SeekPoint point = {};
+                for (int32_t k = 0; k < 8; k++) {
+                    point.sample = (point.sample << 8) | block[i + k];
+                    point.offset = (point.offset << 8) | block[i + 8 + k];
+                }
+
+                if (point.sample != FLAC_PLACEHOLDER_POINT) {
+                    m_seekTable.push_back(point);
+                }
+            }
+        } else {
+            m_file.seekg(size, std::ios::cur);
+        }
+    }
+
+    if (!m_file || !streamInfo) {
+        throw WinMMError("Broken FLAC metadata in " + m_path, MCIERR_HARDWARE);
+    }
+
+    m_audioOffset = static_cast<uint64_t>(m_file.tellg());
+}
+
+size_t FlacDecoder::read(int16_t* buffer, size_t frames)
+{
+    int64_t started = AudioClock::getSystemTime();
+    size_t total = 0;
+
+    while (total < frames) {
+        // a batch may be skipped entirely after a seek
+        if (m_pcmPos == m_pcmFrames && !fillCache()) {
+            break;
+        }
+
+        size_t count = (std::min)(frames - total, m_pcmFrames - m_pcmPos);
+        memcpy(buffer + total * 2, &m_pcm[m_pcmPos * 2],
+            count * 2 * sizeof(int16_t));
+
+        m_pcmPos += count;
+        total += count;
+    }
+
+    m_stats.frames += total;
+    m_stats.seconds += (AudioClock::getSystemTime() - started) / 1e9;
+    return total;
+}
+
+bool FlacDecoder::fillCache()
+{
+    m_pcmPos = 0;
+    m_pcmFrames = 0;
+
+    // anything after the last sample isn't audio, like trailing tags
+    if (m_length && m_nextSample >= m_length) {
+        m_hashEnded = true;
+        return false;
+    }
+
+    size_t count = m_pool ? m_pool->getThreadCount() * FLAC_FRAMES_PER_THREAD
+                          : 1;
+    resizeBatch(count);
+    ensureInput(count * m_frameBound);
+
+    if (m_inputPos >= m_inputSize) {
+        m_hashEnded = true;
+        return false;
+    }
+
+    // A frame ends where the next one starts, which is found by its header
+    // carrying the expected sample number. A false match fails the CRC
+    // check and that frame is decoded the slow way.
+    m_starts.assign(1, m_inputPos);
+
+    uint64_t sample = m_nextSample;
+    FrameHeader header;
+
+    while (m_starts.size() <= count && m_starts.back() < m_inputSize &&
+           parseHeader(&m_input[m_starts.back()],
+               m_inputSize - m_starts.back(), header)) {
+        sample = getFrameSample(header) + header.blockSize;
+
+        size_t next = findFrame(m_starts.back() + header.size, sample);
+        if (next == m_inputSize && !m_inputEnded) {
+            break;
+        }
+
+        m_starts.push_back(next);
+    }
+
+    size_t spans = m_starts.size() - 1;
+
+    if (spans > 1) {
+        m_decoded.assign(spans, 0);
+
+        for (size_t k = 0; k < spans; k++) {
+            m_pool->submit([this, k] {
+                size_t size = m_starts[k + 1] - m_starts[k];
+                m_decoded[k] =
+                    decodeFrame(&m_input[m_starts[k]], size, m_batch[k]) ==
+                    size;
+            });
+        }
+
+        m_pool->wait();
+
+        for (size_t k = 0; k < spans; k++) {
+            if (!m_decoded[k]) {
+                // continue sequentially from the first frame that failed
+                m_inputPos = m_starts[k];
+                break;
+            }
+
+            emit(m_batch[k]);
+            m_inputPos = m_starts[k + 1];
+        }
+
+        if (m_pcmFrames) {
+            return true;
+        }
+    }
+
+    size_t size = decodeFrame(
+        &m_input[m_inputPos], m_inputSize - m_inputPos, m_batch[0]);
+
+    if (!size) {
+        throw WinMMError("Broken FLAC frame at sample " +
+                             std::to_string(m_nextSample) + " in " + m_path,
+            MCIERR_HARDWARE);
+    }
+
+    emit(m_batch[0]);
+    m_inputPos += size;
+    return true;
+}
+
+void FlacDecoder::resizeBatch(size_t count)
+{
+    if (m_batch.size() >= count) {
+        return;
+    }
+
+    m_batch.resize(count);
+    for (Frame& frame : m_batch) {
+        frame.samples.resize(m_channels * m_maxBlockSize);
+    }
+
+    m_pcm.resize(count * m_maxBlockSize * 2);
+}
+
+void FlacDecoder::ensureInput(size_t bytes)
+{
+    if (m_inputSize - m_inputPos >= bytes || m_inputEnded) {
+        return;
+    }
+
+    // keep the unread rest and append to it
+    size_t rest = m_inputSize - m_inputPos;
+    if (rest) {
+        memmove(&m_input[0], &m_input[m_inputPos], rest);
+    }
+
+    m_inputOffset += m_inputPos;
+    m_inputPos = 0;
+    m_inputSize = rest;
+
+    size_t wanted = (std::max)(bytes, static_cast<size_t>(FLAC_READ_SIZE));
+    if (m_input.size() < wanted + FLAC_INPUT_PADDING) {
+        m_input.resize(wanted + FLAC_INPUT_PADDING);
+    }
+
+    m_file.read(
+        reinterpret_cast<char*>(&m_input[m_inputSize]), wanted - m_inputSize);
+    size_t got = static_cast<size_t>(m_file.gcount());
+
+    m_inputSize += got;
+    m_stats.bytesRead += got;
+
+    if (m_inputSize < wanted) {
+        m_inputEnded = true;
+    }
+
+    memset(&m_input[m_inputSize], 0, FLAC_INPUT_PADDING);
+}
+
+void FlacDecoder::moveTo(uint64_t offset)
+{
+    m_file.clear();
+    m_file.seekg(offset, std::ios::beg);
+
+    m_inputOffset = offset;
+    m_inputPos = 0;
+    m_inputSize = 0;
+    m_inputEnded = false;
+
+    m_pcmPos = 0;
+    m_pcmFrames = 0;
+}
+
+size_t FlacDecoder::findFrame(size_t from, uint64_t sample)
+{
+    FrameHeader header;
+
+    for (size_t pos = from; pos + 1 < m_inputSize; pos++) {
+        const void* sync = memchr(&m_input[pos], 0xff, m_inputSize - pos);
+        if (!sync) {
+            break;
+        }
+
+        pos = static_cast<const uint8_t*>(sync) - &m_input[0];
+        if (!parseHeader(&m_input[pos], m_inputSize - pos, header)) {
+            continue;
+        }
+
+        if (sample == FLAC_ANY_SAMPLE) {
+            // without an expected number, only a frame that decodes counts
+            if (decodeFrame(&m_input[pos], m_inputSize - pos, m_batch[0])) {
+                return pos;
+            }
+        } else if (getFrameSample(header) == sample) {
+            return pos;
+        }
+    }
+
+    return m_inputSize;
+}
+
+bool FlacDecoder::findFrameAfter(
+    uint64_t from, uint64_t to, uint64_t& offset, uint64_t& sample)
+{
+    moveTo(from);
+    ensureInput(FLAC_SEEK_SPAN + m_frameBound);
+
+    size_t pos = findFrame(0, FLAC_ANY_SAMPLE);
+    if (pos == m_inputSize || m_inputOffset + pos >= to) {
+        return false;
+    }
+
+    offset = m_inputOffset + pos;
+    sample = m_batch[0].sample;
+    return true;
+}
+
+void FlacDecoder::seek(uint64_t frame)
+{
+    uint64_t target = m_length ? (std::min)(frame, m_length) : frame;
+
+    // start at the closest seek point before the target
+    uint64_t offset = m_audioOffset;
+    uint64_t sample = 0;
+
+    for (const SeekPoint& point : m_seekTable) {
+        if (point.sample <= target && point.sample >= sample) {
+            offset = m_audioOffset + point.offset;
+            sample = point.sample;
+        }
+    }
+
+    // if that's far off, bisect the rest of the file by the frame headers
+    if (target - sample > m_maxBlockSize * 16ull) {
+        uint64_t low = offset;
+        uint64_t high = m_fileSize;
+
+        while (high - low > FLAC_SEEK_SPAN) {
+            uint64_t middle = low + (high - low) / 2;
+            uint64_t found;
+            uint64_t foundSample;
+
+            if (findFrameAfter(middle, high, found, foundSample) &&
+                foundSample <= target) {
+                low = found;
+                offset = found;
+                sample = foundSample;
+            } else {
+                high = middle;
+            }
+        }
+    }
+
+    // decode from there on and drop what's before the target
+    moveTo(offset);
+    m_nextSample = sample;
+    m_skip = target - sample;
+    resetHash();
+}
+
+const char* FlacDecoder::getName()
+{
+    return "flac";
+}
+
+void FlacDecoder::setPool(WorkerPool* pool)
+{
+    m_pool = pool;
+}
+
+void FlacDecoder::setKernels(FlacKernelSet set)
+{
+    m_kernels = &FlacKernels::get(set);
+}
+
+void FlacDecoder::setHashing(bool enabled)
+{
+    m_hashing = enabled;
+    resetHash();
+}
+
+bool FlacDecoder::getDigest(uint8_t digest[16])
+{
+    if (!m_hashValid || !m_hashEnded) {
+        return false;
+    }
+
+    if (!m_hashFinished) {
+        m_md5.finish(m_digest);
+        m_hashFinished = true;
+    }
+
+    memcpy(digest, m_digest, sizeof(m_digest));
+    return true;
+}
+
+const uint8_t* FlacDecoder::getSignature()
+{
+    return m_signature;
+}
+
+uint32_t FlacDecoder::getBitsPerSample()
+{
+    return m_bitsPerSample;
+}
+
+void FlacDecoder::resetHash()
+{
+    // the digest covers the whole stream only, so hashing has to start at
+    // its first frame, even if the samples before a seek target are skipped
+    m_md5 = Md5();
+    m_hashValid = m_hashing && m_nextSample == 0;
+    m_hashEnded = false;
+    m_hashFinished = false;
+}
+
+void FlacDecoder::emit(const Frame& frame)
+{
+    if (m_hashValid) {
+        hash(frame);
+    }
+
+    m_nextSample = frame.sample + frame.blockSize;
+
+    uint32_t skip = static_cast<uint32_t>(
+        (std::min)(m_skip, static_cast<uint64_t>(frame.blockSize)));
+    m_skip -= skip;
+
+    // mono is played on both channels, only the first two of more are used
+    const int32_t* left = &frame.samples[skip];
+    const int32_t* right =
+        m_channels > 1 ? &frame.samples[m_maxBlockSize + skip] : left;
+
+    int16_t* out = &m_pcm[m_pcmFrames * 2];
+    uint32_t count = frame.blockSize - skip;
+    int32_t shift = static_cast<int32_t>(frame.bitsPerSample) - 16;
+
+    if (shift > 0) {
+        // wider samples are reduced with dither, from floats scaled to 16 bit
+        float scale = 1.0f / (1 << shift);
+        for (uint32_t i = 0; i < count; i++) {
+            m_float[i * 2] = left[i] * scale;
+            m_float[i * 2 + 1] = right[i] * scale;
+        }
+
+        m_sampleKernels.fromFloat[SampleInt16](
+            out, &m_float[0], count * 2, m_dither, true);
+    } else if (shift == 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            out[i * 2] = static_cast<int16_t>(left[i]);
+            out[i * 2 + 1] = static_cast<int16_t>(right[i]);
+        }
+    } else {
+        int32_t scale = 1 << -shift;
+        for (uint32_t i = 0; i < count; i++) {
+            out[i * 2] = static_cast<int16_t>(left[i] * scale);
+            out[i * 2 + 1] = static_cast<int16_t>(right[i] * scale);
+        }
+    }
+
+    m_pcmFrames += count;
+}
+
+void FlacDecoder::hash(const Frame& frame)
+{
+    // interleaved little endian samples of whole bytes
+    uint32_t bytes = (frame.bitsPerSample + 7) / 8;
+    size_t size = static_cast<size_t>(frame.blockSize) * m_channels * bytes;
+
+    if (m_hashBuffer.size() < size) {
+        m_hashBuffer.resize(size);
+    }
+
+    uint8_t* out = &m_hashBuffer[0];
+
+    for (uint32_t i = 0; i < frame.blockSize; i++) {
+        for (uint32_t c = 0; c < m_channels; c++) {
+            uint32_t value =
+                static_cast<uint32_t>(frame.samples[c * m_maxBlockSize + i]);
+            for (uint32_t b = 0; b < bytes; b++) {
+                *out++ = static_cast<uint8_t>(value >> (b * 8));
+            }
+        }
+    }
+
+    m_md5.update(&m_hashBuffer[0], size);
+}
+
+bool FlacDecoder::parseHeader(
+    const uint8_t* p, size_t size, FrameHeader& header) const
+{
+    if (size < 6 || p[0] != 0xff || (p[1] & 0xfe) != 0xf8) {
+        return false;
+    }
+
+    uint32_t blockCode = p[2] >> 4;
+    uint32_t rateCode = p[2] & 15;
+    uint32_t sizeCode = (p[3] >> 1) & 7;
+
+    header.variable = (p[1] & 1) != 0;
+    header.assignment = p[3] >> 4;
+
+    if (!blockCode || rateCode == 15 || header.assignment > 10 ||
+        sizeCode == 3 || (p[3] & 1)) {
+        return false;
+    }
+
+    // channels must match STREAMINFO, the buffers are sized by it
+    uint32_t channels = header.assignment < 8 ? header.assignment + 1 : 2;
+    if (channels != m_channels) {
+        return false;
+    }
+
+    // frame or sample number, coded like UTF-8 with up to 36 bits
+    size_t pos = 4;
+    uint32_t first = p[pos++];
+    uint32_t lead = 0;
+    while (lead < 8 && (first & (0x80 >> lead))) {
+        lead++;
+    }
+
+    if (lead == 1 || lead == 8) {
+        return false;
+    }
+
+    header.number = lead ? first & (0x7f >> lead) : first;
+
+    for (uint32_t i = 1; i < lead; i++) {
+        if (pos >= size || (p[pos] & 0xc0) != 0x80) {
+            return false;
+        }
+        header.number = (header.number << 6) | (p[pos++] & 0x3f);
+    }
+
+    // block size, codes 6 and 7 store it after the number
+    if (blockCode == 1) {
+        header.blockSize = 192;
+    } else if (blockCode <= 5) {
+        header.blockSize = 576 << (blockCode - 2);
+    } else if (blockCode == 6) {
+        if (pos + 1 > size) {
+            return false;
+        }
+        header.blockSize = p[pos++] + 1;
+    } else if (blockCode == 7) {
+        if (pos + 2 > size) {
+            return false;
+        }
+        header.blockSize = ((p[pos] << 8) | p[pos + 1]) + 1;
+        pos += 2;
+    } else {
+        header.blockSize = 256 << (blockCode - 8);
+    }
+
+    // the sample rate only matters for its extra bytes
+    if (rateCode == 12) {
+        pos += 1;
+    } else if (rateCode == 13 || rateCode == 14) {
+        pos += 2;
+    }
+
+    static const uint32_t sampleSizes[] = {0, 8, 12, 0, 16, 20, 24, 32};
+    header.bitsPerSample = sizeCode ? sampleSizes[sizeCode] : m_bitsPerSample;
+
+    if (pos >= size || crc8(p, pos) != p[pos]) {
+        return false;
+    }
+
+    // the buffers are sized for the stream's sample size, frames that
+    // change it mid-stream aren't supported
+    if (header.blockSize > m_maxBlockSize ||
+        header.bitsPerSample != m_bitsPerSample) {
+        return false;
+    }
+
+    header.size = pos + 1;
+    return true;
+}
+
+uint64_t FlacDecoder::getFrameSample(const FrameHeader& header) const
+{
+    // fixed block size streams count frames instead of samples
+    return header.variable ? header.number : header.number * m_maxBlockSize;
+}
+
+size_t FlacDecoder::decodeFrame(
+    const uint8_t* data, size_t size, Frame& frame) const
+{
+    FrameHeader header;
+    if (!parseHeader(data, size, header)) {
+        return 0;
+    }
+
+    frame.sample = getFrameSample(header);
+    frame.blockSize = header.blockSize;
+    frame.bitsPerSample = header.bitsPerSample;
+
+    BitReader reader(data + header.size, size - header.size);
+
+    for (uint32_t c = 0; c < m_channels; c++) {
+        // the side channel has one more bit
+        bool side = (header.assignment == 8 && c == 1) ||
+                    (header.assignment == 9 && c == 0) ||
+                    (header.assignment == 10 && c == 1);
+
+        if (!decodeSubframe(reader, *m_kernels,
+                &frame.samples[c * m_maxBlockSize], header.blockSize,
+                header.bitsPerSample + (side ? 1 : 0))) {
+            return 0;
+        }
+    }
+
+    reader.alignToByte();
+    size_t end = header.size + reader.getBytePosition();
+
+    if (end + 2 > size ||
+        crc16(data, end) != ((data[end] << 8) | data[end + 1])) {
+        return 0;
+    }
+
+    int32_t* left = &frame.samples[0];
+    int32_t* right = &frame.samples[m_maxBlockSize];
+
+    switch (header.assignment) {
+        case 8:
+            m_kernels->leftSide(left, right, header.blockSize);
+            break;
+        case 9:
+            m_kernels->rightSide(left, right, header.blockSize);
+            break;
+        case 10:
+            m_kernels->midSide(left, right, header.blockSize);
+            break;
+    }
+
+    return end + 2;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Decoder.hpp"
+#include "FlacKernels.hpp"
+#include "Md5.hpp"
+#include "SampleFormat.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Native FLAC decoder for up to 8 channels of 4 to 24 bits. With a pool,
+// the PCM cache is refilled by decoding a batch of frames in parallel, the
+// frame boundaries are found by their headers. The CRC of every frame is
+// checked. Samples of more than 16 bits are reduced with TPDF dither.
+class FlacDecoder : public Decoder
+{
+public:
+    FlacDecoder();
+
+    void open(const std::string& path) override;
+    size_t read(int16_t* buffer, size_t frames) override;
+    void seek(uint64_t frame) override;
+    const char* getName() override;
+    void setPool(WorkerPool* pool) override;
+
+    // kernels to decode with, the best ones the CPU has by default
+    void setKernels(FlacKernelSet set);
+
+    // Hashes the decoded samples like the encoder did for the signature in
+    // STREAMINFO. There's a digest once the stream has been decoded from
+    // its start to its end, hashing restarts with a seek to the start.
+    void setHashing(bool enabled);
+    bool getDigest(uint8_t digest[16]);
+    const uint8_t* getSignature();
+    uint32_t getBitsPerSample();
+
+private:
+    struct FrameHeader
+    {
+        uint32_t blockSize;
+        uint32_t assignment;
+        uint32_t bitsPerSample;
+        uint64_t number;
+        bool variable;
+        size_t size;
+    };
+
+    // a decoded frame, channels are planar with room for the largest block
+    struct Frame
+    {
+        uint64_t sample;
+        uint32_t blockSize;
+        uint32_t bitsPerSample;
+        std::vector<int32_t> samples;
+    };
+
+    struct SeekPoint
+    {
+        uint64_t sample;
+        uint64_t offset;
+    };
+
+    std::string m_path;
+    std::ifstream m_file;
+    uint64_t m_fileSize;
+    uint64_t m_audioOffset;
+    const FlacKernels* m_kernels;
+    WorkerPool* m_pool;
+
+    // STREAMINFO and SEEKTABLE
+    uint32_t m_maxBlockSize;
+    uint32_t m_bitsPerSample;
+    uint8_t m_signature[16];
+    std::vector<SeekPoint> m_seekTable;
+
+    // window of the compressed stream, m_inputOffset is its file offset
+    std::vector<uint8_t> m_input;
+    uint64_t m_inputOffset;
+    size_t m_inputPos;
+    size_t m_inputSize;
+    bool m_inputEnded;
+    size_t m_frameBound;
+
+    // frames of the current batch
+    std::vector<Frame> m_batch;
+    std::vector<size_t> m_starts;
+    std::vector<uint8_t> m_decoded;
+
+    // decoded 16 bit stereo waiting to be read
+    std::vector<int16_t> m_pcm;
+    size_t m_pcmPos;
+    size_t m_pcmFrames;
+    uint64_t m_nextSample;
+    uint64_t m_skip;
+
+    // reduction of samples wider than 16 bit
+    const SampleKernels& m_sampleKernels;
+    uint32_t m_dither[4];
+    std::vector<float> m_float;
+
+    Md5 m_md5;
+    bool m_hashing;
+    bool m_hashValid;
+    bool m_hashEnded;
+    bool m_hashFinished;
+    uint8_t m_digest[16];
+    std::vector<uint8_t> m_hashBuffer;
+
+    void readMetadata();
+    bool fillCache();
+    void resizeBatch(size_t count);
+    void ensureInput(size_t bytes);
+    void moveTo(uint64_t offset);
+    size_t findFrame(size_t from, uint64_t sample);
+    bool findFrameAfter(
+        uint64_t from, uint64_t to, uint64_t& offset, uint64_t& sample);
+    void resetHash();
+    void emit(const Frame& frame);
+    void hash(const Frame& frame);
+
+    // thread safe, used by the batch jobs
+    bool parseHeader(
+        const uint8_t* data, size_t size, FrameHeader& header) const;
+    uint64_t getFrameSample(const FrameHeader& header) const;
+    size_t decodeFrame(const uint8_t* data, size_t size, Frame& frame) const;
+};
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include "FlacKernels.hpp"
+
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) ||               \
+    defined(__x86_64__)
+#define FLAC_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics for any instruction set, GCC wants to be told
+#ifdef _MSC_VER
+#define FLAC_TARGET(isa)
+#else
+#define FLAC_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static void restoreLpcScalar(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    for (size_t i = order; i < samples; i++) {
+        int32_t sum = 0;
+        for (uint32_t j = 0; j < order; j++) {
+            sum += coefs[j] * data[i - 1 - j];
+        }
+        data[i] += sum >> shift;
+    }
+}
+
+static void restoreLpcWideScalar(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    for (size_t i = order; i < samples; i++) {
+        int64_t sum = 0;
+        for (uint32_t j = 0; j < order; j++) {
+            sum += static_cast<int64_t>(coefs[j]) * data[i - 1 - j];
+        }
+        data[i] += static_cast<int32_t>(sum >> shift);
+    }
+}
+
+static void leftSideScalar(int32_t* left, int32_t* side, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        side[i] = left[i] - side[i];
+    }
+}
+
+static void rightSideScalar(int32_t* side, int32_t* right, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        side[i] += right[i];
+    }
+}
+
+static void midSideScalar(int32_t* mid, int32_t* side, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        // the bit lost by halving the sum is the low bit of the difference
+        int32_t m = static_cast<int32_t>(
+            (static_cast<uint32_t>(mid[i]) << 1) | (side[i] & 1));
+        mid[i] = (m + side[i]) >> 1;
+        side[i] = (m - side[i]) >> 1;
+    }
+}
+
+#ifdef FLAC_X86
+
+// The prediction of a sample depends on the one before, so there's nothing
+// to vectorize within one sample. Instead, for a block of outputs the terms
+// of all samples before the block are summed with one lane per output. Only
+// the triangle of terms within the block is left to the scalar loop.
+//
+// cw[m] holds coefs[m + lane], so lane b sums coefs[j] * data[i + b - 1 - j]
+// over all j >= b.
+
+FLAC_TARGET("sse4.1")
+static void restoreLpcSse41(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    // the triangle outweighs the lanes for short predictors
+    if (order < 4) {
+        restoreLpcScalar(data, samples, coefs, order, shift);
+        return;
+    }
+
+    int32_t padded[FLAC_MAX_LPC_ORDER + 4] = {};
+    memcpy(padded, coefs, order * sizeof(int32_t));
+
+    __m128i cw[FLAC_MAX_LPC_ORDER];
+    for (uint32_t m = 0; m < order; m++) {
+        cw[m] = _mm_loadu_si128(reinterpret_cast<__m128i*>(padded + m));
+    }
+
+    size_t i = order;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t m = 0; m < order; m++) {
+            sum = _mm_add_epi32(sum,
+                _mm_mullo_epi32(_mm_set1_epi32(data[i - 1 - m]), cw[m]));
+        }
+
+        int32_t known[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(known), sum);
+
+        for (uint32_t b = 0; b < 4; b++) {
+            int32_t s = known[b];
+            for (uint32_t j = 0; j < b; j++) {
+                s += coefs[j] * data[i + b - 1 - j];
+            }
+            data[i + b] += s >> shift;
+        }
+    }
+
+    for (; i < samples; i++) {
+        int32_t sum = 0;
+        for (uint32_t j = 0; j < order; j++) {
+            sum += coefs[j] * data[i - 1 - j];
+        }
+        data[i] += sum >> shift;
+    }
+}
+
+FLAC_TARGET("sse4.1")
+static void restoreLpcWideSse41(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    if (order < 4) {
+        restoreLpcWideScalar(data, samples, coefs, order, shift);
+        return;
+    }
+
+    // _mm_mul_epi32 multiplies the low halves of the two 64 bit lanes
+    __m128i cw[FLAC_MAX_LPC_ORDER];
+    for (uint32_t m = 0; m < order; m++) {
+        cw[m] = _mm_set_epi32(
+            0, m + 1 < order ? coefs[m + 1] : 0, 0, coefs[m]);
+    }
+
+    size_t i = order;
+
+    for (; i + 2 <= samples; i += 2) {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t m = 0; m < order; m++) {
+            sum = _mm_add_epi64(
+                sum, _mm_mul_epi32(_mm_set1_epi32(data[i - 1 - m]), cw[m]));
+        }
+
+        int64_t known[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(known), sum);
+
+        data[i] += static_cast<int32_t>(known[0] >> shift);
+        data[i + 1] += static_cast<int32_t>(
+            (known[1] + static_cast<int64_t>(coefs[0]) * data[i]) >> shift);
+    }
+
+    restoreLpcWideScalar(data + i - order, samples - (i - order), coefs,
+        order, shift);
+}
+
+FLAC_TARGET("avx2")
+static void restoreLpcAvx2(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    if (order < 8) {
+        restoreLpcSse41(data, samples, coefs, order, shift);
+        return;
+    }
+
+    int32_t padded[FLAC_MAX_LPC_ORDER + 8] = {};
+    memcpy(padded, coefs, order * sizeof(int32_t));
+
+    __m256i cw[FLAC_MAX_LPC_ORDER];
+    for (uint32_t m = 0; m < order; m++) {
+        cw[m] = _mm256_loadu_si256(reinterpret_cast<__m256i*>(padded + m));
+    }
+
+    size_t i = order;
+
+    for (; i + 8 <= samples; i += 8) {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32_t m = 0; m < order; m++) {
+            sum = _mm256_add_epi32(sum,
+                _mm256_mullo_epi32(_mm256_set1_epi32(data[i - 1 - m]), cw[m]));
+        }
+
+        int32_t known[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(known), sum);
+
+        for (uint32_t b = 0; b < 8; b++) {
+            int32_t s = known[b];
+            for (uint32_t j = 0; j < b; j++) {
+                s += coefs[j] * data[i + b - 1 - j];
+            }
+            data[i + b] += s >> shift;
+        }
+    }
+
+    restoreLpcScalar(data + i - order, samples - (i - order), coefs, order,
+        shift);
+}
+
+FLAC_TARGET("avx2")
+static void restoreLpcWideAvx2(int32_t* data, size_t samples,
+    const int32_t* coefs, uint32_t order, uint32_t shift)
+{
+    if (order < 8) {
+        restoreLpcWideSse41(data, samples, coefs, order, shift);
+        return;
+    }
+
+    __m256i cw[FLAC_MAX_LPC_ORDER];
+    for (uint32_t m = 0; m < order; m++) {
+        int32_t c[4];
+        for (uint32_t b = 0; b < 4; b++) {
+            c[b] = m + b < order ? coefs[m + b] : 0;
+        }
+        cw[m] = _mm256_setr_epi32(c[0], 0, c[1], 0, c[2], 0, c[3], 0);
+    }
+
+    size_t i = order;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32_t m = 0; m < order; m++) {
+            sum = _mm256_add_epi64(sum,
+                _mm256_mul_epi32(_mm256_set1_epi32(data[i - 1 - m]), cw[m]));
+        }
+
+        int64_t known[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(known), sum);
+
+        for (uint32_t b = 0; b < 4; b++) {
+            int64_t s = known[b];
+            for (uint32_t j = 0; j < b; j++) {
+                s += static_cast<int64_t>(coefs[j]) * data[i + b - 1 - j];
+            }
+            data[i + b] += static_cast<int32_t>(s >> shift);
+        }
+    }
+
+    restoreLpcWideScalar(data + i - order, samples - (i - order), coefs,
+        order, shift);
+}
+
+FLAC_TARGET("sse4.1")
+static void leftSideSse41(int32_t* left, int32_t* side, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        __m128i l = _mm_loadu_si128(reinterpret_cast<__m128i*>(left + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<__m128i*>(side + i));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(side + i), _mm_sub_epi32(l, s));
+    }
+    leftSideScalar(left + i, side + i, samples - i);
+}
+
+FLAC_TARGET("sse4.1")
+static void rightSideSse41(int32_t* side, int32_t* right, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<__m128i*>(side + i));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<__m128i*>(right + i));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(side + i), _mm_add_epi32(s, r));
+    }
+    rightSideScalar(side + i, right + i, samples - i);
+}
+
+FLAC_TARGET("sse4.1")
+static void midSideSse41(int32_t* mid, int32_t* side, size_t samples)
+{
+    const __m128i one = _mm_set1_epi32(1);
+
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        __m128i m = _mm_loadu_si128(reinterpret_cast<__m128i*>(mid + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<__m128i*>(side + i));
+        m = _mm_or_si128(_mm_slli_epi32(m, 1), _mm_and_si128(s, one));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mid + i),
+            _mm_srai_epi32(_mm_add_epi32(m, s), 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(side + i),
+            _mm_srai_epi32(_mm_sub_epi32(m, s), 1));
+    }
+    midSideScalar(mid + i, side + i, samples - i);
+}
+
+FLAC_TARGET("avx2")
+static void leftSideAvx2(int32_t* left, int32_t* side, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<__m256i*>(left + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<__m256i*>(side + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(side + i), _mm256_sub_epi32(l, s));
+    }
+    leftSideScalar(left + i, side + i, samples - i);
+}
+
+FLAC_TARGET("avx2")
+static void rightSideAvx2(int32_t* side, int32_t* right, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<__m256i*>(side + i));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<__m256i*>(right + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(side + i), _mm256_add_epi32(s, r));
+    }
+    rightSideScalar(side + i, right + i, samples - i);
+}
+
+FLAC_TARGET("avx2")
+static void midSideAvx2(int32_t* mid, int32_t* side, size_t samples)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i m = _mm256_loadu_si256(reinterpret_cast<__m256i*>(mid + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<__m256i*>(side + i));
+        m = _mm256_or_si256(_mm256_slli_epi32(m, 1), _mm256_and_si256(s, one));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mid + i),
+            _mm256_srai_epi32(_mm256_add_epi32(m, s), 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(side + i),
+            _mm256_srai_epi32(_mm256_sub_epi32(m, s), 1));
+    }
+    midSideScalar(mid + i, side + i, samples - i);
+}
+
+#endif
+
+static const FlacKernels kernels[] = {
+    {restoreLpcScalar, restoreLpcWideScalar, leftSideScalar, rightSideScalar,
+        midSideScalar},
+#ifdef FLAC_X86
+    {restoreLpcSse41, restoreLpcWideSse41, leftSideSse41, rightSideSse41,
+        midSideSse41},
+    {restoreLpcAvx2, restoreLpcWideAvx2, leftSideAvx2, rightSideAvx2,
+        midSideAvx2},
+#endif
+};
+
+bool FlacKernels::isSupported(FlacKernelSet set)
+{
+    if (set == FlacKernelsScalar) {
+        return true;
+    }
+
+#if defined(FLAC_X86) && defined(_MSC_VER)
+    int32_t info[4];
+    __cpuid(info, 1);
+
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    if (set == FlacKernelsSse41) {
+        return sse41;
+    }
+
+    // AVX needs the OS to save the upper register halves
+    bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+               (_xgetbv(0) & 6) == 6;
+
+    __cpuidex(info, 7, 0);
+    return sse41 && avx && (info[1] & (1 << 5));
+#elif defined(FLAC_X86)
+    if (set == FlacKernelsSse41) {
+        return __builtin_cpu_supports("sse4.1");
+    }
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+FlacKernelSet FlacKernels::getBest()
+{
+    static const FlacKernelSet best =
+        isSupported(FlacKernelsAvx2)    ? FlacKernelsAvx2
+        : isSupported(FlacKernelsSse41) ? FlacKernelsSse41
+                                        : FlacKernelsScalar;
+    return best;
+}
+
+const FlacKernels& FlacKernels::get(FlacKernelSet set)
+{
+    return isSupported(set) ? kernels[set] : kernels[FlacKernelsScalar];
+}
+
+const char* FlacKernels::getName(FlacKernelSet set)
+{
+    static const char* names[] = {"scalar", "sse4.1", "avx2"};
+    return names[set];
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// highest LPC order FLAC allows
+#define FLAC_MAX_LPC_ORDER 32
+
+// instruction sets the FLAC kernels come in
+enum FlacKernelSet
+{
+    FlacKernelsScalar,
+    FlacKernelsSse41,
+    FlacKernelsAvx2
+};
+
+// The hot loops of FLAC decoding. All of them work in place on the planar
+// int32 channel buffers of a frame.
+struct FlacKernels
+{
+    // Restores an LPC subframe. The first order samples are the warm-up, the
+    // rest holds the residual and gets replaced by the signal. The 32 bit
+    // version requires bits per sample + coefficient precision + log2 of the
+    // order to be at most 32, the wide one accumulates in 64 bits.
+    void (*restoreLpc)(int32_t* data, size_t samples, const int32_t* coefs,
+        uint32_t order, uint32_t shift);
+    void (*restoreLpcWide)(int32_t* data, size_t samples,
+        const int32_t* coefs, uint32_t order, uint32_t shift);
+
+    // Undo the stereo decorrelation, left ends up in the first channel and
+    // right in the second.
+    void (*leftSide)(int32_t* left, int32_t* side, size_t samples);
+    void (*rightSide)(int32_t* side, int32_t* right, size_t samples);
+    void (*midSide)(int32_t* mid, int32_t* side, size_t samples);
+
+    // the fastest set the CPU supports
+    static FlacKernelSet getBest();
+    static bool isSupported(FlacKernelSet set);
+    static const FlacKernels& get(FlacKernelSet set);
+    static const char* getName(FlacKernelSet set);
+};
\ No newline at end of file
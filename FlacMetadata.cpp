@@ -0,0 +1,172 @@
+#include "FlacMetadata.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#define FLAC_BLOCK_STREAMINFO 0
+#define FLAC_BLOCK_VORBIS_COMMENT 4
+#define FLAC_STREAMINFO_SIZE 34
+
+// comment blocks are small, anything bigger is most likely broken
+#define FLAC_MAX_COMMENT_SIZE (1 << 20)
+
+static std::string toUpper(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return static_cast<char>(toupper(c)); });
+    return value;
+}
+
+static uint32_t readLE32(const std::string& data, size_t offset)
+{
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(data.data() + offset);
+    return p[0] | (p[1] << 8) | (p[2] << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+FlacMetadata::FlacMetadata(const std::string& path)
+    : m_valid(false)
+    , m_streamInfo({})
+{
+    std::ifstream file(path, std::ios::binary);
+
+    char magic[4];
+    if (!file.read(magic, 4) || std::string(magic, 4) != "fLaC") {
+        return;
+    }
+
+    // walk the metadata blocks until the last one
+    bool last = false;
+    while (!last) {
+        unsigned char header[4];
+        if (!file.read(reinterpret_cast<char*>(header), 4)) {
+            return;
+        }
+
+        last = (header[0] & 0x80) != 0;
+        int32_t type = header[0] & 0x7f;
+        uint32_t size = (header[1] << 16) | (header[2] << 8) | header[3];
+
+        bool wanted = type == FLAC_BLOCK_STREAMINFO ||
+                      type == FLAC_BLOCK_VORBIS_COMMENT;
+
+        if (!wanted || size > FLAC_MAX_COMMENT_SIZE) {
+            file.seekg(size, std::ios::cur);
+            continue;
+        }
+
+        std::string block(size, '\0');
+        if (!file.read(&block[0], size)) {
+            return;
+        }
+
+        if (type == FLAC_BLOCK_STREAMINFO) {
+            parseStreamInfo(block);
+        } else {
+            parseComments(block);
+        }
+    }
+}
+
+void FlacMetadata::parseStreamInfo(const std::string& block)
+{
+    if (block.size() < FLAC_STREAMINFO_SIZE) {
+        return;
+    }
+
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(block.data());
+
+    // after the block and frame sizes: 20 bits sample rate, 3 bits channels
+    // minus one, 5 bits sample size minus one, 36 bits sample count and the
+    // MD5 signature
+    m_streamInfo.sampleRate = (p[10] << 12) | (p[11] << 4) | (p[12] >> 4);
+    m_streamInfo.channels = ((p[12] >> 1) & 7) + 1;
+    m_streamInfo.bitsPerSample = (((p[12] & 1) << 4) | (p[13] >> 4)) + 1;
+    m_streamInfo.totalSamples = (static_cast<uint64_t>(p[13] & 15) << 32) |
+                                (static_cast<uint32_t>(p[14]) << 24) |
+                                (p[15] << 16) | (p[16] << 8) | p[17];
+    memcpy(m_streamInfo.md5, p + 18, sizeof(m_streamInfo.md5));
+
+    m_valid = true;
+}
+
+void FlacMetadata::parseComments(const std::string& block)
+{
+    // vendor string, comment count and "NAME=value" comments, all lengths
+    // are little endian
+    size_t offset = 0;
+
+    if (block.size() < 4) {
+        return;
+    }
+    offset += 4 + static_cast<size_t>(readLE32(block, 0));
+
+    if (offset + 4 > block.size()) {
+        return;
+    }
+    uint32_t count = readLE32(block, offset);
+    offset += 4;
+
+    for (uint32_t i = 0; i < count && offset + 4 <= block.size(); i++) {
+        size_t length = readLE32(block, offset);
+        offset += 4;
+
+        if (length > block.size() - offset) {
+            break;
+        }
+
+        std::string comment = block.substr(offset, length);
+        offset += length;
+
+        size_t separator = comment.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+
+        m_tags[toUpper(comment.substr(0, separator))] =
+            comment.substr(separator + 1);
+    }
+
+    LOG_TRACE("Read %zu tags", m_tags.size());
+}
+
+bool FlacMetadata::isValid()
+{
+    return m_valid;
+}
+
+const FlacStreamInfo& FlacMetadata::getStreamInfo()
+{
+    return m_streamInfo;
+}
+
+bool FlacMetadata::has(const std::string& name)
+{
+    return m_tags.find(toUpper(name)) != m_tags.end();
+}
+
+std::string FlacMetadata::get(const std::string& name)
+{
+    auto tag = m_tags.find(toUpper(name));
+    return tag != m_tags.end() ? tag->second : std::string();
+}
+
+int64_t FlacMetadata::getInt(const std::string& name, int64_t defaultValue)
+{
+    std::string value = get(name);
+
+    // tags are free text, don't trust them to be numbers
+    char* end = nullptr;
+    long long number = strtoll(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < 0) {
+        return defaultValue;
+    }
+
+    return number;
+}
\ No newline at end of file
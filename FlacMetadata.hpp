@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// STREAMINFO block of a FLAC file
+struct FlacStreamInfo
+{
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t bitsPerSample;
+    uint64_t totalSamples;
+
+    // signature of the decoded audio, all zero if the encoder didn't set it
+    uint8_t md5[16];
+};
+
+// Stream info and Vorbis comments from the metadata of a FLAC file. Tag
+// names are case insensitive, files without comments simply have no tags.
+class FlacMetadata
+{
+public:
+    FlacMetadata(const std::string& path);
+
+    // false if the file isn't FLAC
+    bool isValid();
+    const FlacStreamInfo& getStreamInfo();
+
+    bool has(const std::string& name);
+    std::string get(const std::string& name);
+    int64_t getInt(const std::string& name, int64_t defaultValue);
+
+private:
+    bool m_valid;
+    FlacStreamInfo m_streamInfo;
+    std::map<std::string, std::string> m_tags;
+
+    void parseStreamInfo(const std::string& block);
+    void parseComments(const std::string& block);
+};
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "FormatBenchmark.hpp"
+#include "Logger.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+
+// samples converted per call, about 12 seconds of stereo audio
+#define BENCHMARK_SAMPLES (1 << 20)
+
+// minimum time spent on each path
+#define BENCHMARK_SECONDS 0.5
+
+// mixer samples per second of audio
+#define REALTIME_SAMPLES (44100.0 * 2)
+
+static double getSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool FormatBenchmark::run(const std::string& reportPath)
+{
+    // a mix that goes past full scale now and then so the clamps get hit
+    std::vector<float> mix(BENCHMARK_SAMPLES);
+    uint32_t random = 0x12345678;
+    for (size_t i = 0; i < mix.size(); i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        mix[i] = (static_cast<int32_t>(random) >> 15) * 0.6f;
+    }
+
+    std::vector<float> floats(BENCHMARK_SAMPLES);
+    std::vector<uint8_t> samples(BENCHMARK_SAMPLES * sizeof(float));
+
+    // scalar output of each path without dither, to compare against
+    std::vector<std::vector<uint8_t>> reference;
+
+    LOG_INFO("Benchmarking sample format conversions");
+
+    for (int32_t set = SampleKernelsScalar; set <= SampleKernels::getBest();
+         set++) {
+        SampleKernelSet kernelSet = static_cast<SampleKernelSet>(set);
+        const SampleKernels& kernels = SampleKernels::get(kernelSet);
+        size_t path = 0;
+
+        for (int32_t direction = 0; direction < 2; direction++) {
+            for (int32_t index = 0; index < SAMPLE_FORMATS; index++) {
+                SampleFormat format = static_cast<SampleFormat>(index);
+                bool toFloat = direction == 1;
+
+                // only the formats below float resolution are dithered
+                bool dithered =
+                    format == SampleInt16 || format == SampleInt24;
+                int32_t variants = !toFloat && dithered ? 2 : 1;
+
+                for (int32_t dither = 0; dither < variants;
+                     dither++) {
+                    Run run = {};
+                    run.path = std::string(toFloat ? "to float from " :
+                                                     "from float to ") +
+                               SampleKernels::getFormatName(format) +
+                               (dither ? " dithered" : "");
+                    run.kernels = kernelSet;
+
+                    uint32_t state[4];
+                    SampleKernels::seedDither(state);
+
+                    // the packed input of the reverse conversions
+                    if (toFloat) {
+                        kernels.fromFloat[format](&samples[0], &mix[0],
+                            BENCHMARK_SAMPLES, state, false);
+                    }
+
+                    double start = getSeconds();
+                    do {
+                        if (toFloat) {
+                            kernels.toFloat[format](
+                                &floats[0], &samples[0], BENCHMARK_SAMPLES);
+                        } else {
+                            kernels.fromFloat[format](&samples[0], &mix[0],
+                                BENCHMARK_SAMPLES, state, dither != 0);
+                        }
+                        run.samples += BENCHMARK_SAMPLES;
+                        run.seconds = getSeconds() - start;
+                    } while (run.seconds < BENCHMARK_SECONDS);
+
+                    // dither noise differs between the lane layouts
+                    if (dither) {
+                        run.result = "dithered";
+                    } else {
+                        const uint8_t* data = toFloat ?
+                            reinterpret_cast<const uint8_t*>(&floats[0]) :
+                            &samples[0];
+                        size_t sampleSize = toFloat ?
+                            sizeof(float) :
+                            SampleKernels::getSampleSize(format);
+                        std::vector<uint8_t> output(
+                            data, data + BENCHMARK_SAMPLES * sampleSize);
+
+                        if (set == SampleKernelsScalar) {
+                            reference.push_back(output);
+                            run.result = "reference";
+                        } else if (path < reference.size() &&
+                                   reference[path] == output) {
+                            run.result = "match";
+                        } else {
+                            run.result = "mismatch";
+                        }
+                        path++;
+                    }
+
+                    m_runs.push_back(run);
+                }
+            }
+        }
+    }
+
+    return writeReport(reportPath);
+}
+
+bool FormatBenchmark::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return false;
+    }
+
+    fprintf(file, "conversion\tkernels\tMsamples/s\tspeed\tresult\n");
+
+    int32_t mismatches = 0;
+
+    for (const Run& run : m_runs) {
+        double rate = run.seconds > 0 ? run.samples / run.seconds : 0.0;
+
+        fprintf(file, "%s\t%s\t%.1f\t%.0fx\t%s\n", run.path.c_str(),
+            SampleKernels::getName(run.kernels), rate / 1e6,
+            rate / REALTIME_SAMPLES, run.result.c_str());
+
+        if (run.result == "mismatch") {
+            mismatches++;
+        }
+    }
+
+    fclose(file);
+
+    LOG_INFO("Benchmarked %zu sample conversions, %d differ from scalar, "
+             "see %s",
+        m_runs.size(), mismatches, reportPath.c_str());
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SampleFormat.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Times every conversion between the mixer floats and the output formats
+// with each kernel set the build has. Writes the throughput in samples per
+// second and multiples of realtime, and whether the vector kernels produce
+// the same samples as the scalar ones.
+class FormatBenchmark
+{
+public:
+    // false if the report can't be written
+    bool run(const std::string& reportPath);
+
+private:
+    struct Run
+    {
+        std::string path;
+        SampleKernelSet kernels;
+        double samples;
+        double seconds;
+        std::string result;
+    };
+
+    std::vector<Run> m_runs;
+
+    bool writeReport(const std::string& reportPath);
+};
\ No newline at end of file
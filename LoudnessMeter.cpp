@@ -0,0 +1,254 @@
+#include "LoudnessMeter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) ||            \
+    defined(__SSE2__)
+#define LOUDNESS_SSE2
+#include <emmintrin.h>
+#endif
+
+#define LOUDNESS_PI 3.14159265358979323846
+
+// BS.1770 filter parameters, which give its 48 kHz coefficients
+#define SHELF_FREQUENCY 1681.974450955533
+#define SHELF_GAIN_DB 3.999843853973347
+#define SHELF_Q 0.7071752369554196
+#define HIGH_PASS_FREQUENCY 38.13547087602444
+#define HIGH_PASS_Q 0.5003270373238773
+
+// gating block length in 100 ms blocks
+#define GATE_BLOCKS 4
+
+// relative gate below the loudness of the blocks above the absolute gate
+#define RELATIVE_GATE -10.0
+
+static double toLoudness(double meanSquare)
+{
+    return -0.691 + 10.0 * log10(meanSquare);
+}
+
+static double toMeanSquare(double loudness)
+{
+    return pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+LoudnessMeter::LoudnessMeter(uint32_t sampleRate, uint32_t channels)
+    : m_state()
+    , m_channels((std::min)(channels, 2u))
+    , m_blockFrames((std::max)(sampleRate / 10, 1u))
+    , m_frames(0)
+    , m_energy()
+    , m_peak(0.0)
+{
+    // the filters are derived for the file's own rate
+    double k = tan(LOUDNESS_PI * SHELF_FREQUENCY / sampleRate);
+    double vh = pow(10.0, SHELF_GAIN_DB / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / SHELF_Q + k * k;
+
+    m_shelf[0] = (vh + vb * k / SHELF_Q + k * k) / a0;
+    m_shelf[1] = 2.0 * (k * k - vh) / a0;
+    m_shelf[2] = (vh - vb * k / SHELF_Q + k * k) / a0;
+    m_shelf[3] = 2.0 * (k * k - 1.0) / a0;
+    m_shelf[4] = (1.0 - k / SHELF_Q + k * k) / a0;
+
+    k = tan(LOUDNESS_PI * HIGH_PASS_FREQUENCY / sampleRate);
+    a0 = 1.0 + k / HIGH_PASS_Q + k * k;
+
+    m_highPass[0] = 1.0;
+    m_highPass[1] = -2.0;
+    m_highPass[2] = 1.0;
+    m_highPass[3] = 2.0 * (k * k - 1.0) / a0;
+    m_highPass[4] = (1.0 - k / HIGH_PASS_Q + k * k) / a0;
+}
+
+#ifdef LOUDNESS_SSE2
+
+void LoudnessMeter::add(const int16_t* samples, size_t frames)
+{
+    // one lane per channel
+    __m128d shelf[5];
+    __m128d highPass[5];
+    for (int32_t i = 0; i < 5; i++) {
+        shelf[i] = _mm_set1_pd(m_shelf[i]);
+        highPass[i] = _mm_set1_pd(m_highPass[i]);
+    }
+
+    __m128d z[4];
+    for (int32_t i = 0; i < 4; i++) {
+        z[i] = _mm_loadu_pd(m_state[i]);
+    }
+
+    const __m128d scale = _mm_set1_pd(1.0 / 32768);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d peak = _mm_set1_pd(m_peak);
+
+    while (frames) {
+        uint32_t count = static_cast<uint32_t>((std::min)(
+            frames, static_cast<size_t>(m_blockFrames - m_frames)));
+        __m128d energy = _mm_loadu_pd(m_energy);
+
+        for (uint32_t i = 0; i < count; i++, samples += 2) {
+            int32_t frame;
+            memcpy(&frame, samples, sizeof(frame));
+
+            // sign extend both samples to 32 bit
+            __m128i pair = _mm_cvtsi32_si128(frame);
+            pair = _mm_srai_epi32(_mm_unpacklo_epi16(pair, pair), 16);
+            __m128d x = _mm_mul_pd(_mm_cvtepi32_pd(pair), scale);
+
+            peak = _mm_max_pd(peak, _mm_andnot_pd(sign, x));
+
+            __m128d y = _mm_add_pd(_mm_mul_pd(shelf[0], x), z[0]);
+            z[0] = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(shelf[1], x),
+                                  _mm_mul_pd(shelf[3], y)),
+                z[1]);
+            z[1] = _mm_sub_pd(
+                _mm_mul_pd(shelf[2], x), _mm_mul_pd(shelf[4], y));
+
+            x = y;
+            y = _mm_add_pd(_mm_mul_pd(highPass[0], x), z[2]);
+            z[2] = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(highPass[1], x),
+                                  _mm_mul_pd(highPass[3], y)),
+                z[3]);
+            z[3] = _mm_sub_pd(
+                _mm_mul_pd(highPass[2], x), _mm_mul_pd(highPass[4], y));
+
+            energy = _mm_add_pd(energy, _mm_mul_pd(y, y));
+        }
+
+        _mm_storeu_pd(m_energy, energy);
+        m_frames += count;
+        frames -= count;
+
+        if (m_frames == m_blockFrames) {
+            endBlock();
+        }
+    }
+
+    for (int32_t i = 0; i < 4; i++) {
+        _mm_storeu_pd(m_state[i], z[i]);
+    }
+
+    double peaks[2];
+    _mm_storeu_pd(peaks, peak);
+    m_peak = (std::max)(peaks[0], peaks[1]);
+}
+
+#else
+
+// one biquad step for one channel
+static inline double filter(const double c[5], double* z1, double* z2,
+    double x)
+{
+    double y = c[0] * x + *z1;
+    *z1 = c[1] * x - c[3] * y + *z2;
+    *z2 = c[2] * x - c[4] * y;
+    return y;
+}
+
+void LoudnessMeter::add(const int16_t* samples, size_t frames)
+{
+    while (frames) {
+        uint32_t count = static_cast<uint32_t>((std::min)(
+            frames, static_cast<size_t>(m_blockFrames - m_frames)));
+
+        for (uint32_t i = 0; i < count; i++, samples += 2) {
+            for (int32_t channel = 0; channel < 2; channel++) {
+                double x = samples[channel] * (1.0 / 32768);
+                m_peak = (std::max)(m_peak, fabs(x));
+
+                double y = filter(m_shelf, &m_state[0][channel],
+                    &m_state[1][channel], x);
+                y = filter(m_highPass, &m_state[2][channel],
+                    &m_state[3][channel], y);
+
+                m_energy[channel] += y * y;
+            }
+        }
+
+        m_frames += count;
+        frames -= count;
+
+        if (m_frames == m_blockFrames) {
+            endBlock();
+        }
+    }
+}
+
+#endif
+
+void LoudnessMeter::endBlock()
+{
+    // channel weights are 1 for left and right
+    double energy = m_energy[0] + (m_channels > 1 ? m_energy[1] : 0.0);
+    m_blocks.push_back(energy / m_blockFrames);
+
+    m_energy[0] = 0.0;
+    m_energy[1] = 0.0;
+    m_frames = 0;
+}
+
+double LoudnessMeter::getIntegrated()
+{
+    // gating blocks above the absolute gate
+    std::vector<double> gated;
+    double threshold = toMeanSquare(LOUDNESS_SILENCE);
+
+    for (size_t i = 0; i + GATE_BLOCKS <= m_blocks.size(); i++) {
+        double meanSquare = 0.0;
+        for (size_t j = i; j < i + GATE_BLOCKS; j++) {
+            meanSquare += m_blocks[j];
+        }
+        meanSquare /= GATE_BLOCKS;
+
+        if (meanSquare > threshold) {
+            gated.push_back(meanSquare);
+        }
+    }
+
+    if (gated.empty()) {
+        return LOUDNESS_SILENCE;
+    }
+
+    double sum = 0.0;
+    for (double meanSquare : gated) {
+        sum += meanSquare;
+    }
+
+    // then those above the relative gate
+    threshold = toMeanSquare(toLoudness(sum / gated.size()) + RELATIVE_GATE);
+    sum = 0.0;
+    size_t count = 0;
+
+    for (double meanSquare : gated) {
+        if (meanSquare > threshold) {
+            sum += meanSquare;
+            count++;
+        }
+    }
+
+    return count ? toLoudness(sum / count) : LOUDNESS_SILENCE;
+}
+
+double LoudnessMeter::getPeak()
+{
+    return m_peak;
+}
+
+float LoudnessMeter::getGain(double loudness, double peak, double target)
+{
+    if (loudness <= LOUDNESS_SILENCE) {
+        return 1.0f;
+    }
+
+    double gain = pow(10.0, (target - loudness) / 20.0);
+    if (peak > 0.0) {
+        gain = (std::min)(gain, 1.0 / peak);
+    }
+
+    return static_cast<float>(gain);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// loudness of tracks without any block above the absolute gate
+#define LOUDNESS_SILENCE -70.0
+
+// Integrated loudness after EBU R128 / ITU-R BS.1770 of interleaved 16 bit
+// stereo, fed in pieces of any size. Both channels go through the K-weighting
+// filters together, in one SSE2 register if the build targets it.
+class LoudnessMeter
+{
+public:
+    // mono sources decoded to two equal channels are measured as one
+    LoudnessMeter(uint32_t sampleRate, uint32_t channels);
+
+    void add(const int16_t* samples, size_t frames);
+
+    // in LUFS, LOUDNESS_SILENCE if everything was gated away
+    double getIntegrated();
+
+    // largest sample magnitude, 1.0 is full scale
+    double getPeak();
+
+    // Linear gain that brings the loudness to the target, lowered so that
+    // the peak doesn't clip.
+    static float getGain(double loudness, double peak, double target);
+
+private:
+    // K-weighting, a high shelf and a high pass biquad, in the order
+    // b0 b1 b2 a1 a2
+    double m_shelf[5];
+    double m_highPass[5];
+
+    // transposed direct form II state of both biquads per channel
+    double m_state[4][2];
+
+    uint32_t m_channels;
+    uint32_t m_blockFrames;
+    uint32_t m_frames;
+    double m_energy[2];
+    double m_peak;
+
+    // mean square of each 100 ms block, 400 ms gating blocks overlap by 3
+    std::vector<double> m_blocks;
+
+    void endBlock();
+};
\ No newline at end of file
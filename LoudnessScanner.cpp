@@ -0,0 +1,215 @@
+#include "LoudnessScanner.hpp"
+#include "Decoder.hpp"
+#include "FlacMetadata.hpp"
+#include "LoudnessMeter.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <Windows.h>
+
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+
+// number of frames decoded at once
+#define SCAN_BLOCK_FRAMES 4096
+
+// loudness ReplayGain 2.0 tags are relative to
+#define REPLAYGAIN_REFERENCE -18.0
+
+LoudnessScanner::LoudnessScanner(CDTrackList& tracks, WorkerPool& pool,
+    const std::string& cachePath, double target, bool useTags)
+    : m_tracks(tracks)
+    , m_jobs(pool)
+    , m_cachePath(cachePath)
+    , m_target(target)
+    , m_useTags(useTags)
+    , m_cancel(false)
+{
+    for (auto& trackPair : tracks.map()) {
+        const CDTrack& track = trackPair.second;
+        if (track.path.empty()) {
+            continue;
+        }
+
+        Entry entry = {};
+        entry.track = trackPair.first;
+        entry.path = track.path;
+        entry.name = track.path.substr(tracks.getDirectory().size() + 1);
+        entry.codec = track.codec;
+
+        // a changed file is measured again
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (GetFileAttributesEx(
+                track.path.c_str(), GetFileExInfoStandard, &data)) {
+            entry.size =
+                (static_cast<uint64_t>(data.nFileSizeHigh) << 32) |
+                data.nFileSizeLow;
+            entry.time =
+                (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime)
+                    << 32) |
+                data.ftLastWriteTime.dwLowDateTime;
+        }
+
+        m_entries.push_back(entry);
+    }
+
+    m_thread = std::thread(&LoudnessScanner::run, this);
+}
+
+LoudnessScanner::~LoudnessScanner()
+{
+    m_cancel = true;
+    m_thread.join();
+}
+
+void LoudnessScanner::run()
+{
+    loadCache();
+
+    int32_t measured = 0;
+
+    for (Entry& entry : m_entries) {
+        if (entry.known || (m_useTags && readTags(entry))) {
+            apply(entry);
+            continue;
+        }
+
+        m_jobs.submit([this, &entry] { measure(entry); });
+        measured++;
+    }
+
+    LOG_INFO("Measuring the loudness of %d of %zu tracks", measured,
+        m_entries.size());
+
+    m_jobs.wait();
+
+    // what was measured before a cancel is kept for the next scan
+    if (m_cancel) {
+        LOG_INFO("Loudness scan cancelled");
+    }
+
+    saveCache();
+}
+
+void LoudnessScanner::loadCache()
+{
+    FILE* file = fopen(m_cachePath.c_str(), "r");
+    if (!file) {
+        return;
+    }
+
+    // one "loudness peak size time name" line per file
+    double loudness;
+    double peak;
+    unsigned long long size;
+    unsigned long long time;
+    char name[MAX_PATH];
+
+    while (fscanf(file, "%lf %lf %llu %llu %259[^\n]", &loudness, &peak,
+               &size, &time, name) == 5) {
+        for (Entry& entry : m_entries) {
+            if (entry.name == name && entry.size == size &&
+                entry.time == time) {
+                entry.loudness = loudness;
+                entry.peak = peak;
+                entry.known = true;
+            }
+        }
+    }
+
+    fclose(file);
+}
+
+bool LoudnessScanner::readTags(Entry& entry)
+{
+    // only FLAC files have a tag reader
+    if (entry.codec != "flac") {
+        return false;
+    }
+
+    FlacMetadata metadata(entry.path);
+    if (!metadata.has("REPLAYGAIN_TRACK_GAIN")) {
+        return false;
+    }
+
+    // the gain is written like "-6.52 dB"
+    std::string gain = metadata.get("REPLAYGAIN_TRACK_GAIN");
+    char* end;
+    double value = strtod(gain.c_str(), &end);
+    if (end == gain.c_str()) {
+        return false;
+    }
+
+    entry.loudness = REPLAYGAIN_REFERENCE - value;
+    entry.peak = atof(metadata.get("REPLAYGAIN_TRACK_PEAK").c_str());
+    entry.known = true;
+
+    LOG_TRACE("%s: ReplayGain %s", entry.name.c_str(), gain.c_str());
+    return true;
+}
+
+void LoudnessScanner::measure(Entry& entry)
+{
+    if (m_cancel) {
+        return;
+    }
+
+    Decoder* decoder = Decoder::create(entry.codec);
+
+    try {
+        decoder->open(entry.path);
+
+        LoudnessMeter meter(decoder->getSampleRate(), decoder->getChannels());
+        std::vector<int16_t> buffer(SCAN_BLOCK_FRAMES * 2);
+        size_t frames;
+
+        while (!m_cancel &&
+               (frames = decoder->read(&buffer[0], SCAN_BLOCK_FRAMES))) {
+            meter.add(&buffer[0], frames);
+        }
+
+        if (!m_cancel) {
+            entry.loudness = meter.getIntegrated();
+            entry.peak = meter.getPeak();
+            entry.known = true;
+        }
+    } catch (const WinMMError& ex) {
+        LOG_INFO("%s: %s", entry.path.c_str(), ex.what());
+    }
+
+    delete decoder;
+
+    if (entry.known) {
+        apply(entry);
+    }
+}
+
+void LoudnessScanner::apply(const Entry& entry)
+{
+    float gain = LoudnessMeter::getGain(entry.loudness, entry.peak, m_target);
+    m_tracks.setGain(entry.track, gain);
+
+    LOG_TRACE("Track %d: %.1f LUFS, peak %.3f, gain %.1f dB", entry.track,
+        entry.loudness, entry.peak, 20.0 * log10(gain));
+}
+
+void LoudnessScanner::saveCache()
+{
+    FILE* file = fopen(m_cachePath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", m_cachePath.c_str());
+        return;
+    }
+
+    for (const Entry& entry : m_entries) {
+        if (entry.known) {
+            fprintf(file, "%.2f %.5f %llu %llu %s\n", entry.loudness,
+                entry.peak, static_cast<unsigned long long>(entry.size),
+                static_cast<unsigned long long>(entry.time),
+                entry.name.c_str());
+        }
+    }
+
+    fclose(file);
+}
\ No newline at end of file
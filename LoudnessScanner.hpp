@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CDTrackList.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Finds the loudness of all tracks and sets the gain that levels them to the
+// target. ReplayGain tags are used where a file has them, the rest are
+// measured on the worker pool. Results are cached by the file's path in the
+// music directory, its size and modification time, so each file is only
+// measured once.
+class LoudnessScanner
+{
+public:
+    // target in LUFS
+    LoudnessScanner(CDTrackList& tracks, WorkerPool& pool,
+        const std::string& cachePath, double target, bool useTags);
+
+    // cancels a running scan
+    ~LoudnessScanner();
+
+private:
+    struct Entry
+    {
+        int32_t track;
+        std::string path;
+        std::string name;
+        std::string codec;
+        uint64_t size;
+        uint64_t time;
+
+        // in LUFS, peak 0 if unknown
+        double loudness;
+        double peak;
+        bool known;
+    };
+
+    CDTrackList& m_tracks;
+    JobGroup m_jobs;
+    std::string m_cachePath;
+    double m_target;
+    bool m_useTags;
+    std::vector<Entry> m_entries;
+    std::atomic<bool> m_cancel;
+    std::thread m_thread;
+
+    void run();
+    void loadCache();
+    bool readTags(Entry& entry);
+    void measure(Entry& entry);
+    void apply(const Entry& entry);
+    void saveCache();
+};
\ No newline at end of file
@@ -0,0 +1,572 @@
+#include "MciParser.hpp"
+
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void copyString(char* buffer, size_t size, LPCSTR string)
+{
+    strncpy_s(buffer, size, string, _TRUNCATE);
+}
+
+static void copyString(char* buffer, size_t size, LPCWSTR string)
+{
+    // the string is left empty if it doesn't fit
+    if (!WideCharToMultiByte(CP_ACP, 0, string, -1, buffer,
+            static_cast<int>(size), nullptr, nullptr)) {
+        buffer[0] = '\0';
+    }
+}
+
+void MciOpen::parse(DWORD_PTR fdwCommand, const MCI_OPEN_PARMSA* parms)
+{
+    read(fdwCommand, parms);
+}
+
+void MciOpen::parse(DWORD_PTR fdwCommand, const MCI_OPEN_PARMSW* parms)
+{
+    read(fdwCommand, parms);
+}
+
+template <typename Parms>
+void MciOpen::read(DWORD_PTR fdwCommand, const Parms* parms)
+{
+    m_flags = fdwCommand;
+    m_deviceTypeID = 0;
+    m_deviceType[0] = '\0';
+    m_elementName[0] = '\0';
+    m_alias[0] = '\0';
+
+    if (fdwCommand & MCI_OPEN_TYPE) {
+        if (fdwCommand & MCI_OPEN_TYPE_ID) {
+            m_deviceTypeID = LOWORD(parms->lpstrDeviceType);
+        } else if (parms->lpstrDeviceType) {
+            copyString(m_deviceType, sizeof(m_deviceType),
+                parms->lpstrDeviceType);
+        }
+    }
+
+    if ((fdwCommand & MCI_OPEN_ELEMENT) &&
+        !(fdwCommand & MCI_OPEN_ELEMENT_ID) && parms->lpstrElementName) {
+        copyString(m_elementName, sizeof(m_elementName),
+            parms->lpstrElementName);
+    }
+
+    if ((fdwCommand & MCI_OPEN_ALIAS) && parms->lpstrAlias) {
+        copyString(m_alias, sizeof(m_alias), parms->lpstrAlias);
+    }
+}
+
+bool MciOpen::isCdAudio() const
+{
+    if (!(m_flags & MCI_OPEN_TYPE)) {
+        return false;
+    }
+
+    if (m_flags & MCI_OPEN_TYPE_ID) {
+        return m_deviceTypeID == MCI_DEVTYPE_CD_AUDIO;
+    }
+
+    return !_stricmp(m_deviceType, "cdaudio");
+}
+
+WORD MciOpen::getDeviceTypeID() const
+{
+    return m_deviceTypeID;
+}
+
+const char* MciOpen::getDeviceType() const
+{
+    return m_deviceType;
+}
+
+const char* MciOpen::getElementName() const
+{
+    return m_elementName;
+}
+
+const char* MciOpen::getAlias() const
+{
+    return m_alias;
+}
+
+bool MciString::parse(LPCSTR command)
+{
+    if (strnlen(command, MaxLength) == MaxLength) {
+        return false;
+    }
+
+    strcpy_s(m_text, sizeof(m_text), command);
+    return split();
+}
+
+bool MciString::parse(LPCWSTR command)
+{
+    if (!WideCharToMultiByte(CP_ACP, 0, command, -1, m_text, sizeof(m_text),
+            nullptr, nullptr)) {
+        return false;
+    }
+
+    return split();
+}
+
+size_t MciString::getCount() const
+{
+    return m_count;
+}
+
+const char* MciString::getWord(size_t index) const
+{
+    return index < m_count ? m_words[index] : "";
+}
+
+bool MciString::isWord(size_t index, const char* word) const
+{
+    return !_stricmp(getWord(index), word);
+}
+
+bool MciString::split()
+{
+    m_count = 0;
+
+    char* next = m_text;
+    while (true) {
+        while (*next == ' ' || *next == '\t') {
+            next++;
+        }
+
+        if (!*next) {
+            return true;
+        }
+
+        if (m_count == MaxWords) {
+            return false;
+        }
+
+        char end = ' ';
+        if (*next == '"') {
+            end = '"';
+            next++;
+        }
+
+        m_words[m_count++] = next;
+
+        while (*next && *next != end && (end == '"' || *next != '\t')) {
+            next++;
+        }
+
+        if (*next) {
+            *next++ = '\0';
+        }
+    }
+}
+
+static const struct
+{
+    const char* verb;
+    UINT message;
+} STRING_VERBS[] = {
+    {"open", MCI_OPEN},
+    {"close", MCI_CLOSE},
+    {"play", MCI_PLAY},
+    {"stop", MCI_STOP},
+    {"pause", MCI_PAUSE},
+    {"resume", MCI_RESUME},
+    {"seek", MCI_SEEK},
+    {"set", MCI_SET},
+    {"status", MCI_STATUS},
+};
+
+// the first name of a format is the one status returns
+static const struct
+{
+    const char* name;
+    DWORD format;
+} TIME_FORMAT_NAMES[] = {
+    {"milliseconds", MCI_FORMAT_MILLISECONDS},
+    {"ms", MCI_FORMAT_MILLISECONDS},
+    {"msf", MCI_FORMAT_MSF},
+    {"tmsf", MCI_FORMAT_TMSF},
+    {"frames", MCI_FORMAT_FRAMES},
+    {"samples", MCI_FORMAT_SAMPLES},
+};
+
+// items of several words are matched word by word
+static const struct
+{
+    const char* words;
+    DWORD item;
+    DWORD_PTR flags;
+} STATUS_ITEMS[] = {
+    {"position", MCI_STATUS_POSITION, 0},
+    {"start position", MCI_STATUS_POSITION, MCI_STATUS_START},
+    {"length", MCI_STATUS_LENGTH, 0},
+    {"number of tracks", MCI_STATUS_NUMBER_OF_TRACKS, 0},
+    {"current track", MCI_STATUS_CURRENT_TRACK, 0},
+    {"mode", MCI_STATUS_MODE, 0},
+    {"media present", MCI_STATUS_MEDIA_PRESENT, 0},
+    {"ready", MCI_STATUS_READY, 0},
+    {"time format", MCI_STATUS_TIME_FORMAT, 0},
+    {"type", MCI_CDA_STATUS_TYPE_TRACK, 0},
+};
+
+// advances the index to the last word if all words follow at it
+static bool matchWords(
+    const MciString& command, size_t& index, const char* words)
+{
+    char word[32];
+    size_t next = index;
+
+    while (*words) {
+        size_t length = strcspn(words, " ");
+        if (length >= sizeof(word)) {
+            return false;
+        }
+
+        memcpy(word, words, length);
+        word[length] = '\0';
+        if (!command.isWord(next, word)) {
+            return false;
+        }
+
+        words += length;
+        if (*words) {
+            words++;
+            next++;
+        }
+    }
+
+    index = next;
+    return true;
+}
+
+// MSF and TMSF fields go into the bytes of the value, the first one lowest
+static bool readPosition(const char* word, int32_t timeFormat, DWORD& value)
+{
+    bool packed =
+        timeFormat == MCI_FORMAT_MSF || timeFormat == MCI_FORMAT_TMSF;
+    size_t maxFields = timeFormat == MCI_FORMAT_TMSF ? 4 : packed ? 3 : 1;
+
+    value = 0;
+    for (size_t field = 0; field < maxFields; field++) {
+        if (!isdigit(static_cast<unsigned char>(*word))) {
+            return false;
+        }
+
+        char* end;
+        unsigned long number = strtoul(word, &end, 10);
+        if (packed && number > 0xFF) {
+            return false;
+        }
+
+        value |= static_cast<DWORD>(number) << (packed ? field * 8 : 0);
+
+        if (!*end) {
+            return true;
+        }
+
+        if (*end != ':') {
+            return false;
+        }
+
+        word = end + 1;
+    }
+
+    return false;
+}
+
+static bool writeReturn(LPSTR ret, size_t retSize, const char* format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    int length = vsnprintf_s(ret, retSize, _TRUNCATE, format, list);
+    va_end(list);
+    return length >= 0;
+}
+
+MCIERROR MciStringCommand::translate(
+    const MciString& command, int32_t timeFormat, HWND hwndCallback)
+{
+    m_message = 0;
+    m_flags = 0;
+    m_alias[0] = '\0';
+    memset(&m_parms, 0, sizeof(m_parms));
+
+    for (const auto& verb : STRING_VERBS) {
+        if (command.isWord(0, verb.verb)) {
+            m_message = verb.message;
+        }
+    }
+
+    if (!m_message) {
+        return MCIERR_UNRECOGNIZED_COMMAND;
+    }
+
+    if (command.getCount() < 2) {
+        return MCIERR_MISSING_DEVICE_NAME;
+    }
+
+    // the caller decides whether the device is ours, opens always name it
+    // by type
+    if (m_message == MCI_OPEN) {
+        m_flags |= MCI_OPEN_TYPE;
+        m_parms.open.lpstrDeviceType = "cdaudio";
+    }
+
+    for (size_t i = 2; i < command.getCount(); i++) {
+        MCIERROR result = MMSYSERR_NOERROR;
+
+        if (command.isWord(i, "notify")) {
+            m_flags |= MCI_NOTIFY;
+            m_parms.generic.dwCallback =
+                reinterpret_cast<DWORD_PTR>(hwndCallback);
+        } else if (command.isWord(i, "wait")) {
+            m_flags |= MCI_WAIT;
+        } else if (m_message == MCI_OPEN) {
+            result = readOpen(command, i);
+        } else if (m_message == MCI_PLAY) {
+            result = readPlay(command, i, timeFormat);
+        } else if (m_message == MCI_SEEK) {
+            result = readSeek(command, i, timeFormat);
+        } else if (m_message == MCI_SET) {
+            result = readSet(command, i);
+        } else if (m_message == MCI_STATUS) {
+            result = readStatus(command, i);
+        } else {
+            result = MCIERR_UNRECOGNIZED_KEYWORD;
+        }
+
+        if (result) {
+            return result;
+        }
+    }
+
+    if (m_message == MCI_STATUS && !(m_flags & MCI_STATUS_ITEM)) {
+        return MCIERR_MISSING_PARAMETER;
+    }
+
+    if (m_message == MCI_SEEK &&
+        !(m_flags & (MCI_SEEK_TO_START | MCI_SEEK_TO_END | MCI_TO))) {
+        return MCIERR_MISSING_PARAMETER;
+    }
+
+    return MMSYSERR_NOERROR;
+}
+
+UINT MciStringCommand::getMessage() const
+{
+    return m_message;
+}
+
+DWORD_PTR MciStringCommand::getFlags() const
+{
+    return m_flags;
+}
+
+DWORD_PTR MciStringCommand::getParms()
+{
+    return reinterpret_cast<DWORD_PTR>(&m_parms);
+}
+
+MCIERROR MciStringCommand::readOpen(const MciString& command, size_t& index)
+{
+    if (command.isWord(index, "shareable")) {
+        m_flags |= MCI_OPEN_SHAREABLE;
+        return MMSYSERR_NOERROR;
+    }
+
+    // the type was checked by the caller
+    if (command.isWord(index, "type") && index + 1 < command.getCount()) {
+        index++;
+        return MMSYSERR_NOERROR;
+    }
+
+    if (command.isWord(index, "alias")) {
+        if (++index == command.getCount()) {
+            return MCIERR_MISSING_STRING_ARGUMENT;
+        }
+
+        copyString(m_alias, sizeof(m_alias), command.getWord(index));
+        m_flags |= MCI_OPEN_ALIAS;
+        m_parms.open.lpstrAlias = m_alias;
+        return MMSYSERR_NOERROR;
+    }
+
+    return MCIERR_UNRECOGNIZED_KEYWORD;
+}
+
+MCIERROR MciStringCommand::readPlay(
+    const MciString& command, size_t& index, int32_t timeFormat)
+{
+    bool from = command.isWord(index, "from");
+    if (!from && !command.isWord(index, "to")) {
+        return MCIERR_UNRECOGNIZED_KEYWORD;
+    }
+
+    if (++index == command.getCount()) {
+        return MCIERR_MISSING_PARAMETER;
+    }
+
+    DWORD& position = from ? m_parms.play.dwFrom : m_parms.play.dwTo;
+    if (!readPosition(command.getWord(index), timeFormat, position)) {
+        return MCIERR_BAD_INTEGER;
+    }
+
+    m_flags |= from ? MCI_FROM : MCI_TO;
+    return MMSYSERR_NOERROR;
+}
+
+MCIERROR MciStringCommand::readSeek(
+    const MciString& command, size_t& index, int32_t timeFormat)
+{
+    if (!command.isWord(index, "to")) {
+        return MCIERR_UNRECOGNIZED_KEYWORD;
+    }
+
+    if (++index == command.getCount()) {
+        return MCIERR_MISSING_PARAMETER;
+    }
+
+    if (command.isWord(index, "start")) {
+        m_flags |= MCI_SEEK_TO_START;
+    } else if (command.isWord(index, "end")) {
+        m_flags |= MCI_SEEK_TO_END;
+    } else if (readPosition(
+                   command.getWord(index), timeFormat, m_parms.seek.dwTo)) {
+        m_flags |= MCI_TO;
+    } else {
+        return MCIERR_BAD_INTEGER;
+    }
+
+    return MMSYSERR_NOERROR;
+}
+
+MCIERROR MciStringCommand::readSet(const MciString& command, size_t& index)
+{
+    // there is no door, and the volume is set through aux
+    if (command.isWord(index, "door") || command.isWord(index, "audio")) {
+        return MCIERR_UNSUPPORTED_FUNCTION;
+    }
+
+    if (!matchWords(command, index, "time format")) {
+        return MCIERR_UNRECOGNIZED_KEYWORD;
+    }
+
+    if (++index == command.getCount()) {
+        return MCIERR_MISSING_PARAMETER;
+    }
+
+    for (const auto& name : TIME_FORMAT_NAMES) {
+        if (command.isWord(index, name.name)) {
+            m_flags |= MCI_SET_TIME_FORMAT;
+            m_parms.set.dwTimeFormat = name.format;
+            return MMSYSERR_NOERROR;
+        }
+    }
+
+    return MCIERR_BAD_TIME_FORMAT;
+}
+
+MCIERROR MciStringCommand::readStatus(const MciString& command, size_t& index)
+{
+    if (command.isWord(index, "track")) {
+        char* end;
+        const char* track = command.getWord(++index);
+        m_parms.status.dwTrack = strtoul(track, &end, 10);
+        if (!isdigit(static_cast<unsigned char>(*track)) || *end) {
+            return MCIERR_BAD_INTEGER;
+        }
+
+        m_flags |= MCI_TRACK;
+        return MMSYSERR_NOERROR;
+    }
+
+    if (m_flags & MCI_STATUS_ITEM) {
+        return MCIERR_UNRECOGNIZED_KEYWORD;
+    }
+
+    for (const auto& item : STATUS_ITEMS) {
+        if (matchWords(command, index, item.words)) {
+            m_flags |= MCI_STATUS_ITEM | item.flags;
+            m_parms.status.dwItem = item.item;
+            return MMSYSERR_NOERROR;
+        }
+    }
+
+    return MCIERR_UNRECOGNIZED_KEYWORD;
+}
+
+MCIERROR MciStringCommand::formatReturn(
+    LPSTR ret, size_t retSize, int32_t timeFormat) const
+{
+    if (!ret || !retSize) {
+        return MMSYSERR_NOERROR;
+    }
+
+    ret[0] = '\0';
+    bool fits = true;
+    DWORD_PTR value = m_parms.status.dwReturn;
+
+    if (m_message == MCI_OPEN) {
+        fits = writeReturn(ret, retSize, "%u", m_parms.open.wDeviceID);
+    } else if (m_message != MCI_STATUS) {
+        return MMSYSERR_NOERROR;
+    }
+
+    switch (m_message == MCI_STATUS ? m_parms.status.dwItem : 0) {
+        case MCI_STATUS_POSITION:
+        case MCI_STATUS_LENGTH:
+            // lengths of TMSF are given in MSF
+            if (timeFormat == MCI_FORMAT_TMSF &&
+                m_parms.status.dwItem == MCI_STATUS_POSITION) {
+                fits = writeReturn(ret, retSize, "%02u:%02u:%02u:%02u",
+                    MCI_TMSF_TRACK(value), MCI_TMSF_MINUTE(value),
+                    MCI_TMSF_SECOND(value), MCI_TMSF_FRAME(value));
+            } else if (timeFormat == MCI_FORMAT_MSF ||
+                       timeFormat == MCI_FORMAT_TMSF) {
+                fits = writeReturn(ret, retSize, "%02u:%02u:%02u",
+                    MCI_MSF_MINUTE(value), MCI_MSF_SECOND(value),
+                    MCI_MSF_FRAME(value));
+            } else {
+                fits = writeReturn(ret, retSize, "%u",
+                    static_cast<uint32_t>(value));
+            }
+            break;
+
+        case MCI_STATUS_MODE:
+            fits = writeReturn(ret, retSize, "%s",
+                value == MCI_MODE_PLAY    ? "playing"
+                : value == MCI_MODE_PAUSE ? "paused"
+                                          : "stopped");
+            break;
+
+        case MCI_STATUS_MEDIA_PRESENT:
+        case MCI_STATUS_READY:
+            fits = writeReturn(ret, retSize, "%s", value ? "true" : "false");
+            break;
+
+        case MCI_STATUS_TIME_FORMAT:
+            for (const auto& name : TIME_FORMAT_NAMES) {
+                if (name.format == value) {
+                    fits = writeReturn(ret, retSize, "%s", name.name);
+                    break;
+                }
+            }
+            break;
+
+        case MCI_CDA_STATUS_TYPE_TRACK:
+            fits = writeReturn(ret, retSize, "%s",
+                value == MCI_CDA_TRACK_AUDIO ? "audio" : "other");
+            break;
+
+        case MCI_STATUS_NUMBER_OF_TRACKS:
+        case MCI_STATUS_CURRENT_TRACK:
+            fits = writeReturn(
+                ret, retSize, "%u", static_cast<uint32_t>(value));
+            break;
+    }
+
+    return fits ? MMSYSERR_NOERROR : MCIERR_PARAM_OVERFLOW;
+}
\ No newline at end of file
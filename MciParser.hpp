@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+
+// The parts of an MCI_OPEN that decide who handles it, read from either
+// MCI_OPEN_PARMSA or MCI_OPEN_PARMSW. Strings are copied narrow into fixed
+// buffers and cut off if they don't fit.
+class MciOpen
+{
+public:
+    void parse(DWORD_PTR fdwCommand, const MCI_OPEN_PARMSA* parms);
+    void parse(DWORD_PTR fdwCommand, const MCI_OPEN_PARMSW* parms);
+
+    // true if the device type is cdaudio, by name or by ID
+    bool isCdAudio() const;
+
+    // 0 unless given by ID
+    WORD getDeviceTypeID() const;
+    // empty if not given or given by ID
+    const char* getDeviceType() const;
+    const char* getElementName() const;
+    const char* getAlias() const;
+
+private:
+    DWORD_PTR m_flags;
+    WORD m_deviceTypeID;
+    char m_deviceType[32];
+    char m_elementName[MAX_PATH];
+    char m_alias[64];
+
+    template <typename Parms>
+    void read(DWORD_PTR fdwCommand, const Parms* parms);
+};
+
+// An MCI string command split into words. The words point into a fixed
+// buffer, quotes around a word are removed.
+class MciString
+{
+public:
+    static const size_t MaxLength = 256;
+    static const size_t MaxWords = 16;
+
+    // false if the command is too long or has too many words
+    bool parse(LPCSTR command);
+    bool parse(LPCWSTR command);
+
+    size_t getCount() const;
+    // empty past the last word
+    const char* getWord(size_t index) const;
+    // compares case-insensitively like MCI does
+    bool isWord(size_t index, const char* word) const;
+
+private:
+    char m_text[MaxLength];
+    const char* m_words[MaxWords];
+    size_t m_count;
+
+    bool split();
+};
+
+// A cdaudio string command translated into the MCI command it stands for,
+// so that strings and commands share one dispatch. The device is the
+// second word, positions are read in the given time format like MCI reads
+// them: colon separated fields for MSF and TMSF, numbers for the others.
+class MciStringCommand
+{
+public:
+    // MCIERR_* if the string isn't a cdaudio command we know
+    MCIERROR translate(
+        const MciString& command, int32_t timeFormat, HWND hwndCallback);
+
+    UINT getMessage() const;
+    DWORD_PTR getFlags() const;
+    DWORD_PTR getParms();
+
+    // Writes the result of the command like the string interface does: the
+    // device ID for MCI_OPEN, the item for MCI_STATUS, nothing otherwise.
+    // Positions are written in the given time format.
+    MCIERROR formatReturn(LPSTR ret, size_t retSize, int32_t timeFormat) const;
+
+private:
+    UINT m_message;
+    DWORD_PTR m_flags;
+    char m_alias[64];
+
+    union
+    {
+        MCI_GENERIC_PARMS generic;
+        MCI_OPEN_PARMSA open;
+        MCI_PLAY_PARMS play;
+        MCI_SEEK_PARMS seek;
+        MCI_SET_PARMS set;
+        MCI_STATUS_PARMS status;
+    } m_parms;
+
+    MCIERROR readOpen(const MciString& command, size_t& index);
+    MCIERROR readPlay(const MciString& command, size_t& index,
+        int32_t timeFormat);
+    MCIERROR readSeek(const MciString& command, size_t& index,
+        int32_t timeFormat);
+    MCIERROR readSet(const MciString& command, size_t& index);
+    MCIERROR readStatus(const MciString& command, size_t& index);
+};
\ No newline at end of file
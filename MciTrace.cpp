@@ -0,0 +1,233 @@
+#include "MciTrace.hpp"
+#include "AudioClock.hpp"
+#include "Logger.hpp"
+#include "MciParser.hpp"
+
+#include <cstring>
+
+// file header, the records follow it
+static const char TRACE_MAGIC[4] = {'Z', 'M', 'C', 'T'};
+static const uint32_t TRACE_VERSION = 1;
+
+MciRecorder::MciRecorder()
+    : m_file(nullptr)
+    , m_start(0)
+{
+}
+
+MciRecorder::~MciRecorder()
+{
+    if (m_file) {
+        fclose(m_file);
+    }
+}
+
+void MciRecorder::open(Config& config)
+{
+    // [trace]
+    // record = 1 to trace all MCI and aux calls of the game
+    // file = zplaymm.trace in the game directory
+    if (!config.getBool("trace", "record", false)) {
+        return;
+    }
+
+    std::string path = Config::getGameDirectory() + '\\' +
+                       config.getString("trace", "file", "zplaymm.trace");
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        LOG_INFO("Can't write %s", path.c_str());
+        return;
+    }
+
+    fwrite(TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, file);
+    fwrite(&TRACE_VERSION, sizeof(TRACE_VERSION), 1, file);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_start = now();
+    m_file = file;
+
+    LOG_INFO("Tracing MCI calls to %s", path.c_str());
+}
+
+int64_t MciRecorder::now()
+{
+    return AudioClock::getSystemTime();
+}
+
+void MciRecorder::recordCommand(int64_t started, MCIDEVICEID IDDevice,
+    UINT uMsg, DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide,
+    bool foreign, MCIERROR result)
+{
+    if (!m_file) {
+        return;
+    }
+
+    MciTraceRecord record = {};
+    record.call = TraceCommand;
+    record.traits = (wide ? TraceWide : 0) | (foreign ? TraceForeign : 0);
+    record.device = IDDevice;
+    record.message = uMsg;
+    record.flags = static_cast<uint32_t>(fdwCommand);
+    record.result = result;
+
+    MciOpen open;
+    const char* text = nullptr;
+
+    // the parameter block is optional for most messages
+    if (dwParam) {
+        switch (uMsg) {
+            case MCI_OPEN: {
+                if (wide) {
+                    open.parse(fdwCommand,
+                        reinterpret_cast<MCI_OPEN_PARMSW*>(dwParam));
+                } else {
+                    open.parse(fdwCommand,
+                        reinterpret_cast<MCI_OPEN_PARMSA*>(dwParam));
+                }
+                record.params[0] = open.getDeviceTypeID();
+                text = open.getDeviceType();
+
+                // the A and W blocks both start with the callback and ID
+                auto parms = reinterpret_cast<LPMCI_OPEN_PARMSA>(dwParam);
+                record.params[2] = parms->wDeviceID;
+                break;
+            }
+
+            case MCI_PLAY: {
+                auto parms = reinterpret_cast<LPMCI_PLAY_PARMS>(dwParam);
+                record.params[0] = parms->dwFrom;
+                record.params[1] = parms->dwTo;
+                break;
+            }
+
+            case MCI_SEEK: {
+                auto parms = reinterpret_cast<LPMCI_SEEK_PARMS>(dwParam);
+                record.params[0] = parms->dwTo;
+                break;
+            }
+
+            case MCI_SET: {
+                auto parms = reinterpret_cast<LPMCI_SET_PARMS>(dwParam);
+                record.params[0] = parms->dwTimeFormat;
+                record.params[1] = parms->dwAudio;
+                break;
+            }
+
+            case MCI_STATUS: {
+                auto parms = reinterpret_cast<LPMCI_STATUS_PARMS>(dwParam);
+                record.params[0] = parms->dwItem;
+                record.params[1] = parms->dwTrack;
+                record.params[2] = static_cast<uint32_t>(parms->dwReturn);
+                break;
+            }
+        }
+    }
+
+    write(started, record, text);
+}
+
+void MciRecorder::recordString(
+    int64_t started, LPCSTR cmd, bool foreign, MCIERROR result)
+{
+    MciTraceRecord record = {};
+    record.call = TraceString;
+    record.traits = foreign ? TraceForeign : 0;
+    record.result = result;
+
+    write(started, record, cmd);
+}
+
+void MciRecorder::recordString(
+    int64_t started, LPCWSTR cmd, bool foreign, MCIERROR result)
+{
+    if (!m_file) {
+        return;
+    }
+
+    MciTraceRecord record = {};
+    record.call = TraceString;
+    record.traits = TraceWide | (foreign ? TraceForeign : 0);
+    record.result = result;
+
+    // commands that don't fit are recorded empty
+    char text[MciString::MaxLength];
+    if (!cmd || !WideCharToMultiByte(CP_ACP, 0, cmd, -1, text,
+                    sizeof(text), nullptr, nullptr)) {
+        text[0] = '\0';
+    }
+
+    write(started, record, text);
+}
+
+void MciRecorder::recordAux(int64_t started, MciTraceCall call,
+    UINT uDeviceID, DWORD volume, MMRESULT result)
+{
+    MciTraceRecord record = {};
+    record.call = static_cast<uint8_t>(call);
+    record.device = uDeviceID;
+    record.params[call == TraceAuxGetVolume ? 2 : 0] = volume;
+    record.result = result;
+
+    write(started, record, nullptr);
+}
+
+void MciRecorder::write(
+    int64_t started, MciTraceRecord& record, const char* text)
+{
+    int64_t finished = now();
+
+    size_t length = text ? strlen(text) : 0;
+    record.textLength = static_cast<uint16_t>(length);
+    record.duration = static_cast<uint32_t>((finished - started) / 1000);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file) {
+        return;
+    }
+
+    record.time = (started - m_start) / 1000;
+    fwrite(&record, sizeof(record), 1, m_file);
+    fwrite(text, 1, length, m_file);
+
+    // a trace is most useful when the game crashes
+    fflush(m_file);
+}
+
+MciTraceReader::MciTraceReader()
+    : m_file(nullptr)
+{
+}
+
+MciTraceReader::~MciTraceReader()
+{
+    if (m_file) {
+        fclose(m_file);
+    }
+}
+
+bool MciTraceReader::open(const std::string& path)
+{
+    m_file = fopen(path.c_str(), "rb");
+    if (!m_file) {
+        return false;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    uint32_t version;
+    return fread(magic, sizeof(magic), 1, m_file) == 1 &&
+           fread(&version, sizeof(version), 1, m_file) == 1 &&
+           !memcmp(magic, TRACE_MAGIC, sizeof(magic)) &&
+           version == TRACE_VERSION;
+}
+
+bool MciTraceReader::read(MciTraceRecord& record, std::string& text)
+{
+    if (fread(&record, sizeof(record), 1, m_file) != 1) {
+        return false;
+    }
+
+    text.resize(record.textLength);
+    return !record.textLength ||
+           fread(&text[0], 1, record.textLength, m_file) == record.textLength;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+// intercepted functions a trace holds calls of
+enum MciTraceCall
+{
+    TraceCommand,
+    TraceString,
+    TraceAuxGetNumDevs,
+    TraceAuxGetDevCaps,
+    TraceAuxGetVolume,
+    TraceAuxSetVolume
+};
+
+// bits of MciTraceRecord::traits
+enum MciTraceTraits
+{
+    // sent through the W function
+    TraceWide = 1,
+    // passed on to the system without reaching the player
+    TraceForeign = 2
+};
+
+// One call of a trace file, followed by textLength characters of the string
+// command or the device type of an MCI_OPEN. params holds the fields of the
+// parameter block the message uses: dwFrom and dwTo of MCI_PLAY, dwTo of
+// MCI_SEEK, dwTimeFormat and dwAudio of MCI_SET, dwItem and dwTrack of
+// MCI_STATUS, the type ID of MCI_OPEN and the volume of auxSetVolume. The
+// value returned in the block, like dwReturn, is in params[2].
+#pragma pack(push, 1)
+struct MciTraceRecord
+{
+    // microseconds since the trace started and spent in the call
+    int64_t time;
+    uint32_t duration;
+    uint8_t call;
+    uint8_t traits;
+    uint16_t textLength;
+    uint32_t device;
+    uint32_t message;
+    uint32_t flags;
+    uint32_t params[3];
+    uint32_t result;
+};
+#pragma pack(pop)
+
+// Writes the MCI and aux calls of the game to a trace file, so that bugs
+// can be reproduced and real games benchmarked with TraceReplay.
+class MciRecorder
+{
+public:
+    MciRecorder();
+    ~MciRecorder();
+
+    // starts a trace if [trace] record is set
+    void open(Config& config);
+
+    // time to pass as started to the record functions
+    static int64_t now();
+
+    // called after the call returned, with the parameters it was given
+    void recordCommand(int64_t started, MCIDEVICEID IDDevice, UINT uMsg,
+        DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide, bool foreign,
+        MCIERROR result);
+    void recordString(
+        int64_t started, LPCSTR cmd, bool foreign, MCIERROR result);
+    void recordString(
+        int64_t started, LPCWSTR cmd, bool foreign, MCIERROR result);
+    void recordAux(int64_t started, MciTraceCall call, UINT uDeviceID,
+        DWORD volume, MMRESULT result);
+
+private:
+    std::mutex m_mutex;
+    // set once before the first call is recorded
+    FILE* m_file;
+    int64_t m_start;
+
+    void write(int64_t started, MciTraceRecord& record, const char* text);
+};
+
+// Reads a trace written by MciRecorder.
+class MciTraceReader
+{
+public:
+    MciTraceReader();
+    ~MciTraceReader();
+
+    // false if the file is missing or not a trace
+    bool open(const std::string& path);
+
+    // false at the end of the trace
+    bool read(MciTraceRecord& record, std::string& text);
+
+private:
+    FILE* m_file;
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "Md5.hpp"
+
+#include <cstring>
+
+// per-round shift amounts and sine derived constants from RFC 1321
+static const uint32_t SHIFTS[64] = {7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17,
+    22, 7, 12, 17, 22, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 6, 10, 15, 21,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+static const uint32_t CONSTANTS[64] = {0xd76aa478, 0xe8c7b756, 0x242070db,
+    0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501, 0x698098d8,
+    0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e,
+    0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d,
+    0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87,
+    0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942,
+    0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60,
+    0xbebfbc70, 0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039,
+    0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244, 0x432aff97, 0xab9423a7,
+    0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1, 0x6fa87e4f,
+    0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb,
+    0xeb86d391};
+
+static inline uint32_t rotateLeft(uint32_t value, uint32_t shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+Md5::Md5()
+    : m_size(0)
+{
+    m_state[0] = 0x67452301;
+    m_state[1] = 0xefcdab89;
+    m_state[2] = 0x98badcfe;
+    m_state[3] = 0x10325476;
+}
+
+void Md5::update(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t used = static_cast<size_t>(m_size % 64);
+    m_size += size;
+
+    // complete a partial block first
+    if (used) {
+        size_t count = 64 - used < size ? 64 - used : size;
+        memcpy(m_block + used, bytes, count);
+        bytes += count;
+        size -= count;
+
+        if (used + count < 64) {
+            return;
+        }
+
+        transform(m_block);
+    }
+
+    for (; size >= 64; bytes += 64, size -= 64) {
+        transform(bytes);
+    }
+
+    memcpy(m_block, bytes, size);
+}
+
+void Md5::finish(uint8_t digest[16])
+{
+    uint64_t bits = m_size * 8;
+
+    // a one bit, zeros up to 56 bytes mod 64, then the length in bits
+    uint8_t padding[72] = {0x80};
+    size_t used = static_cast<size_t>(m_size % 64);
+    size_t count = used < 56 ? 56 - used : 120 - used;
+
+    for (int32_t i = 0; i < 8; i++) {
+        padding[count + i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+
+    update(padding, count + 8);
+
+    for (int32_t i = 0; i < 16; i++) {
+        digest[i] = static_cast<uint8_t>(m_state[i / 4] >> ((i % 4) * 8));
+    }
+}
+
+std::string Md5::toString(const uint8_t digest[16])
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result;
+    for (int32_t i = 0; i < 16; i++) {
+        result += digits[digest[i] >> 4];
+        result += digits[digest[i] & 15];
+    }
+
+    return result;
+}
+
+void Md5::transform(const uint8_t block[64])
+{
+    uint32_t words[16];
+    for (int32_t i = 0; i < 16; i++) {
+        words[i] = block[i * 4] | (block[i * 4 + 1] << 8) |
+                   (block[i * 4 + 2] << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+    }
+
+    uint32_t a = m_state[0];
+    uint32_t b = m_state[1];
+    uint32_t c = m_state[2];
+    uint32_t d = m_state[3];
+
+    for (int32_t i = 0; i < 64; i++) {
+        uint32_t f;
+        int32_t g;
+
+        switch (i / 16) {
+            case 0:
+                f = (b & c) | (~b & d);
+                g = i;
+                break;
+            case 1:
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) % 16;
+                break;
+            case 2:
+                f = b ^ c ^ d;
+                g = (3 * i + 5) % 16;
+                break;
+            default:
+                f = c ^ (b | ~d);
+                g = (7 * i) % 16;
+                break;
+        }
+
+        uint32_t next = d;
+        d = c;
+        c = b;
+        b += rotateLeft(a + f + CONSTANTS[i] + words[g], SHIFTS[i]);
+        a = next;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+}
\ No newline at end of file
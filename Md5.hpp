@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Incremental MD5 as used by FLAC for the signature of the decoded audio
+class Md5
+{
+public:
+    Md5();
+    void update(const void* data, size_t size);
+    void finish(uint8_t digest[16]);
+
+    static std::string toString(const uint8_t digest[16]);
+
+private:
+    uint32_t m_state[4];
+    uint64_t m_size;
+    uint8_t m_block[64];
+
+    void transform(const uint8_t block[64]);
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "Notifier.hpp"
+#include "Logger.hpp"
+
+// tokens and slot states are made of a generation and a slot index/state
+#define TOKEN_SLOT_BITS 4
+#define STATE_BITS 4
+#define STATE_MASK ((1 << STATE_BITS) - 1)
+
+static uint32_t makeState(uint32_t generation, uint32_t state)
+{
+    return (generation << STATE_BITS) | state;
+}
+
+NotifySink::~NotifySink()
+{
+}
+
+void NotifySink::post(HWND hwnd, uint32_t result, MCIDEVICEID deviceID)
+{
+    LOG_TRACE("Posting MM_MCINOTIFY message %d to HWND %p", result, hwnd);
+    PostMessage(hwnd, MM_MCINOTIFY, result, deviceID);
+}
+
+Notifier::Notifier(MCIDEVICEID deviceID, NotifySink* sink)
+    : m_deviceID(deviceID)
+    , m_sink(sink ? sink : &m_defaultSink)
+    , m_pending(0)
+    , m_running(true)
+{
+    static_assert(Notifier::NUM_SLOTS <= (1 << TOKEN_SLOT_BITS),
+        "slot index must fit into the token");
+
+    for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+        m_slots[i].state = makeState(1, StateFree);
+        m_slots[i].hwnd = nullptr;
+    }
+
+    // a slot is completed once per generation, so these never grow while
+    // a result is posted from the audio thread
+    m_completed.reserve(NUM_SLOTS);
+    m_delivering.reserve(NUM_SLOTS);
+
+    m_thread = std::thread(&Notifier::run, this);
+}
+
+Notifier::~Notifier()
+{
+    // a closed device aborts what is still pending, everything else is
+    // delivered before the thread exits
+    abort();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+uint32_t Notifier::begin(HWND hwnd)
+{
+    uint32_t token = reserve(hwnd, StatePending);
+
+    uint32_t previous = m_pending.exchange(token);
+    if (previous) {
+        transition(previous, StateSuperseded);
+    }
+
+    return token;
+}
+
+bool Notifier::finish(uint32_t token, uint32_t result)
+{
+    State state;
+
+    switch (result) {
+        case MCI_NOTIFY_SUCCESSFUL:
+            state = StateSuccessful;
+            break;
+        case MCI_NOTIFY_SUPERSEDED:
+            state = StateSuperseded;
+            break;
+        case MCI_NOTIFY_ABORTED:
+            state = StateAborted;
+            break;
+        default:
+            state = StateFailure;
+            break;
+    }
+
+    if (!transition(token, state)) {
+        return false;
+    }
+
+    // no longer pending, unless a newer command took over already
+    m_pending.compare_exchange_strong(token, 0);
+
+    return true;
+}
+
+void Notifier::abort()
+{
+    uint32_t previous = m_pending.exchange(0);
+    if (previous) {
+        transition(previous, StateAborted);
+    }
+}
+
+void Notifier::notify(HWND hwnd)
+{
+    // a new notification request supersedes the pending one
+    uint32_t previous = m_pending.exchange(0);
+    if (previous) {
+        transition(previous, StateSuperseded);
+    }
+
+    reserve(hwnd, StateSuccessful);
+}
+
+uint32_t Notifier::reserve(HWND hwnd, State state)
+{
+    while (true) {
+        for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+            Slot& slot = m_slots[i];
+            uint32_t current = slot.state;
+
+            if ((current & STATE_MASK) != StateFree) {
+                continue;
+            }
+
+            uint32_t generation = current >> STATE_BITS;
+            if (!slot.state.compare_exchange_strong(
+                    current, makeState(generation, StateReserved))) {
+                continue;
+            }
+
+            slot.hwnd = hwnd;
+            slot.state.store(
+                makeState(generation, state), std::memory_order_release);
+
+            if (state != StatePending) {
+                complete(i);
+            }
+
+            return (generation << TOKEN_SLOT_BITS) | i;
+        }
+
+        // all slots are waiting for delivery, which can only happen if
+        // notifications are requested faster than they can be posted
+        std::this_thread::yield();
+    }
+}
+
+bool Notifier::transition(uint32_t token, State state)
+{
+    uint32_t index = token & ((1 << TOKEN_SLOT_BITS) - 1);
+    Slot& slot = m_slots[index];
+    uint32_t generation = token >> TOKEN_SLOT_BITS;
+
+    // only a pending notification of the same generation can complete
+    uint32_t expected = makeState(generation, StatePending);
+    if (!slot.state.compare_exchange_strong(
+            expected, makeState(generation, state))) {
+        return false;
+    }
+
+    complete(index);
+    return true;
+}
+
+void Notifier::complete(uint32_t slot)
+{
+    // queued under the lock, so the thread can't miss the wake-up between
+    // checking the queue and waiting
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completed.push_back(slot);
+    }
+
+    m_wake.notify_one();
+}
+
+void Notifier::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_wake.wait(
+            lock, [this] { return !m_completed.empty() || !m_running; });
+
+        // everything completed before the close is still delivered
+        if (m_completed.empty()) {
+            return;
+        }
+
+        m_delivering.swap(m_completed);
+
+        lock.unlock();
+        deliver();
+        lock.lock();
+    }
+}
+
+void Notifier::deliver()
+{
+    for (uint32_t i : m_delivering) {
+        Slot& slot = m_slots[i];
+        uint32_t current = slot.state.load(std::memory_order_acquire);
+        uint32_t generation = current >> STATE_BITS;
+        uint32_t result;
+
+        switch (current & STATE_MASK) {
+            case StateSuccessful:
+                result = MCI_NOTIFY_SUCCESSFUL;
+                break;
+            case StateSuperseded:
+                result = MCI_NOTIFY_SUPERSEDED;
+                break;
+            case StateAborted:
+                result = MCI_NOTIFY_ABORTED;
+                break;
+            case StateFailure:
+                result = MCI_NOTIFY_FAILURE;
+                break;
+            default:
+                continue;
+        }
+
+        if (slot.hwnd) {
+            m_sink->post(slot.hwnd, result, m_deviceID);
+        }
+
+        // a new generation invalidates old tokens for this slot
+        slot.state.store(makeState(generation + 1, StateFree),
+            std::memory_order_release);
+    }
+
+    m_delivering.clear();
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Receives MM_MCINOTIFY messages from the notifier thread. Replaceable to
+// observe notifications without a window.
+class NotifySink
+{
+public:
+    virtual ~NotifySink();
+    virtual void post(HWND hwnd, uint32_t result, MCIDEVICEID deviceID);
+};
+
+// Delivers MCI_NOTIFY results on a dedicated thread. Each notification
+// goes through an atomic state machine, so the first of completion, abort,
+// supersession or failure wins no matter which thread it comes from.
+// Results are posted in the order they were completed in.
+class Notifier
+{
+public:
+    Notifier(MCIDEVICEID deviceID, NotifySink* sink = nullptr);
+    ~Notifier();
+
+    // Registers a notification for a command that completes later. A
+    // pending notification is superseded. Returns a token for finish().
+    uint32_t begin(HWND hwnd);
+
+    // Completes the notification of the token with an MCI_NOTIFY_* result,
+    // unless something else completed it already. Safe to call from any
+    // thread, including the audio thread.
+    bool finish(uint32_t token, uint32_t result);
+
+    // aborts the pending notification, if any
+    void abort();
+
+    // notifies a command that completed immediately
+    void notify(HWND hwnd);
+
+private:
+    enum State
+    {
+        StateFree,
+        StateReserved,
+        StatePending,
+        StateSuccessful,
+        StateSuperseded,
+        StateAborted,
+        StateFailure
+    };
+
+    struct Slot
+    {
+        // generation in the upper bits, State in the lower four
+        std::atomic<uint32_t> state;
+        HWND hwnd;
+    };
+
+    static const uint32_t NUM_SLOTS = 16;
+
+    MCIDEVICEID m_deviceID;
+    NotifySink m_defaultSink;
+    NotifySink* m_sink;
+    Slot m_slots[NUM_SLOTS];
+    std::atomic<uint32_t> m_pending;
+    bool m_running;
+
+    // slots in the order they were completed, waiting for the thread
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<uint32_t> m_completed;
+    std::vector<uint32_t> m_delivering;
+    std::thread m_thread;
+
+    uint32_t reserve(HWND hwnd, State state);
+    bool transition(uint32_t token, State state);
+    void complete(uint32_t slot);
+    void run();
+    void deliver();
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "PlaySequence.hpp"
+#include "Logger.hpp"
+
+#include <iterator>
+#include <stdio.h>
+
+// counts are halved when one gets this high, so old habits fade out
+#define SEQUENCE_MAX_COUNT 1000
+
+PlaySequence::PlaySequence(const std::string& path)
+    : m_path(path)
+    , m_lastTrack(0)
+    , m_changed(false)
+{
+    FILE* file = fopen(m_path.c_str(), "r");
+    if (!file) {
+        return;
+    }
+
+    // one "from to count" line per transition
+    int32_t from;
+    int32_t to;
+    uint32_t count;
+    while (fscanf(file, "%d %d %u", &from, &to, &count) == 3) {
+        if (from > 0 && to > 0 && count > 0) {
+            m_transitions[from][to] = count;
+        }
+    }
+
+    fclose(file);
+
+    LOG_TRACE(
+        "Loaded %d tracks from %s", m_transitions.size(), m_path.c_str());
+}
+
+void PlaySequence::record(int32_t track)
+{
+    int32_t lastTrack = m_lastTrack;
+    m_lastTrack = track;
+
+    // replaying a track says nothing about what comes next
+    if (!lastTrack || lastTrack == track) {
+        return;
+    }
+
+    std::map<int32_t, uint32_t>& next = m_transitions[lastTrack];
+    if (++next[track] >= SEQUENCE_MAX_COUNT) {
+        for (auto it = next.begin(); it != next.end();) {
+            it->second /= 2;
+            it = it->second ? std::next(it) : next.erase(it);
+        }
+    }
+
+    m_changed = true;
+}
+
+int32_t PlaySequence::predict(int32_t track)
+{
+    auto transitions = m_transitions.find(track);
+    if (transitions == m_transitions.end()) {
+        return 0;
+    }
+
+    int32_t best = 0;
+    uint32_t bestCount = 0;
+    for (auto& next : transitions->second) {
+        if (next.second > bestCount) {
+            best = next.first;
+            bestCount = next.second;
+        }
+    }
+
+    return best;
+}
+
+void PlaySequence::save()
+{
+    if (!m_changed) {
+        return;
+    }
+
+    FILE* file = fopen(m_path.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", m_path.c_str());
+        return;
+    }
+
+    for (auto& from : m_transitions) {
+        for (auto& to : from.second) {
+            fprintf(file, "%d %d %u\n", from.first, to.first, to.second);
+        }
+    }
+
+    fclose(file);
+    m_changed = false;
+}
\ No newline at end of file
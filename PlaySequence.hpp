@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Markov table of which track a game plays after which, so the likely next
+// track can be prepared in advance. Stored as text in the music directory.
+class PlaySequence
+{
+public:
+    PlaySequence(const std::string& path);
+
+    // records that the track started playing
+    void record(int32_t track);
+
+    // the track most often played after the given one, 0 if there is none
+    int32_t predict(int32_t track);
+
+    // writes the table if it has changed
+    void save();
+
+private:
+    std::string m_path;
+    std::map<int32_t, std::map<int32_t, uint32_t>> m_transitions;
+    int32_t m_lastTrack;
+    bool m_changed;
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "Prefetcher.hpp"
+#include "Logger.hpp"
+
+#include <Windows.h>
+
+#include <vector>
+
+#define PREFETCH_CHUNK_SIZE (256 * 1024)
+
+Prefetcher::Prefetcher()
+    : m_exit(false)
+{
+    m_thread = std::thread(&Prefetcher::run, this);
+}
+
+Prefetcher::~Prefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void Prefetcher::prefetch(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (path == m_warm) {
+            return;
+        }
+
+        m_request = path;
+    }
+
+    m_wake.notify_one();
+}
+
+bool Prefetcher::isWarm(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !path.empty() && path == m_warm;
+}
+
+void Prefetcher::run()
+{
+    // low CPU and I/O priority, playback must never wait for us
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_wake.wait(lock, [this] { return m_exit || !m_request.empty(); });
+
+        if (m_exit) {
+            return;
+        }
+
+        std::string path = m_request;
+        m_request.clear();
+        m_warm.clear();
+
+        lock.unlock();
+        bool complete = read(path);
+        lock.lock();
+
+        // only if no newer request came in meanwhile
+        if (complete && m_request.empty()) {
+            m_warm = path;
+        }
+    }
+}
+
+bool Prefetcher::read(const std::string& path)
+{
+    LOG_TRACE("Prefetching %s", path.c_str());
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    std::vector<char> buffer(PREFETCH_CHUNK_SIZE);
+    DWORD bytesRead;
+    bool complete = false;
+
+    while (true) {
+        // give up early if the request is outdated
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_exit || !m_request.empty()) {
+                break;
+            }
+        }
+
+        if (!ReadFile(
+                file, &buffer[0], PREFETCH_CHUNK_SIZE, &bytesRead, NULL)) {
+            break;
+        }
+
+        // end of file
+        if (!bytesRead) {
+            complete = true;
+            break;
+        }
+    }
+
+    CloseHandle(file);
+    return complete;
+}
\ No newline at end of file
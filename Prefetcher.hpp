@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reads files on a background thread so they are in the page cache when
+// the decoder opens them.
+class Prefetcher
+{
+public:
+    Prefetcher();
+    ~Prefetcher();
+
+    // replaces the file that is being prefetched, if any
+    void prefetch(const std::string& path);
+
+    // true if the file has been read completely
+    bool isWarm(const std::string& path);
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::string m_request;
+    std::string m_warm;
+    bool m_exit;
+    std::thread m_thread;
+
+    void run();
+    bool read(const std::string& path);
+};
\ No newline at end of file
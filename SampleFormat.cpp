@@ -0,0 +1,403 @@
+#include "SampleFormat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) ||            \
+    defined(__SSE2__)
+#define SAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// float limits of the integer formats, in mixer units
+#define INT16_MIN_FLOAT -32768.0f
+#define INT16_MAX_FLOAT 32767.0f
+#define INT24_MIN_FLOAT -8388608.0f
+#define INT24_MAX_FLOAT 8388607.0f
+#define INT32_MIN_FLOAT -2147483648.0f
+// the largest float below 2^31
+#define INT32_MAX_FLOAT 2147483520.0f
+
+// xorshift32, cheap enough to run per sample
+static inline uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// the difference of two uniform values in [0, 1) is triangular
+static inline float nextDither(uint32_t dither[4])
+{
+    float r1 = (nextRandom(dither[0]) >> 8) * (1.0f / (1 << 24));
+    float r2 = (nextRandom(dither[0]) >> 8) * (1.0f / (1 << 24));
+    return r1 - r2;
+}
+
+static inline float clamp(float value, float min, float max)
+{
+    return (std::min)((std::max)(value, min), max);
+}
+
+static void fromFloatInt16Scalar(void* output, const float* input,
+    size_t samples, uint32_t dither[4], bool enableDither)
+{
+    int16_t* out = static_cast<int16_t*>(output);
+
+    for (size_t i = 0; i < samples; i++) {
+        float value = input[i];
+        if (enableDither) {
+            value += nextDither(dither);
+        }
+
+        value = clamp(value, INT16_MIN_FLOAT, INT16_MAX_FLOAT);
+        out[i] = static_cast<int16_t>(lrintf(value));
+    }
+}
+
+static void fromFloatInt24Scalar(void* output, const float* input,
+    size_t samples, uint32_t dither[4], bool enableDither)
+{
+    uint8_t* out = static_cast<uint8_t*>(output);
+
+    for (size_t i = 0; i < samples; i++) {
+        float value = input[i] * 256.0f;
+        if (enableDither) {
+            value += nextDither(dither);
+        }
+
+        value = clamp(value, INT24_MIN_FLOAT, INT24_MAX_FLOAT);
+        int32_t sample = static_cast<int32_t>(lrintf(value));
+
+        out[i * 3] = static_cast<uint8_t>(sample);
+        out[i * 3 + 1] = static_cast<uint8_t>(sample >> 8);
+        out[i * 3 + 2] = static_cast<uint8_t>(sample >> 16);
+    }
+}
+
+static void fromFloatInt32Scalar(
+    void* output, const float* input, size_t samples, uint32_t*, bool)
+{
+    int32_t* out = static_cast<int32_t*>(output);
+
+    for (size_t i = 0; i < samples; i++) {
+        float value = clamp(input[i] * 65536.0f, INT32_MIN_FLOAT, INT32_MAX_FLOAT);
+        out[i] = static_cast<int32_t>(lrintf(value));
+    }
+}
+
+static void fromFloatFloat32Scalar(
+    void* output, const float* input, size_t samples, uint32_t*, bool)
+{
+    float* out = static_cast<float*>(output);
+
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = clamp(input[i] * (1.0f / 32768), -1.0f, 1.0f);
+    }
+}
+
+static void toFloatInt16Scalar(float* output, const void* input, size_t samples)
+{
+    const int16_t* in = static_cast<const int16_t*>(input);
+
+    for (size_t i = 0; i < samples; i++) {
+        output[i] = in[i];
+    }
+}
+
+static void toFloatInt24Scalar(float* output, const void* input, size_t samples)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(input);
+
+    for (size_t i = 0; i < samples; i++) {
+        // put the sample in the top bytes, the shift extends the sign
+        uint32_t bits = (in[i * 3] << 8) | (in[i * 3 + 1] << 16) |
+                        (static_cast<uint32_t>(in[i * 3 + 2]) << 24);
+        output[i] = static_cast<float>(static_cast<int32_t>(bits) >> 8) *
+                    (1.0f / 256);
+    }
+}
+
+static void toFloatInt32Scalar(float* output, const void* input, size_t samples)
+{
+    const int32_t* in = static_cast<const int32_t*>(input);
+
+    for (size_t i = 0; i < samples; i++) {
+        output[i] = static_cast<float>(in[i]) * (1.0f / 65536);
+    }
+}
+
+static void toFloatFloat32Scalar(
+    float* output, const void* input, size_t samples)
+{
+    const float* in = static_cast<const float*>(input);
+
+    for (size_t i = 0; i < samples; i++) {
+        output[i] = in[i] * 32768.0f;
+    }
+}
+
+#ifdef SAMPLE_SSE2
+
+// four lanes of TPDF dither of +-1
+static inline __m128 nextDither(__m128i& state)
+{
+    const __m128i one = _mm_set1_epi32(0x3f800000);
+    __m128 r[2];
+
+    for (int32_t k = 0; k < 2; k++) {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+
+        // random mantissa with exponent 0 gives a float in [1, 2)
+        r[k] = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(state, 9), one));
+    }
+
+    return _mm_sub_ps(r[0], r[1]);
+}
+
+static void fromFloatInt16Sse2(void* output, const float* input,
+    size_t samples, uint32_t dither[4], bool enableDither)
+{
+    int16_t* out = static_cast<int16_t*>(output);
+    __m128i state = _mm_loadu_si128(reinterpret_cast<__m128i*>(dither));
+    const __m128 min = _mm_set1_ps(INT16_MIN_FLOAT);
+    const __m128 max = _mm_set1_ps(INT16_MAX_FLOAT);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_loadu_ps(input + i);
+        __m128 b = _mm_loadu_ps(input + i + 4);
+
+        if (enableDither) {
+            a = _mm_add_ps(a, nextDither(state));
+            b = _mm_add_ps(b, nextDither(state));
+        }
+
+        // clamp first, out of range floats convert to 0x80000000
+        a = _mm_min_ps(_mm_max_ps(a, min), max);
+        b = _mm_min_ps(_mm_max_ps(b, min), max);
+
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither), state);
+    fromFloatInt16Scalar(out + i, input + i, samples - i, dither, enableDither);
+}
+
+static void fromFloatInt24Sse2(void* output, const float* input,
+    size_t samples, uint32_t dither[4], bool enableDither)
+{
+    uint8_t* out = static_cast<uint8_t*>(output);
+    __m128i state = _mm_loadu_si128(reinterpret_cast<__m128i*>(dither));
+    const __m128 scale = _mm_set1_ps(256.0f);
+    const __m128 min = _mm_set1_ps(INT24_MIN_FLOAT);
+    const __m128 max = _mm_set1_ps(INT24_MAX_FLOAT);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(input + i), scale);
+
+        if (enableDither) {
+            a = _mm_add_ps(a, nextDither(state));
+        }
+
+        a = _mm_min_ps(_mm_max_ps(a, min), max);
+
+        int32_t values[4];
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(values), _mm_cvtps_epi32(a));
+
+        // each store leaves a byte the next one overwrites
+        uint8_t* o = out + i * 3;
+        memcpy(o, &values[0], 4);
+        memcpy(o + 3, &values[1], 4);
+        memcpy(o + 6, &values[2], 4);
+        memcpy(o + 9, &values[3], 3);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither), state);
+    fromFloatInt24Scalar(
+        out + i * 3, input + i, samples - i, dither, enableDither);
+}
+
+static void fromFloatInt32Sse2(void* output, const float* input,
+    size_t samples, uint32_t* dither, bool enableDither)
+{
+    int32_t* out = static_cast<int32_t*>(output);
+    const __m128 scale = _mm_set1_ps(65536.0f);
+    const __m128 min = _mm_set1_ps(INT32_MIN_FLOAT);
+    const __m128 max = _mm_set1_ps(INT32_MAX_FLOAT);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(input + i), scale);
+        a = _mm_min_ps(_mm_max_ps(a, min), max);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(out + i), _mm_cvtps_epi32(a));
+    }
+
+    fromFloatInt32Scalar(out + i, input + i, samples - i, dither, enableDither);
+}
+
+static void fromFloatFloat32Sse2(void* output, const float* input,
+    size_t samples, uint32_t* dither, bool enableDither)
+{
+    float* out = static_cast<float*>(output);
+    const __m128 scale = _mm_set1_ps(1.0f / 32768);
+    const __m128 min = _mm_set1_ps(-1.0f);
+    const __m128 max = _mm_set1_ps(1.0f);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(input + i), scale);
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(a, min), max));
+    }
+
+    fromFloatFloat32Scalar(
+        out + i, input + i, samples - i, dither, enableDither);
+}
+
+static void toFloatInt16Sse2(float* output, const void* input, size_t samples)
+{
+    const int16_t* in = static_cast<const int16_t*>(input);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+
+        // sign extend int16 to int32 by shifting the duplicated halves back
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+        _mm_storeu_ps(output + i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(output + i + 4, _mm_cvtepi32_ps(hi));
+    }
+
+    toFloatInt16Scalar(output + i, in + i, samples - i);
+}
+
+static void toFloatInt24Sse2(float* output, const void* input, size_t samples)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(input);
+    const __m128 scale = _mm_set1_ps(1.0f / 256);
+    size_t i = 0;
+
+    // each load takes a byte of the next sample, so stop one sample early
+    for (; i + 5 <= samples; i += 4) {
+        int32_t values[4];
+        const uint8_t* p = in + i * 3;
+        memcpy(&values[0], p, 4);
+        memcpy(&values[1], p + 3, 4);
+        memcpy(&values[2], p + 6, 4);
+        memcpy(&values[3], p + 9, 4);
+
+        // drop the extra byte and extend the sign
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        s = _mm_srai_epi32(_mm_slli_epi32(s, 8), 8);
+
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+
+    toFloatInt24Scalar(output + i, in + i * 3, samples - i);
+}
+
+static void toFloatInt32Sse2(float* output, const void* input, size_t samples)
+{
+    const int32_t* in = static_cast<const int32_t*>(input);
+    const __m128 scale = _mm_set1_ps(1.0f / 65536);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+
+    toFloatInt32Scalar(output + i, in + i, samples - i);
+}
+
+static void toFloatFloat32Sse2(
+    float* output, const void* input, size_t samples)
+{
+    const float* in = static_cast<const float*>(input);
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(in + i), scale));
+    }
+
+    toFloatFloat32Scalar(output + i, in + i, samples - i);
+}
+
+#endif
+
+static const SampleKernels kernels[] = {
+    {{fromFloatInt16Scalar, fromFloatInt24Scalar, fromFloatInt32Scalar,
+         fromFloatFloat32Scalar},
+        {toFloatInt16Scalar, toFloatInt24Scalar, toFloatInt32Scalar,
+            toFloatFloat32Scalar}},
+#ifdef SAMPLE_SSE2
+    {{fromFloatInt16Sse2, fromFloatInt24Sse2, fromFloatInt32Sse2,
+         fromFloatFloat32Sse2},
+        {toFloatInt16Sse2, toFloatInt24Sse2, toFloatInt32Sse2,
+            toFloatFloat32Sse2}},
+#endif
+};
+
+SampleKernelSet SampleKernels::getBest()
+{
+#ifdef SAMPLE_SSE2
+    return SampleKernelsSse2;
+#else
+    return SampleKernelsScalar;
+#endif
+}
+
+const SampleKernels& SampleKernels::get(SampleKernelSet set)
+{
+    return set <= getBest() ? kernels[set] : kernels[SampleKernelsScalar];
+}
+
+const char* SampleKernels::getName(SampleKernelSet set)
+{
+    static const char* names[] = {"scalar", "sse2"};
+    return names[set];
+}
+
+void SampleKernels::seedDither(uint32_t dither[4])
+{
+    // xorshift seeds must not be zero
+    dither[0] = 0x9E3779B9;
+    dither[1] = 0x7F4A7C15;
+    dither[2] = 0x85EBCA6B;
+    dither[3] = 0xC2B2AE35;
+}
+
+uint32_t SampleKernels::getSampleSize(SampleFormat format)
+{
+    static const uint32_t sizes[] = {2, 3, 4, 4};
+    return sizes[format];
+}
+
+const char* SampleKernels::getFormatName(SampleFormat format)
+{
+    static const char* names[] = {"int16", "int24", "int32", "float32"};
+    return names[format];
+}
+
+bool SampleKernels::parseFormat(const std::string& name, SampleFormat& format)
+{
+    for (int32_t i = 0; i < SAMPLE_FORMATS; i++) {
+        if (name == getFormatName(static_cast<SampleFormat>(i))) {
+            format = static_cast<SampleFormat>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// sample formats an output can be opened with, all interleaved
+enum SampleFormat
+{
+    SampleInt16,
+    // packed into 3 bytes
+    SampleInt24,
+    SampleInt32,
+    SampleFloat32
+};
+
+#define SAMPLE_FORMATS 4
+
+// instruction sets the sample kernels come in
+enum SampleKernelSet
+{
+    SampleKernelsScalar,
+    SampleKernelsSse2
+};
+
+// Conversions between the sample formats and the floats of the mixer, which
+// are scaled so that 1.0 is one LSB of 16 bit. Integer results saturate.
+struct SampleKernels
+{
+    // From mixer floats to the format. If enabled, TPDF dither of +-1 LSB
+    // of the format is added before rounding. int32 and float32 hold the
+    // floats exactly and are never dithered.
+    void (*fromFloat[SAMPLE_FORMATS])(void* output, const float* input,
+        size_t samples, uint32_t dither[4], bool enableDither);
+
+    // from the format to mixer floats
+    void (*toFloat[SAMPLE_FORMATS])(
+        float* output, const void* input, size_t samples);
+
+    // SSE2 if the build targets it
+    static SampleKernelSet getBest();
+    static const SampleKernels& get(SampleKernelSet set);
+    static const char* getName(SampleKernelSet set);
+
+    // xorshift seeds for the dither state, one per SIMD lane
+    static void seedDither(uint32_t dither[4]);
+
+    static uint32_t getSampleSize(SampleFormat format);
+    static const char* getFormatName(SampleFormat format);
+
+    // false if the name isn't one of the format names
+    static bool parseFormat(const std::string& name, SampleFormat& format);
+};
\ No newline at end of file
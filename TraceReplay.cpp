@@ -0,0 +1,257 @@
+#include "TraceReplay.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+static const char* getMessageName(uint32_t message)
+{
+    switch (message) {
+        case MCI_OPEN:
+            return "MCI_OPEN";
+        case MCI_CLOSE:
+            return "MCI_CLOSE";
+        case MCI_PLAY:
+            return "MCI_PLAY";
+        case MCI_SEEK:
+            return "MCI_SEEK";
+        case MCI_STOP:
+            return "MCI_STOP";
+        case MCI_PAUSE:
+            return "MCI_PAUSE";
+        case MCI_RESUME:
+            return "MCI_RESUME";
+        case MCI_STATUS:
+            return "MCI_STATUS";
+        case MCI_SET:
+            return "MCI_SET";
+        case MCI_SYSINFO:
+            return "MCI_SYSINFO";
+        case MCI_GETDEVCAPS:
+            return "MCI_GETDEVCAPS";
+        case MCI_INFO:
+            return "MCI_INFO";
+        default:
+            return "MCI_OTHER";
+    }
+}
+
+static const char* getCallName(uint8_t call)
+{
+    switch (call) {
+        case TraceCommand:
+            return "mciSendCommand";
+        case TraceString:
+            return "mciSendString";
+        case TraceAuxGetNumDevs:
+            return "auxGetNumDevs";
+        case TraceAuxGetDevCaps:
+            return "auxGetDevCaps";
+        case TraceAuxGetVolume:
+            return "auxGetVolume";
+        case TraceAuxSetVolume:
+            return "auxSetVolume";
+        default:
+            return "unknown";
+    }
+}
+
+TraceReplay::TraceReplay(WinMM& winmm, bool paced)
+    : m_winmm(winmm)
+    , m_paced(paced)
+{
+}
+
+bool TraceReplay::run(
+    const std::string& tracePath, const std::string& reportPath)
+{
+    MciTraceReader reader;
+    if (!reader.open(tracePath)) {
+        LOG_INFO("Can't read trace %s", tracePath.c_str());
+        return false;
+    }
+
+    // the pacing starts with the first call, not with the game
+    auto start = std::chrono::steady_clock::now();
+    int64_t first = -1;
+
+    Call call;
+    while (reader.read(call.record, call.text)) {
+        if (call.record.traits & TraceForeign) {
+            continue;
+        }
+
+        if (first < 0) {
+            first = call.record.time;
+        }
+
+        if (m_paced) {
+            std::this_thread::sleep_until(start +
+                std::chrono::microseconds(call.record.time - first));
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        call.result = replay(call.record, call.text);
+        auto replayed = std::chrono::steady_clock::now() - started;
+
+        call.replayed = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(replayed)
+                .count());
+        m_calls.push_back(call);
+    }
+
+    writeReport(reportPath);
+    return true;
+}
+
+MCIERROR TraceReplay::replay(
+    const MciTraceRecord& record, const std::string& text)
+{
+    try {
+        switch (record.call) {
+            case TraceCommand:
+                return replayCommand(record, text);
+
+            case TraceString: {
+                // notifications go nowhere
+                char ret[128];
+                return m_winmm.mciSendStringA(
+                    text.c_str(), ret, sizeof(ret), nullptr);
+            }
+
+            case TraceAuxGetNumDevs:
+                return m_winmm.auxGetNumDevs();
+
+            case TraceAuxGetDevCaps: {
+                AUXCAPS caps;
+                return m_winmm.auxGetDevCapsA(
+                    record.device, &caps, sizeof(caps));
+            }
+
+            case TraceAuxGetVolume: {
+                DWORD volume;
+                return m_winmm.auxGetVolume(record.device, &volume);
+            }
+
+            case TraceAuxSetVolume:
+                return m_winmm.auxSetVolume(record.device, record.params[0]);
+
+            default:
+                return MMSYSERR_NOTSUPPORTED;
+        }
+    } catch (const WinMMError& ex) {
+        return ex.getErrorCode();
+    } catch (const std::exception& ex) {
+        LOG_INFO("%s", ex.what());
+        return MMSYSERR_ERROR;
+    }
+}
+
+MCIERROR TraceReplay::replayCommand(
+    const MciTraceRecord& record, const std::string& text)
+{
+    // there is no window to notify
+    DWORD_PTR flags = record.flags & ~MCI_NOTIFY;
+
+    // only the fields the recorder keeps are set, the rest is zero
+    switch (record.message) {
+        case MCI_OPEN: {
+            // the alias and element weren't recorded
+            MCI_OPEN_PARMSA parms = {};
+            flags &= ~(MCI_OPEN_ALIAS | MCI_OPEN_ELEMENT);
+            if (flags & MCI_OPEN_TYPE_ID) {
+                parms.lpstrDeviceType =
+                    reinterpret_cast<LPCSTR>(record.params[0]);
+            } else {
+                parms.lpstrDeviceType = text.c_str();
+            }
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(&parms));
+        }
+
+        case MCI_PLAY: {
+            MCI_PLAY_PARMS parms = {};
+            parms.dwFrom = record.params[0];
+            parms.dwTo = record.params[1];
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(&parms));
+        }
+
+        case MCI_SEEK: {
+            MCI_SEEK_PARMS parms = {};
+            parms.dwTo = record.params[0];
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(&parms));
+        }
+
+        case MCI_SET: {
+            MCI_SET_PARMS parms = {};
+            parms.dwTimeFormat = record.params[0];
+            parms.dwAudio = record.params[1];
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(&parms));
+        }
+
+        case MCI_STATUS: {
+            MCI_STATUS_PARMS parms = {};
+            parms.dwItem = record.params[0];
+            parms.dwTrack = record.params[1];
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(&parms));
+        }
+
+        default: {
+            // large enough for the parameter block of any message
+            DWORD_PTR parms[16] = {};
+            return m_winmm.mciSendCommandA(record.device, record.message,
+                flags, reinterpret_cast<DWORD_PTR>(parms));
+        }
+    }
+}
+
+void TraceReplay::writeReport(const std::string& reportPath)
+{
+    FILE* file = fopen(reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", reportPath.c_str());
+        return;
+    }
+
+    fprintf(file, "time ms\tcall\tcommand\trecorded result\treplayed result\t"
+                  "recorded us\treplayed us\n");
+
+    uint64_t recordedTotal = 0;
+    uint64_t replayedTotal = 0;
+    uint32_t mismatches = 0;
+
+    for (const Call& call : m_calls) {
+        const MciTraceRecord& record = call.record;
+
+        std::string command;
+        if (record.call == TraceCommand) {
+            command = getMessageName(record.message);
+        } else {
+            command = call.text;
+        }
+
+        fprintf(file, "%.3f\t%s\t%s\t%u\t%u\t%u\t%u\n", record.time / 1000.0,
+            getCallName(record.call), command.c_str(), record.result,
+            static_cast<uint32_t>(call.result), record.duration,
+            call.replayed);
+
+        recordedTotal += record.duration;
+        replayedTotal += call.replayed;
+        if (record.result != call.result) {
+            mismatches++;
+        }
+    }
+
+    fclose(file);
+
+    LOG_INFO("Replayed %u calls in %.3f ms, recorded %.3f ms, %u results "
+             "differ, see %s",
+        static_cast<uint32_t>(m_calls.size()), replayedTotal / 1000.0,
+        recordedTotal / 1000.0, mismatches, reportPath.c_str());
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MciTrace.hpp"
+#include "WinMM.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plays a trace of MciRecorder back into the WinMM layer and writes the
+// recorded and the replayed latency of every call. Calls the system
+// handled for the game are skipped. Commands are sent at the pacing of the
+// recording, or back to back when not paced.
+class TraceReplay
+{
+public:
+    // WinMM should be set up for the null output before anything is opened
+    TraceReplay(WinMM& winmm, bool paced);
+
+    // false if the trace can't be read
+    bool run(const std::string& tracePath, const std::string& reportPath);
+
+private:
+    struct Call
+    {
+        MciTraceRecord record;
+        std::string text;
+        MCIERROR result;
+        uint32_t replayed;
+    };
+
+    WinMM& m_winmm;
+    bool m_paced;
+    std::vector<Call> m_calls;
+
+    MCIERROR replay(const MciTraceRecord& record, const std::string& text);
+    MCIERROR replayCommand(
+        const MciTraceRecord& record, const std::string& text);
+    void writeReport(const std::string& reportPath);
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "TrackPattern.hpp"
+
+#include <cctype>
+
+// digits of a track or disc number
+#define NUMBER_DIGITS 3
+
+static const char trackField[] = "{track}";
+static const char discField[] = "{disc}";
+
+TrackPattern::TrackPattern(const std::string& pattern)
+    : m_levels(1)
+{
+    size_t i = 0;
+
+    while (i < pattern.size()) {
+        std::vector<Token>& tokens = m_levels.back();
+        char c = pattern[i];
+
+        if (c == '\\' || c == '/') {
+            // empty levels would only match empty names
+            if (!tokens.empty()) {
+                m_levels.emplace_back();
+            }
+            i++;
+        } else if (c == '*') {
+            // consecutive wildcards are one
+            if (tokens.empty() || tokens.back().type != TokenAny) {
+                tokens.push_back({TokenAny, ""});
+            }
+            i++;
+        } else if (!pattern.compare(i, sizeof(trackField) - 1, trackField)) {
+            tokens.push_back({TokenTrack, ""});
+            i += sizeof(trackField) - 1;
+        } else if (!pattern.compare(i, sizeof(discField) - 1, discField)) {
+            tokens.push_back({TokenDisc, ""});
+            i += sizeof(discField) - 1;
+        } else {
+            if (tokens.empty() || tokens.back().type != TokenLiteral) {
+                tokens.push_back({TokenLiteral, ""});
+            }
+            tokens.back().text += static_cast<char>(
+                tolower(static_cast<unsigned char>(c)));
+            i++;
+        }
+    }
+
+    if (m_levels.back().empty()) {
+        m_levels.pop_back();
+    }
+}
+
+bool TrackPattern::isValid() const
+{
+    if (m_levels.empty()) {
+        return false;
+    }
+
+    for (const Token& token : m_levels.back()) {
+        if (token.type == TokenTrack) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t TrackPattern::getDepth() const
+{
+    return m_levels.size();
+}
+
+std::string TrackPattern::getPrefix(size_t level) const
+{
+    if (level >= m_levels.size() || m_levels[level].empty() ||
+        m_levels[level][0].type != TokenLiteral) {
+        return "";
+    }
+
+    return m_levels[level][0].text;
+}
+
+bool TrackPattern::match(size_t level, const char* name, size_t length,
+    int32_t& disc, int32_t& track) const
+{
+    if (level >= m_levels.size()) {
+        return false;
+    }
+
+    const std::vector<Token>& tokens = m_levels[level];
+    return matchTokens(tokens.data(), tokens.data() + tokens.size(), name,
+        name + length, disc, track);
+}
+
+bool TrackPattern::isNumber(const Token* token)
+{
+    return token->type == TokenTrack || token->type == TokenDisc;
+}
+
+bool TrackPattern::matchTokens(const Token* token, const Token* end,
+    const char* name, const char* nameEnd, int32_t& disc, int32_t& track)
+{
+    if (token == end) {
+        return name == nameEnd;
+    }
+
+    switch (token->type) {
+        case TokenLiteral: {
+            size_t length = token->text.size();
+            if (static_cast<size_t>(nameEnd - name) < length) {
+                return false;
+            }
+
+            for (size_t i = 0; i < length; i++) {
+                if (tolower(static_cast<unsigned char>(name[i])) !=
+                    token->text[i]) {
+                    return false;
+                }
+            }
+
+            return matchTokens(token + 1, end, name + length, nameEnd, disc,
+                track);
+        }
+
+        case TokenAny:
+            // shortest text first, so a following number gets all its
+            // digits, and never the end of a number in front of it
+            for (const char* next = name; next <= nameEnd; next++) {
+                if (next > name && next < nameEnd && token + 1 != end &&
+                    isNumber(token + 1) &&
+                    isdigit(static_cast<unsigned char>(next[-1])) &&
+                    isdigit(static_cast<unsigned char>(*next))) {
+                    continue;
+                }
+
+                if (matchTokens(token + 1, end, next, nameEnd, disc, track)) {
+                    return true;
+                }
+            }
+            return false;
+
+        default: {
+            // numbers take as many digits as there are
+            int32_t value = 0;
+            int32_t digits = 0;
+            while (name < nameEnd && digits < NUMBER_DIGITS &&
+                   isdigit(static_cast<unsigned char>(*name))) {
+                value = value * 10 + (*name++ - '0');
+                digits++;
+            }
+
+            // a longer number is something else, unless another number
+            // follows right away
+            bool longer = name < nameEnd &&
+                          isdigit(static_cast<unsigned char>(*name)) &&
+                          (token + 1 == end || !isNumber(token + 1));
+
+            if (!digits || longer ||
+                !matchTokens(token + 1, end, name, nameEnd, disc, track)) {
+                return false;
+            }
+
+            (token->type == TokenTrack ? track : disc) = value;
+            return true;
+        }
+    }
+}
\ No newline at end of file
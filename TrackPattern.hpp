@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Naming template of the track files, matched against file names without
+// their extension. "{track}" stands for the track number and "{disc}" for
+// the disc number, each one to three digits, "*" for any text. Longer
+// numbers don't match. Directory levels are separated by backslashes and
+// are matched against the subdirectories, e.g. "Disc{disc}\Track{track}*".
+// Letters match in any case. Matching doesn't allocate.
+class TrackPattern
+{
+public:
+    explicit TrackPattern(const std::string& pattern);
+
+    // false if the last level has no track number
+    bool isValid() const;
+
+    // number of levels, the last one is the file name
+    size_t getDepth() const;
+
+    // literal text the names of a level start with, to narrow the search
+    std::string getPrefix(size_t level) const;
+
+    // Matches the name against the given level. Numbers the level doesn't
+    // contain are left as they are.
+    bool match(size_t level, const char* name, size_t length,
+        int32_t& disc, int32_t& track) const;
+
+private:
+    enum TokenType
+    {
+        TokenLiteral,
+        TokenAny,
+        TokenTrack,
+        TokenDisc
+    };
+
+    struct Token
+    {
+        TokenType type;
+
+        // lower case, literals only
+        std::string text;
+    };
+
+    std::vector<std::vector<Token>> m_levels;
+
+    static bool isNumber(const Token* token);
+    static bool matchTokens(const Token* token, const Token* end,
+        const char* name, const char* nameEnd, int32_t& disc,
+        int32_t& track);
+};
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "TrackVerifier.hpp"
+#include "Decoder.hpp"
+#include "FlacDecoder.hpp"
+#include "FlacMetadata.hpp"
+#include "Logger.hpp"
+#include "Md5.hpp"
+#include "WinMMError.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+
+// number of frames decoded at once
+#define VERIFY_BLOCK_FRAMES 4096
+
+static double getSeconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+TrackVerifier::TrackVerifier(
+    CDTrackList& tracks, WorkerPool& pool, const std::string& reportPath)
+    : m_jobs(pool)
+    , m_reportPath(reportPath)
+    , m_cancel(false)
+{
+    // the jobs work on their own copy of the audio tracks
+    for (auto& trackPair : tracks.map()) {
+        if (trackPair.second.path.empty()) {
+            continue;
+        }
+
+        Result result = {};
+        result.track = trackPair.first;
+        result.path = trackPair.second.path;
+        result.codec = trackPair.second.codec;
+        m_results.push_back(result);
+    }
+
+    m_thread = std::thread(&TrackVerifier::run, this);
+}
+
+TrackVerifier::~TrackVerifier()
+{
+    m_cancel = true;
+    m_thread.join();
+}
+
+void TrackVerifier::run()
+{
+    LOG_INFO("Verifying %zu tracks on %u threads", m_results.size(),
+        m_jobs.getPool().getThreadCount());
+
+    double started = getSeconds();
+
+    for (Result& result : m_results) {
+        m_jobs.submit([this, &result] { verify(result); });
+    }
+
+    m_jobs.wait();
+
+    if (m_cancel) {
+        LOG_INFO("Verification cancelled");
+        return;
+    }
+
+    writeReport(getSeconds() - started);
+}
+
+void TrackVerifier::verify(Result& result)
+{
+    if (m_cancel) {
+        result.error = "cancelled";
+        return;
+    }
+
+    Decoder* decoder = Decoder::create(result.codec);
+    Md5 md5;
+    double started = getSeconds();
+
+    // the native decoder hashes the samples at their own size and channels
+    FlacDecoder* flac = dynamic_cast<FlacDecoder*>(decoder);
+    bool native = false;
+    uint8_t digest[16];
+
+    try {
+        decoder->open(result.path);
+
+        if (flac) {
+            flac->setHashing(true);
+        }
+
+        if (decoder->getSampleRate()) {
+            result.length = static_cast<double>(decoder->getLength()) /
+                            decoder->getSampleRate();
+        }
+
+        // hash the decoded PCM, nothing paces the decoder
+        std::vector<int16_t> buffer(VERIFY_BLOCK_FRAMES * 2);
+        size_t frames;
+
+        while (!m_cancel &&
+               (frames = decoder->read(&buffer[0], VERIFY_BLOCK_FRAMES))) {
+            if (!flac) {
+                md5.update(&buffer[0], frames * 2 * sizeof(int16_t));
+            }
+            result.samples += frames;
+        }
+
+        native = flac && flac->getDigest(digest);
+    } catch (const WinMMError& ex) {
+        result.error = ex.what();
+    }
+
+    result.seconds = getSeconds() - started;
+    delete decoder;
+
+    if (!result.error.empty() || m_cancel) {
+        return;
+    }
+
+    // other decoders output 16 bit stereo, which is what the signature
+    // covers for CD audio only
+    if (!native) {
+        md5.finish(digest);
+    }
+
+    FlacMetadata metadata(result.path);
+    const FlacStreamInfo& info = metadata.getStreamInfo();
+    static const uint8_t unset[16] = {};
+
+    if (result.codec != "flac" || !metadata.isValid()) {
+        result.md5 = "n/a";
+    } else if (!memcmp(info.md5, unset, sizeof(unset))) {
+        result.md5 = "unset";
+    } else if (!native && (info.bitsPerSample != 16 || info.channels != 2)) {
+        result.md5 = "unchecked";
+    } else if (memcmp(info.md5, digest, sizeof(digest)) != 0) {
+        result.md5 = "mismatch";
+        result.error = "MD5 " + Md5::toString(digest) + " instead of " +
+                       Md5::toString(info.md5);
+    } else if (info.totalSamples && info.totalSamples != result.samples) {
+        result.md5 = "match";
+        result.error = "decoded " + std::to_string(result.samples) +
+                       " of " + std::to_string(info.totalSamples) +
+                       " samples";
+    } else {
+        result.md5 = "match";
+    }
+}
+
+void TrackVerifier::writeReport(double seconds)
+{
+    FILE* file = fopen(m_reportPath.c_str(), "w");
+    if (!file) {
+        LOG_INFO("Can't write %s", m_reportPath.c_str());
+        return;
+    }
+
+    int32_t failed = 0;
+    double audio = 0.0;
+
+    fprintf(file, "track\tresult\tmd5\tsamples\tlength\tdecode\tspeed\tfile\n");
+
+    for (const Result& result : m_results) {
+        double speed = result.seconds > 0 ? result.length / result.seconds : 0;
+
+        fprintf(file, "%02d\t%s\t%s\t%llu\t%.1f s\t%.2f s\t%.1fx\t%s\n",
+            result.track, result.error.empty() ? "ok" : "FAILED",
+            result.md5.c_str(),
+            static_cast<unsigned long long>(result.samples), result.length,
+            result.seconds, speed, result.path.c_str());
+
+        if (!result.error.empty()) {
+            fprintf(file, "\t%s\n", result.error.c_str());
+            failed++;
+        }
+
+        audio += result.length;
+    }
+
+    fprintf(file, "\n%d tracks, %d failed, %.1f s of audio in %.2f s (%.1fx)\n",
+        static_cast<int32_t>(m_results.size()), failed, audio, seconds,
+        seconds > 0 ? audio / seconds : 0.0);
+
+    fclose(file);
+
+    LOG_INFO("Verified %zu tracks, %d failed, see %s", m_results.size(),
+        failed, m_reportPath.c_str());
+}
\ No newline at end of file
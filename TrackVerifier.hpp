@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CDTrackList.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes all tracks on the worker pool and writes a report listing files
+// that fail to decode or don't match their FLAC MD5 signature, along with
+// the decode speed of each file.
+class TrackVerifier
+{
+public:
+    TrackVerifier(
+        CDTrackList& tracks, WorkerPool& pool, const std::string& reportPath);
+
+    // cancels a running verification
+    ~TrackVerifier();
+
+private:
+    struct Result
+    {
+        int32_t track;
+        std::string path;
+        std::string codec;
+        std::string error;
+        std::string md5;
+        uint64_t samples;
+        double length;
+        double seconds;
+    };
+
+    JobGroup m_jobs;
+    std::string m_reportPath;
+    std::vector<Result> m_results;
+    std::atomic<bool> m_cancel;
+    std::thread m_thread;
+
+    void run();
+    void verify(Result& result);
+    void writeReport(double seconds);
+};
\ No newline at end of file
@@ -0,0 +1,1625 @@
+#include "VorbisDecoder.hpp"
+#include "AudioClock.hpp"
+#include "WinMMError.hpp"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#define OGG_HEADER_SIZE 27
+#define OGG_MAX_SEGMENTS 255
+#define OGG_FLAG_CONTINUED 1
+#define OGG_FLAG_LAST 4
+#define OGG_NO_GRANULE UINT64_MAX
+
+#define VORBIS_PI 3.14159265358979323846
+
+// the end of the file is searched for the last page in chunks of this size
+#define VORBIS_TAIL_SIZE (64 * 1024)
+
+// codes up to this many bits are looked up in a table
+#define VORBIS_FAST_BITS 10
+
+#define VORBIS_MAX_FLOOR_POINTS 65
+
+// a book of vectors may have at most this many values in all
+#define VORBIS_MAX_VALUES (1 << 24)
+
+// reads load 8 bytes at any position up to the end of the packet
+#define VORBIS_PACKET_PADDING 8
+
+// the stream starts at a granule position that isn't known yet
+#define VORBIS_UNKNOWN_OFFSET UINT64_MAX
+
+static const uint32_t* getCrcTable()
+{
+    static uint32_t table[256];
+    static bool ready = false;
+
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i << 24;
+            for (int32_t bit = 0; bit < 8; bit++) {
+                crc = (crc << 1) ^ (crc & 0x80000000 ? 0x04c11db7 : 0);
+            }
+            table[i] = crc;
+        }
+        ready = true;
+    }
+
+    return table;
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    const uint32_t* table = getCrcTable();
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc << 8) ^ table[(crc >> 24) ^ data[i]];
+    }
+    return crc;
+}
+
+// the floor amplitudes, 140 dB in 256 steps
+static const float* getInverseDbTable()
+{
+    static float table[256];
+    static bool ready = false;
+
+    if (!ready) {
+        for (int32_t i = 0; i < 256; i++) {
+            table[i] = static_cast<float>(
+                1.0649863e-07 * exp(i * log(1.0 / 1.0649863e-07) / 255));
+        }
+        ready = true;
+    }
+
+    return table;
+}
+
+static inline uint64_t loadLE64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t readLE32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// bits needed to store the value
+static uint32_t ilog(uint32_t value)
+{
+    uint32_t bits = 0;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+static uint32_t reverseBits(uint32_t value)
+{
+    value = ((value & 0xaaaaaaaa) >> 1) | ((value & 0x55555555) << 1);
+    value = ((value & 0xcccccccc) >> 2) | ((value & 0x33333333) << 2);
+    value = ((value & 0xf0f0f0f0) >> 4) | ((value & 0x0f0f0f0f) << 4);
+    value = ((value & 0xff00ff00) >> 8) | ((value & 0x00ff00ff) << 8);
+    return (value >> 16) | (value << 16);
+}
+
+// 21 bits mantissa, 10 bits exponent and the sign
+static float unpackFloat(uint32_t value)
+{
+    double mantissa = value & 0x1fffff;
+    int32_t exponent = static_cast<int32_t>((value >> 21) & 0x3ff) - 788;
+    return static_cast<float>(
+        ldexp(value & 0x80000000 ? -mantissa : mantissa, exponent));
+}
+
+// the largest count of values whose power of the dimensions fits the entries
+static uint32_t getLookupValues(uint32_t entries, uint32_t dimensions)
+{
+    uint32_t values = static_cast<uint32_t>(
+        floor(exp(log(static_cast<double>(entries)) / dimensions)));
+
+    while (pow(values + 1.0, dimensions) <= entries) {
+        values++;
+    }
+    while (values > 1 && pow(static_cast<double>(values), dimensions) >
+                             entries) {
+        values--;
+    }
+    return values;
+}
+
+static int32_t renderPoint(
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x)
+{
+    int32_t dy = y1 - y0;
+    int32_t offset = abs(dy) * (x - x0) / (x1 - x0);
+    return dy < 0 ? y0 - offset : y0 + offset;
+}
+
+// Multiplies the vector with the floor line from x0 up to x1, the steps
+// of the line are those of the integer Bresenham the encoder used.
+static void renderLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    float* vector, int32_t size)
+{
+    const float* table = getInverseDbTable();
+    int32_t dy = y1 - y0;
+    int32_t dx = x1 - x0;
+    int32_t base = dy / dx;
+    int32_t step = dy < 0 ? base - 1 : base + 1;
+    int32_t error = 0;
+    int32_t remainder = abs(dy) - abs(base) * dx;
+    int32_t end = (std::min)(x1, size);
+    int32_t y = y0;
+
+    for (int32_t x = x0; x < end; x++) {
+        if (x > x0) {
+            error += remainder;
+            if (error >= dx) {
+                error -= dx;
+                y += step;
+            } else {
+                y += base;
+            }
+        }
+        vector[x] *= table[(std::min)((std::max)(y, 0), 255)];
+    }
+}
+
+// in place complex FFT of interleaved real and imaginary parts
+static void fft(float* data, uint32_t size, const std::vector<float>& twiddles,
+    const std::vector<uint32_t>& bitReverse)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        uint32_t j = bitReverse[i];
+        if (j > i) {
+            std::swap(data[i * 2], data[j * 2]);
+            std::swap(data[i * 2 + 1], data[j * 2 + 1]);
+        }
+    }
+
+    for (uint32_t half = 1; half < size; half *= 2) {
+        uint32_t stride = size / (half * 2);
+
+        for (uint32_t start = 0; start < size; start += half * 2) {
+            for (uint32_t k = 0; k < half; k++) {
+                float wr = twiddles[k * stride * 2];
+                float wi = twiddles[k * stride * 2 + 1];
+                float* a = &data[(start + k) * 2];
+                float* b = &data[(start + k + half) * 2];
+
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+// LSB first reader over a packet in memory, as Vorbis packs its fields.
+// Reads past the end return zero bits and are caught by overrun().
+class VorbisReader
+{
+public:
+    VorbisReader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_pos(0)
+        , m_end(size * 8)
+    {
+    }
+
+    uint32_t read(uint32_t bits)
+    {
+        if (!bits) {
+            return 0;
+        }
+        uint64_t value = peek() & ((1ull << bits) - 1);
+        m_pos += bits;
+        return static_cast<uint32_t>(value);
+    }
+
+    bool readFlag()
+    {
+        return read(1) != 0;
+    }
+
+    // the entry of the next code, -1 if there is none or the packet ended
+    int32_t decode(const VorbisDecoder::Codebook& book)
+    {
+        int32_t entry = book.single;
+
+        if (entry < 0) {
+            uint64_t bits = peek();
+            entry = book.fast[bits & ((1u << VORBIS_FAST_BITS) - 1)];
+
+            for (size_t i = 0; entry < 0 && i < book.slow.size(); i++) {
+                uint32_t candidate = book.slow[i];
+                uint64_t mask = (1ull << book.lengths[candidate]) - 1;
+                if ((bits & mask) == book.codes[candidate]) {
+                    entry = static_cast<int32_t>(candidate);
+                }
+            }
+
+            if (entry < 0) {
+                return -1;
+            }
+        }
+
+        m_pos += book.lengths[entry];
+        return overrun() ? -1 : entry;
+    }
+
+    bool overrun()
+    {
+        return m_pos > m_end;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_pos;
+    size_t m_end;
+
+    uint64_t peek()
+    {
+        if (m_pos >= m_end) {
+            return 0;
+        }
+        return loadLE64(m_data + (m_pos >> 3)) >> (m_pos & 7);
+    }
+};
+
+static void require(bool condition, const std::string& path)
+{
+    if (!condition) {
+        throw WinMMError("Broken Vorbis setup in " + path, MCIERR_HARDWARE);
+    }
+}
+
+VorbisDecoder::VorbisDecoder()
+    : m_fileSize(0)
+    , m_filePos(0)
+    , m_serial(0)
+    , m_hasSerial(false)
+    , m_nextPage(0)
+    , m_segment(0)
+    , m_bodyPos(0)
+    , m_pageGranule(OGG_NO_GRANULE)
+    , m_pageSerial(0)
+    , m_pageFlags(0)
+    , m_packetSize(0)
+    , m_blockSizes()
+    , m_previousSize(0)
+    , m_pcmPos(0)
+    , m_pcmFrames(0)
+    , m_nextSample(0)
+    , m_placed(false)
+    , m_target(0)
+    , m_skip(0)
+    , m_granuleOffset(VORBIS_UNKNOWN_OFFSET)
+    , m_sampleKernels(SampleKernels::get(SampleKernels::getBest()))
+{
+    SampleKernels::seedDither(m_dither);
+}
+
+void VorbisDecoder::open(const std::string& path)
+{
+    m_path = path;
+    m_file.open(path, std::ios::binary);
+    if (!m_file) {
+        throw WinMMError("Can't open " + path, MCIERR_HARDWARE);
+    }
+
+    m_file.seekg(0, std::ios::end);
+    m_fileSize = static_cast<uint64_t>(m_file.tellg());
+    m_file.seekg(0, std::ios::beg);
+    moveTo(0);
+
+    readHeaders();
+    prepareBlocks();
+
+    // made relative to the start of the stream once that is known
+    m_length = findLength();
+    restart();
+
+    // decode up to the first granule position, it places the stream
+    fillCache();
+}
+
+void VorbisDecoder::readHeaders()
+{
+    for (uint32_t type = 1; type <= 5; type += 2) {
+        uint64_t granule;
+        if (!readPacket(granule)) {
+            throw WinMMError("Not an Ogg Vorbis file: " + m_path,
+                MCIERR_HARDWARE);
+        }
+
+        VorbisReader reader(m_packet.data(), m_packetSize);
+        bool valid = reader.read(8) == type;
+        for (const char* magic = "vorbis"; *magic; magic++) {
+            valid = valid && reader.read(8) == static_cast<uint8_t>(*magic);
+        }
+
+        if (!valid) {
+            throw WinMMError("Not an Ogg Vorbis file: " + m_path,
+                MCIERR_HARDWARE);
+        }
+
+        if (type == 1) {
+            uint32_t version = reader.read(32);
+            m_channels = reader.read(8);
+            m_sampleRate = reader.read(32);
+
+            // bitrates
+            reader.read(32);
+            reader.read(32);
+            reader.read(32);
+
+            m_blockSizes[0] = 1u << reader.read(4);
+            m_blockSizes[1] = 1u << reader.read(4);
+
+            if (version || !m_channels || !m_sampleRate ||
+                m_blockSizes[0] < 64 || m_blockSizes[1] > 8192 ||
+                m_blockSizes[0] > m_blockSizes[1] || !reader.readFlag()) {
+                throw WinMMError("Unsupported Vorbis stream in " + m_path,
+                    MCIERR_HARDWARE);
+            }
+        } else if (type == 5) {
+            readSetup(reader);
+        }
+    }
+}
+
+void VorbisDecoder::readSetup(VorbisReader& reader)
+{
+    m_codebooks.resize(reader.read(8) + 1);
+    for (Codebook& book : m_codebooks) {
+        readCodebook(reader, book);
+    }
+
+    // the time domain transforms are placeholders
+    uint32_t transforms = reader.read(6) + 1;
+    for (uint32_t i = 0; i < transforms; i++) {
+        require(!reader.read(16), m_path);
+    }
+
+    m_floors.resize(reader.read(6) + 1);
+    for (Floor& floor : m_floors) {
+        if (reader.read(16) != 1) {
+            throw WinMMError("Unsupported Vorbis floor in " + m_path,
+                MCIERR_HARDWARE);
+        }
+        readFloor(reader, floor);
+    }
+
+    m_residues.resize(reader.read(6) + 1);
+    for (Residue& residue : m_residues) {
+        residue.type = reader.read(16);
+        require(residue.type <= 2, m_path);
+        readResidue(reader, residue);
+    }
+
+    m_mappings.resize(reader.read(6) + 1);
+    for (Mapping& mapping : m_mappings) {
+        readMapping(reader, mapping);
+    }
+
+    m_modes.resize(reader.read(6) + 1);
+    for (Mode& mode : m_modes) {
+        mode.blockFlag = reader.readFlag();
+        uint32_t window = reader.read(16);
+        uint32_t transform = reader.read(16);
+        mode.mapping = reader.read(8);
+        require(!window && !transform && mode.mapping < m_mappings.size(),
+            m_path);
+    }
+
+    require(reader.readFlag() && !reader.overrun(), m_path);
+}
+
+void VorbisDecoder::readCodebook(VorbisReader& reader, Codebook& book)
+{
+    require(reader.read(24) == 0x564342, m_path);
+    book.dimensions = reader.read(16);
+    book.entries = reader.read(24);
+    require(book.entries > 0, m_path);
+
+    uint32_t entries = book.entries;
+    book.lengths.assign(entries, 0);
+
+    if (reader.readFlag()) {
+        // ordered, runs of entries with rising lengths
+        uint32_t length = reader.read(5) + 1;
+        for (uint32_t entry = 0; entry < entries; length++) {
+            uint32_t count = reader.read(ilog(entries - entry));
+            require(length <= 32 && count <= entries - entry &&
+                        !reader.overrun(),
+                m_path);
+            std::fill(&book.lengths[entry], &book.lengths[entry] + count,
+                static_cast<uint8_t>(length));
+            entry += count;
+        }
+    } else {
+        bool sparse = reader.readFlag();
+        for (uint32_t entry = 0; entry < entries; entry++) {
+            if (!sparse || reader.readFlag()) {
+                book.lengths[entry] = static_cast<uint8_t>(reader.read(5) + 1);
+            }
+        }
+    }
+
+    uint32_t lookup = reader.read(4);
+    if (lookup == 1 || lookup == 2) {
+        float minimum = unpackFloat(reader.read(32));
+        float delta = unpackFloat(reader.read(32));
+        uint32_t valueBits = reader.read(4) + 1;
+        bool sequence = reader.readFlag();
+
+        uint64_t total = static_cast<uint64_t>(entries) * book.dimensions;
+        require(book.dimensions && total <= VORBIS_MAX_VALUES, m_path);
+
+        // a grid of values on each axis or a value for each one of each entry
+        uint32_t count = lookup == 1
+                             ? getLookupValues(entries, book.dimensions)
+                             : static_cast<uint32_t>(total);
+        std::vector<uint32_t> multiplicands(count);
+        for (uint32_t& multiplicand : multiplicands) {
+            multiplicand = reader.read(valueBits);
+        }
+        require(!reader.overrun(), m_path);
+
+        book.values.resize(static_cast<size_t>(total));
+        for (uint32_t entry = 0; entry < entries; entry++) {
+            float last = 0;
+            uint32_t divisor = 1;
+
+            for (uint32_t i = 0; i < book.dimensions; i++) {
+                uint32_t index = lookup == 1
+                                     ? entry / divisor % count
+                                     : entry * book.dimensions + i;
+                float value = multiplicands[index] * delta + minimum + last;
+                if (sequence) {
+                    last = value;
+                }
+
+                book.values[entry * book.dimensions + i] = value;
+                divisor *= count;
+            }
+        }
+    } else {
+        require(!lookup, m_path);
+    }
+
+    require(!reader.overrun(), m_path);
+
+    // Each code is the lowest one free at its length, taken in the order of
+    // the entries. available[] holds the free code of each length, MSB
+    // aligned, the first code is all zeros.
+    book.codes.assign(entries, 0);
+    book.fast.assign(1 << VORBIS_FAST_BITS, -1);
+    book.single = -1;
+
+    uint32_t used = 0;
+    uint32_t available[33] = {};
+
+    for (uint32_t entry = 0; entry < entries; entry++) {
+        uint32_t length = book.lengths[entry];
+        if (!length) {
+            continue;
+        }
+
+        if (!used++) {
+            book.single = static_cast<int32_t>(entry);
+            for (uint32_t i = 1; i <= length; i++) {
+                available[i] = 1u << (32 - i);
+            }
+            continue;
+        }
+
+        uint32_t free = length;
+        while (free > 0 && !available[free]) {
+            free--;
+        }
+        require(free > 0, m_path);
+
+        uint32_t code = available[free];
+        available[free] = 0;
+        book.codes[entry] = reverseBits(code);
+
+        // the longer codes below the one taken are free
+        for (uint32_t i = length; i > free; i--) {
+            available[i] = code + (1u << (32 - i));
+        }
+    }
+
+    if (used != 1) {
+        book.single = -1;
+
+        for (uint32_t entry = 0; entry < entries; entry++) {
+            uint32_t length = book.lengths[entry];
+            if (!length) {
+                continue;
+            }
+
+            if (length > VORBIS_FAST_BITS) {
+                book.slow.push_back(entry);
+                continue;
+            }
+
+            for (uint32_t bits = book.codes[entry];
+                 bits < (1u << VORBIS_FAST_BITS); bits += 1u << length) {
+                book.fast[bits] = static_cast<int32_t>(entry);
+            }
+        }
+
+        // shorter codes are more likely
+        std::stable_sort(book.slow.begin(), book.slow.end(),
+            [&book](uint32_t a, uint32_t b) {
+                return book.lengths[a] < book.lengths[b];
+            });
+    }
+}
+
+void VorbisDecoder::readFloor(VorbisReader& reader, Floor& floor)
+{
+    uint32_t books = static_cast<uint32_t>(m_codebooks.size());
+    uint32_t classes = 0;
+
+    floor.partitionClass.resize(reader.read(5));
+    for (uint8_t& partitionClass : floor.partitionClass) {
+        partitionClass = static_cast<uint8_t>(reader.read(4));
+        classes = (std::max)(classes, partitionClass + 1u);
+    }
+
+    for (uint32_t c = 0; c < classes; c++) {
+        floor.classDimensions[c] = reader.read(3) + 1;
+        floor.classSubclasses[c] = reader.read(2);
+        floor.classMasterbook[c] = -1;
+
+        if (floor.classSubclasses[c]) {
+            floor.classMasterbook[c] = static_cast<int32_t>(reader.read(8));
+            require(floor.classMasterbook[c] < static_cast<int32_t>(books),
+                m_path);
+        }
+
+        for (uint32_t i = 0; i < (1u << floor.classSubclasses[c]); i++) {
+            floor.subclassBooks[c][i] =
+                static_cast<int32_t>(reader.read(8)) - 1;
+            require(floor.subclassBooks[c][i] < static_cast<int32_t>(books),
+                m_path);
+        }
+    }
+
+    floor.multiplier = reader.read(2) + 1;
+    uint32_t rangeBits = reader.read(4);
+
+    floor.x.push_back(0);
+    floor.x.push_back(1u << rangeBits);
+    for (uint8_t partitionClass : floor.partitionClass) {
+        for (uint32_t i = 0; i < floor.classDimensions[partitionClass]; i++) {
+            floor.x.push_back(reader.read(rangeBits));
+        }
+    }
+
+    uint32_t count = static_cast<uint32_t>(floor.x.size());
+    require(count <= VORBIS_MAX_FLOOR_POINTS && !reader.overrun(), m_path);
+
+    floor.sorted.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        floor.sorted[i] = i;
+    }
+    std::sort(floor.sorted.begin(), floor.sorted.end(),
+        [&floor](uint32_t a, uint32_t b) { return floor.x[a] < floor.x[b]; });
+
+    for (uint32_t i = 1; i < count; i++) {
+        require(floor.x[floor.sorted[i]] != floor.x[floor.sorted[i - 1]],
+            m_path);
+    }
+
+    // the closest points on either side among those before each point
+    floor.low.assign(count, 0);
+    floor.high.assign(count, 1);
+    for (uint32_t i = 2; i < count; i++) {
+        for (uint32_t j = 0; j < i; j++) {
+            if (floor.x[j] < floor.x[i] &&
+                floor.x[j] > floor.x[floor.low[i]]) {
+                floor.low[i] = j;
+            }
+            if (floor.x[j] > floor.x[i] &&
+                floor.x[j] < floor.x[floor.high[i]]) {
+                floor.high[i] = j;
+            }
+        }
+    }
+}
+
+void VorbisDecoder::readResidue(VorbisReader& reader, Residue& residue)
+{
+    residue.begin = reader.read(24);
+    residue.end = reader.read(24);
+    residue.partitionSize = reader.read(24) + 1;
+    residue.classifications = reader.read(6) + 1;
+    residue.classbook = reader.read(8);
+
+    require(residue.classbook < m_codebooks.size() &&
+                m_codebooks[residue.classbook].dimensions,
+        m_path);
+
+    // the passes each classification has a book for
+    uint32_t cascades[64];
+    for (uint32_t c = 0; c < residue.classifications; c++) {
+        uint32_t low = reader.read(3);
+        uint32_t high = reader.readFlag() ? reader.read(5) : 0;
+        cascades[c] = (high << 3) | low;
+    }
+
+    residue.books.assign(residue.classifications * 8, -1);
+    for (uint32_t c = 0; c < residue.classifications; c++) {
+        for (uint32_t pass = 0; pass < 8; pass++) {
+            if (!(cascades[c] & (1u << pass))) {
+                continue;
+            }
+
+            uint32_t book = reader.read(8);
+            require(book < m_codebooks.size() &&
+                        !m_codebooks[book].values.empty() &&
+                        residue.partitionSize %
+                                m_codebooks[book].dimensions ==
+                            0,
+                m_path);
+            residue.books[c * 8 + pass] = static_cast<int32_t>(book);
+        }
+    }
+
+    require(!reader.overrun(), m_path);
+}
+
+void VorbisDecoder::readMapping(VorbisReader& reader, Mapping& mapping)
+{
+    require(!reader.read(16), m_path);
+    uint32_t submaps = reader.readFlag() ? reader.read(4) + 1 : 1;
+
+    if (reader.readFlag()) {
+        uint32_t steps = reader.read(8) + 1;
+        uint32_t bits = ilog(m_channels - 1);
+
+        for (uint32_t i = 0; i < steps; i++) {
+            uint32_t magnitude = reader.read(bits);
+            uint32_t angle = reader.read(bits);
+            require(magnitude != angle && magnitude < m_channels &&
+                        angle < m_channels,
+                m_path);
+            mapping.magnitude.push_back(magnitude);
+            mapping.angle.push_back(angle);
+        }
+    }
+
+    require(!reader.read(2), m_path);
+
+    mapping.mux.assign(m_channels, 0);
+    if (submaps > 1) {
+        for (uint8_t& mux : mapping.mux) {
+            mux = static_cast<uint8_t>(reader.read(4));
+            require(mux < submaps, m_path);
+        }
+    }
+
+    for (uint32_t i = 0; i < submaps; i++) {
+        // unused time configuration
+        reader.read(8);
+
+        mapping.floors.push_back(reader.read(8));
+        mapping.residues.push_back(reader.read(8));
+        require(mapping.floors.back() < m_floors.size() &&
+                    mapping.residues.back() < m_residues.size(),
+            m_path);
+    }
+}
+
+void VorbisDecoder::prepareBlocks()
+{
+    for (int32_t flag = 0; flag < 2; flag++) {
+        uint32_t size = m_blockSizes[flag];
+        uint32_t half = size / 2;
+        uint32_t quarter = size / 4;
+
+        // the rising half of the power complementary window
+        m_windows[flag].resize(half);
+        for (uint32_t i = 0; i < half; i++) {
+            double s = sin((i + 0.5) / half * VORBIS_PI / 2);
+            m_windows[flag][i] =
+                static_cast<float>(sin(VORBIS_PI / 2 * s * s));
+        }
+
+        // the inverse MDCT is a DCT-IV of half the size done with an FFT of
+        // a quarter, twiddled before and after
+        Transform& transform = m_transforms[flag];
+        transform.pre.resize(half);
+        transform.post.resize(half);
+        transform.twiddles.resize(quarter);
+        transform.bitReverse.resize(quarter);
+
+        uint32_t bits = ilog(quarter) - 1;
+        for (uint32_t i = 0; i < quarter; i++) {
+            double pre = -VORBIS_PI * i / half;
+            double post = -VORBIS_PI * (i + 0.25) / half;
+            transform.pre[i * 2] = static_cast<float>(cos(pre));
+            transform.pre[i * 2 + 1] = static_cast<float>(sin(pre));
+            transform.post[i * 2] = static_cast<float>(cos(post));
+            transform.post[i * 2 + 1] = static_cast<float>(sin(post));
+            transform.bitReverse[i] = reverseBits(i) >> (32 - bits);
+        }
+
+        for (uint32_t i = 0; i < quarter / 2; i++) {
+            double angle = -2 * VORBIS_PI * i / quarter;
+            transform.twiddles[i * 2] = static_cast<float>(cos(angle));
+            transform.twiddles[i * 2 + 1] = static_cast<float>(sin(angle));
+        }
+    }
+
+    uint32_t longHalf = m_blockSizes[1] / 2;
+    m_residue.resize(m_channels * longHalf);
+    m_block.resize(2 * m_blockSizes[1]);
+    m_overlap.resize(2 * longHalf);
+    m_work.resize(m_blockSizes[1]);
+    m_stereo.resize(m_blockSizes[1]);
+    m_floorY.resize(m_channels * VORBIS_MAX_FLOOR_POINTS);
+}
+
+uint64_t VorbisDecoder::findLength()
+{
+    // the granule position of the last page is the length, search for its
+    // capture pattern from the end
+    std::vector<char> chunk;
+    uint64_t end = m_fileSize;
+
+    while (end > 0) {
+        uint64_t start = end > VORBIS_TAIL_SIZE ? end - VORBIS_TAIL_SIZE : 0;
+
+        // with the bytes of a pattern that starts just before the end
+        chunk.resize(static_cast<size_t>((std::min)(end + 3, m_fileSize) -
+                                         start));
+        m_file.clear();
+        m_file.seekg(start, std::ios::beg);
+        m_file.read(&chunk[0], chunk.size());
+        m_filePos = OGG_NO_GRANULE;
+        m_stats.bytesRead += chunk.size();
+
+        for (size_t i = static_cast<size_t>(end - start); i-- > 0;) {
+            if (i + 4 <= chunk.size() && !memcmp(&chunk[i], "OggS", 4) &&
+                readPageAt(start + i) && m_pageSerial == m_serial &&
+                m_pageGranule != OGG_NO_GRANULE) {
+                return m_pageGranule;
+            }
+        }
+
+        end = start;
+    }
+
+    throw WinMMError("Broken Ogg stream in " + m_path, MCIERR_HARDWARE);
+}
+
+void VorbisDecoder::indexPages()
+{
+    uint8_t header[OGG_HEADER_SIZE + OGG_MAX_SEGMENTS];
+    uint64_t offset = 0;
+
+    m_file.clear();
+    m_file.seekg(0, std::ios::beg);
+    m_filePos = OGG_NO_GRANULE;
+
+    // the headers only, the bodies are skipped
+    while (m_file.read(reinterpret_cast<char*>(header), OGG_HEADER_SIZE) &&
+           !memcmp(header, "OggS", 4)) {
+        uint32_t segments = header[26];
+        if (!m_file.read(
+                reinterpret_cast<char*>(header + OGG_HEADER_SIZE), segments)) {
+            break;
+        }
+
+        uint32_t bodySize = 0;
+        for (uint32_t i = 0; i < segments; i++) {
+            bodySize += header[OGG_HEADER_SIZE + i];
+        }
+
+        offset += OGG_HEADER_SIZE + segments + bodySize;
+        m_stats.bytesRead += OGG_HEADER_SIZE + segments;
+
+        uint64_t granule = loadLE64(header + 6);
+        if (readLE32(header + 14) == m_serial && granule != OGG_NO_GRANULE) {
+            m_pages.push_back({offset, granule});
+        }
+
+        m_file.seekg(bodySize, std::ios::cur);
+    }
+}
+
+bool VorbisDecoder::readPageAt(uint64_t offset)
+{
+    uint8_t header[OGG_HEADER_SIZE + OGG_MAX_SEGMENTS];
+
+    if (m_filePos != offset) {
+        m_file.clear();
+        m_file.seekg(offset, std::ios::beg);
+    }
+    m_filePos = OGG_NO_GRANULE;
+
+    if (!m_file.read(reinterpret_cast<char*>(header), OGG_HEADER_SIZE) ||
+        memcmp(header, "OggS", 4) != 0 || header[4] != 0) {
+        return false;
+    }
+
+    uint32_t segments = header[26];
+    if (!m_file.read(
+            reinterpret_cast<char*>(header + OGG_HEADER_SIZE), segments)) {
+        return false;
+    }
+
+    uint32_t bodySize = 0;
+    for (uint32_t i = 0; i < segments; i++) {
+        bodySize += header[OGG_HEADER_SIZE + i];
+    }
+
+    m_body.resize(bodySize);
+    if (bodySize && !m_file.read(reinterpret_cast<char*>(&m_body[0]),
+                        bodySize)) {
+        return false;
+    }
+
+    m_stats.bytesRead += OGG_HEADER_SIZE + segments + bodySize;
+
+    // the CRC is taken with its own field zero
+    uint32_t stored = readLE32(header + 22);
+    memset(header + 22, 0, 4);
+    uint32_t crc = crc32(0, header, OGG_HEADER_SIZE + segments);
+    if (crc32(crc, m_body.data(), bodySize) != stored) {
+        return false;
+    }
+
+    m_pageFlags = header[5];
+    m_pageGranule = loadLE64(header + 6);
+    m_pageSerial = readLE32(header + 14);
+    m_lacing.assign(header + OGG_HEADER_SIZE,
+        header + OGG_HEADER_SIZE + segments);
+    m_segment = 0;
+    m_bodyPos = 0;
+    m_nextPage = offset + OGG_HEADER_SIZE + segments + bodySize;
+    m_filePos = m_nextPage;
+    return true;
+}
+
+bool VorbisDecoder::readPage()
+{
+    while (m_nextPage + OGG_HEADER_SIZE <= m_fileSize) {
+        uint64_t offset = m_nextPage;
+
+        if (!readPageAt(offset)) {
+            // a broken page loses the packet it was part of, go on with the
+            // next capture pattern
+            m_packet.clear();
+            m_lacing.clear();
+            m_segment = 0;
+            m_nextPage = findCapture(offset + 1);
+            continue;
+        }
+
+        // the first page sets the stream to decode
+        if (!m_hasSerial) {
+            m_serial = m_pageSerial;
+            m_hasSerial = true;
+        }
+
+        if (m_pageSerial == m_serial) {
+            return true;
+        }
+    }
+
+    m_lacing.clear();
+    m_segment = 0;
+    return false;
+}
+
+uint64_t VorbisDecoder::findCapture(uint64_t offset)
+{
+    char chunk[4096];
+
+    while (offset + 4 <= m_fileSize) {
+        size_t size = static_cast<size_t>(
+            (std::min)(static_cast<uint64_t>(sizeof(chunk)),
+                m_fileSize - offset));
+
+        m_file.clear();
+        m_file.seekg(offset, std::ios::beg);
+        m_file.read(chunk, size);
+        m_filePos = OGG_NO_GRANULE;
+        m_stats.bytesRead += size;
+
+        for (size_t i = 0; i + 4 <= size; i++) {
+            if (!memcmp(chunk + i, "OggS", 4)) {
+                return offset + i;
+            }
+        }
+
+        offset += size - 3;
+    }
+
+    return m_fileSize;
+}
+
+bool VorbisDecoder::readPacket(uint64_t& granule)
+{
+    m_packet.clear();
+
+    while (true) {
+        if (m_segment == m_lacing.size()) {
+            if (!readPage()) {
+                return false;
+            }
+
+            bool continued = (m_pageFlags & OGG_FLAG_CONTINUED) != 0;
+            if (continued && m_packet.empty()) {
+                // the start of this packet wasn't read, skip the rest
+                while (m_segment < m_lacing.size()) {
+                    uint8_t lacing = m_lacing[m_segment++];
+                    m_bodyPos += lacing;
+                    if (lacing < 255) {
+                        break;
+                    }
+                }
+            } else if (!continued) {
+                m_packet.clear();
+            }
+            continue;
+        }
+
+        uint8_t lacing = m_lacing[m_segment++];
+        m_packet.insert(m_packet.end(), m_body.data() + m_bodyPos,
+            m_body.data() + m_bodyPos + lacing);
+        m_bodyPos += lacing;
+
+        if (lacing == 255) {
+            continue;
+        }
+
+        // the granule position is that of the last packet ending on the page
+        granule = m_pageGranule;
+        for (size_t i = m_segment; i < m_lacing.size(); i++) {
+            if (m_lacing[i] < 255) {
+                granule = OGG_NO_GRANULE;
+                break;
+            }
+        }
+
+        m_packetSize = m_packet.size();
+        m_packet.resize(m_packetSize + VORBIS_PACKET_PADDING, 0);
+        return true;
+    }
+}
+
+void VorbisDecoder::moveTo(uint64_t offset)
+{
+    m_nextPage = offset;
+    m_lacing.clear();
+    m_segment = 0;
+    m_packet.clear();
+}
+
+void VorbisDecoder::restart()
+{
+    moveTo(0);
+
+    uint64_t granule;
+    for (int32_t i = 0; i < 3; i++) {
+        readPacket(granule);
+    }
+
+    m_previousSize = 0;
+    m_placed = false;
+    m_target = 0;
+    m_skip = 0;
+    m_pcmPos = 0;
+    m_pcmFrames = 0;
+}
+
+size_t VorbisDecoder::read(int16_t* buffer, size_t frames)
+{
+    int64_t started = AudioClock::getSystemTime();
+    size_t total = 0;
+
+    while (total < frames) {
+        if (m_pcmPos == m_pcmFrames && !fillCache()) {
+            break;
+        }
+
+        size_t count = (std::min)(frames - total, m_pcmFrames - m_pcmPos);
+        memcpy(buffer + total * 2, &m_pcm[m_pcmPos * 2],
+            count * 2 * sizeof(int16_t));
+
+        m_pcmPos += count;
+        total += count;
+    }
+
+    m_stats.frames += total;
+    m_stats.seconds += (AudioClock::getSystemTime() - started) / 1e9;
+    return total;
+}
+
+bool VorbisDecoder::fillCache()
+{
+    m_pcmPos = 0;
+    m_pcmFrames = 0;
+
+    // until placed the decoded frames are kept, where they are in the stream
+    // is known at the next granule position
+    uint64_t granule;
+    while (readPacket(granule)) {
+        size_t added = decodePacket();
+
+        if (!m_placed) {
+            if (granule != OGG_NO_GRANULE) {
+                place(granule, (m_pageFlags & OGG_FLAG_LAST) != 0);
+            }
+        } else if (added) {
+            uint64_t skip = (std::min)(m_skip, static_cast<uint64_t>(added));
+            m_skip -= skip;
+            m_pcmPos += static_cast<size_t>(skip);
+
+            m_nextSample += added;
+            if (m_nextSample > m_length) {
+                uint64_t excess = (std::min)(m_nextSample - m_length,
+                    static_cast<uint64_t>(m_pcmFrames - m_pcmPos));
+                m_pcmFrames -= static_cast<size_t>(excess);
+            }
+        }
+
+        if (m_placed && m_pcmPos < m_pcmFrames) {
+            return true;
+        }
+    }
+
+    return m_pcmPos < m_pcmFrames;
+}
+
+void VorbisDecoder::place(uint64_t granule, bool last)
+{
+    uint64_t pending = m_pcmFrames - m_pcmPos;
+
+    // the first granule position tells where the stream starts, leading
+    // samples it doesn't count are dropped like those before a seek target
+    if (m_granuleOffset == VORBIS_UNKNOWN_OFFSET) {
+        m_granuleOffset = granule > pending && !last ? granule - pending : 0;
+        m_length = m_length > m_granuleOffset ? m_length - m_granuleOffset : 0;
+    }
+
+    // The last page may end the stream before its last block ends, so its
+    // granule position doesn't tell where the frames decoded start. Seeks
+    // start before that page, it only places a stream decoded from its
+    // start.
+    uint64_t end = pending;
+    if (!last) {
+        end = granule > m_granuleOffset ? granule - m_granuleOffset : 0;
+    }
+
+    int64_t first = static_cast<int64_t>(end) - static_cast<int64_t>(pending);
+    int64_t target = static_cast<int64_t>(m_target);
+
+    m_placed = true;
+    m_nextSample = end;
+
+    if (first < target) {
+        uint64_t drop = (std::min)(static_cast<uint64_t>(target - first),
+            pending);
+        m_pcmPos += static_cast<size_t>(drop);
+        m_skip = static_cast<uint64_t>(target - first) - drop;
+    }
+
+    if (end > m_length) {
+        uint64_t excess = (std::min)(end - m_length,
+            static_cast<uint64_t>(m_pcmFrames - m_pcmPos));
+        m_pcmFrames -= static_cast<size_t>(excess);
+    }
+}
+
+size_t VorbisDecoder::decodePacket()
+{
+    VorbisReader reader(m_packet.data(), m_packetSize);
+
+    // header packets and empty ones
+    if (!m_packetSize || reader.readFlag()) {
+        return 0;
+    }
+
+    uint32_t modeIndex =
+        reader.read(ilog(static_cast<uint32_t>(m_modes.size()) - 1));
+    if (modeIndex >= m_modes.size()) {
+        return 0;
+    }
+
+    const Mode& mode = m_modes[modeIndex];
+    uint32_t flag = mode.blockFlag ? 1 : 0;
+    uint32_t size = m_blockSizes[flag];
+    uint32_t half = size / 2;
+    uint32_t stride = m_blockSizes[1] / 2;
+
+    // a long block overlaps short neighbours with a short slope
+    uint32_t leftFlag = flag;
+    uint32_t rightFlag = flag;
+    if (flag) {
+        leftFlag = reader.read(1);
+        rightFlag = reader.read(1);
+    }
+
+    if (reader.overrun()) {
+        return 0;
+    }
+
+    const Mapping& mapping = m_mappings[mode.mapping];
+
+    // a channel without a floor is silent, its residue is only decoded if
+    // it's coupled to one that isn't
+    bool silent[256];
+    bool skipped[256];
+    for (uint32_t c = 0; c < m_channels; c++) {
+        const Floor& floor = m_floors[mapping.floors[mapping.mux[c]]];
+        silent[c] =
+            !decodeFloor(reader, floor, &m_floorY[c * VORBIS_MAX_FLOOR_POINTS]);
+        skipped[c] = silent[c];
+    }
+
+    for (size_t i = 0; i < mapping.magnitude.size(); i++) {
+        uint32_t magnitude = mapping.magnitude[i];
+        uint32_t angle = mapping.angle[i];
+        if (!skipped[magnitude] || !skipped[angle]) {
+            skipped[magnitude] = false;
+            skipped[angle] = false;
+        }
+    }
+
+    for (uint32_t c = 0; c < m_channels; c++) {
+        std::fill(&m_residue[c * stride], &m_residue[c * stride] + half, 0.0f);
+    }
+
+    for (size_t submap = 0; submap < mapping.residues.size(); submap++) {
+        float* vectors[256];
+        bool skips[256];
+        uint32_t count = 0;
+
+        for (uint32_t c = 0; c < m_channels; c++) {
+            if (mapping.mux[c] == submap) {
+                vectors[count] = &m_residue[c * stride];
+                skips[count] = skipped[c];
+                count++;
+            }
+        }
+
+        decodeResidue(reader, m_residues[mapping.residues[submap]], vectors,
+            skips, count, half);
+    }
+
+    // undo the coupling, last step first
+    for (size_t i = mapping.magnitude.size(); i-- > 0;) {
+        float* magnitudes = &m_residue[mapping.magnitude[i] * stride];
+        float* angles = &m_residue[mapping.angle[i] * stride];
+
+        for (uint32_t k = 0; k < half; k++) {
+            float magnitude = magnitudes[k];
+            float angle = angles[k];
+
+            if (magnitude > 0) {
+                if (angle > 0) {
+                    angles[k] = magnitude - angle;
+                } else {
+                    angles[k] = magnitude;
+                    magnitudes[k] = magnitude + angle;
+                }
+            } else {
+                if (angle > 0) {
+                    angles[k] = magnitude + angle;
+                } else {
+                    angles[k] = magnitude;
+                    magnitudes[k] = magnitude - angle;
+                }
+            }
+        }
+    }
+
+    // only the channels played are transformed
+    uint32_t outputs = (std::min)(m_channels, 2u);
+    uint32_t leftSize = m_blockSizes[leftFlag];
+    uint32_t rightSize = m_blockSizes[rightFlag];
+    uint32_t leftStart = size / 4 - leftSize / 4;
+    uint32_t rightStart = size * 3 / 4 - rightSize / 4;
+    const float* leftWindow = &m_windows[leftFlag][0];
+    const float* rightWindow = &m_windows[rightFlag][0];
+
+    for (uint32_t c = 0; c < outputs; c++) {
+        float* block = &m_block[c * m_blockSizes[1]];
+
+        if (silent[c]) {
+            std::fill(block, block + size, 0.0f);
+            continue;
+        }
+
+        float* vector = &m_residue[c * stride];
+        const Floor& floor = m_floors[mapping.floors[mapping.mux[c]]];
+        renderFloor(
+            floor, &m_floorY[c * VORBIS_MAX_FLOOR_POINTS], vector, half);
+        imdct(vector, block, size, m_transforms[flag]);
+
+        std::fill(block, block + leftStart, 0.0f);
+        for (uint32_t i = 0; i < leftSize / 2; i++) {
+            block[leftStart + i] *= leftWindow[i];
+        }
+        for (uint32_t i = 0; i < rightSize / 2; i++) {
+            block[rightStart + i] *= rightWindow[rightSize / 2 - 1 - i];
+        }
+        std::fill(block + rightStart + rightSize / 2, block + size, 0.0f);
+    }
+
+    // The frames between the centers of the previous block and this one,
+    // the end of the previous block overlapped with the start of this.
+    // The first block after a start or a seek only fills the overlap.
+    size_t frames = 0;
+
+    if (m_previousSize) {
+        frames = m_previousSize / 4 + size / 4;
+        uint32_t overlapped = (std::min)(
+            static_cast<uint32_t>(frames), m_previousSize / 2);
+        int32_t shift = static_cast<int32_t>(size / 4) -
+                        static_cast<int32_t>(m_previousSize / 4);
+        size_t begin = shift < 0 ? static_cast<size_t>(-shift) : 0;
+
+        for (uint32_t c = 0; c < 2; c++) {
+            uint32_t source = c < outputs ? c : 0;
+            const float* overlap = &m_overlap[source * stride];
+            const float* block = &m_block[source * m_blockSizes[1]];
+            float* out = &m_stereo[c];
+
+            for (size_t i = 0; i < frames; i++) {
+                out[i * 2] = i < overlapped ? overlap[i] : 0.0f;
+            }
+            for (size_t i = begin; i < frames; i++) {
+                out[i * 2] += block[static_cast<int32_t>(i) + shift];
+            }
+            for (size_t i = 0; i < frames; i++) {
+                out[i * 2] *= 32768.0f;
+            }
+        }
+
+        if (m_pcm.size() < (m_pcmFrames + frames) * 2) {
+            m_pcm.resize((m_pcmFrames + frames) * 2);
+        }
+
+        m_sampleKernels.fromFloat[SampleInt16](&m_pcm[m_pcmFrames * 2],
+            &m_stereo[0], frames * 2, m_dither, true);
+        m_pcmFrames += frames;
+    }
+
+    for (uint32_t c = 0; c < outputs; c++) {
+        const float* block = &m_block[c * m_blockSizes[1]];
+        std::copy(block + half, block + size, &m_overlap[c * stride]);
+    }
+
+    m_previousSize = size;
+    return frames;
+}
+
+bool VorbisDecoder::decodeFloor(
+    VorbisReader& reader, const Floor& floor, int32_t* y)
+{
+    static const uint32_t ranges[4] = {256, 128, 86, 64};
+
+    if (!reader.readFlag()) {
+        return false;
+    }
+
+    uint32_t bits = ilog(ranges[floor.multiplier - 1] - 1);
+    y[0] = static_cast<int32_t>(reader.read(bits));
+    y[1] = static_cast<int32_t>(reader.read(bits));
+    size_t point = 2;
+
+    for (uint8_t partitionClass : floor.partitionClass) {
+        uint32_t subclassBits = floor.classSubclasses[partitionClass];
+        uint32_t mask = (1u << subclassBits) - 1;
+        uint32_t subclasses = 0;
+
+        if (subclassBits) {
+            int32_t entry = reader.decode(
+                m_codebooks[floor.classMasterbook[partitionClass]]);
+            if (entry < 0) {
+                return false;
+            }
+            subclasses = static_cast<uint32_t>(entry);
+        }
+
+        for (uint32_t i = 0; i < floor.classDimensions[partitionClass]; i++) {
+            int32_t book =
+                floor.subclassBooks[partitionClass][subclasses & mask];
+            subclasses >>= subclassBits;
+            y[point] = 0;
+
+            if (book >= 0) {
+                y[point] = reader.decode(m_codebooks[book]);
+                if (y[point] < 0) {
+                    return false;
+                }
+            }
+            point++;
+        }
+    }
+
+    return !reader.overrun();
+}
+
+void VorbisDecoder::renderFloor(
+    const Floor& floor, const int32_t* y, float* vector, uint32_t size)
+{
+    static const int32_t ranges[4] = {256, 128, 86, 64};
+    int32_t range = ranges[floor.multiplier - 1];
+    uint32_t count = static_cast<uint32_t>(floor.x.size());
+
+    // each point is coded as the offset from the line between its
+    // neighbours, points without one aren't drawn
+    int32_t values[VORBIS_MAX_FLOOR_POINTS];
+    bool used[VORBIS_MAX_FLOOR_POINTS];
+    values[0] = y[0];
+    values[1] = y[1];
+    used[0] = true;
+    used[1] = true;
+
+    for (uint32_t i = 2; i < count; i++) {
+        uint32_t low = floor.low[i];
+        uint32_t high = floor.high[i];
+        int32_t predicted = renderPoint(floor.x[low], values[low],
+            floor.x[high], values[high], floor.x[i]);
+        int32_t value = y[i];
+        int32_t highRoom = range - predicted;
+        int32_t lowRoom = predicted;
+        int32_t room = (std::min)(highRoom, lowRoom) * 2;
+
+        used[i] = value != 0;
+        values[i] = predicted;
+
+        if (!value) {
+            continue;
+        }
+
+        used[low] = true;
+        used[high] = true;
+
+        if (value >= room) {
+            values[i] = highRoom > lowRoom ? value - lowRoom + predicted
+                                           : predicted - value + highRoom - 1;
+        } else if (value & 1) {
+            values[i] = predicted - (value + 1) / 2;
+        } else {
+            values[i] = predicted + value / 2;
+        }
+    }
+
+    int32_t multiplier = static_cast<int32_t>(floor.multiplier);
+    int32_t lastX = 0;
+    int32_t lastY = values[0] * multiplier;
+    int32_t end = static_cast<int32_t>(size);
+
+    for (uint32_t j = 1; j < count; j++) {
+        uint32_t i = floor.sorted[j];
+        if (!used[i]) {
+            continue;
+        }
+
+        int32_t x = static_cast<int32_t>(floor.x[i]);
+        int32_t value = values[i] * multiplier;
+        renderLine(lastX, lastY, x, value, vector, end);
+        lastX = x;
+        lastY = value;
+    }
+
+    if (lastX < end) {
+        renderLine(lastX, lastY, end, lastY, vector, end);
+    }
+}
+
+void VorbisDecoder::decodeResidue(VorbisReader& reader,
+    const Residue& residue, float* const* vectors, const bool* skipped,
+    uint32_t count, uint32_t size)
+{
+    if (residue.type != 2) {
+        readPartitions(
+            reader, residue, vectors, skipped, count, size, residue.type);
+        return;
+    }
+
+    // type 2 codes the channels interleaved as one vector, decoded unless
+    // all of them are skipped
+    bool skip = true;
+    for (uint32_t c = 0; c < count; c++) {
+        skip = skip && skipped[c];
+    }
+    if (skip) {
+        return;
+    }
+
+    m_interleaved.assign(static_cast<size_t>(size) * count, 0.0f);
+    float* interleaved = m_interleaved.data();
+    readPartitions(reader, residue, &interleaved, &skip, 1, size * count, 1);
+
+    for (uint32_t i = 0; i < size; i++) {
+        for (uint32_t c = 0; c < count; c++) {
+            vectors[c][i] = interleaved[i * count + c];
+        }
+    }
+}
+
+bool VorbisDecoder::readPartitions(VorbisReader& reader,
+    const Residue& residue, float* const* vectors, const bool* skipped,
+    uint32_t count, uint32_t size, uint32_t type)
+{
+    uint32_t begin = (std::min)(residue.begin, size);
+    uint32_t end = (std::min)(residue.end, size);
+    uint32_t partitionSize = residue.partitionSize;
+    uint32_t partitions = end > begin ? (end - begin) / partitionSize : 0;
+
+    // one code of the class book holds the classes of several partitions
+    const Codebook& classbook = m_codebooks[residue.classbook];
+    uint32_t perCode = classbook.dimensions;
+    uint32_t classStride = partitions + perCode;
+    m_classes.resize(count * classStride);
+
+    for (uint32_t pass = 0; pass < 8; pass++) {
+        for (uint32_t partition = 0; partition < partitions;) {
+            if (!pass) {
+                for (uint32_t c = 0; c < count; c++) {
+                    if (skipped[c]) {
+                        continue;
+                    }
+
+                    int32_t code = reader.decode(classbook);
+                    if (code < 0) {
+                        return false;
+                    }
+
+                    uint8_t* classes = &m_classes[c * classStride + partition];
+                    for (uint32_t i = perCode; i-- > 0;) {
+                        classes[i] = static_cast<uint8_t>(
+                            code % residue.classifications);
+                        code /= residue.classifications;
+                    }
+                }
+            }
+
+            for (uint32_t i = 0; i < perCode && partition < partitions;
+                 i++, partition++) {
+                for (uint32_t c = 0; c < count; c++) {
+                    if (skipped[c]) {
+                        continue;
+                    }
+
+                    uint32_t classification =
+                        m_classes[c * classStride + partition];
+                    int32_t index = residue.books[classification * 8 + pass];
+                    if (index < 0) {
+                        continue;
+                    }
+
+                    const Codebook& book = m_codebooks[index];
+                    uint32_t dimensions = book.dimensions;
+                    float* out =
+                        vectors[c] + begin + partition * partitionSize;
+
+                    // type 0 spreads each vector over the partition, type 1
+                    // places them one after the other
+                    uint32_t step = type ? 1 : partitionSize / dimensions;
+                    uint32_t codes = partitionSize / dimensions;
+
+                    for (uint32_t j = 0; j < codes; j++) {
+                        int32_t entry = reader.decode(book);
+                        if (entry < 0) {
+                            return false;
+                        }
+
+                        const float* values = &book.values[entry * dimensions];
+                        float* target = type ? out + j * dimensions : out + j;
+                        for (uint32_t k = 0; k < dimensions; k++) {
+                            target[k * step] += values[k];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void VorbisDecoder::imdct(const float* input, float* output, uint32_t size,
+    const Transform& transform)
+{
+    uint32_t half = size / 2;
+    uint32_t quarter = size / 4;
+    float* z = &m_work[0];
+    float* u = &m_work[half];
+
+    // the even coefficients and the odd ones reversed as complex numbers
+    for (uint32_t i = 0; i < quarter; i++) {
+        float a = input[i * 2];
+        float b = input[half - 1 - i * 2];
+        float wr = transform.pre[i * 2];
+        float wi = transform.pre[i * 2 + 1];
+        z[i * 2] = a * wr - b * wi;
+        z[i * 2 + 1] = a * wi + b * wr;
+    }
+
+    fft(z, quarter, transform.twiddles, transform.bitReverse);
+
+    // the DCT-IV, even outputs from the real parts, odd ones reversed
+    for (uint32_t i = 0; i < quarter; i++) {
+        float wr = transform.post[i * 2];
+        float wi = transform.post[i * 2 + 1];
+        u[i * 2] = z[i * 2] * wr - z[i * 2 + 1] * wi;
+        u[half - 1 - i * 2] = -(z[i * 2] * wi + z[i * 2 + 1] * wr);
+    }
+
+    // the MDCT block is the DCT-IV shifted by a quarter and mirrored
+    for (uint32_t i = 0; i < quarter; i++) {
+        output[i] = u[quarter + i];
+    }
+    for (uint32_t i = quarter; i < quarter * 3; i++) {
+        output[i] = -u[quarter * 3 - 1 - i];
+    }
+    for (uint32_t i = quarter * 3; i < size; i++) {
+        output[i] = -u[i - quarter * 3];
+    }
+}
+
+void VorbisDecoder::seek(uint64_t frame)
+{
+    uint64_t target = (std::min)(frame, m_length);
+
+    if (m_pages.empty()) {
+        indexPages();
+    }
+
+    // The packets decoded first fill the overlap and don't start with a
+    // frame a granule position counts, so start after the last page that
+    // ends a long block before the target. The page after that one has to
+    // place the frames, which the last page can't.
+    uint64_t granule = target + m_granuleOffset;
+    const Page* start = nullptr;
+
+    for (size_t i = 0; i + 2 < m_pages.size(); i++) {
+        if (m_pages[i].granule + m_blockSizes[1] > granule) {
+            break;
+        }
+        start = &m_pages[i];
+    }
+
+    if (start) {
+        moveTo(start->end);
+        m_previousSize = 0;
+        m_placed = false;
+        m_skip = 0;
+        m_pcmPos = 0;
+        m_pcmFrames = 0;
+    } else {
+        restart();
+    }
+
+    m_target = target;
+}
+
+const char* VorbisDecoder::getName()
+{
+    return "ogg";
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Decoder.hpp"
+#include "SampleFormat.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class VorbisReader;
+
+// Native Ogg Vorbis I decoder, so the builds without libzplay play ogg too.
+// Decodes the first logical stream of the file, mono is played on both
+// channels and only the first two channels of more are used. Floor 0 isn't
+// supported, no encoder since libvorbis 1.0 writes it. The page CRCs are
+// checked, a broken page is skipped. Seeks go to the page before the target by the
+// granule positions and decode on from there.
+class VorbisDecoder : public Decoder
+{
+public:
+    VorbisDecoder();
+
+    void open(const std::string& path) override;
+    size_t read(int16_t* buffer, size_t frames) override;
+    void seek(uint64_t frame) override;
+    const char* getName() override;
+
+private:
+    friend class VorbisReader;
+
+    struct Codebook
+    {
+        uint32_t dimensions;
+        uint32_t entries;
+
+        // code lengths, 0 for unused entries, and the codes bit reversed
+        std::vector<uint8_t> lengths;
+        std::vector<uint32_t> codes;
+
+        // entry of each short code by its first bits, -1 for longer codes,
+        // the entries with longer codes are searched
+        std::vector<int32_t> fast;
+        std::vector<uint32_t> slow;
+
+        // the entry if there is only one, it takes no bits to pick
+        int32_t single;
+
+        // vector of each entry, empty for books of scalars
+        std::vector<float> values;
+    };
+
+    struct Floor
+    {
+        std::vector<uint8_t> partitionClass;
+        uint32_t classDimensions[16];
+        uint32_t classSubclasses[16];
+        int32_t classMasterbook[16];
+        int32_t subclassBooks[16][8];
+        uint32_t multiplier;
+
+        // points in stream order, their order by position and the points
+        // each one is predicted from
+        std::vector<uint32_t> x;
+        std::vector<uint32_t> sorted;
+        std::vector<uint32_t> low;
+        std::vector<uint32_t> high;
+    };
+
+    struct Residue
+    {
+        uint32_t type;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t partitionSize;
+        uint32_t classifications;
+        uint32_t classbook;
+        std::vector<int32_t> books;
+    };
+
+    struct Mapping
+    {
+        std::vector<uint32_t> magnitude;
+        std::vector<uint32_t> angle;
+        std::vector<uint8_t> mux;
+        std::vector<uint32_t> floors;
+        std::vector<uint32_t> residues;
+    };
+
+    struct Mode
+    {
+        bool blockFlag;
+        uint32_t mapping;
+    };
+
+    // FFT of a quarter of the block size for the inverse MDCT
+    struct Transform
+    {
+        std::vector<float> twiddles;
+        std::vector<float> pre;
+        std::vector<float> post;
+        std::vector<uint32_t> bitReverse;
+    };
+
+    // a page with a granule position, a seek can start after its end
+    struct Page
+    {
+        uint64_t end;
+        uint64_t granule;
+    };
+
+    std::string m_path;
+    std::ifstream m_file;
+    uint64_t m_fileSize;
+    uint64_t m_filePos;
+
+    // the page being read and the packet being put together
+    uint32_t m_serial;
+    bool m_hasSerial;
+    uint64_t m_nextPage;
+    std::vector<uint8_t> m_lacing;
+    std::vector<uint8_t> m_body;
+    size_t m_segment;
+    size_t m_bodyPos;
+    uint64_t m_pageGranule;
+    uint32_t m_pageSerial;
+    uint8_t m_pageFlags;
+    std::vector<uint8_t> m_packet;
+    size_t m_packetSize;
+    std::vector<Page> m_pages;
+
+    // setup header
+    uint32_t m_blockSizes[2];
+    std::vector<Codebook> m_codebooks;
+    std::vector<Floor> m_floors;
+    std::vector<Residue> m_residues;
+    std::vector<Mapping> m_mappings;
+    std::vector<Mode> m_modes;
+    std::vector<float> m_windows[2];
+    Transform m_transforms[2];
+
+    // per channel vectors of the packet being decoded, the windowed end of
+    // the previous block and its size, 0 if there is none
+    std::vector<float> m_residue;
+    std::vector<float> m_block;
+    std::vector<float> m_overlap;
+    std::vector<float> m_work;
+    std::vector<float> m_interleaved;
+    std::vector<int32_t> m_floorY;
+    std::vector<uint8_t> m_classes;
+    uint32_t m_previousSize;
+
+    // decoded 16 bit stereo waiting to be read, m_nextSample follows its
+    // last frame once a granule position has placed it
+    std::vector<int16_t> m_pcm;
+    size_t m_pcmPos;
+    size_t m_pcmFrames;
+    uint64_t m_nextSample;
+    bool m_placed;
+    uint64_t m_target;
+    uint64_t m_skip;
+    uint64_t m_granuleOffset;
+
+    const SampleKernels& m_sampleKernels;
+    uint32_t m_dither[4];
+    std::vector<float> m_stereo;
+
+    void readHeaders();
+    void readSetup(VorbisReader& reader);
+    void readCodebook(VorbisReader& reader, Codebook& book);
+    void readFloor(VorbisReader& reader, Floor& floor);
+    void readResidue(VorbisReader& reader, Residue& residue);
+    void readMapping(VorbisReader& reader, Mapping& mapping);
+    void prepareBlocks();
+    uint64_t findLength();
+    void indexPages();
+
+    bool readPageAt(uint64_t offset);
+    bool readPage();
+    uint64_t findCapture(uint64_t offset);
+    bool readPacket(uint64_t& granule);
+    void moveTo(uint64_t offset);
+    void restart();
+
+    bool fillCache();
+    void place(uint64_t granule, bool last);
+    size_t decodePacket();
+    bool decodeFloor(VorbisReader& reader, const Floor& floor, int32_t* y);
+    void renderFloor(const Floor& floor, const int32_t* y, float* vector,
+        uint32_t size);
+    void decodeResidue(VorbisReader& reader, const Residue& residue,
+        float* const* vectors, const bool* skipped, uint32_t count,
+        uint32_t size);
+    bool readPartitions(VorbisReader& reader, const Residue& residue,
+        float* const* vectors, const bool* skipped, uint32_t count,
+        uint32_t size, uint32_t type);
+    void imdct(const float* input, float* output, uint32_t size,
+        const Transform& transform);
+};
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "WasapiOutput.hpp"
+#include "AudioMixer.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <avrt.h>
+#include <mmreg.h>
+#include <ksmedia.h>
+
+// not defined by older SDKs, supported since Windows 7
+#ifndef AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM
+#define AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM 0x80000000
+#endif
+
+#ifndef AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY
+#define AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY 0x08000000
+#endif
+
+// REFERENCE_TIME is in 100 ns units
+#define REFTIMES_PER_MS 10000
+
+WasapiOutput::WasapiOutput(
+    uint32_t period, bool exclusive, SampleFormat format)
+    : AudioOutput(format)
+    , m_period(static_cast<REFERENCE_TIME>(period) * REFTIMES_PER_MS)
+    , m_exclusive(exclusive)
+    , m_enumerator(nullptr)
+    , m_device(nullptr)
+    , m_client(nullptr)
+    , m_render(nullptr)
+    , m_event(nullptr)
+    , m_bufferFrames(0)
+    , m_streamLatency(0)
+    , m_latency(0)
+    , m_running(false)
+    , m_ready(false)
+    , m_result(S_OK)
+{
+}
+
+WasapiOutput::~WasapiOutput()
+{
+    stop();
+}
+
+void WasapiOutput::start(AudioMixer& mixer)
+{
+    m_ready = false;
+    m_running = true;
+
+    // COM objects are created on the audio thread, wait until it's done
+    m_thread = std::thread(&WasapiOutput::run, this, &mixer);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_started.wait(lock, [this] { return m_ready; });
+    lock.unlock();
+
+    if (FAILED(m_result)) {
+        stop();
+
+        char message[64];
+        sprintf_s(message, sizeof(message),
+            "WASAPI initialization failed (0x%08x)", m_result);
+        throw WinMMError(message, MCIERR_HARDWARE);
+    }
+}
+
+void WasapiOutput::stop()
+{
+    m_running = false;
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+uint32_t WasapiOutput::getLatency()
+{
+    return m_latency;
+}
+
+void WasapiOutput::run(AudioMixer* mixer)
+{
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool comInitialized = SUCCEEDED(hr);
+
+    DWORD taskIndex = 0;
+    HANDLE task = AvSetMmThreadCharacteristicsA("Pro Audio", &taskIndex);
+
+    hr = openDevice();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_result = hr;
+        m_ready = true;
+    }
+    m_started.notify_one();
+
+    while (SUCCEEDED(hr) && m_running) {
+        // wake up at least every 200 ms to check for stop requests
+        if (WaitForSingleObject(m_event, 200) != WAIT_OBJECT_0) {
+            continue;
+        }
+
+        // exclusive mode buffers are always refilled completely
+        UINT32 padding = 0;
+        if (!m_exclusive) {
+            hr = m_client->GetCurrentPadding(&padding);
+            if (FAILED(hr)) {
+                break;
+            }
+        }
+
+        UINT32 frames = m_bufferFrames - padding;
+        if (!frames) {
+            continue;
+        }
+
+        BYTE* data;
+        hr = m_render->GetBuffer(frames, &data);
+        if (FAILED(hr)) {
+            break;
+        }
+
+        mixer->render(data, frames, padding + m_streamLatency);
+
+        hr = m_render->ReleaseBuffer(frames, 0);
+
+        m_latency = padding + frames + m_streamLatency;
+    }
+
+    if (FAILED(hr)) {
+        LOG_INFO("WASAPI output stopped (0x%08x)", hr);
+    }
+
+    closeDevice();
+
+    if (task) {
+        AvRevertMmThreadCharacteristics(task);
+    }
+
+    if (comInitialized) {
+        CoUninitialize();
+    }
+}
+
+HRESULT WasapiOutput::openDevice()
+{
+    m_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr,
+        CLSCTX_ALL, __uuidof(IMMDeviceEnumerator),
+        reinterpret_cast<void**>(&m_enumerator));
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    hr = m_enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &m_device);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    hr = initializeClient();
+
+    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+        // exclusive mode requires a period aligned to the device buffer, the
+        // failed client reports the next aligned buffer size
+        UINT32 frames;
+        m_client->GetBufferSize(&frames);
+        m_client->Release();
+        m_client = nullptr;
+
+        m_period = static_cast<REFERENCE_TIME>(
+            1000.0 * REFTIMES_PER_MS * frames / AUDIO_SAMPLE_RATE + 0.5);
+        hr = initializeClient();
+    }
+
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    hr = m_client->GetBufferSize(&m_bufferFrames);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    REFERENCE_TIME streamLatency = 0;
+    m_client->GetStreamLatency(&streamLatency);
+    m_streamLatency = static_cast<uint32_t>(
+        streamLatency * AUDIO_SAMPLE_RATE / (1000 * REFTIMES_PER_MS));
+
+    hr = m_client->SetEventHandle(m_event);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    hr = m_client->GetService(__uuidof(IAudioRenderClient),
+        reinterpret_cast<void**>(&m_render));
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    // start with a buffer of silence, exclusive mode glitches otherwise
+    BYTE* data;
+    hr = m_render->GetBuffer(m_bufferFrames, &data);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    m_render->ReleaseBuffer(m_bufferFrames, AUDCLNT_BUFFERFLAGS_SILENT);
+
+    m_latency = m_bufferFrames + m_streamLatency;
+
+    LOG_TRACE("WASAPI %s mode, buffer %d frames, stream latency %d frames",
+        m_exclusive ? "exclusive" : "shared", m_bufferFrames, m_streamLatency);
+
+    return m_client->Start();
+}
+
+HRESULT WasapiOutput::initializeClient()
+{
+    HRESULT hr = m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+        nullptr, reinterpret_cast<void**>(&m_client));
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    // anything but 16 bit needs the extensible format in exclusive mode
+    WAVEFORMATEXTENSIBLE extensible = {};
+    WAVEFORMATEX& format = extensible.Format;
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = AUDIO_CHANNELS;
+    format.nSamplesPerSec = AUDIO_SAMPLE_RATE;
+    format.wBitsPerSample =
+        static_cast<WORD>(SampleKernels::getSampleSize(m_format) * 8);
+    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    if (m_format != SampleInt16) {
+        format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        format.cbSize = sizeof(extensible) - sizeof(format);
+        extensible.Samples.wValidBitsPerSample = format.wBitsPerSample;
+        extensible.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+        extensible.SubFormat = m_format == SampleFloat32
+                                   ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+                                   : KSDATAFORMAT_SUBTYPE_PCM;
+    }
+
+    DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
+
+    if (m_exclusive) {
+        // buffer duration and periodicity must be equal in event mode
+        return m_client->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, flags,
+            m_period, m_period, &format, nullptr);
+    }
+
+    // let the audio engine convert to its mix format
+    flags |= AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+             AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
+
+    return m_client->Initialize(
+        AUDCLNT_SHAREMODE_SHARED, flags, m_period, 0, &format, nullptr);
+}
+
+void WasapiOutput::closeDevice()
+{
+    if (m_client) {
+        m_client->Stop();
+    }
+
+    if (m_render) {
+        m_render->Release();
+        m_render = nullptr;
+    }
+
+    if (m_client) {
+        m_client->Release();
+        m_client = nullptr;
+    }
+
+    if (m_device) {
+        m_device->Release();
+        m_device = nullptr;
+    }
+
+    if (m_enumerator) {
+        m_enumerator->Release();
+        m_enumerator = nullptr;
+    }
+
+    if (m_event) {
+        CloseHandle(m_event);
+        m_event = nullptr;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AudioOutput.hpp"
+
+#include <Windows.h>
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Event driven WASAPI output on the default render device, in shared or
+// exclusive mode with a configurable buffer period and sample format.
+class WasapiOutput : public AudioOutput
+{
+public:
+    WasapiOutput(uint32_t period, bool exclusive, SampleFormat format);
+    ~WasapiOutput();
+
+    void start(AudioMixer& mixer) override;
+    void stop() override;
+    uint32_t getLatency() override;
+
+private:
+    REFERENCE_TIME m_period;
+    bool m_exclusive;
+    IMMDeviceEnumerator* m_enumerator;
+    IMMDevice* m_device;
+    IAudioClient* m_client;
+    IAudioRenderClient* m_render;
+    HANDLE m_event;
+    UINT32 m_bufferFrames;
+    uint32_t m_streamLatency;
+    std::atomic<uint32_t> m_latency;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    // start handshake with the audio thread
+    std::mutex m_mutex;
+    std::condition_variable m_started;
+    bool m_ready;
+    HRESULT m_result;
+
+    void run(AudioMixer* mixer);
+    HRESULT openDevice();
+    HRESULT initializeClient();
+    void closeDevice();
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "WavDecoder.hpp"
+#include "AudioClock.hpp"
+#include "WinMMError.hpp"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define WAV_TAG_PCM 0x0001
+#define WAV_TAG_IEEE_FLOAT 0x0003
+#define WAV_TAG_EXTENSIBLE 0xfffe
+
+// number of frames read from the file at once
+#define WAV_READ_FRAMES 4096
+
+static uint32_t readLE(const unsigned char* p, int32_t bytes)
+{
+    uint32_t value = 0;
+    for (int32_t i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+WavDecoder::WavDecoder()
+    : m_encoding(EncodingInt)
+    , m_bitsPerSample(0)
+    , m_blockAlign(0)
+    , m_dataOffset(0)
+    , m_frame(0)
+    , m_kernels(SampleKernels::get(SampleKernels::getBest()))
+{
+    SampleKernels::seedDither(m_dither);
+}
+
+void WavDecoder::open(const std::string& path)
+{
+    m_file.open(path, std::ios::binary);
+
+    unsigned char header[12];
+    if (!m_file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        throw WinMMError("Not a WAVE file: " + path, MCIERR_HARDWARE);
+    }
+
+    bool format = false;
+
+    // walk the chunks up to the data, fmt must come first
+    while (true) {
+        unsigned char chunk[8];
+        if (!m_file.read(reinterpret_cast<char*>(chunk), sizeof(chunk))) {
+            throw WinMMError("No WAVE data in " + path, MCIERR_HARDWARE);
+        }
+
+        uint32_t size = readLE(chunk + 4, 4);
+
+        if (!memcmp(chunk, "fmt ", 4) && size >= 16 && size <= 64) {
+            unsigned char fmt[64];
+            if (!m_file.read(reinterpret_cast<char*>(fmt), size)) {
+                break;
+            }
+
+            // extensible formats keep the real tag in the sub format GUID
+            uint32_t tag = readLE(fmt, 2);
+            if (tag == WAV_TAG_EXTENSIBLE && size >= 26) {
+                tag = readLE(fmt + 24, 2);
+            }
+
+            m_channels = readLE(fmt + 2, 2);
+            m_sampleRate = readLE(fmt + 4, 4);
+            m_blockAlign = readLE(fmt + 12, 2);
+            m_bitsPerSample = readLE(fmt + 14, 2);
+            m_encoding = tag == WAV_TAG_IEEE_FLOAT ? EncodingFloat
+                                                       : EncodingInt;
+
+            bool supported =
+                (tag == WAV_TAG_PCM && m_bitsPerSample >= 8 &&
+                    m_bitsPerSample <= 32 && m_bitsPerSample % 8 == 0) ||
+                (tag == WAV_TAG_IEEE_FLOAT && m_bitsPerSample == 32);
+
+            if (!supported || !m_channels || !m_sampleRate ||
+                m_blockAlign != m_channels * m_bitsPerSample / 8) {
+                throw WinMMError(
+                    "Unsupported WAVE format in " + path, MCIERR_HARDWARE);
+            }
+
+            format = true;
+        } else if (!memcmp(chunk, "data", 4) && format) {
+            m_dataOffset = static_cast<uint64_t>(m_file.tellg());
+            m_length = size / m_blockAlign;
+            break;
+        } else {
+            // chunks are padded to even sizes
+            m_file.seekg(size + (size & 1), std::ios::cur);
+        }
+    }
+
+    if (!format || !m_dataOffset) {
+        throw WinMMError("Broken WAVE file: " + path, MCIERR_HARDWARE);
+    }
+
+    m_stats.bytesRead = m_dataOffset;
+    m_raw.resize(WAV_READ_FRAMES * m_blockAlign);
+
+    if (m_encoding == EncodingFloat || m_bitsPerSample > 16) {
+        m_float.resize(WAV_READ_FRAMES * m_channels);
+        m_stereo.resize(WAV_READ_FRAMES * 2);
+    }
+}
+
+size_t WavDecoder::read(int16_t* buffer, size_t frames)
+{
+    int64_t started = AudioClock::getSystemTime();
+    size_t total = 0;
+
+    while (total < frames && m_frame < m_length) {
+        size_t count = (std::min)(frames - total,
+            static_cast<size_t>(WAV_READ_FRAMES));
+        count = static_cast<size_t>(
+            (std::min)(static_cast<uint64_t>(count), m_length - m_frame));
+
+        m_file.read(&m_raw[0], count * m_blockAlign);
+        count = static_cast<size_t>(m_file.gcount()) / m_blockAlign;
+        if (!count) {
+            // the file is shorter than its header says
+            m_length = m_frame;
+            break;
+        }
+
+        convert(&m_raw[0], buffer + total * 2, count);
+
+        m_stats.bytesRead += count * m_blockAlign;
+        m_frame += count;
+        total += count;
+    }
+
+    m_stats.frames += total;
+    m_stats.seconds += (AudioClock::getSystemTime() - started) / 1e9;
+    return total;
+}
+
+void WavDecoder::convert(const char* raw, int16_t* buffer, size_t frames)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(raw);
+    uint32_t bytes = m_bitsPerSample / 8;
+    uint32_t channels = (std::min)(m_channels, 2u);
+
+    if (m_encoding == EncodingFloat || bytes > 2) {
+        reduce(raw, buffer, frames);
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        const unsigned char* frame = p + i * m_blockAlign;
+
+        for (uint32_t c = 0; c < channels; c++) {
+            const unsigned char* sample = frame + c * bytes;
+            int16_t value;
+
+            if (bytes == 1) {
+                // 8 bit samples are unsigned
+                value = static_cast<int16_t>((sample[0] - 128) << 8);
+            } else {
+                value = static_cast<int16_t>(readLE(sample, 2));
+            }
+
+            buffer[i * 2 + c] = value;
+        }
+
+        if (channels == 1) {
+            buffer[i * 2 + 1] = buffer[i * 2];
+        }
+    }
+}
+
+void WavDecoder::reduce(const char* raw, int16_t* buffer, size_t frames)
+{
+    SampleFormat format = m_encoding == EncodingFloat ? SampleFloat32
+                          : m_bitsPerSample == 24     ? SampleInt24
+                                                      : SampleInt32;
+
+    m_kernels.toFloat[format](&m_float[0], raw, frames * m_channels);
+
+    // pick the first two channels, mono is played on both
+    const float* stereo = &m_float[0];
+    if (m_channels != 2) {
+        uint32_t right = m_channels > 1 ? 1 : 0;
+        for (size_t i = 0; i < frames; i++) {
+            m_stereo[i * 2] = m_float[i * m_channels];
+            m_stereo[i * 2 + 1] = m_float[i * m_channels + right];
+        }
+        stereo = &m_stereo[0];
+    }
+
+    m_kernels.fromFloat[SampleInt16](buffer, stereo, frames * 2, m_dither, true);
+}
+
+void WavDecoder::seek(uint64_t frame)
+{
+    m_frame = (std::min)(frame, m_length);
+    m_file.clear();
+    m_file.seekg(m_dataOffset + m_frame * m_blockAlign, std::ios::beg);
+}
+
+const char* WavDecoder::getName()
+{
+    return "wav";
+}
\ No newline at end of file
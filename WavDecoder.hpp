@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Decoder.hpp"
+#include "SampleFormat.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// Reads uncompressed RIFF WAVE files with 8 to 32 bit integer or 32 bit
+// float samples. Mono is played on both channels, only the first two
+// channels of anything wider are used. Samples of more than 16 bits are
+// reduced to 16 with TPDF dither.
+class WavDecoder : public Decoder
+{
+public:
+    WavDecoder();
+
+    void open(const std::string& path) override;
+    size_t read(int16_t* buffer, size_t frames) override;
+    void seek(uint64_t frame) override;
+    const char* getName() override;
+
+private:
+    enum Encoding
+    {
+        EncodingInt,
+        EncodingFloat
+    };
+
+    std::ifstream m_file;
+    Encoding m_encoding;
+    uint32_t m_bitsPerSample;
+    uint32_t m_blockAlign;
+    uint64_t m_dataOffset;
+    uint64_t m_frame;
+    std::vector<char> m_raw;
+
+    // conversion of samples wider than 16 bit
+    const SampleKernels& m_kernels;
+    uint32_t m_dither[4];
+    std::vector<float> m_float;
+    std::vector<float> m_stereo;
+
+    void convert(const char* raw, int16_t* buffer, size_t frames);
+    void reduce(const char* raw, int16_t* buffer, size_t frames);
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "WinMM.hpp"
+#include "AudioClock.hpp"
 #include "Logger.hpp"
+#include "WinMMError.hpp"
 
 #include <stdio.h>
 
@@ -8,7 +10,14 @@
 
 WinMM::WinMM()
     : m_mciSendCommandA(nullptr)
+    , m_mciSendCommandW(nullptr)
     , m_mciSendStringA(nullptr)
+    , m_mciSendStringW(nullptr)
+    , m_mixer(m_config)
+    , m_player(nullptr)
+    , m_deviceID(0)
+    , m_alias()
+    , m_volume(0)
 {
 }
 
@@ -16,8 +25,12 @@ void WinMM::load(HINSTANCE hinstDLL)
 {
     m_mciSendCommandA = reinterpret_cast<mciSendCommandA_t>(
         GetProcAddress(hinstDLL, "mciSendCommandA"));
+    m_mciSendCommandW = reinterpret_cast<mciSendCommandW_t>(
+        GetProcAddress(hinstDLL, "mciSendCommandW"));
     m_mciSendStringA = reinterpret_cast<mciSendStringA_t>(
         GetProcAddress(hinstDLL, "mciSendStringA"));
+    m_mciSendStringW = reinterpret_cast<mciSendStringW_t>(
+        GetProcAddress(hinstDLL, "mciSendStringW"));
 }
 
 MCIERROR WinMM::commandResume(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam)
@@ -30,61 +43,43 @@ MCIERROR WinMM::commandResume(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam)
 }
 
 MCIERROR WinMM::commandOpen(
-    MCIDEVICEID IDDevice, DWORD_PTR fdwCommand, LPMCI_OPEN_PARMS dwParam)
+    DWORD_PTR fdwCommand, const MciOpen& open, MCIDEVICEID& deviceID)
 {
     LOG_TRACE("  MCI_OPEN");
 
     if (fdwCommand & MCI_OPEN_ALIAS) {
         LOG_TRACE("    MCI_OPEN_ALIAS");
-        LOG_TRACE("      lpstrAlias = %s", dwParam->lpstrAlias);
+        LOG_TRACE("      lpstrAlias = %s", open.getAlias());
     }
 
     if (fdwCommand & MCI_OPEN_ELEMENT) {
         LOG_TRACE("    MCI_OPEN_ELEMENT");
-
-        if (fdwCommand & MCI_OPEN_ELEMENT_ID) {
-            LOG_TRACE("      MCI_OPEN_ELEMENT_ID");
-            LOG_TRACE("      lpstrElementName = %d", dwParam->lpstrElementName);
-        } else {
-            LOG_TRACE("      lpstrElementName = %s", dwParam->lpstrElementName);
-        }
+        LOG_TRACE("      lpstrElementName = %s", open.getElementName());
     }
 
     if (fdwCommand & MCI_OPEN_SHAREABLE) {
         LOG_TRACE("    MCI_OPEN_SHAREABLE");
     }
 
-    if (fdwCommand & MCI_OPEN_TYPE) {
-        LOG_TRACE("    MCI_OPEN_TYPE");
-
-        if (fdwCommand & MCI_OPEN_TYPE_ID) {
-            LOG_TRACE("      MCI_OPEN_TYPE_ID");
+    LOG_TRACE("    MCI_OPEN_TYPE");
+    LOG_TRACE("      dwParam = %s", open.getDeviceType());
 
-            if (LOWORD(dwParam->lpstrDeviceType) != MCI_DEVTYPE_CD_AUDIO) {
-                goto skip;
-            }
-        } else {
-            LOG_TRACE("      dwParam = %s", dwParam->lpstrDeviceType);
-
-            if (strcmp(dwParam->lpstrDeviceType, "cdaudio") != 0) {
-                goto skip;
-            }
-        }
+    if (m_player) {
+        return MCIERR_DEVICE_OPEN;
+    }
 
-        if (m_player) {
-            return MCIERR_DEVICE_OPEN;
-        }
+    int64_t started = AudioClock::getSystemTime();
+    m_player = new CDPlayer(m_mixer, m_config, m_diagnostics);
+    m_diagnostics.addLatency(
+        DiagOpens, AudioClock::getSystemTime() - started);
 
-        m_player = new CDPlayer();
-        dwParam->wDeviceID = m_player->getDeviceID();
+    m_deviceID = m_player->getDeviceID();
+    deviceID = m_player->getDeviceID();
 
-        return MMSYSERR_NOERROR;
-    }
+    std::lock_guard<std::mutex> lock(m_aliasMutex);
+    strncpy_s(m_alias, sizeof(m_alias), open.getAlias(), _TRUNCATE);
 
-skip:
-    // command is not for cdaudio
-    return m_mciSendCommandA(
-        IDDevice, MCI_OPEN, fdwCommand, reinterpret_cast<DWORD_PTR>(dwParam));
+    return MMSYSERR_NOERROR;
 }
 
 MCIERROR WinMM::commandClose(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam)
@@ -92,6 +87,17 @@ MCIERROR WinMM::commandClose(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam)
     LOG_TRACE("  MCI_CLOSE");
 
     if (m_player) {
+        // delivered by the notifier before it shuts down with the player
+        if (fdwCommand & MCI_NOTIFY) {
+            m_player->notify(reinterpret_cast<HWND>(dwParam->dwCallback));
+        }
+
+        m_deviceID = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_aliasMutex);
+            m_alias[0] = '\0';
+        }
+
         delete m_player;
         m_player = nullptr;
     }
@@ -105,24 +111,14 @@ MCIERROR WinMM::commandSet(DWORD_PTR fdwCommand, LPMCI_SET_PARMS dwParam)
 
     if (fdwCommand & MCI_SET_TIME_FORMAT) {
         LOG_TRACE("    MCI_SET_TIME_FORMAT");
+        LOG_TRACE("      dwTimeFormat = %d", dwParam->dwTimeFormat);
 
-        // Only MCI_FORMAT_MILLISECONDS, MCI_FORMAT_MSF and MCI_FORMAT_TMSF
-        // are allowed for cdaudio devices
-        switch (dwParam->dwTimeFormat) {
-            case MCI_FORMAT_MILLISECONDS:
-                LOG_TRACE("      MCI_FORMAT_MILLISECONDS");
-                break;
-            case MCI_FORMAT_MSF:
-                LOG_TRACE("      MCI_FORMAT_MSF");
-                break;
-            case MCI_FORMAT_TMSF:
-                LOG_TRACE("      MCI_FORMAT_TMSF");
-                break;
-            default:
-                return MMSYSERR_INVALPARAM;
+        // The codec is picked here once, instead of on every conversion.
+        // Besides the cdaudio formats, frames and samples are accepted.
+        MCIERROR result = m_player->setTimeFormat(dwParam->dwTimeFormat);
+        if (result) {
+            return result;
         }
-
-        m_player->setTimeFormat(dwParam->dwTimeFormat);
     }
 
     return MMSYSERR_NOERROR;
@@ -168,9 +164,12 @@ MCIERROR WinMM::commandPlay(DWORD_PTR fdwCommand, LPMCI_PLAY_PARMS dwParam)
         to = dwParam->dwTo;
     }
 
-    m_player->play(from, to);
+    HWND notify = nullptr;
+    if (fdwCommand & MCI_NOTIFY) {
+        notify = reinterpret_cast<HWND>(dwParam->dwCallback);
+    }
 
-    return MMSYSERR_NOERROR;
+    return m_player->play(from, to, notify);
 }
 
 MCIERROR WinMM::commandStop(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam)
@@ -223,7 +222,10 @@ MCIERROR WinMM::commandStatus(DWORD_PTR fdwCommand, LPMCI_STATUS_PARMS dwParam)
 
             case MCI_STATUS_POSITION:
                 LOG_TRACE("      MCI_STATUS_POSITION");
-                if (fdwCommand & MCI_TRACK) {
+                if (fdwCommand & MCI_STATUS_START) {
+                    LOG_TRACE("    MCI_STATUS_START");
+                    dwParam->dwReturn = m_player->getPosition(1);
+                } else if (fdwCommand & MCI_TRACK) {
                     dwParam->dwReturn = m_player->getPosition(dwParam->dwTrack);
                 } else {
                     dwParam->dwReturn = m_player->getPosition(0);
@@ -273,7 +275,7 @@ MCIERROR WinMM::commandStatus(DWORD_PTR fdwCommand, LPMCI_STATUS_PARMS dwParam)
 
             case MCI_STATUS_TIME_FORMAT:
                 LOG_TRACE("      MCI_STATUS_TIME_FORMAT");
-                dwParam->dwReturn = m_timeFormat;
+                dwParam->dwReturn = m_player->getTimeFormat();
                 break;
 
             case MCI_STATUS_START:
@@ -291,20 +293,73 @@ MCIERROR WinMM::commandStatus(DWORD_PTR fdwCommand, LPMCI_STATUS_PARMS dwParam)
 MCIERROR WinMM::mciSendCommandA(
     MCIDEVICEID IDDevice, UINT uMsg, DWORD_PTR fdwCommand, DWORD_PTR dwParam)
 {
-    LOG_TRACE("WinMM::mciSendCommandA(IDDevice=%p, uMsg=%p, fdwCommand=%p, "
-           "dwParam=%p)",
-        IDDevice, uMsg, fdwCommand, dwParam);
+    return sendCommand(IDDevice, uMsg, fdwCommand, dwParam, false);
+}
+
+MCIERROR WinMM::mciSendCommandW(
+    MCIDEVICEID IDDevice, UINT uMsg, DWORD_PTR fdwCommand, DWORD_PTR dwParam)
+{
+    return sendCommand(IDDevice, uMsg, fdwCommand, dwParam, true);
+}
 
+bool WinMM::isForeignCommand(MCIDEVICEID IDDevice, UINT uMsg,
+    DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide)
+{
     if (uMsg != MCI_OPEN) {
-        if (IDDevice != m_player->getDeviceID()) {
-            // command is not for our device
-            return m_mciSendCommandA(IDDevice, uMsg, fdwCommand, dwParam);
-        }
+        // an ID no open of ours has returned
+        return IDDevice != m_deviceID;
+    }
 
-        if (!m_player) {
-            // device hasn't been opened yet
-            return MCIERR_INVALID_DEVICE_NAME;
-        }
+    if (!dwParam) {
+        return true;
+    }
+
+    MciOpen open;
+    if (wide) {
+        open.parse(fdwCommand, reinterpret_cast<LPMCI_OPEN_PARMSW>(dwParam));
+    } else {
+        open.parse(fdwCommand, reinterpret_cast<LPMCI_OPEN_PARMSA>(dwParam));
+    }
+
+    return !open.isCdAudio();
+}
+
+bool WinMM::isForeignString(LPCSTR cmd)
+{
+    MciString command;
+    return !command.parse(cmd) || !isOwnString(command);
+}
+
+bool WinMM::isForeignString(LPCWSTR cmd)
+{
+    MciString command;
+    return !command.parse(cmd) || !isOwnString(command);
+}
+
+MCIERROR WinMM::forwardCommand(MCIDEVICEID IDDevice, UINT uMsg,
+    DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide)
+{
+    if (wide) {
+        return m_mciSendCommandW(IDDevice, uMsg, fdwCommand, dwParam);
+    }
+
+    return m_mciSendCommandA(IDDevice, uMsg, fdwCommand, dwParam);
+}
+
+MCIERROR WinMM::sendCommand(MCIDEVICEID IDDevice, UINT uMsg,
+    DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide)
+{
+    LOG_TRACE("IDDevice=%p, uMsg=%p, fdwCommand=%p, dwParam=%p, wide=%d",
+        IDDevice, uMsg, fdwCommand, dwParam, wide);
+
+    MCIERROR result;
+    if (queryStats(IDDevice, uMsg, fdwCommand, dwParam, result)) {
+        return result;
+    }
+
+    if (uMsg != MCI_OPEN && (!m_player || IDDevice != m_deviceID)) {
+        // command is not for our device, or it hasn't been opened yet
+        return forwardCommand(IDDevice, uMsg, fdwCommand, dwParam, wide);
     }
 
     if (fdwCommand & MCI_NOTIFY) {
@@ -315,13 +370,34 @@ MCIERROR WinMM::mciSendCommandA(
         LOG_TRACE("  MCI_WAIT");
     }
 
-    MCIERROR result;
-
     switch (uMsg) {
-        case MCI_OPEN:
-            result = commandOpen(IDDevice, fdwCommand,
-                reinterpret_cast<LPMCI_OPEN_PARMS>(dwParam));
+        case MCI_OPEN: {
+            MciOpen open;
+            MCIDEVICEID* deviceID = nullptr;
+
+            if (!dwParam) {
+                // let the system report the missing parameters
+            } else if (wide) {
+                LPMCI_OPEN_PARMSW parms =
+                    reinterpret_cast<LPMCI_OPEN_PARMSW>(dwParam);
+                open.parse(fdwCommand, parms);
+                deviceID = &parms->wDeviceID;
+            } else {
+                LPMCI_OPEN_PARMSA parms =
+                    reinterpret_cast<LPMCI_OPEN_PARMSA>(dwParam);
+                open.parse(fdwCommand, parms);
+                deviceID = &parms->wDeviceID;
+            }
+
+            if (!deviceID || !open.isCdAudio()) {
+                // command is not for cdaudio
+                return forwardCommand(
+                    IDDevice, uMsg, fdwCommand, dwParam, wide);
+            }
+
+            result = commandOpen(fdwCommand, open, *deviceID);
             break;
+        }
         case MCI_CLOSE:
             result = commandClose(
                 fdwCommand, reinterpret_cast<LPMCI_GENERIC_PARMS>(dwParam));
@@ -356,18 +432,20 @@ MCIERROR WinMM::mciSendCommandA(
             break;
         default:
             // unrecognized command
-            return m_mciSendCommandA(IDDevice, uMsg, fdwCommand, dwParam);
+            return forwardCommand(IDDevice, uMsg, fdwCommand, dwParam, wide);
     }
 
-    if (m_player && result == MMSYSERR_NOERROR) {
-        bool notify = (fdwCommand & MCI_NOTIFY) != 0;
-        m_player->setNotify(notify);
-        if (notify && dwParam) {
-            LPMCI_GENERIC_PARMS parms =
-                reinterpret_cast<LPMCI_GENERIC_PARMS>(dwParam);
-            m_player->setNotifyCallback(
-                reinterpret_cast<HWND>(parms->dwCallback));
-        }
+    // MCI_PLAY notifies once the range has been played and MCI_CLOSE before
+    // the player is gone, all other commands complete right away
+    if (m_player && result == MMSYSERR_NOERROR && uMsg != MCI_PLAY &&
+        (fdwCommand & MCI_NOTIFY) && dwParam) {
+        LPMCI_GENERIC_PARMS parms =
+            reinterpret_cast<LPMCI_GENERIC_PARMS>(dwParam);
+        m_player->notify(reinterpret_cast<HWND>(parms->dwCallback));
+    }
+
+    if (result != MMSYSERR_NOERROR) {
+        LOG_TRACE("  %s", WinMMError::getErrorName(result));
     }
 
     return result;
@@ -378,8 +456,188 @@ MCIERROR WinMM::mciSendStringA(
 {
     LOG_TRACE("cmd=%s", cmd);
 
-    // this one is a big TODO
-    return MMSYSERR_NOERROR;
+    MCIERROR result;
+    if (queryStats(cmd, ret, cchReturn, hwndCallback, result)) {
+        return result;
+    }
+
+    MciString command;
+    if (command.parse(cmd)) {
+        bool handled = false;
+        result = sendString(command, ret, cchReturn, hwndCallback, handled);
+        if (handled) {
+            return result;
+        }
+    }
+
+    return forwardString(cmd, ret, cchReturn, hwndCallback);
+}
+
+MCIERROR WinMM::mciSendStringW(
+    LPCWSTR cmd, LPWSTR ret, UINT cchReturn, HWND hwndCallback)
+{
+    LOG_TRACE("cmd=%ls", cmd);
+
+    MCIERROR result;
+    if (queryStats(cmd, ret, cchReturn, hwndCallback, result)) {
+        return result;
+    }
+
+    MciString command;
+    if (command.parse(cmd)) {
+        // anything that fits into cchReturn bytes also fits into cchReturn
+        // wide characters
+        char narrow[MciString::MaxLength];
+        size_t narrowSize =
+            cchReturn < sizeof(narrow) ? cchReturn : sizeof(narrow);
+
+        bool handled = false;
+        result = sendString(command, ret ? narrow : nullptr, narrowSize,
+            hwndCallback, handled);
+        if (handled) {
+            if (result == MMSYSERR_NOERROR && ret && cchReturn > 0) {
+                MultiByteToWideChar(CP_ACP, 0, narrow, -1, ret,
+                    static_cast<int>(cchReturn));
+            }
+            return result;
+        }
+    }
+
+    return forwardString(cmd, ret, cchReturn, hwndCallback);
+}
+
+MCIERROR WinMM::forwardString(
+    LPCSTR cmd, LPSTR ret, UINT cchReturn, HWND hwndCallback)
+{
+    return m_mciSendStringA(cmd, ret, cchReturn, hwndCallback);
+}
+
+MCIERROR WinMM::forwardString(
+    LPCWSTR cmd, LPWSTR ret, UINT cchReturn, HWND hwndCallback)
+{
+    return m_mciSendStringW(cmd, ret, cchReturn, hwndCallback);
+}
+
+bool WinMM::isOwnString(const MciString& command)
+{
+    // "set cdaudio soundtrack <set>" and "status cdaudio soundtrack" switch
+    // and query the soundtrack set
+    if ((command.isWord(0, "set") || command.isWord(0, "status")) &&
+        command.isWord(1, "cdaudio") && command.isWord(2, "soundtrack")) {
+        return true;
+    }
+
+    // the rest are the cdaudio commands MciStringCommand knows, opened by
+    // type or sent to the device or its alias
+    if (command.isWord(0, "open")) {
+        if (command.isWord(1, "cdaudio")) {
+            return true;
+        }
+
+        for (size_t i = 2; i + 1 < command.getCount(); i++) {
+            if (command.isWord(i, "type")) {
+                return command.isWord(i + 1, "cdaudio");
+            }
+        }
+
+        return false;
+    }
+
+    return (command.isWord(0, "close") || command.isWord(0, "play") ||
+               command.isWord(0, "stop") || command.isWord(0, "pause") ||
+               command.isWord(0, "resume") || command.isWord(0, "seek") ||
+               command.isWord(0, "set") || command.isWord(0, "status")) &&
+           isOwnDevice(command.getWord(1));
+}
+
+bool WinMM::isOwnDevice(const char* device)
+{
+    if (!_stricmp(device, "cdaudio")) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_aliasMutex);
+    return m_alias[0] && !_stricmp(device, m_alias);
+}
+
+MCIERROR WinMM::sendString(const MciString& command, LPSTR ret,
+    size_t retSize, HWND hwndCallback, bool& handled)
+{
+    if (ret && retSize > 0) {
+        ret[0] = '\0';
+    }
+
+    if (!isOwnString(command)) {
+        return MMSYSERR_NOERROR;
+    }
+
+    handled = true;
+
+    if (command.isWord(2, "soundtrack")) {
+        if (!m_player) {
+            return MCIERR_INVALID_DEVICE_NAME;
+        }
+
+        if (command.isWord(0, "set")) {
+            if (command.getCount() < 4) {
+                return MCIERR_MISSING_STRING_ARGUMENT;
+            }
+
+            return m_player->selectTrackSet(command.getWord(3));
+        }
+
+        const std::string& name = m_player->getTrackSet();
+        if (!ret || retSize <= name.size()) {
+            return MCIERR_PARAM_OVERFLOW;
+        }
+
+        strcpy_s(ret, retSize, name.c_str());
+        return MMSYSERR_NOERROR;
+    }
+
+    // positions are read and written in the format of the player, MSF
+    // until it is opened
+    int32_t timeFormat =
+        m_player ? m_player->getTimeFormat() : MCI_FORMAT_MSF;
+
+    MciStringCommand translated;
+    MCIERROR result =
+        translated.translate(command, timeFormat, hwndCallback);
+    if (result) {
+        return result;
+    }
+
+    UINT message = translated.getMessage();
+    if (message != MCI_OPEN && !m_player) {
+        return MCIERR_INVALID_DEVICE_NAME;
+    }
+
+    result = sendCommand(message == MCI_OPEN ? 0 : m_deviceID.load(),
+        message, translated.getFlags(), translated.getParms(), false);
+    if (result) {
+        return result;
+    }
+
+    if (m_player) {
+        timeFormat = m_player->getTimeFormat();
+    }
+
+    return translated.formatReturn(ret, retSize, timeFormat);
+}
+
+Config& WinMM::getConfig()
+{
+    return m_config;
+}
+
+Diagnostics& WinMM::getDiagnostics()
+{
+    return m_diagnostics;
+}
+
+void WinMM::startDiagnosticsPipe()
+{
+    m_pipe.start(m_diagnostics, m_config);
 }
 
 UINT WinMM::auxGetNumDevs()
@@ -431,4 +689,111 @@ MMRESULT WinMM::auxSetVolume(UINT uDeviceID, DWORD dwVolume)
     m_player->setVolume(dwVolume);
 
     return MMSYSERR_NOERROR;
+}
+
+bool WinMM::queryStats(MCIDEVICEID IDDevice, UINT uMsg,
+    DWORD_PTR fdwCommand, DWORD_PTR dwParam, MCIERROR& result)
+{
+    if (uMsg != MCI_STATUS || !IDDevice || IDDevice != m_deviceID ||
+        !(fdwCommand & MCI_STATUS_ITEM) || !dwParam) {
+        return false;
+    }
+
+    LPMCI_STATUS_PARMS parms = reinterpret_cast<LPMCI_STATUS_PARMS>(dwParam);
+    if (parms->dwItem < MCI_STATUS_ZPLAYMM ||
+        parms->dwItem - MCI_STATUS_ZPLAYMM >= DiagCount) {
+        return false;
+    }
+
+    DiagnosticsItem item =
+        static_cast<DiagnosticsItem>(parms->dwItem - MCI_STATUS_ZPLAYMM);
+    parms->dwReturn = static_cast<DWORD_PTR>(m_diagnostics.get(item));
+
+    // The notifier belongs to the player and needs the lock. The query
+    // completes right away, so the window is notified directly.
+    if (fdwCommand & MCI_NOTIFY) {
+        PostMessage(reinterpret_cast<HWND>(parms->dwCallback), MM_MCINOTIFY,
+            MCI_NOTIFY_SUCCESSFUL, IDDevice);
+    }
+
+    result = MMSYSERR_NOERROR;
+    return true;
+}
+
+bool WinMM::queryStats(LPCSTR cmd, LPSTR ret, UINT cchReturn,
+    HWND hwndCallback, MCIERROR& result)
+{
+    MciString command;
+    if (!command.parse(cmd) || !isStatsString(command)) {
+        return false;
+    }
+
+    result = sendStats(command, ret, cchReturn, hwndCallback);
+    return true;
+}
+
+bool WinMM::queryStats(LPCWSTR cmd, LPWSTR ret, UINT cchReturn,
+    HWND hwndCallback, MCIERROR& result)
+{
+    MciString command;
+    if (!command.parse(cmd) || !isStatsString(command)) {
+        return false;
+    }
+
+    // all items take a few hundred characters
+    char narrow[1024];
+    size_t narrowSize =
+        cchReturn < sizeof(narrow) ? cchReturn : sizeof(narrow);
+
+    result = sendStats(
+        command, ret ? narrow : nullptr, narrowSize, hwndCallback);
+    if (result == MMSYSERR_NOERROR && ret && cchReturn > 0) {
+        MultiByteToWideChar(
+            CP_ACP, 0, narrow, -1, ret, static_cast<int>(cchReturn));
+    }
+    return true;
+}
+
+bool WinMM::isStatsString(const MciString& command)
+{
+    return command.isWord(0, "status") && command.isWord(1, "cdaudio") &&
+           command.isWord(2, "zplaymm-stats");
+}
+
+MCIERROR WinMM::sendStats(const MciString& command, LPSTR ret,
+    size_t retSize, HWND hwndCallback)
+{
+    // an item, followed by the flags in any order
+    DiagnosticsItem item = DiagCount;
+    bool notify = false;
+
+    for (size_t i = 3; i < command.getCount(); i++) {
+        if (command.isWord(i, "notify")) {
+            notify = true;
+        } else if (command.isWord(i, "wait")) {
+            // answered right away anyway
+        } else if (i > 3 || item != DiagCount) {
+            return MCIERR_EXTRA_CHARACTERS;
+        } else if (!Diagnostics::findItem(command.getWord(i), item)) {
+            return MCIERR_UNRECOGNIZED_KEYWORD;
+        }
+    }
+
+    MCIERROR result = MMSYSERR_NOERROR;
+
+    // nothing to return the snapshot in otherwise
+    if (ret && retSize) {
+        bool fits = item == DiagCount
+                        ? m_diagnostics.format(ret, retSize)
+                        : m_diagnostics.format(item, ret, retSize);
+        result = fits ? MMSYSERR_NOERROR : MCIERR_PARAM_OVERFLOW;
+    }
+
+    // like the command, the window is notified directly
+    if (notify && result == MMSYSERR_NOERROR) {
+        PostMessage(hwndCallback, MM_MCINOTIFY, MCI_NOTIFY_SUCCESSFUL,
+            m_deviceID.load());
+    }
+
+    return result;
 }
\ No newline at end of file
@@ -1,13 +1,22 @@
 #pragma once
 
+#include "AudioMixer.hpp"
 #include "CDPlayer.hpp"
+#include "Config.hpp"
+#include "Diagnostics.hpp"
+#include "MciParser.hpp"
 
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <windows.h>
 
 typedef MCIERROR(WINAPI* mciSendCommandA_t)(
     MCIDEVICEID, UINT, DWORD_PTR, DWORD_PTR);
-typedef MCIERROR(WINAPI* mciSendStringA_t)(LPCSTR, LPCSTR, UINT, HWND);
+typedef MCIERROR(WINAPI* mciSendCommandW_t)(
+    MCIDEVICEID, UINT, DWORD_PTR, DWORD_PTR);
+typedef MCIERROR(WINAPI* mciSendStringA_t)(LPCSTR, LPSTR, UINT, HWND);
+typedef MCIERROR(WINAPI* mciSendStringW_t)(LPCWSTR, LPWSTR, UINT, HWND);
 
 class WinMM
 {
@@ -16,23 +25,73 @@ public:
     void load(HINSTANCE hinstDLL);
     MCIERROR mciSendCommandA(MCIDEVICEID IDDevice, UINT uMsg,
         DWORD_PTR fdwCommand, DWORD_PTR dwParam);
+    MCIERROR mciSendCommandW(MCIDEVICEID IDDevice, UINT uMsg,
+        DWORD_PTR fdwCommand, DWORD_PTR dwParam);
     MCIERROR mciSendStringA(
         LPCTSTR cmd, LPTSTR ret, UINT cchReturn, HWND hwndCallback);
+    MCIERROR mciSendStringW(
+        LPCWSTR cmd, LPWSTR ret, UINT cchReturn, HWND hwndCallback);
     UINT auxGetNumDevs();
     MMRESULT auxGetDevCapsA(UINT_PTR uDeviceID, LPAUXCAPS lpCaps, UINT cbCaps);
     MMRESULT auxGetVolume(UINT uDeviceID, LPDWORD lpdwVolume);
     MMRESULT auxSetVolume(UINT uDeviceID, DWORD dwVolume);
 
+    // read when the player opens, for tools that override settings
+    Config& getConfig();
+    Diagnostics& getDiagnostics();
+
+    // serves the diagnostics to other processes if configured, until WinMM
+    // is destroyed
+    void startDiagnosticsPipe();
+
+    // Answers the vendor MCI_STATUS items and "status cdaudio zplaymm-stats
+    // [item] [notify] [wait]" from the diagnostics, without the lock. False
+    // for anything else. The string gives all items unless one is named.
+    // MCI_NOTIFY and notify post MCI_NOTIFY_SUCCESSFUL straight away.
+    bool queryStats(MCIDEVICEID IDDevice, UINT uMsg, DWORD_PTR fdwCommand,
+        DWORD_PTR dwParam, MCIERROR& result);
+    bool queryStats(LPCSTR cmd, LPSTR ret, UINT cchReturn, HWND hwndCallback,
+        MCIERROR& result);
+    bool queryStats(LPCWSTR cmd, LPWSTR ret, UINT cchReturn,
+        HWND hwndCallback, MCIERROR& result);
+
+    // True for commands that aren't for our device. Safe to call without
+    // the lock, so that they can go to the system right away.
+    bool isForeignCommand(MCIDEVICEID IDDevice, UINT uMsg,
+        DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide);
+    bool isForeignString(LPCSTR cmd);
+    bool isForeignString(LPCWSTR cmd);
+
+    // The A and W commands only differ in the strings of MCI_OPEN, wide
+    // selects the system function others are passed on to.
+    MCIERROR forwardCommand(MCIDEVICEID IDDevice, UINT uMsg,
+        DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide);
+    MCIERROR forwardString(
+        LPCSTR cmd, LPSTR ret, UINT cchReturn, HWND hwndCallback);
+    MCIERROR forwardString(
+        LPCWSTR cmd, LPWSTR ret, UINT cchReturn, HWND hwndCallback);
+
 private:
     mciSendCommandA_t m_mciSendCommandA;
+    mciSendCommandW_t m_mciSendCommandW;
     mciSendStringA_t m_mciSendStringA;
+    mciSendStringW_t m_mciSendStringW;
+    Config m_config;
+    AudioMixer m_mixer;
+    Diagnostics m_diagnostics;
+    // declared after the counters, so that it stops before they are gone
+    DiagnosticsPipe m_pipe;
     CDPlayer* m_player;
-    DWORD m_timeFormat;
+    // ID of the open player, 0 while closed, read without the lock
+    std::atomic<MCIDEVICEID> m_deviceID;
+    // alias of the open player, strings may name the device by it
+    std::mutex m_aliasMutex;
+    char m_alias[64];
     DWORD m_volume;
 
     MCIERROR commandResume(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam);
     MCIERROR commandOpen(
-        MCIDEVICEID IDDevice, DWORD_PTR fdwCommand, LPMCI_OPEN_PARMS dwParam);
+        DWORD_PTR fdwCommand, const MciOpen& open, MCIDEVICEID& deviceID);
     MCIERROR commandClose(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam);
     MCIERROR commandSet(DWORD_PTR fdwCommand, LPMCI_SET_PARMS dwParam);
     MCIERROR commandSeek(DWORD_PTR fdwCommand, LPMCI_SEEK_PARMS dwParam);
@@ -40,4 +99,17 @@ private:
     MCIERROR commandStop(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam);
     MCIERROR commandPause(DWORD_PTR fdwCommand, LPMCI_GENERIC_PARMS dwParam);
     MCIERROR commandStatus(DWORD_PTR fdwCommand, LPMCI_STATUS_PARMS dwParam);
+
+    MCIERROR sendCommand(MCIDEVICEID IDDevice, UINT uMsg,
+        DWORD_PTR fdwCommand, DWORD_PTR dwParam, bool wide);
+    // the string commands handled here instead of by the system
+    bool isOwnString(const MciString& command);
+    bool isOwnDevice(const char* device);
+    // Handles the string commands of our own, the result is written narrow.
+    // handled is false for all others, which go to the system.
+    MCIERROR sendString(const MciString& command, LPSTR ret,
+        size_t retSize, HWND hwndCallback, bool& handled);
+    static bool isStatsString(const MciString& command);
+    MCIERROR sendStats(const MciString& command, LPSTR ret, size_t retSize,
+        HWND hwndCallback);
 };
\ No newline at end of file
@@ -1,9 +1,15 @@
 #include "WinMMError.hpp"
 
 #include <Windows.h>
-#include <map>
 
-static std::map<int32_t, std::string> MCIERR_NAMES = {
+struct ErrorName
+{
+    int32_t code;
+    const char* name;
+};
+
+// in the order of the codes, for the binary search
+static constexpr ErrorName MCIERR_NAMES[] = {
     {MCIERR_INVALID_DEVICE_ID, "MCIERR_INVALID_DEVICE_ID"},
     {MCIERR_UNRECOGNIZED_KEYWORD, "MCIERR_UNRECOGNIZED_KEYWORD"},
     {MCIERR_UNRECOGNIZED_COMMAND, "MCIERR_UNRECOGNIZED_COMMAND"},
@@ -22,7 +28,8 @@ static std::map<int32_t, std::string> MCIERR_NAMES = {
     {MCIERR_UNSUPPORTED_FUNCTION, "MCIERR_UNSUPPORTED_FUNCTION"},
     {MCIERR_FILE_NOT_FOUND, "MCIERR_FILE_NOT_FOUND"},
     {MCIERR_DEVICE_NOT_READY, "MCIERR_DEVICE_NOT_READY"},
-    {MCIERR_INTERNAL, "MCIERR_INTERNAL"}, {MCIERR_DRIVER, "MCIERR_DRIVER"},
+    {MCIERR_INTERNAL, "MCIERR_INTERNAL"},
+    {MCIERR_DRIVER, "MCIERR_DRIVER"},
     {MCIERR_CANNOT_USE_ALL, "MCIERR_CANNOT_USE_ALL"},
     {MCIERR_MULTIPLE, "MCIERR_MULTIPLE"},
     {MCIERR_EXTENSION_NOT_FOUND, "MCIERR_EXTENSION_NOT_FOUND"},
@@ -49,7 +56,8 @@ static std::map<int32_t, std::string> MCIERR_NAMES = {
     {MCIERR_FILENAME_REQUIRED, "MCIERR_FILENAME_REQUIRED"},
     {MCIERR_EXTRA_CHARACTERS, "MCIERR_EXTRA_CHARACTERS"},
     {MCIERR_DEVICE_NOT_INSTALLED, "MCIERR_DEVICE_NOT_INSTALLED"},
-    {MCIERR_GET_CD, "MCIERR_GET_CD"}, {MCIERR_SET_CD, "MCIERR_SET_CD"},
+    {MCIERR_GET_CD, "MCIERR_GET_CD"},
+    {MCIERR_SET_CD, "MCIERR_SET_CD"},
     {MCIERR_SET_DRIVE, "MCIERR_SET_DRIVE"},
     {MCIERR_DEVICE_LENGTH, "MCIERR_DEVICE_LENGTH"},
     {MCIERR_DEVICE_ORD_LENGTH, "MCIERR_DEVICE_ORD_LENGTH"},
@@ -76,7 +84,63 @@ static std::map<int32_t, std::string> MCIERR_NAMES = {
     {MCIERR_CREATEWINDOW, "MCIERR_CREATEWINDOW"},
     {MCIERR_FILE_READ, "MCIERR_FILE_READ"},
     {MCIERR_FILE_WRITE, "MCIERR_FILE_WRITE"},
-    {MCIERR_NO_IDENTITY, "MCIERR_NO_IDENTITY"}};
+    {MCIERR_NO_IDENTITY, "MCIERR_NO_IDENTITY"},
+};
+
+static constexpr size_t MCIERR_COUNT =
+    sizeof(MCIERR_NAMES) / sizeof(MCIERR_NAMES[0]);
+
+static constexpr bool isAscending(const ErrorName* names, size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        if (names[i].code <= names[i - 1].code) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static constexpr const char* findErrorName(int32_t errorCode)
+{
+    size_t first = 0;
+    size_t last = MCIERR_COUNT;
+
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (MCIERR_NAMES[middle].code < errorCode) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    if (first < MCIERR_COUNT && MCIERR_NAMES[first].code == errorCode) {
+        return MCIERR_NAMES[first].name;
+    }
+
+    return "unknown";
+}
+
+static constexpr bool isEqual(const char* a, const char* b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static_assert(isAscending(MCIERR_NAMES, MCIERR_COUNT),
+    "MCI error names must be sorted by code!");
+static_assert(isEqual(findErrorName(MCIERR_INVALID_DEVICE_ID),
+                  "MCIERR_INVALID_DEVICE_ID"),
+    "MCI error name lookup is broken!");
+static_assert(isEqual(findErrorName(MCIERR_OUTOFRANGE), "MCIERR_OUTOFRANGE"),
+    "MCI error name lookup is broken!");
+static_assert(isEqual(findErrorName(MCIERR_NO_IDENTITY), "MCIERR_NO_IDENTITY"),
+    "MCI error name lookup is broken!");
+static_assert(isEqual(findErrorName(MMSYSERR_ERROR), "unknown"),
+    "MCI error name lookup is broken!");
 
 WinMMError::WinMMError(int32_t errorCode)
     : std::runtime_error("MCI error code")
@@ -100,7 +164,12 @@ int32_t WinMMError::getErrorCode() const
     return m_errorCode;
 }
 
-const std::string& WinMMError::getErrorName() const
+const char* WinMMError::getErrorName() const
+{
+    return getErrorName(m_errorCode);
+}
+
+const char* WinMMError::getErrorName(int32_t errorCode)
 {
-    return MCIERR_NAMES[m_errorCode];
+    return findErrorName(errorCode);
 }
\ No newline at end of file
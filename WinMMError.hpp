@@ -11,7 +11,10 @@ public:
     WinMMError(const char* message, int32_t errorCode);
     WinMMError(const std::string& message, int32_t errorCode);
     int32_t getErrorCode() const;
-    const std::string& getErrorName() const;
+    const char* getErrorName() const;
+
+    // "unknown" for codes that aren't MCIERR_*
+    static const char* getErrorName(int32_t errorCode);
 
 private:
     int32_t m_errorCode;
@@ -0,0 +1,190 @@
+#pragma once
+
+// Every export of the system winmm.dll with its ordinal, in the order of
+// the ordinals. FORWARD exports jump to the system function, WRAP exports
+// jump to wrap_<name> in ZPlayMM.cpp. The export list of the DLL, the names
+// to resolve and the jump thunks are all generated from this table.
+//
+// libzplay calls the mixer*, waveIn* and waveOut* exports of this DLL, so
+// they must stay FORWARD.
+#define WINMM_EXPORTS(FORWARD, WRAP)                                           \
+    FORWARD(CloseDriver, 3)                                                    \
+    FORWARD(DefDriverProc, 4)                                                  \
+    FORWARD(DriverCallback, 5)                                                 \
+    FORWARD(DrvGetModuleHandle, 6)                                             \
+    FORWARD(GetDriverModuleHandle, 7)                                          \
+    FORWARD(OpenDriver, 8)                                                     \
+    FORWARD(PlaySound, 9)                                                      \
+    FORWARD(PlaySoundA, 10)                                                    \
+    FORWARD(PlaySoundW, 11)                                                    \
+    FORWARD(SendDriverMessage, 12)                                             \
+    FORWARD(WOWAppExit, 13)                                                    \
+    WRAP(auxGetDevCapsA, 14)                                                   \
+    FORWARD(auxGetDevCapsW, 15)                                                \
+    WRAP(auxGetNumDevs, 16)                                                    \
+    WRAP(auxGetVolume, 17)                                                     \
+    FORWARD(auxOutMessage, 18)                                                 \
+    WRAP(auxSetVolume, 19)                                                     \
+    FORWARD(joyConfigChanged, 20)                                              \
+    FORWARD(joyGetDevCapsA, 21)                                                \
+    FORWARD(joyGetDevCapsW, 22)                                                \
+    FORWARD(joyGetNumDevs, 23)                                                 \
+    FORWARD(joyGetPos, 24)                                                     \
+    FORWARD(joyGetPosEx, 25)                                                   \
+    FORWARD(joyGetThreshold, 26)                                               \
+    FORWARD(joyReleaseCapture, 27)                                             \
+    FORWARD(joySetCapture, 28)                                                 \
+    FORWARD(joySetThreshold, 29)                                               \
+    FORWARD(mciDriverNotify, 30)                                               \
+    FORWARD(mciDriverYield, 31)                                                \
+    FORWARD(mciExecute, 32)                                                    \
+    FORWARD(mciFreeCommandResource, 33)                                        \
+    FORWARD(mciGetCreatorTask, 34)                                             \
+    FORWARD(mciGetDeviceIDA, 35)                                               \
+    FORWARD(mciGetDeviceIDFromElementIDA, 36)                                  \
+    FORWARD(mciGetDeviceIDFromElementIDW, 37)                                  \
+    FORWARD(mciGetDeviceIDW, 38)                                               \
+    FORWARD(mciGetDriverData, 39)                                              \
+    FORWARD(mciGetErrorStringA, 40)                                            \
+    FORWARD(mciGetErrorStringW, 41)                                            \
+    FORWARD(mciGetYieldProc, 42)                                               \
+    FORWARD(mciLoadCommandResource, 43)                                        \
+    WRAP(mciSendCommandA, 44)                                                  \
+    WRAP(mciSendCommandW, 45)                                                  \
+    WRAP(mciSendStringA, 46)                                                   \
+    WRAP(mciSendStringW, 47)                                                   \
+    FORWARD(mciSetDriverData, 48)                                              \
+    FORWARD(mciSetYieldProc, 49)                                               \
+    FORWARD(midiConnect, 50)                                                   \
+    FORWARD(midiDisconnect, 51)                                                \
+    FORWARD(midiInAddBuffer, 52)                                               \
+    FORWARD(midiInClose, 53)                                                   \
+    FORWARD(midiInGetDevCapsA, 54)                                             \
+    FORWARD(midiInGetDevCapsW, 55)                                             \
+    FORWARD(midiInGetErrorTextA, 56)                                           \
+    FORWARD(midiInGetErrorTextW, 57)                                           \
+    FORWARD(midiInGetID, 58)                                                   \
+    FORWARD(midiInGetNumDevs, 59)                                              \
+    FORWARD(midiInMessage, 60)                                                 \
+    FORWARD(midiInOpen, 61)                                                    \
+    FORWARD(midiInPrepareHeader, 62)                                           \
+    FORWARD(midiInReset, 63)                                                   \
+    FORWARD(midiInStart, 64)                                                   \
+    FORWARD(midiInStop, 65)                                                    \
+    FORWARD(midiInUnprepareHeader, 66)                                         \
+    FORWARD(midiOutCacheDrumPatches, 67)                                       \
+    FORWARD(midiOutCachePatches, 68)                                           \
+    FORWARD(midiOutClose, 69)                                                  \
+    FORWARD(midiOutGetDevCapsA, 70)                                            \
+    FORWARD(midiOutGetDevCapsW, 71)                                            \
+    FORWARD(midiOutGetErrorTextA, 72)                                          \
+    FORWARD(midiOutGetErrorTextW, 73)                                          \
+    FORWARD(midiOutGetID, 74)                                                  \
+    FORWARD(midiOutGetNumDevs, 75)                                             \
+    FORWARD(midiOutGetVolume, 76)                                              \
+    FORWARD(midiOutLongMsg, 77)                                                \
+    FORWARD(midiOutMessage, 78)                                                \
+    FORWARD(midiOutOpen, 79)                                                   \
+    FORWARD(midiOutPrepareHeader, 80)                                          \
+    FORWARD(midiOutReset, 81)                                                  \
+    FORWARD(midiOutSetVolume, 82)                                              \
+    FORWARD(midiOutShortMsg, 83)                                               \
+    FORWARD(midiOutUnprepareHeader, 84)                                        \
+    FORWARD(midiStreamClose, 85)                                               \
+    FORWARD(midiStreamOpen, 86)                                                \
+    FORWARD(midiStreamOut, 87)                                                 \
+    FORWARD(midiStreamPause, 88)                                               \
+    FORWARD(midiStreamPosition, 89)                                            \
+    FORWARD(midiStreamProperty, 90)                                            \
+    FORWARD(midiStreamRestart, 91)                                             \
+    FORWARD(midiStreamStop, 92)                                                \
+    FORWARD(mixerClose, 93)                                                    \
+    FORWARD(mixerGetControlDetailsA, 94)                                       \
+    FORWARD(mixerGetControlDetailsW, 95)                                       \
+    FORWARD(mixerGetDevCapsA, 96)                                              \
+    FORWARD(mixerGetDevCapsW, 97)                                              \
+    FORWARD(mixerGetID, 98)                                                    \
+    FORWARD(mixerGetLineControlsA, 99)                                         \
+    FORWARD(mixerGetLineControlsW, 100)                                        \
+    FORWARD(mixerGetLineInfoA, 101)                                            \
+    FORWARD(mixerGetLineInfoW, 102)                                            \
+    FORWARD(mixerGetNumDevs, 103)                                              \
+    FORWARD(mixerMessage, 104)                                                 \
+    FORWARD(mixerOpen, 105)                                                    \
+    FORWARD(mixerSetControlDetails, 106)                                       \
+    FORWARD(mmDrvInstall, 107)                                                 \
+    FORWARD(mmGetCurrentTask, 108)                                             \
+    FORWARD(mmTaskBlock, 109)                                                  \
+    FORWARD(mmTaskCreate, 110)                                                 \
+    FORWARD(mmTaskSignal, 111)                                                 \
+    FORWARD(mmTaskYield, 112)                                                  \
+    FORWARD(mmioAdvance, 113)                                                  \
+    FORWARD(mmioAscend, 114)                                                   \
+    FORWARD(mmioClose, 115)                                                    \
+    FORWARD(mmioCreateChunk, 116)                                              \
+    FORWARD(mmioDescend, 117)                                                  \
+    FORWARD(mmioFlush, 118)                                                    \
+    FORWARD(mmioGetInfo, 119)                                                  \
+    FORWARD(mmioInstallIOProcA, 120)                                           \
+    FORWARD(mmioInstallIOProcW, 121)                                           \
+    FORWARD(mmioOpenA, 122)                                                    \
+    FORWARD(mmioOpenW, 123)                                                    \
+    FORWARD(mmioRead, 124)                                                     \
+    FORWARD(mmioRenameA, 125)                                                  \
+    FORWARD(mmioRenameW, 126)                                                  \
+    FORWARD(mmioSeek, 127)                                                     \
+    FORWARD(mmioSendMessage, 128)                                              \
+    FORWARD(mmioSetBuffer, 129)                                                \
+    FORWARD(mmioSetInfo, 130)                                                  \
+    FORWARD(mmioStringToFOURCCA, 131)                                          \
+    FORWARD(mmioStringToFOURCCW, 132)                                          \
+    FORWARD(mmioWrite, 133)                                                    \
+    FORWARD(mmsystemGetVersion, 134)                                           \
+    FORWARD(sndPlaySoundA, 135)                                                \
+    FORWARD(sndPlaySoundW, 136)                                                \
+    FORWARD(timeBeginPeriod, 137)                                              \
+    FORWARD(timeEndPeriod, 138)                                                \
+    FORWARD(timeGetDevCaps, 139)                                               \
+    FORWARD(timeGetSystemTime, 140)                                            \
+    FORWARD(timeGetTime, 141)                                                  \
+    FORWARD(timeKillEvent, 142)                                                \
+    FORWARD(timeSetEvent, 143)                                                 \
+    FORWARD(waveInAddBuffer, 144)                                              \
+    FORWARD(waveInClose, 145)                                                  \
+    FORWARD(waveInGetDevCapsA, 146)                                            \
+    FORWARD(waveInGetDevCapsW, 147)                                            \
+    FORWARD(waveInGetErrorTextA, 148)                                          \
+    FORWARD(waveInGetErrorTextW, 149)                                          \
+    FORWARD(waveInGetID, 150)                                                  \
+    FORWARD(waveInGetNumDevs, 151)                                             \
+    FORWARD(waveInGetPosition, 152)                                            \
+    FORWARD(waveInMessage, 153)                                                \
+    FORWARD(waveInOpen, 154)                                                   \
+    FORWARD(waveInPrepareHeader, 155)                                          \
+    FORWARD(waveInReset, 156)                                                  \
+    FORWARD(waveInStart, 157)                                                  \
+    FORWARD(waveInStop, 158)                                                   \
+    FORWARD(waveInUnprepareHeader, 159)                                        \
+    FORWARD(waveOutBreakLoop, 160)                                             \
+    FORWARD(waveOutClose, 161)                                                 \
+    FORWARD(waveOutGetDevCapsA, 162)                                           \
+    FORWARD(waveOutGetDevCapsW, 163)                                           \
+    FORWARD(waveOutGetErrorTextA, 164)                                         \
+    FORWARD(waveOutGetErrorTextW, 165)                                         \
+    FORWARD(waveOutGetID, 166)                                                 \
+    FORWARD(waveOutGetNumDevs, 167)                                            \
+    FORWARD(waveOutGetPitch, 168)                                              \
+    FORWARD(waveOutGetPlaybackRate, 169)                                       \
+    FORWARD(waveOutGetPosition, 170)                                           \
+    FORWARD(waveOutGetVolume, 171)                                             \
+    FORWARD(waveOutMessage, 172)                                               \
+    FORWARD(waveOutOpen, 173)                                                  \
+    FORWARD(waveOutPause, 174)                                                 \
+    FORWARD(waveOutPrepareHeader, 175)                                         \
+    FORWARD(waveOutReset, 176)                                                 \
+    FORWARD(waveOutRestart, 177)                                               \
+    FORWARD(waveOutSetPitch, 178)                                              \
+    FORWARD(waveOutSetPlaybackRate, 179)                                       \
+    FORWARD(waveOutSetVolume, 180)                                             \
+    FORWARD(waveOutUnprepareHeader, 181)                                       \
+    FORWARD(waveOutWrite, 182)
@@ -0,0 +1,124 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(uint32_t threads, int32_t priority)
+    : m_priority(priority)
+    , m_running(0)
+    , m_exit(false)
+{
+    if (!threads) {
+        uint32_t cores = std::thread::hardware_concurrency();
+        threads = (std::max)(cores, 2u) - 1;
+    }
+
+    for (uint32_t i = 0; i < threads; i++) {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+        m_jobs.clear();
+    }
+
+    m_jobReady.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+
+    m_jobReady.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_jobs.empty() && !m_running; });
+}
+
+uint32_t WorkerPool::getThreadCount()
+{
+    return static_cast<uint32_t>(m_threads.size());
+}
+
+void WorkerPool::run()
+{
+    // background work must not take time from the game or the audio thread
+    SetThreadPriority(GetCurrentThread(), m_priority);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_jobReady.wait(lock, [this] { return m_exit || !m_jobs.empty(); });
+
+        if (m_exit) {
+            return;
+        }
+
+        std::function<void()> job = m_jobs.front();
+        m_jobs.pop_front();
+        m_running++;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        m_running--;
+        if (m_jobs.empty() && !m_running) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+JobGroup::JobGroup(WorkerPool& pool)
+    : m_pool(pool)
+    , m_pending(0)
+{
+}
+
+JobGroup::~JobGroup()
+{
+    wait();
+}
+
+void JobGroup::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending++;
+    }
+
+    m_pool.submit([this, job] {
+        job();
+
+        // notified under the lock, the group may be destroyed as soon as
+        // the waiter sees the count drop
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!--m_pending) {
+            m_done.notify_all();
+        }
+    });
+}
+
+void JobGroup::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return !m_pending; });
+}
+
+WorkerPool& JobGroup::getPool()
+{
+    return m_pool;
+}
\ No newline at end of file
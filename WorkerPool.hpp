@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of background threads for decode jobs like track verification
+// and cache warm-up. Jobs run in submission order on the first free thread.
+class WorkerPool
+{
+public:
+    // Zero threads means one per core, minus one for the game. Pass a
+    // higher priority for work the playback waits for.
+    explicit WorkerPool(
+        uint32_t threads = 0, int32_t priority = THREAD_PRIORITY_BELOW_NORMAL);
+    ~WorkerPool();
+
+    void submit(std::function<void()> job);
+
+    // blocks until all submitted jobs are done
+    void wait();
+
+    uint32_t getThreadCount();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_jobReady;
+    std::condition_variable m_idle;
+    std::deque<std::function<void()>> m_jobs;
+    int32_t m_priority;
+    uint32_t m_running;
+    bool m_exit;
+    std::vector<std::thread> m_threads;
+
+    void run();
+};
+
+// Jobs of one owner on a shared pool. Waiting only waits for the group's own
+// jobs, not for those other owners submitted.
+class JobGroup
+{
+public:
+    explicit JobGroup(WorkerPool& pool);
+
+    // waits for the jobs that are still running
+    ~JobGroup();
+
+    void submit(std::function<void()> job);
+
+    // blocks until all jobs of the group are done
+    void wait();
+
+    WorkerPool& getPool();
+
+private:
+    WorkerPool& m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    uint32_t m_pending;
+};
\ No newline at end of file
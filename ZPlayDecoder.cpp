@@ -0,0 +1,170 @@
+#include "ZPlayDecoder.hpp"
+#include "AudioClock.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+ZPlayDecoder::ZPlayDecoder(TStreamFormat format, const char* name)
+    : m_player(nullptr)
+    , m_format(format)
+    , m_name(name)
+    , m_fileSize(0)
+    , m_data(nullptr)
+    , m_available(0)
+    , m_started(false)
+    , m_ended(false)
+    , m_flush(false)
+    , m_resumed(0)
+{
+}
+
+ZPlayDecoder::~ZPlayDecoder()
+{
+    if (m_player) {
+        stopDecoding();
+        m_player->Release();
+    }
+}
+
+void ZPlayDecoder::open(const std::string& path)
+{
+    m_player = CreateZPlay();
+
+    // decoded PCM is diverted to read() instead of the sound card
+    m_player->SetCallbackFunc(&callback,
+        static_cast<TCallbackMessage>(MsgStop | MsgWaveBuffer), this);
+    m_player->SetSettings(sidAccurateSeek, 1);
+
+    if (!m_player->OpenFile(path.c_str(), m_format)) {
+        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    }
+
+    TStreamInfo info;
+    m_player->GetStreamInfo(&info);
+
+    m_sampleRate = info.SamplingRate;
+    m_channels = info.ChannelNumber;
+    m_length = info.Length.samples;
+
+    // libzplay reads by itself, the reads are estimated from the file size
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    m_fileSize = file ? static_cast<uint64_t>(file.tellg()) : 0;
+}
+
+size_t ZPlayDecoder::read(int16_t* buffer, size_t frames)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // decoding starts with the first read, so opening for the length only
+    // costs no decoding
+    if (!m_started) {
+        m_started = true;
+        m_ended = false;
+        m_resumed = AudioClock::getSystemTime();
+
+        // the decoding thread needs the lock for its first buffer
+        lock.unlock();
+        bool playing = m_player->Play() != 0;
+        lock.lock();
+
+        if (!playing) {
+            LOG_INFO("Decoding failed: %s", m_player->GetError());
+            m_ended = true;
+        }
+    }
+
+    m_ready.wait(lock, [this] { return m_available > 0 || m_ended; });
+
+    size_t count = (std::min)(frames, m_available);
+
+    for (size_t i = 0; i < count; i++) {
+        // mono is played on both channels
+        buffer[i * 2] = m_data[0];
+        buffer[i * 2 + 1] = m_data[m_channels > 1 ? 1 : 0];
+        m_data += m_channels;
+    }
+
+    m_available -= count;
+    m_stats.frames += count;
+
+    if (m_length) {
+        m_stats.bytesRead = m_fileSize * (std::min)(m_stats.frames, m_length) /
+                            m_length;
+    }
+
+    if (!m_available) {
+        m_consumed.notify_one();
+    }
+
+    return count;
+}
+
+void ZPlayDecoder::seek(uint64_t frame)
+{
+    stopDecoding();
+
+    TStreamTime offset = {};
+    offset.samples = static_cast<uint32_t>(frame);
+    if (!m_player->Seek(tfSamples, &offset, smFromBeginning)) {
+        throw WinMMError(m_player->GetError(), MCIERR_HARDWARE);
+    }
+}
+
+const char* ZPlayDecoder::getName()
+{
+    return m_name;
+}
+
+void ZPlayDecoder::stopDecoding()
+{
+    {
+        // a callback waiting for read() returns right away
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_flush = true;
+    }
+
+    m_consumed.notify_one();
+    m_player->Stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flush = false;
+    m_data = nullptr;
+    m_available = 0;
+    m_started = false;
+    m_ended = false;
+}
+
+int32_t WINAPI ZPlayDecoder::callback(void* instance, void* user_data,
+    TCallbackMessage message, unsigned int param1, unsigned int param2)
+{
+    ZPlayDecoder* decoder = static_cast<ZPlayDecoder*>(user_data);
+    std::unique_lock<std::mutex> lock(decoder->m_mutex);
+
+    if (message == MsgWaveBuffer) {
+        // the time since the last buffer went to decoding it
+        int64_t now = AudioClock::getSystemTime();
+        decoder->m_stats.seconds += (now - decoder->m_resumed) / 1e9;
+
+        // param1 points to 16 bit PCM, param2 is its size in bytes
+        decoder->m_data = reinterpret_cast<const int16_t*>(param1);
+        decoder->m_available =
+            param2 / (decoder->m_channels * sizeof(int16_t));
+        decoder->m_ready.notify_one();
+
+        decoder->m_consumed.wait(lock, [decoder] {
+            return decoder->m_flush || decoder->m_available == 0;
+        });
+
+        decoder->m_resumed = AudioClock::getSystemTime();
+
+        // returning 1 keeps the data away from the sound card, 2 stops
+        return decoder->m_flush ? 2 : 1;
+    }
+
+    decoder->m_ended = true;
+    decoder->m_ready.notify_one();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Decoder.hpp"
+#include "libzplay.h"
+
+#include <Windows.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+using namespace libZPlay;
+
+// Decodes anything libzplay can open. libzplay pushes PCM from its own
+// thread, each buffer is handed over to read() before decoding goes on.
+class ZPlayDecoder : public Decoder
+{
+public:
+    ZPlayDecoder(TStreamFormat format, const char* name);
+    ~ZPlayDecoder() override;
+
+    void open(const std::string& path) override;
+    size_t read(int16_t* buffer, size_t frames) override;
+    void seek(uint64_t frame) override;
+    const char* getName() override;
+
+private:
+    ZPlay* m_player;
+    TStreamFormat m_format;
+    const char* m_name;
+    uint64_t m_fileSize;
+
+    // the buffer libzplay is waiting on, guarded by the mutex
+    const int16_t* m_data;
+    size_t m_available;
+    bool m_started;
+    bool m_ended;
+    bool m_flush;
+    int64_t m_resumed;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_consumed;
+
+    static int32_t WINAPI callback(void* instance, void* user_data,
+        TCallbackMessage message, unsigned int param1, unsigned int param2);
+
+    void stopDecoding();
+};
\ No newline at end of file
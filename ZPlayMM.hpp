@@ -1,7 +1,61 @@
 #pragma once
 
-#define DECLARE_DLL_JMP(name, type, offset)                                    \
-    type __declspec(naked) __stdcall name##()                                  \
+#include <Windows.h>
+
+#include <cstdint>
+
+#ifdef _M_IX86
+
+// Exports the function under the name and ordinal of the system export. It
+// jumps to the system function of the export, or to resolveThunk with the
+// index in ecx while the export hasn't been resolved yet.
+#define DECLARE_DLL_JMP(name, ordinal)                                         \
+    void __declspec(naked) __stdcall jmp_##name()                              \
     {                                                                          \
-        __asm { jmp dword ptr [ offset ] }                                     \
-    }
\ No newline at end of file
+        __pragma(comment(linker,                                               \
+            "/EXPORT:" #name "=" __FUNCDNAME__ ",@" #ordinal))                 \
+        __asm { mov eax, dword ptr [exportProcs + export_##name * 4] }         \
+        __asm { mov ecx, export_##name }                                       \
+        __asm { test eax, eax }                                                \
+        __asm { jz resolveThunk }                                              \
+        __asm { jmp eax }                                                      \
+    }
+
+#else
+
+// in ZPlayMM64.asm, enters resolveExport with the index from r10d
+extern "C" void resolveThunk();
+
+// x64 has no inline assembly, so the thunks are machine code put together
+// from constants in an executable section. They do the same as the x86
+// thunks, the addresses in them are relocated by the loader.
+#pragma pack(push, 1)
+struct ExportThunk
+{
+    // mov rax, slot
+    uint8_t loadSlot[2];
+    FARPROC* slot;
+    // mov rax, [rax]; test rax, rax; jz loadIndex; jmp rax
+    uint8_t jumpSlot[10];
+    // mov r10d, index
+    uint8_t loadIndex[2];
+    uint32_t index;
+    // mov rax, resolve; jmp rax
+    uint8_t loadResolve[2];
+    void (*resolve)();
+    uint8_t jumpResolve[2];
+};
+#pragma pack(pop)
+
+#pragma section(".zthunk", read, execute)
+
+#define DECLARE_DLL_JMP(name, ordinal)                                         \
+    __pragma(comment(linker, "/EXPORT:" #name "=jmp_" #name ",@" #ordinal))    \
+    extern "C" __declspec(allocate(".zthunk"))                                 \
+        const ExportThunk jmp_##name = {{0x48, 0xB8},                          \
+            &exportProcs[export_##name],                                       \
+            {0x48, 0x8B, 0x00, 0x48, 0x85, 0xC0, 0x74, 0x02, 0xFF, 0xE0},      \
+            {0x41, 0xBA}, export_##name, {0x48, 0xB8}, resolveThunk,           \
+            {0xFF, 0xE0}};
+
+#endif
\ No newline at end of file
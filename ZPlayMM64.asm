@@ -0,0 +1,45 @@
+; Entered by a jump from an x64 thunk with the export index in r10d and the
+; caller's return address and arguments untouched. The argument registers
+; are kept around the call to resolveExport, which returns the function to
+; jump to.
+
+EXTERN resolveExport:PROC
+
+.code
+
+resolveThunk PROC FRAME
+    push rcx
+    .pushreg rcx
+    push rdx
+    .pushreg rdx
+    push r8
+    .pushreg r8
+    push r9
+    .pushreg r9
+    ; shadow space, xmm0-xmm3 and the alignment to 16 bytes
+    sub rsp, 104
+    .allocstack 104
+    .endprolog
+
+    movdqa xmmword ptr [rsp + 32], xmm0
+    movdqa xmmword ptr [rsp + 48], xmm1
+    movdqa xmmword ptr [rsp + 64], xmm2
+    movdqa xmmword ptr [rsp + 80], xmm3
+
+    mov ecx, r10d
+    call resolveExport
+
+    movdqa xmm0, xmmword ptr [rsp + 32]
+    movdqa xmm1, xmmword ptr [rsp + 48]
+    movdqa xmm2, xmmword ptr [rsp + 64]
+    movdqa xmm3, xmmword ptr [rsp + 80]
+
+    add rsp, 104
+    pop r9
+    pop r8
+    pop rdx
+    pop rcx
+    jmp rax
+resolveThunk ENDP
+
+END
\ No newline at end of file
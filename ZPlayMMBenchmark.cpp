@@ -0,0 +1,212 @@
+#include "AttachBenchmark.hpp"
+#include "CDTrackList.hpp"
+#include "Config.hpp"
+#include "CoreBenchmark.hpp"
+#include "DecoderBenchmark.hpp"
+#include "FileSystem.hpp"
+#include "FlacBenchmark.hpp"
+#include "FormatBenchmark.hpp"
+#include "WinMMError.hpp"
+
+#ifdef _WIN32
+#include "ErrorBenchmark.hpp"
+#include "WinMM.hpp"
+#endif
+
+#include <Windows.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Benchmarks of the playback core, outside of any game:
+//   ZPlayMMBenchmark <benchmark> [arguments]
+// Each one writes <benchmark>.txt to the current directory.
+
+#ifdef _WIN32
+// the path of the system winmm.dll, empty if there is no system directory
+static std::string getSystemDLLPath()
+{
+    char dllPath[MAX_PATH];
+    UINT size = GetSystemDirectory(dllPath, sizeof(dllPath));
+    if (!size || size >= sizeof(dllPath)) {
+        return std::string();
+    }
+
+    strcat_s(dllPath, sizeof(dllPath), "\\winmm.dll");
+    return dllPath;
+}
+
+// A WinMM of our own for the MCI runs, on the null output. The player may
+// still be open after a failed run, the process ends right after.
+static WinMM* createWinMM()
+{
+    HMODULE systemDLL = LoadLibrary(getSystemDLLPath().c_str());
+    if (!systemDLL) {
+        return nullptr;
+    }
+
+    WinMM* winmm = new WinMM();
+    winmm->load(systemDLL);
+    winmm->getConfig().set("output", "backend", "null");
+    return winmm;
+}
+#endif
+
+// the game directory of the synthetic soundtracks, empty if there is none
+static std::string createGameDirectory()
+{
+    std::string directory =
+        FileSystem::getTempDirectory() + "zplaymm-benchmark";
+    if (!FileSystem::createDirectory(directory)) {
+        fprintf(stderr, "Can't create %s\n", directory.c_str());
+        return std::string();
+    }
+
+    Config::setGameDirectory(directory);
+    return directory;
+}
+
+// attach [library] [proxy]: process attach with the exports resolved up
+// front and on first call, against the system winmm.dll, or on other
+// systems a stub with its exports. The proxy is a built winmm.dll of ours,
+// to time the load of two builds.
+static bool runAttach(int argc, char** argv)
+{
+#ifdef _WIN32
+    std::string library = getSystemDLLPath();
+#else
+    std::string library = WINMM_STUB;
+#endif
+
+    if (argc > 0) {
+        library = argv[0];
+    }
+
+    AttachBenchmark benchmark(library, argc > 1 ? argv[1] : "");
+    return benchmark.run("attach.txt");
+}
+
+// core [tracks]: the synthetic soundtrack of 2 to 99 tracks goes to the
+// temp directory
+static bool runCore(int argc, char** argv)
+{
+    int32_t tracks = argc > 0 ? atoi(argv[0]) : 0;
+    if (tracks < 2 || tracks > 99) {
+        tracks = 99;
+    }
+
+    std::string directory = createGameDirectory();
+    if (directory.empty()) {
+        return false;
+    }
+
+#ifdef _WIN32
+    WinMM* winmm = createWinMM();
+    if (!winmm) {
+        fprintf(stderr, "Can't load the system winmm.dll\n");
+        return false;
+    }
+
+    CoreBenchmark benchmark(winmm->getConfig(), directory, tracks, winmm);
+#else
+    Config config;
+    CoreBenchmark benchmark(config, directory, tracks);
+#endif
+
+    return benchmark.run("core.txt");
+}
+
+// decoders <game directory> [set]: every encoding of the tracks of the set,
+// found with the settings of the game
+static bool runDecoders(int argc, char** argv)
+{
+    if (argc < 1) {
+        fprintf(stderr, "No game directory\n");
+        return false;
+    }
+
+    Config::setGameDirectory(argv[0]);
+    Config config;
+
+    try {
+        CDTrackList tracks(argc > 1 ? argv[1] : "music", "Track", config);
+        DecoderBenchmark benchmark(tracks);
+        return benchmark.run("decoders.txt");
+    } catch (const WinMMError& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return false;
+    }
+}
+
+// flac: decode speed and exactness of the FLAC kernels on a synthetic
+// corpus in the temp directory
+static bool runFlac(int argc, char** argv)
+{
+    FlacBenchmark benchmark;
+    return benchmark.run("flac.txt");
+}
+
+// formats: throughput of the conversions to and from the output formats
+static bool runFormats(int argc, char** argv)
+{
+    FormatBenchmark benchmark;
+    return benchmark.run("formats.txt");
+}
+
+#ifdef _WIN32
+// errors: refused MCI commands, on a synthetic soundtrack in the temp
+// directory
+static bool runErrors(int argc, char** argv)
+{
+    std::string directory = createGameDirectory();
+    if (directory.empty()) {
+        return false;
+    }
+
+    WinMM* winmm = createWinMM();
+    if (!winmm) {
+        fprintf(stderr, "Can't load the system winmm.dll\n");
+        return false;
+    }
+
+    ErrorBenchmark benchmark(*winmm, directory);
+    return benchmark.run("errors.txt");
+}
+#endif
+
+static const struct
+{
+    const char* name;
+    const char* arguments;
+    bool (*run)(int argc, char** argv);
+} BENCHMARKS[] = {
+    {"attach", "[library] [proxy]", runAttach},
+    {"core", "[tracks]", runCore},
+    {"decoders", "<game directory> [set]", runDecoders},
+    {"flac", "", runFlac},
+    {"formats", "", runFormats},
+#ifdef _WIN32
+    {"errors", "", runErrors},
+#endif
+};
+
+int main(int argc, char** argv)
+{
+    for (const auto& benchmark : BENCHMARKS) {
+        if (argc >= 2 && !strcmp(argv[1], benchmark.name)) {
+            if (!benchmark.run(argc - 2, argv + 2)) {
+                fprintf(stderr, "The %s benchmark failed\n", benchmark.name);
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        }
+    }
+
+    fprintf(stderr, "usage: %s <benchmark> [arguments]\n", argv[0]);
+    for (const auto& benchmark : BENCHMARKS) {
+        fprintf(stderr, "  %s %s\n", benchmark.name, benchmark.arguments);
+    }
+    return EXIT_FAILURE;
+}
\ No newline at end of file
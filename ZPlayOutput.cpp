@@ -0,0 +1,84 @@
+#include "ZPlayOutput.hpp"
+#include "AudioMixer.hpp"
+#include "Logger.hpp"
+#include "WinMMError.hpp"
+
+#include <algorithm>
+
+// number of frames pushed to the player per request
+#define OUTPUT_BLOCK 1024
+
+ZPlayOutput::ZPlayOutput(uint32_t period)
+    : m_player(nullptr)
+    , m_mixer(nullptr)
+    , m_period(period)
+    , m_block(OUTPUT_BLOCK * AUDIO_CHANNELS)
+{
+}
+
+ZPlayOutput::~ZPlayOutput()
+{
+    stop();
+}
+
+void ZPlayOutput::start(AudioMixer& mixer)
+{
+    m_mixer = &mixer;
+    m_player = CreateZPlay();
+
+    m_player->SetSettings(sidSamplerate, AUDIO_SAMPLE_RATE);
+    m_player->SetSettings(sidChannelNumber, AUDIO_CHANNELS);
+    m_player->SetSettings(sidBitPerSample, 16);
+    m_player->SetSettings(sidBigEndian, 0);
+    m_player->SetSettings(sidWaveBufferSize, m_period);
+
+    // prime the dynamic stream with a block of silence, the rest is pushed
+    // from the callback
+    std::fill(m_block.begin(), m_block.end(), 0);
+    if (!m_player->OpenStream(1, 1, &m_block[0],
+            OUTPUT_BLOCK * AUDIO_CHANNELS * sizeof(int16_t), sfPCM)) {
+        std::string error = m_player->GetError();
+        stop();
+        throw WinMMError(error, MCIERR_HARDWARE);
+    }
+
+    m_player->SetCallbackFunc(&callback, MsgStreamNeedMoreData, this);
+
+    if (!m_player->Play()) {
+        std::string error = m_player->GetError();
+        stop();
+        throw WinMMError(error, MCIERR_HARDWARE);
+    }
+}
+
+void ZPlayOutput::stop()
+{
+    if (!m_player) {
+        return;
+    }
+
+    m_player->Stop();
+    m_player->Release();
+    m_player = nullptr;
+}
+
+uint32_t ZPlayOutput::getLatency()
+{
+    // the wave buffer size may have been adjusted by libzplay
+    uint32_t period = m_player ? m_player->GetSettings(sidWaveBufferSize) : 0;
+    return period * AUDIO_SAMPLE_RATE / 1000 + OUTPUT_BLOCK;
+}
+
+int32_t WINAPI ZPlayOutput::callback(void* instance, void* user_data,
+    TCallbackMessage message, unsigned int param1, unsigned int param2)
+{
+    ZPlayOutput* output = static_cast<ZPlayOutput*>(user_data);
+
+    // the player ran low on data, push the next block
+    output->m_mixer->render(
+        &output->m_block[0], OUTPUT_BLOCK, output->getLatency() - OUTPUT_BLOCK);
+    output->m_player->PushDataToStream(
+        &output->m_block[0], OUTPUT_BLOCK * AUDIO_CHANNELS * sizeof(int16_t));
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "AudioOutput.hpp"
+#include "libzplay.h"
+
+#include <Windows.h>
+#include <cstdint>
+#include <vector>
+
+using namespace libZPlay;
+
+// Plays the mix through a libzplay dynamic PCM stream. The wave-out
+// buffering is left to libzplay, so latency is only an estimate.
+class ZPlayOutput : public AudioOutput
+{
+public:
+    ZPlayOutput(uint32_t period);
+    ~ZPlayOutput();
+
+    void start(AudioMixer& mixer) override;
+    void stop() override;
+    uint32_t getLatency() override;
+
+private:
+    ZPlay* m_player;
+    AudioMixer* m_mixer;
+    uint32_t m_period;
+    std::vector<int16_t> m_block;
+
+    static int32_t WINAPI callback(void* instance, void* user_data,
+        TCallbackMessage message, unsigned int param1, unsigned int param2);
+};
\ No newline at end of file
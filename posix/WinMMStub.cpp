@@ -0,0 +1,11 @@
+#include "WinMMExports.hpp"
+
+// A library with every export of winmm.dll doing nothing, for timing how
+// they are loaded and looked up without Windows.
+
+#define EXPORT_STUB(name, ordinal)                                             \
+    extern "C" void name()                                                     \
+    {                                                                          \
+    }
+WINMM_EXPORTS(EXPORT_STUB, EXPORT_STUB)
+#undef EXPORT_STUB
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Windows.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <dlfcn.h>
+
+static std::string trim(const std::string& value)
+{
+    size_t first = value.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+
+    size_t last = value.find_last_not_of(" \t\r\n");
+    return value.substr(first, last - first + 1);
+}
+
+// the value of the key in the section, false if there is none
+static bool readProfile(LPCSTR lpAppName, LPCSTR lpKeyName,
+    LPCSTR lpFileName, std::string& value)
+{
+    std::ifstream file(lpFileName);
+    std::string line;
+    bool inSection = false;
+
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == ';') {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            size_t end = line.find(']');
+            inSection = end != std::string::npos &&
+                        !_stricmp(line.substr(1, end - 1).c_str(), lpAppName);
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (!inSection || equals == std::string::npos ||
+            _stricmp(trim(line.substr(0, equals)).c_str(), lpKeyName)) {
+            continue;
+        }
+
+        value = trim(line.substr(equals + 1));
+
+        // quotes around the whole value are dropped
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+HANDLE GetCurrentThread()
+{
+    return nullptr;
+}
+
+BOOL SetThreadPriority(HANDLE hThread, int nPriority)
+{
+    return TRUE;
+}
+
+BOOL PostMessage(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
+{
+    return FALSE;
+}
+
+void OutputDebugStringA(LPCSTR lpOutputString)
+{
+    fputs(lpOutputString, stderr);
+}
+
+HMODULE LoadLibraryA(LPCSTR lpLibFileName)
+{
+    return static_cast<HMODULE>(dlopen(lpLibFileName, RTLD_NOW));
+}
+
+HMODULE GetModuleHandleA(LPCSTR lpModuleName)
+{
+    void* module = dlopen(lpModuleName, RTLD_NOW | RTLD_NOLOAD);
+    if (module) {
+        // the handle doesn't hold a reference on Windows
+        dlclose(module);
+    }
+    return static_cast<HMODULE>(module);
+}
+
+FARPROC GetProcAddress(HMODULE hModule, LPCSTR lpProcName)
+{
+    return reinterpret_cast<FARPROC>(dlsym(hModule, lpProcName));
+}
+
+BOOL FreeLibrary(HMODULE hLibModule)
+{
+    return !dlclose(hLibModule);
+}
+
+DWORD GetPrivateProfileStringA(LPCSTR lpAppName, LPCSTR lpKeyName,
+    LPCSTR lpDefault, LPSTR lpReturnedString, DWORD nSize,
+    LPCSTR lpFileName)
+{
+    if (!nSize) {
+        return 0;
+    }
+
+    std::string value;
+    if (!readProfile(lpAppName, lpKeyName, lpFileName, value)) {
+        value = lpDefault ? lpDefault : "";
+    }
+
+    size_t size = (std::min)(value.size(), static_cast<size_t>(nSize - 1));
+    memcpy(lpReturnedString, value.data(), size);
+    lpReturnedString[size] = '\0';
+    return static_cast<DWORD>(size);
+}
+
+UINT GetPrivateProfileIntA(
+    LPCSTR lpAppName, LPCSTR lpKeyName, int nDefault, LPCSTR lpFileName)
+{
+    std::string value;
+    if (!readProfile(lpAppName, lpKeyName, lpFileName, value)) {
+        return static_cast<UINT>(nDefault);
+    }
+
+    return static_cast<UINT>(strtol(value.c_str(), nullptr, 10));
+}
+
+int vsnprintf_s(char* buffer, size_t size, size_t count, const char* format,
+    va_list list)
+{
+    if (!size) {
+        return -1;
+    }
+
+    size_t limit = count == _TRUNCATE ? size : (std::min)(size, count + 1);
+    int length = vsnprintf(buffer, limit, format, list);
+    if (length < 0) {
+        buffer[0] = '\0';
+        return -1;
+    }
+
+    // truncated output counts as a failure, like it does on Windows
+    return static_cast<size_t>(length) < limit ? length : -1;
+}
+
+int _vsnprintf_s(char* buffer, size_t size, size_t count,
+    const char* format, va_list list)
+{
+    return vsnprintf_s(buffer, size, count, format, list);
+}
+
+int _snprintf_s(
+    char* buffer, size_t size, size_t count, const char* format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    int length = vsnprintf_s(buffer, size, count, format, list);
+    va_end(list);
+    return length;
+}
+
+int sprintf_s(char* buffer, size_t size, const char* format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    int length = vsnprintf_s(buffer, size, _TRUNCATE, format, list);
+    va_end(list);
+
+    // the secure version leaves nothing of a string that doesn't fit
+    if (length < 0 && size) {
+        buffer[0] = '\0';
+    }
+    return length;
+}
+
+int strcpy_s(char* destination, size_t size, const char* source)
+{
+    return strncpy_s(destination, size, source, strlen(source));
+}
+
+int strncpy_s(
+    char* destination, size_t size, const char* source, size_t count)
+{
+    if (!size) {
+        return EINVAL;
+    }
+
+    size_t length = strnlen(source, count == _TRUNCATE ? size : count);
+    if (length >= size) {
+        if (count != _TRUNCATE) {
+            destination[0] = '\0';
+            return ERANGE;
+        }
+        length = size - 1;
+    }
+
+    memcpy(destination, source, length);
+    destination[length] = '\0';
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+#pragma once
+
+// the MSVC intrinsics the portable core uses
+
+#define _ReturnAddress() __builtin_return_address(0)
\ No newline at end of file
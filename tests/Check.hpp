@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the test programs. A failed check prints where it
+// failed and the test goes on, the program exits with the failure count.
+
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                    \
+    do {                                                                    \
+        if (!(condition)) {                                                 \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,          \
+                __LINE__, #condition);                                      \
+            checkFailures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                             \
+    do {                                                                    \
+        double checkActual = (actual);                                      \
+        double checkExpected = (expected);                                  \
+        if (!(fabs(checkActual - checkExpected) <= (tolerance))) {          \
+            fprintf(stderr, "%s:%d: %s is %f, expected %f\n", __FILE__,     \
+                __LINE__, #actual, checkActual, checkExpected);             \
+            checkFailures++;                                                \
+        }                                                                   \
+    } while (0)
+
+static int finishChecks(const char* name)
+{
+    if (checkFailures) {
+        fprintf(stderr, "%s: %d checks failed\n", name, checkFailures);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: passed\n", name);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
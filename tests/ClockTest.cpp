@@ -0,0 +1,160 @@
+#include "AudioClock.hpp"
+#include "AudioSource.hpp"
+#include "Check.hpp"
+
+#include <vector>
+
+// a device callback period of 10 ms
+#define BLOCK_FRAMES 441
+#define BLOCK_NS 10000000
+
+// the clock the tests move by hand
+static int64_t now = 0;
+
+static int64_t getTestTime()
+{
+    return now;
+}
+
+static void testInterpolation()
+{
+    now = 0;
+    AudioClock clock(&getTestTime);
+    CHECK(clock.getPlayedFrames() == 0.0);
+
+    // two blocks handed over, the first one starts playing
+    clock.update(2 * BLOCK_FRAMES, BLOCK_FRAMES);
+    CHECK_NEAR(clock.getPlayedFrames(), BLOCK_FRAMES, 1e-6);
+
+    now += BLOCK_NS / 2;
+    CHECK_NEAR(clock.getPlayedFrames(), 1.5 * BLOCK_FRAMES, 1e-6);
+
+    // the device can't play what hasn't been rendered
+    now += 10 * BLOCK_NS;
+    CHECK_NEAR(clock.getPlayedFrames(), 2 * BLOCK_FRAMES, 1e-6);
+
+    clock.reset();
+    CHECK(clock.getPlayedFrames() == 0.0);
+}
+
+static void testJitter()
+{
+    now = 0;
+    AudioClock clock(&getTestTime);
+
+    clock.update(4 * BLOCK_FRAMES, 2 * BLOCK_FRAMES);
+    now += BLOCK_NS * 3 / 2;
+    double interpolated = clock.getPlayedFrames();
+    CHECK_NEAR(interpolated, 3.5 * BLOCK_FRAMES, 1e-6);
+
+    // a late callback reports less than was interpolated before it
+    clock.update(5 * BLOCK_FRAMES, 2 * BLOCK_FRAMES);
+    CHECK(clock.getPlayedFrames() >= interpolated);
+
+    // and the interpolation carries on from the update
+    now += BLOCK_NS;
+    CHECK_NEAR(clock.getPlayedFrames(), 4 * BLOCK_FRAMES, 1e-6);
+}
+
+static void testSteadyPlayback()
+{
+    now = 0;
+    AudioClock clock(&getTestTime);
+    double last = 0.0;
+
+    // two blocks ahead of the device, polled four times per block
+    for (int32_t block = 0; block < 1000; block++) {
+        now = static_cast<int64_t>(block) * BLOCK_NS;
+        clock.update((block + 2) * BLOCK_FRAMES, 2 * BLOCK_FRAMES);
+
+        for (int32_t poll = 0; poll < 4; poll++) {
+            now = static_cast<int64_t>(block) * BLOCK_NS +
+                  poll * (BLOCK_NS / 4);
+            double played = clock.getPlayedFrames();
+            double expected = now * (AUDIO_SAMPLE_RATE / 1e9);
+
+            CHECK_NEAR(played, expected, 1.0);
+            CHECK(played >= last);
+            last = played;
+        }
+    }
+}
+
+static void testSourcePosition()
+{
+    StreamSource source(16 * BLOCK_FRAMES);
+    source.open();
+
+    std::vector<int16_t> buffer(4 * BLOCK_FRAMES * AUDIO_CHANNELS);
+    CHECK(source.write(&buffer[0], 4 * BLOCK_FRAMES) ==
+          StreamSource::WriteQueued);
+
+    // the source joins the mix at mixer frame 10000
+    uint64_t start = 10000;
+    CHECK(source.pull(&buffer[0], BLOCK_FRAMES, start) == BLOCK_FRAMES);
+    CHECK(source.getPosition(0.0) == 0.0);
+    CHECK_NEAR(source.getPosition(start + BLOCK_FRAMES / 2.0),
+        BLOCK_FRAMES / 2.0, 1e-6);
+    CHECK_NEAR(
+        source.getPosition(start + BLOCK_FRAMES), BLOCK_FRAMES, 1e-6);
+
+    // an earlier clock reading doesn't move the position back
+    source.pull(&buffer[0], BLOCK_FRAMES, start + BLOCK_FRAMES);
+    CHECK(source.getPosition(start + BLOCK_FRAMES / 2.0) >= BLOCK_FRAMES);
+    CHECK_NEAR(source.getPosition(start + 2 * BLOCK_FRAMES),
+        2 * BLOCK_FRAMES, 1e-6);
+
+    // a short read only counts the frames that were there
+    source.pull(&buffer[0], 4 * BLOCK_FRAMES, start + 2 * BLOCK_FRAMES);
+    CHECK_NEAR(source.getPosition(start + 6 * BLOCK_FRAMES),
+        4 * BLOCK_FRAMES, 1e-6);
+
+    // positions count from the first frame after opening again
+    source.open();
+    CHECK(source.getPosition(start + 6 * BLOCK_FRAMES) == 0.0);
+}
+
+static void testSourceWithClock()
+{
+    now = 0;
+    AudioClock clock(&getTestTime);
+    StreamSource source(16 * BLOCK_FRAMES);
+    source.open();
+
+    std::vector<int16_t> buffer(BLOCK_FRAMES * AUDIO_CHANNELS);
+    uint64_t mixed = 0;
+    double last = 0.0;
+
+    // the mixer renders a block per callback and stays two ahead of the
+    // device, which starts with the first callback
+    for (int32_t block = 0; block < 200; block++) {
+        while (mixed < static_cast<uint64_t>(block + 2) * BLOCK_FRAMES) {
+            source.write(&buffer[0], BLOCK_FRAMES);
+            source.pull(&buffer[0], BLOCK_FRAMES, mixed);
+            mixed += BLOCK_FRAMES;
+        }
+
+        now = static_cast<int64_t>(block) * BLOCK_NS;
+        clock.update(mixed, 2 * BLOCK_FRAMES);
+
+        for (int32_t poll = 0; poll < 2; poll++) {
+            now = static_cast<int64_t>(block) * BLOCK_NS +
+                  poll * (BLOCK_NS / 2);
+            double position = source.getPosition(clock.getPlayedFrames());
+
+            CHECK_NEAR(position, now * (AUDIO_SAMPLE_RATE / 1e9), 1.0);
+            CHECK(position >= last);
+            last = position;
+        }
+    }
+}
+
+int main()
+{
+    testInterpolation();
+    testJitter();
+    testSteadyPlayback();
+    testSourcePosition();
+    testSourceWithClock();
+    return finishChecks("ClockTest");
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "WinMMExports.hpp"
+#include "Check.hpp"
+
+#include <Windows.h>
+
+#include <cstring>
+#include <set>
+#include <string>
+
+#ifdef __x86_64__
+#include <sys/mman.h>
+#endif
+
+// the lists ZPlayMM.cpp generates from the table
+
+enum ExportIndex
+{
+#define EXPORT_INDEX(name, ordinal) export_##name,
+    WINMM_EXPORTS(EXPORT_INDEX, EXPORT_INDEX)
+#undef EXPORT_INDEX
+    exportCount
+};
+
+static const char* const exportNames[] = {
+#define EXPORT_NAME(name, ordinal) #name,
+    WINMM_EXPORTS(EXPORT_NAME, EXPORT_NAME)
+#undef EXPORT_NAME
+};
+
+static const uint16_t exportOrdinals[] = {
+#define EXPORT_ORDINAL(name, ordinal) ordinal,
+    WINMM_EXPORTS(EXPORT_ORDINAL, EXPORT_ORDINAL)
+#undef EXPORT_ORDINAL
+};
+
+static const bool exportWrapped[] = {
+#define EXPORT_FORWARD(name, ordinal) false,
+#define EXPORT_WRAP(name, ordinal) true,
+    WINMM_EXPORTS(EXPORT_FORWARD, EXPORT_WRAP)
+#undef EXPORT_FORWARD
+#undef EXPORT_WRAP
+};
+
+static void testTable()
+{
+    CHECK(sizeof(exportNames) / sizeof(exportNames[0]) == exportCount);
+    CHECK(sizeof(exportOrdinals) / sizeof(exportOrdinals[0]) == exportCount);
+    CHECK(!strcmp(exportNames[export_mciSendCommandA], "mciSendCommandA"));
+
+    std::set<std::string> names;
+
+    for (size_t i = 0; i < exportCount; i++) {
+        std::string name = exportNames[i];
+        CHECK(names.insert(name).second);
+
+        // the system DLL has no gaps in its ordinals
+        if (i) {
+            CHECK(exportOrdinals[i] == exportOrdinals[i - 1] + 1);
+        }
+
+        // libzplay plays through these, a wrapper would see its calls
+        if (!name.compare(0, 5, "mixer") || !name.compare(0, 6, "waveIn") ||
+            !name.compare(0, 7, "waveOut")) {
+            CHECK(!exportWrapped[i]);
+        }
+    }
+
+    // the commands of the CD audio device
+    CHECK(exportWrapped[export_mciSendCommandA]);
+    CHECK(exportWrapped[export_mciSendCommandW]);
+    CHECK(exportWrapped[export_mciSendStringA]);
+    CHECK(exportWrapped[export_mciSendStringW]);
+}
+
+#ifdef __x86_64__
+
+static FARPROC exportProcs[exportCount];
+
+// Stands in for ZPlayMM64.asm and returns the index the thunk passes on in
+// r10d, which the System V ABI leaves free like the Windows one.
+extern "C" void resolveThunk();
+asm(".text\n"
+    ".globl resolveThunk\n"
+    "resolveThunk:\n"
+    "    mov %r10d, %eax\n"
+    "    ret\n");
+
+// the section and linker directives of the thunks only apply to MSVC
+#define __declspec(attribute)
+#define __pragma(directive)
+
+#include "ZPlayMM.hpp"
+
+WINMM_EXPORTS(DECLARE_DLL_JMP, DECLARE_DLL_JMP)
+
+static const ExportThunk* const thunks[] = {
+#define EXPORT_THUNK(name, ordinal) &jmp_##name,
+    WINMM_EXPORTS(EXPORT_THUNK, EXPORT_THUNK)
+#undef EXPORT_THUNK
+};
+
+static intptr_t combine(intptr_t a, intptr_t b)
+{
+    return a * 1000 + b;
+}
+
+// runs every thunk from an executable copy, it only holds absolute
+// addresses
+static void testThunks()
+{
+    size_t size = sizeof(ExportThunk) * exportCount;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "No executable memory for the thunks\n");
+        checkFailures++;
+        return;
+    }
+
+    ExportThunk* code = static_cast<ExportThunk*>(memory);
+
+    for (size_t i = 0; i < exportCount; i++) {
+        memcpy(&code[i], thunks[i], sizeof(ExportThunk));
+        CHECK(code[i].slot == &exportProcs[i]);
+    }
+
+    for (size_t i = 0; i < exportCount; i++) {
+        // unresolved, the thunk hands its index to the resolver
+        exportProcs[i] = nullptr;
+        uint32_t index = reinterpret_cast<uint32_t (*)()>(&code[i])();
+        CHECK(index == i);
+
+        // resolved, it jumps to the function with the arguments untouched
+        exportProcs[i] = reinterpret_cast<FARPROC>(&combine);
+        intptr_t result =
+            reinterpret_cast<intptr_t (*)(intptr_t, intptr_t)>(&code[i])(
+                12, 34);
+        CHECK(result == 12034);
+    }
+
+    munmap(memory, size);
+}
+
+#endif
+
+int main()
+{
+    testTable();
+#ifdef __x86_64__
+    testThunks();
+#endif
+    return finishChecks("ExportTest");
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "FlacDecoder.hpp"
+#include "Check.hpp"
+#include "Md5.hpp"
+#include "WinMMError.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// frames read at once, less than a block so reads end mid-frame
+#define READ_FRAMES 1000
+
+// where seeks go, past the first block
+#define SEEK_FRAME 5000
+
+struct Fixture
+{
+    const char* name;
+    uint32_t channels;
+    uint32_t bitsPerSample;
+};
+
+// written by data/generate.py
+static const Fixture fixtures[] = {
+    {"stereo16.flac", 2, 16},
+    {"stereo24.flac", 2, 24},
+    {"mono16.flac", 1, 16},
+    {"stereo8.flac", 2, 8},
+};
+
+static std::vector<int16_t> readAll(FlacDecoder& decoder)
+{
+    std::vector<int16_t> samples;
+    std::vector<int16_t> buffer(READ_FRAMES * 2);
+
+    while (size_t frames = decoder.read(&buffer[0], READ_FRAMES)) {
+        samples.insert(samples.end(), &buffer[0], &buffer[frames * 2]);
+    }
+
+    return samples;
+}
+
+// The 16 bit output of samples up to 16 bits holds them unchanged in the
+// top bits, the bits below are zero. Hashed like the encoder did, it has
+// to match the signature.
+static bool matchesSignature(const std::vector<int16_t>& samples,
+    const Fixture& fixture, const uint8_t* signature)
+{
+    uint32_t shift = 16 - fixture.bitsPerSample;
+    uint32_t bytes = (fixture.bitsPerSample + 7) / 8;
+    std::vector<uint8_t> data;
+
+    for (size_t i = 0; i < samples.size(); i += 2) {
+        for (uint32_t c = 0; c < fixture.channels; c++) {
+            int32_t value = samples[i + c] >> shift;
+            if (samples[i + c] != static_cast<int16_t>(value * (1 << shift))) {
+                return false;
+            }
+
+            for (uint32_t b = 0; b < bytes; b++) {
+                data.push_back(static_cast<uint8_t>(value >> (b * 8)));
+            }
+        }
+    }
+
+    Md5 md5;
+    md5.update(data.data(), data.size());
+    uint8_t digest[16];
+    md5.finish(digest);
+    return !memcmp(digest, signature, sizeof(digest));
+}
+
+static void testDecode(const std::string& directory, const Fixture& fixture,
+    FlacKernelSet kernels, WorkerPool* pool)
+{
+    FlacDecoder decoder;
+    decoder.open(directory + "/" + fixture.name);
+    decoder.setKernels(kernels);
+    decoder.setPool(pool);
+    decoder.setHashing(true);
+
+    CHECK(decoder.getChannels() == fixture.channels);
+    CHECK(decoder.getBitsPerSample() == fixture.bitsPerSample);
+
+    std::vector<int16_t> samples = readAll(decoder);
+    CHECK(samples.size() == decoder.getLength() * 2);
+
+    // the native samples, before wider ones are dithered to 16 bits
+    uint8_t digest[16];
+    CHECK(decoder.getDigest(digest));
+    CHECK(!memcmp(digest, decoder.getSignature(), sizeof(digest)));
+
+    if (fixture.bitsPerSample > 16) {
+        return;
+    }
+
+    CHECK(matchesSignature(samples, fixture, decoder.getSignature()));
+
+    if (fixture.channels == 1) {
+        bool same = true;
+        for (size_t i = 0; i < samples.size(); i += 2) {
+            same = same && samples[i] == samples[i + 1];
+        }
+        CHECK(same);
+    }
+
+    // a seek continues with the same samples
+    decoder.seek(SEEK_FRAME);
+    std::vector<int16_t> buffer(READ_FRAMES * 2);
+    CHECK(decoder.read(&buffer[0], READ_FRAMES) == READ_FRAMES);
+    CHECK(std::equal(buffer.begin(), buffer.end(),
+        samples.begin() + SEEK_FRAME * 2));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixture directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    WorkerPool pool;
+
+    for (const Fixture& fixture : fixtures) {
+        for (int32_t set = FlacKernelsScalar; set <= FlacKernelsAvx2; set++) {
+            FlacKernelSet kernels = static_cast<FlacKernelSet>(set);
+            if (!FlacKernels::isSupported(kernels)) {
+                continue;
+            }
+
+            for (int32_t pooled = 0; pooled < 2; pooled++) {
+                try {
+                    testDecode(argv[1], fixture, kernels,
+                        pooled ? &pool : nullptr);
+                } catch (const WinMMError& ex) {
+                    fprintf(stderr, "%s: %s\n", fixture.name, ex.what());
+                    checkFailures++;
+                }
+            }
+        }
+    }
+
+    return finishChecks("FlacTest");
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "Notifier.hpp"
+#include "Check.hpp"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define DEVICE_ID 7
+
+// records the notifications instead of posting them to a window
+class RecordingSink : public NotifySink
+{
+public:
+    struct Post
+    {
+        HWND hwnd;
+        uint32_t result;
+        MCIDEVICEID deviceID;
+    };
+
+    void post(HWND hwnd, uint32_t result, MCIDEVICEID deviceID) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_posts.push_back({hwnd, result, deviceID});
+    }
+
+    std::vector<Post> getPosts()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_posts;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<Post> m_posts;
+};
+
+static HWND getWindow(uintptr_t id)
+{
+    return reinterpret_cast<HWND>(id);
+}
+
+// The notifier is destroyed before the posts are checked, which delivers
+// everything that was completed and aborts what is still pending.
+
+static void testFinish()
+{
+    RecordingSink sink;
+    {
+        Notifier notifier(DEVICE_ID, &sink);
+        uint32_t token = notifier.begin(getWindow(1));
+        CHECK(notifier.finish(token, MCI_NOTIFY_SUCCESSFUL));
+
+        // the first completion wins
+        CHECK(!notifier.finish(token, MCI_NOTIFY_FAILURE));
+        notifier.abort();
+    }
+
+    std::vector<RecordingSink::Post> posts = sink.getPosts();
+    CHECK(posts.size() == 1);
+    if (posts.size() == 1) {
+        CHECK(posts[0].hwnd == getWindow(1));
+        CHECK(posts[0].result == MCI_NOTIFY_SUCCESSFUL);
+        CHECK(posts[0].deviceID == DEVICE_ID);
+    }
+}
+
+static void testSupersede()
+{
+    RecordingSink sink;
+    {
+        Notifier notifier(DEVICE_ID, &sink);
+        uint32_t first = notifier.begin(getWindow(1));
+        uint32_t second = notifier.begin(getWindow(2));
+        CHECK(!notifier.finish(first, MCI_NOTIFY_SUCCESSFUL));
+
+        // a command completing right away supersedes the pending one too
+        notifier.notify(getWindow(3));
+        CHECK(!notifier.finish(second, MCI_NOTIFY_SUCCESSFUL));
+    }
+
+    std::vector<RecordingSink::Post> posts = sink.getPosts();
+    CHECK(posts.size() == 3);
+    if (posts.size() == 3) {
+        CHECK(posts[0].hwnd == getWindow(1));
+        CHECK(posts[0].result == MCI_NOTIFY_SUPERSEDED);
+        CHECK(posts[1].hwnd == getWindow(2));
+        CHECK(posts[1].result == MCI_NOTIFY_SUPERSEDED);
+        CHECK(posts[2].hwnd == getWindow(3));
+        CHECK(posts[2].result == MCI_NOTIFY_SUCCESSFUL);
+    }
+}
+
+static void testAbort()
+{
+    RecordingSink sink;
+    {
+        Notifier notifier(DEVICE_ID, &sink);
+        uint32_t token = notifier.begin(getWindow(1));
+        notifier.abort();
+        CHECK(!notifier.finish(token, MCI_NOTIFY_SUCCESSFUL));
+
+        // a notification without a window completes without a post
+        token = notifier.begin(nullptr);
+        CHECK(notifier.finish(token, MCI_NOTIFY_SUCCESSFUL));
+
+        // closing the device aborts the pending one
+        notifier.begin(getWindow(2));
+    }
+
+    std::vector<RecordingSink::Post> posts = sink.getPosts();
+    CHECK(posts.size() == 2);
+    if (posts.size() == 2) {
+        CHECK(posts[0].hwnd == getWindow(1));
+        CHECK(posts[0].result == MCI_NOTIFY_ABORTED);
+        CHECK(posts[1].hwnd == getWindow(2));
+        CHECK(posts[1].result == MCI_NOTIFY_ABORTED);
+    }
+}
+
+static void testOrder()
+{
+    // more notifications than slots, so slots are reused while delivering
+    const uintptr_t count = 1000;
+
+    RecordingSink sink;
+    {
+        Notifier notifier(DEVICE_ID, &sink);
+        for (uintptr_t i = 1; i <= count; i++) {
+            notifier.notify(getWindow(i));
+        }
+    }
+
+    std::vector<RecordingSink::Post> posts = sink.getPosts();
+    CHECK(posts.size() == count);
+    for (size_t i = 0; i < posts.size(); i++) {
+        CHECK(posts[i].hwnd == getWindow(i + 1));
+        CHECK(posts[i].result == MCI_NOTIFY_SUCCESSFUL);
+    }
+}
+
+static void testRace()
+{
+    // the audio thread finishes while the control thread aborts
+    const int32_t rounds = 2000;
+    int32_t finished = 0;
+
+    RecordingSink sink;
+    {
+        Notifier notifier(DEVICE_ID, &sink);
+        for (int32_t i = 0; i < rounds; i++) {
+            uint32_t token = notifier.begin(getWindow(1));
+            bool won = false;
+
+            std::thread audio([&notifier, &won, token] {
+                won = notifier.finish(token, MCI_NOTIFY_SUCCESSFUL);
+            });
+            notifier.abort();
+            audio.join();
+
+            finished += won ? 1 : 0;
+        }
+    }
+
+    std::vector<RecordingSink::Post> posts = sink.getPosts();
+    int32_t successful = 0;
+    for (const RecordingSink::Post& post : posts) {
+        successful += post.result == MCI_NOTIFY_SUCCESSFUL ? 1 : 0;
+    }
+
+    // exactly one notification per command, from the side that won
+    CHECK(posts.size() == rounds);
+    CHECK(successful == finished);
+}
+
+int main()
+{
+    testFinish();
+    testSupersede();
+    testAbort();
+    testOrder();
+    testRace();
+    return finishChecks("NotifierTest");
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "TrackPattern.hpp"
+#include "Check.hpp"
+
+#include <cstring>
+
+// a number the level doesn't set
+#define NONE -1
+
+struct Case
+{
+    const char* pattern;
+    size_t level;
+    const char* name;
+    bool matches;
+    int32_t disc;
+    int32_t track;
+};
+
+// names of the last level come with an extension, like the files
+static const Case cases[] = {
+    {"Track{track}*", 0, "Track1.ogg", true, NONE, 1},
+    {"Track{track}*", 0, "Track01.ogg", true, NONE, 1},
+    {"Track{track}*", 0, "Track099.flac", true, NONE, 99},
+    {"Track{track}*", 0, "track12 - Title.mp3", true, NONE, 12},
+    {"Track{track}*", 0, "TRACK05.wav", true, NONE, 5},
+    {"Track{track}*", 0, "Track02.disc.ogg", true, NONE, 2},
+    {"Track{track}*", 0, "Track.ogg", false, NONE, NONE},
+    {"Track{track}*", 0, "Track", false, NONE, NONE},
+    {"Track{track}*", 0, "Trackxx.ogg", false, NONE, NONE},
+    {"Track{track}*", 0, "Track1234.ogg", false, NONE, NONE},
+    {"Track{track}*", 0, "Tracks01.ogg", false, NONE, NONE},
+    {"Track{track}", 0, "Track01 - Title.ogg", false, NONE, NONE},
+    {"{track}", 0, "7.ogg", true, NONE, 7},
+    {"{track}", 0, "1000.ogg", false, NONE, NONE},
+    {"{track}", 0, ".ogg", false, NONE, NONE},
+    {"*{track}", 0, "Song 42.ogg", true, NONE, 42},
+    {"*{track}", 0, "Song 1234.ogg", false, NONE, NONE},
+    {"*-{track}-*", 0, "Game-07-Boss.ogg", true, NONE, 7},
+    {"**{track}", 0, "x3.ogg", true, NONE, 3},
+    {"{disc}-{track}", 0, "2-11.ogg", true, 2, 11},
+    {"{disc}-{track}", 0, "002-011.ogg", true, 2, 11},
+    {"{disc}-{track}", 0, "2-.ogg", false, NONE, NONE},
+    {"{disc}{track}", 0, "01005.ogg", true, 10, 5},
+    {"CD{disc}\\{track}*", 0, "CD1", true, 1, NONE},
+    {"CD{disc}\\{track}*", 0, "cd002", true, 2, NONE},
+    {"CD{disc}\\{track}*", 0, "CD", false, NONE, NONE},
+    {"CD{disc}\\{track}*", 0, "CD1234", false, NONE, NONE},
+    {"CD{disc}\\{track}*", 1, "05 Intro.ogg", true, NONE, 5},
+    {"CD{disc}\\{track}*", 1, "Intro.ogg", false, NONE, NONE},
+    {"CD{disc}\\{track}*", 2, "05.ogg", false, NONE, NONE},
+    {"CD{disc}/Track{track}", 1, "Track3.flac", true, NONE, 3},
+    {"*\\Disc{disc}\\{track}", 0, "Soundtrack", true, NONE, NONE},
+    {"*\\Disc{disc}\\{track}", 1, "Disc10", true, 10, NONE},
+    {"*\\Disc{disc}\\{track}", 2, "010.ogg", true, NONE, 10},
+};
+
+static void testMatch()
+{
+    for (const Case& c : cases) {
+        TrackPattern pattern(c.pattern);
+        bool last = c.level + 1 == pattern.getDepth();
+
+        // CDTrackList leaves the extension out of the match
+        const char* dot = last ? strrchr(c.name, '.') : nullptr;
+        size_t length = dot ? dot - c.name : strlen(c.name);
+
+        int32_t disc = NONE;
+        int32_t track = NONE;
+        bool matched = pattern.match(c.level, c.name, length, disc, track);
+
+        if (matched != c.matches || disc != c.disc || track != c.track) {
+            fprintf(stderr, "\"%s\" level %zu on \"%s\": %s, disc %d, "
+                            "track %d\n",
+                c.pattern, c.level, c.name, matched ? "match" : "no match",
+                disc, track);
+            checkFailures++;
+        }
+    }
+}
+
+static void testLevels()
+{
+    TrackPattern nested("CD{disc}\\Track{track}*");
+    CHECK(nested.isValid());
+    CHECK(nested.getDepth() == 2);
+    CHECK(nested.getPrefix(0) == "cd");
+    CHECK(nested.getPrefix(1) == "track");
+    CHECK(nested.getPrefix(2) == "");
+
+    // empty levels are dropped
+    TrackPattern slashes("\\\\Music//{track}\\");
+    CHECK(slashes.isValid());
+    CHECK(slashes.getDepth() == 2);
+    CHECK(slashes.getPrefix(0) == "music");
+    CHECK(slashes.getPrefix(1) == "");
+
+    // the file names need a track number
+    CHECK(!TrackPattern("Track").isValid());
+    CHECK(!TrackPattern("{track}\\Music").isValid());
+    CHECK(!TrackPattern("").isValid());
+    CHECK(TrackPattern("{disc}{track}").isValid());
+}
+
+int main()
+{
+    testMatch();
+    testLevels();
+    return finishChecks("TrackPatternTest");
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "VorbisDecoder.hpp"
+#include "Check.hpp"
+#include "FlacDecoder.hpp"
+#include "WinMMError.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// frames read at once, less than a long block so reads end mid-packet
+#define READ_FRAMES 1000
+
+// where seeks go, far enough into the stereo fixture to start after a page
+#define SEEK_FRAME 15000
+
+// The decoder dithers to 16 bits and the reference is rounded, so a sample
+// may be off by a little more than a step.
+#define TOLERANCE 2
+
+struct Fixture
+{
+    const char* name;
+    uint32_t sampleRate;
+    uint32_t channels;
+};
+
+// written by data/generate.py, each with what libvorbis decodes it to
+static const Fixture fixtures[] = {
+    {"stereo.ogg", 44100, 2},
+    {"mono.ogg", 22050, 1},
+};
+
+static std::vector<int16_t> readAll(Decoder& decoder)
+{
+    std::vector<int16_t> samples;
+    std::vector<int16_t> buffer(READ_FRAMES * 2);
+
+    while (size_t frames = decoder.read(&buffer[0], READ_FRAMES)) {
+        samples.insert(samples.end(), &buffer[0], &buffer[frames * 2]);
+    }
+
+    return samples;
+}
+
+static int32_t getMaxDifference(const std::vector<int16_t>& samples,
+    const std::vector<int16_t>& reference, size_t offset)
+{
+    int32_t difference = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        difference =
+            (std::max)(difference, abs(samples[i] - reference[offset + i]));
+    }
+    return difference;
+}
+
+static void testDecode(const std::string& directory, const Fixture& fixture)
+{
+    std::string path = directory + "/" + fixture.name;
+
+    FlacDecoder reference;
+    reference.open(path + ".flac");
+    std::vector<int16_t> expected = readAll(reference);
+
+    VorbisDecoder decoder;
+    decoder.open(path);
+
+    CHECK(decoder.getSampleRate() == fixture.sampleRate);
+    CHECK(decoder.getChannels() == fixture.channels);
+    CHECK(decoder.getLength() == reference.getLength());
+
+    std::vector<int16_t> samples = readAll(decoder);
+    CHECK(samples.size() == expected.size());
+    if (samples.size() != expected.size()) {
+        return;
+    }
+
+    CHECK(getMaxDifference(samples, expected, 0) <= TOLERANCE);
+
+    // a seek lands on the same frames, a seek back restarts the stream
+    for (uint64_t frame : {SEEK_FRAME, 0, 3}) {
+        if (frame + READ_FRAMES > decoder.getLength()) {
+            continue;
+        }
+
+        decoder.seek(frame);
+        std::vector<int16_t> buffer(READ_FRAMES * 2);
+        CHECK(decoder.read(&buffer[0], READ_FRAMES) == READ_FRAMES);
+        CHECK(getMaxDifference(buffer, expected, frame * 2) <= TOLERANCE);
+    }
+
+    // a seek to the end leaves nothing to read
+    decoder.seek(decoder.getLength());
+    int16_t buffer[2];
+    CHECK(decoder.read(buffer, 1) == 0);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixture directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (const Fixture& fixture : fixtures) {
+        try {
+            testDecode(argv[1], fixture);
+        } catch (const WinMMError& ex) {
+            fprintf(stderr, "%s: %s\n", fixture.name, ex.what());
+            checkFailures++;
+        }
+    }
+
+    // not a Vorbis stream
+    try {
+        VorbisDecoder decoder;
+        decoder.open(std::string(argv[1]) + "/stereo16.flac");
+        CHECK(false);
+    } catch (const WinMMError&) {
+    }
+
+    return finishChecks("VorbisTest");
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+# Writes the FLAC fixtures of FlacTest with libFLAC through libsndfile, so
+# the decoder is checked against streams of an encoder other than the
+# FLAC benchmark's. The Ogg Vorbis fixtures of VorbisTest are written with
+# libvorbis, next to what libvorbis decodes them to as 16 bit FLAC. Needs
+# numpy and soundfile.
+import numpy as np
+import soundfile as sf
+
+RATE = 44100
+FRAMES = RATE // 4
+
+# name, subtype, compression level from 0 to 1, channels
+FIXTURES = [
+    ("stereo16", "PCM_16", 1.0, 2),
+    ("stereo24", "PCM_24", 0.5, 2),
+    ("mono16", "PCM_16", 0.0, 1),
+    ("stereo8", "PCM_S8", 0.5, 2),
+]
+
+t = np.arange(FRAMES) / RATE
+random = np.random.default_rng(1)
+
+for name, subtype, level, channels in FIXTURES:
+    tone = (np.sin(2 * np.pi * 220 * t) + 0.5 * np.sin(2 * np.pi * 331 * t) +
+            0.25 * np.sin(2 * np.pi * 1375 * t))
+    left = 0.3 * tone + random.normal(0, 0.005, FRAMES)
+    right = 0.7 * left + 0.09 * np.sin(2 * np.pi * 440 * t)
+    data = np.stack([left, right], 1) if channels == 2 else left
+
+    sf.write(name + ".flac", data, RATE, subtype=subtype,
+             compression_level=level)
+
+
+# name, sample rate, quality from 0 to 1, channels
+VORBIS_FIXTURES = [
+    ("stereo", 44100, 0.5, 2),
+    ("mono", 22050, 0.1, 1),
+]
+
+for name, rate, quality, channels in VORBIS_FIXTURES:
+    frames = rate // 2
+    t = np.arange(frames) / rate
+    tone = np.sin(2 * np.pi * 220 * t) + 0.5 * np.sin(2 * np.pi * 1375 * t)
+    left = 0.3 * tone + random.normal(0, 0.005, frames)
+
+    # clicks make the encoder switch to short blocks
+    for start in range(0, frames - 100, rate // 8):
+        left[start:start + 100] += random.normal(0, 0.2, 100)
+
+    right = 0.7 * left + 0.09 * np.sin(2 * np.pi * 440 * t)
+    data = np.stack([left, right], 1) if channels == 2 else left
+
+    sf.write(name + ".ogg", data, rate, subtype="VORBIS",
+             compression_level=1.0 - quality)
+    # rounded and clipped the way the decoders of the DLL do
+    decoded, _ = sf.read(name + ".ogg", dtype="float32")
+    pcm = np.clip(np.round(decoded * 32768), -32768, 32767).astype(np.int16)
+    sf.write(name + ".ogg.flac", pcm, rate, subtype="PCM_16")